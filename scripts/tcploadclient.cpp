@@ -0,0 +1,254 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+// A load client for the TCP server, it measures accepting, reading and broadcasting with many
+// local connections(10k by default). Start the TCP server of xTools, let it send to all clients
+// with the timed sending(every second, for example), then run:
+//
+//   g++ -O2 -std=c++17 tcploadclient.cpp -o tcploadclient
+//   ./tcploadclient 127.0.0.1 20000 [connections] [seconds]
+//
+// The server port should be outside net.ipv4.ip_local_port_range, the clients take 10k ports from
+// it. The open files limit(ulimit -n) of both processes must exceed the number of connections.
+// accept:    all connections are opened, at most 1000 handshakes are in flight at a time.
+// read:      every connection sends a 64 byte message per round for the given time, a server that
+//            does not keep up fills the socket buffers and the rate drops to its read rate.
+// broadcast: the time from the first to the last connection receiving the next broadcast, once
+//            the connections have been quiet for 300 ms.
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+const int messageSize = 64;
+const int maxConnecting = 1000;
+
+double nowMs()
+{
+    using namespace std::chrono;
+    return duration_cast<duration<double, std::milli>>(steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void fail(const char *what)
+{
+    fprintf(stderr, "%s: %s\n", what, strerror(errno));
+    exit(1);
+}
+
+void watch(int epollFd, int op, int fd, unsigned events)
+{
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.fd = fd;
+    if (::epoll_ctl(epollFd, op, fd, &ev) < 0) {
+        fail("epoll_ctl");
+    }
+}
+
+std::vector<int> connectAll(int epollFd, const struct sockaddr_in &addr, int connections)
+{
+    std::vector<int> fds;
+    int connecting = 0;
+    int opened = 0;
+    int failed = 0;
+    const double start = nowMs();
+    while (static_cast<int>(fds.size()) + failed < connections) {
+        for (; connecting < maxConnecting && opened < connections; ++opened, ++connecting) {
+            int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd < 0) {
+                fail("socket");
+            }
+            int ret = ::connect(fd, reinterpret_cast<const struct sockaddr *>(&addr), sizeof(addr));
+            if (ret < 0 && errno != EINPROGRESS) {
+                fail("connect");
+            }
+            watch(epollFd, EPOLL_CTL_ADD, fd, EPOLLOUT);
+        }
+
+        struct epoll_event events[256];
+        int n = ::epoll_wait(epollFd, events, 256, 5000);
+        if (n == 0) {
+            fprintf(stderr, "accept: timed out with %d connections pending\n", connecting);
+            exit(1);
+        }
+        for (int i = 0; i < n; ++i) {
+            const int fd = events[i].data.fd;
+            int error = 0;
+            socklen_t length = sizeof(error);
+            ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length);
+            connecting--;
+            if (error != 0) {
+                ::close(fd);
+                failed++;
+                continue;
+            }
+
+            int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            watch(epollFd, EPOLL_CTL_MOD, fd, EPOLLIN);
+            fds.push_back(fd);
+        }
+    }
+
+    const double elapsed = nowMs() - start;
+    printf("accept     %d connections in %.0f ms, %.0f connections/s, %d failed\n",
+           static_cast<int>(fds.size()),
+           elapsed,
+           fds.size() / (elapsed / 1000.0),
+           failed);
+    return fds;
+}
+
+void drain(int epollFd)
+{
+    // Quiet means nothing has arrived for this long, it is shorter than the broadcast interval.
+    const int quietMs = 300;
+    char buffer[16 * 1024];
+    while (true) {
+        struct epoll_event events[256];
+        int n = ::epoll_wait(epollFd, events, 256, quietMs);
+        if (n == 0) {
+            return;
+        }
+        for (int i = 0; i < n; ++i) {
+            while (::recv(events[i].data.fd, buffer, sizeof(buffer), MSG_DONTWAIT) > 0) {
+            }
+        }
+    }
+}
+
+void sendAll(const std::vector<int> &fds, double seconds)
+{
+    char message[messageSize];
+    memset(message, 'x', sizeof(message));
+    long sent = 0;
+    long stalled = 0;
+    const double start = nowMs();
+    while (nowMs() - start < seconds * 1000.0) {
+        for (int fd : fds) {
+            ssize_t ret = ::send(fd, message, sizeof(message), MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (ret == sizeof(message)) {
+                sent++;
+            } else if (ret < 0 && errno == EAGAIN) {
+                stalled++;
+            } else if (ret < 0) {
+                fail("send");
+            }
+        }
+    }
+
+    const double elapsed = (nowMs() - start) / 1000.0;
+    printf("read       %.0f messages/s, %.1f MB/s, %.1f %% of the sends found a full buffer\n",
+           sent / elapsed,
+           sent * messageSize / elapsed / 1e6,
+           100.0 * stalled / std::max(1L, sent + stalled));
+}
+
+void waitBroadcast(int epollFd, const std::vector<int> &fds, double seconds)
+{
+    // Whatever arrived before is not part of the measured broadcast, a broadcast that is still
+    // being received is waited out.
+    drain(epollFd);
+
+    std::vector<char> received(static_cast<size_t>(*std::max_element(fds.begin(), fds.end())) + 1);
+    size_t count = 0;
+    double first = 0;
+    double last = 0;
+    char buffer[16 * 1024];
+    const double start = nowMs();
+    while (count < fds.size() && nowMs() - start < seconds * 1000.0) {
+        struct epoll_event events[256];
+        int n = ::epoll_wait(epollFd, events, 256, 100);
+        const double now = nowMs();
+        for (int i = 0; i < n; ++i) {
+            const int fd = events[i].data.fd;
+            if (::recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT) <= 0 || received[fd]) {
+                continue;
+            }
+
+            received[fd] = 1;
+            if (count++ == 0) {
+                first = now;
+            }
+            last = now;
+        }
+    }
+
+    if (count == 0) {
+        printf("broadcast  nothing received in %.0f s, is the timed sending on?\n", seconds);
+        return;
+    }
+    printf("broadcast  %d of %d connections received it within %.1f ms\n",
+           static_cast<int>(count),
+           static_cast<int>(fds.size()),
+           last - first);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s address port [connections] [seconds]\n", argv[0]);
+        return 1;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(atoi(argv[2])));
+    if (::inet_pton(AF_INET, argv[1], &addr.sin_addr) != 1) {
+        fprintf(stderr, "Invalid address: %s\n", argv[1]);
+        return 1;
+    }
+    const int connections = argc > 3 ? atoi(argv[3]) : 10000;
+    const double seconds = argc > 4 ? atof(argv[4]) : 5.0;
+
+    struct rlimit limit;
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &limit);
+        if (limit.rlim_cur < static_cast<rlim_t>(connections) + 16) {
+            fprintf(stderr,
+                    "The open files limit(%d) is too low\n",
+                    static_cast<int>(limit.rlim_cur));
+            return 1;
+        }
+    }
+    ::signal(SIGPIPE, SIG_IGN);
+
+    int epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    std::vector<int> fds = connectAll(epollFd, addr, connections);
+    if (fds.empty()) {
+        return 1;
+    }
+    sendAll(fds, seconds);
+    waitBroadcast(epollFd, fds, seconds);
+
+    for (int fd : fds) {
+        ::close(fd);
+    }
+    ::close(epollFd);
+    return 0;
+}
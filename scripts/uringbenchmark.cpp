@@ -0,0 +1,371 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+// Compares the io_uring backend of the TCP server workers with epoll and with poll() at 1, 100 and
+// 10k connections. poll() stands in for the Qt event loop, QEventDispatcherUNIX hands every socket
+// notifier to one poll() per iteration. The ring is the Uring class of the application, it is used
+// the way the workers use it: multishot receives into provided buffers.
+//
+// A child process connects the clients and runs rounds: every client sends a small message, the
+// server echoes it and the round ends when all echoes are back. Build and run it with
+// uringbenchmark.sh, or:
+//
+//   g++ -O2 -std=c++17 -I../src/device/linux uringbenchmark.cpp ../src/device/linux/uring.cpp
+//   ./a.out [seconds] [connections...]
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "uring.h"
+
+namespace {
+
+const int messageSize = 64;
+const unsigned uringEntries = 4096;
+const unsigned uringBufferCount = 4096;
+const unsigned uringBufferSize = 16 * 1024;
+const uint16_t uringBufferGroup = 0;
+
+double nowUs()
+{
+    using namespace std::chrono;
+    return duration_cast<duration<double, std::micro>>(steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void fail(const char *what)
+{
+    fprintf(stderr, "%s: %s\n", what, strerror(errno));
+    exit(1);
+}
+
+void echo(int fd, const char *data, int size)
+{
+    // The messages are tiny, the socket buffer always takes them.
+    while (size > 0) {
+        ssize_t ret = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            return;
+        }
+        data += ret;
+        size -= static_cast<int>(ret);
+    }
+}
+
+// Returns the number of connections that are still open.
+int serveRecv(int fd, char *buffer, int size)
+{
+    while (true) {
+        ssize_t ret = ::recv(fd, buffer, size, 0);
+        if (ret > 0) {
+            echo(fd, buffer, static_cast<int>(ret));
+            if (ret < size) {
+                return 1;
+            }
+        } else if (ret < 0 && errno == EINTR) {
+            continue;
+        } else if (ret < 0 && errno == EAGAIN) {
+            return 1;
+        } else {
+            return 0;
+        }
+    }
+}
+
+void servePoll(const std::vector<int> &fds)
+{
+    std::vector<struct pollfd> pfds(fds.size());
+    for (size_t i = 0; i < fds.size(); ++i) {
+        pfds[i].fd = fds[i];
+        pfds[i].events = POLLIN;
+    }
+
+    std::vector<char> buffer(uringBufferSize);
+    size_t open = fds.size();
+    while (open > 0) {
+        if (::poll(pfds.data(), pfds.size(), -1) < 0 && errno != EINTR) {
+            fail("poll");
+        }
+        for (auto &pfd : pfds) {
+            if (pfd.fd >= 0 && pfd.revents) {
+                if (!serveRecv(pfd.fd, buffer.data(), static_cast<int>(buffer.size()))) {
+                    ::close(pfd.fd);
+                    pfd.fd = -1;
+                    open--;
+                }
+            }
+        }
+    }
+}
+
+void serveEpoll(const std::vector<int> &fds)
+{
+    int epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    for (int fd : fds) {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    std::vector<char> buffer(uringBufferSize);
+    size_t open = fds.size();
+    while (open > 0) {
+        struct epoll_event events[256];
+        int n = ::epoll_wait(epollFd, events, 256, -1);
+        if (n < 0 && errno != EINTR) {
+            fail("epoll_wait");
+        }
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (!serveRecv(fd, buffer.data(), static_cast<int>(buffer.size()))) {
+                ::close(fd);
+                open--;
+            }
+        }
+    }
+
+    ::close(epollFd);
+}
+
+void serveUring(const std::vector<int> &fds)
+{
+    Uring uring;
+    if (!uring.open(uringEntries)) {
+        fail("io_uring_setup");
+    }
+    if (!uring.setupBuffers(uringBufferGroup, uringBufferCount, uringBufferSize)) {
+        fail("IORING_OP_PROVIDE_BUFFERS");
+    }
+    for (int fd : fds) {
+        uring.prepareMultishotRecv(fd, static_cast<uint64_t>(fd) + 1);
+    }
+
+    size_t open = fds.size();
+    while (open > 0) {
+        if (uring.submit(1) < 0 && errno != EBUSY && errno != EAGAIN && errno != EINTR) {
+            fail("io_uring_enter");
+        }
+
+        uring.handleCompletions([&](const struct io_uring_cqe &cqe) {
+            if (cqe.user_data == 0) {
+                return;
+            }
+
+            const int fd = static_cast<int>(cqe.user_data - 1);
+            if (cqe.flags & IORING_CQE_F_BUFFER) {
+                uint16_t id = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+                if (cqe.res > 0) {
+                    echo(fd, uring.buffer(id), cqe.res);
+                }
+                uring.recycleBuffer(id);
+            }
+
+            if (cqe.flags & IORING_CQE_F_MORE) {
+                return;
+            }
+            if (cqe.res > 0 || cqe.res == -ENOBUFS) {
+                uring.prepareMultishotRecv(fd, cqe.user_data);
+            } else {
+                ::close(fd);
+                open--;
+            }
+        });
+    }
+}
+
+struct Result
+{
+    long rounds;
+    double seconds;
+    double medianUs;
+    double p99Us;
+};
+
+Result runClients(uint16_t port, int connections, double seconds)
+{
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    std::vector<int> fds;
+    int epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    for (int i = 0; i < connections; ++i) {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0 || ::connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0) {
+            fail("connect");
+        }
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+        fds.push_back(fd);
+    }
+
+    char message[messageSize];
+    memset(message, 'x', sizeof(message));
+    std::vector<char> buffer(uringBufferSize);
+    std::vector<double> rounds;
+    const double start = nowUs();
+    while (nowUs() - start < seconds * 1e6) {
+        const double roundStart = nowUs();
+        for (int fd : fds) {
+            echo(fd, message, messageSize);
+        }
+
+        long expected = static_cast<long>(connections) * messageSize;
+        while (expected > 0) {
+            struct epoll_event events[256];
+            int n = ::epoll_wait(epollFd, events, 256, -1);
+            for (int i = 0; i < n; ++i) {
+                ssize_t ret = ::recv(events[i].data.fd, buffer.data(), buffer.size(), 0);
+                if (ret <= 0) {
+                    fail("recv");
+                }
+                expected -= ret;
+            }
+        }
+        rounds.push_back(nowUs() - roundStart);
+    }
+
+    const double elapsed = (nowUs() - start) / 1e6;
+    for (int fd : fds) {
+        ::close(fd);
+    }
+    ::close(epollFd);
+
+    std::sort(rounds.begin(), rounds.end());
+    Result result;
+    result.rounds = static_cast<long>(rounds.size());
+    result.seconds = elapsed;
+    result.medianUs = rounds[rounds.size() / 2];
+    result.p99Us = rounds[std::min(rounds.size() - 1, rounds.size() * 99 / 100)];
+    return result;
+}
+
+void benchmark(const std::string &backend, int connections, double seconds)
+{
+    int listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(addr);
+    if (::bind(listenFd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0
+        || ::listen(listenFd, SOMAXCONN) < 0
+        || ::getsockname(listenFd, reinterpret_cast<struct sockaddr *>(&addr), &length) < 0) {
+        fail("listen");
+    }
+
+    // The result comes back through a pipe, the child owns only the client ends.
+    int results[2];
+    if (::pipe(results) < 0) {
+        fail("pipe");
+    }
+    pid_t child = ::fork();
+    if (child == 0) {
+        ::close(listenFd);
+        ::close(results[0]);
+        Result result = runClients(ntohs(addr.sin_port), connections, seconds);
+        if (::write(results[1], &result, sizeof(result)) != sizeof(result)) {
+            fail("write");
+        }
+        _exit(0);
+    }
+    ::close(results[1]);
+
+    std::vector<int> fds;
+    while (static_cast<int>(fds.size()) < connections) {
+        int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            fail("accept");
+        }
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        fds.push_back(fd);
+    }
+    ::close(listenFd);
+
+    if (backend == "poll") {
+        servePoll(fds);
+    } else if (backend == "epoll") {
+        serveEpoll(fds);
+    } else {
+        serveUring(fds);
+    }
+
+    Result result;
+    if (::read(results[0], &result, sizeof(result)) != sizeof(result)) {
+        fail("read");
+    }
+    ::close(results[0]);
+    ::waitpid(child, nullptr, 0);
+
+    const double messages = static_cast<double>(result.rounds) * connections;
+    printf("%-6s %6d connections  %9.0f messages/s  round median %9.1f us  p99 %9.1f us\n",
+           backend.c_str(),
+           connections,
+           messages / result.seconds,
+           result.medianUs,
+           result.p99Us);
+    fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    double seconds = argc > 1 ? atof(argv[1]) : 3.0;
+    std::vector<int> connections;
+    for (int i = 2; i < argc; ++i) {
+        connections.push_back(atoi(argv[i]));
+    }
+    if (connections.empty()) {
+        connections = {1, 100, 10000};
+    }
+
+    // Both processes hold one fd per connection.
+    struct rlimit limit;
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    ::signal(SIGPIPE, SIG_IGN);
+
+    for (int count : connections) {
+        for (const char *backend : {"poll", "epoll", "uring"}) {
+            benchmark(backend, count, seconds);
+        }
+    }
+    return 0;
+}
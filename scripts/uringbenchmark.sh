@@ -0,0 +1,9 @@
+#!/bin/bash
+
+# Builds the io_uring benchmark and runs it at 1, 100 and 10k connections. The first argument is
+# the number of seconds per run, the others override the connection counts. 10k connections need
+# 10k open files in each process, raise the hard limit (ulimit -Hn) if it is lower.
+cd "$(dirname "$0")" || exit 1
+g++ -O2 -std=c++17 -I../src/device/linux uringbenchmark.cpp ../src/device/linux/uring.cpp \
+  -o /tmp/uringbenchmark || exit 1
+/tmp/uringbenchmark "${@:-3}"
@@ -58,6 +58,7 @@ QList<int> supportedDeviceTypes()
     if (deviceTypes.isEmpty()) {
 #ifdef X_ENABLE_SERIAL_PORT
         deviceTypes << static_cast<int>(DeviceType::SerialPort);
+        deviceTypes << static_cast<int>(DeviceType::SerialPortSniffer);
 #endif
 #ifdef X_ENABLE_BLUETOOTH
         deviceTypes << static_cast<int>(DeviceType::BleCentral);
@@ -69,12 +70,23 @@ QList<int> supportedDeviceTypes()
         deviceTypes << static_cast<int>(DeviceType::UdpServer);
         deviceTypes << static_cast<int>(DeviceType::TcpClient);
         deviceTypes << static_cast<int>(DeviceType::TcpServer);
+#ifdef X_ENABLE_SSL
+        deviceTypes << static_cast<int>(DeviceType::SslTcpClient);
+        deviceTypes << static_cast<int>(DeviceType::SslTcpServer);
+#endif
+#ifdef X_ENABLE_LINUX_NATIVE
+        deviceTypes << static_cast<int>(DeviceType::TcpProxy);
+        deviceTypes << static_cast<int>(DeviceType::MulticastReceiver);
+        deviceTypes << static_cast<int>(DeviceType::SharedMemory);
+#endif
 #ifdef X_ENABLE_WEB_SOCKET
         deviceTypes << static_cast<int>(DeviceType::WebSocketClient);
         deviceTypes << static_cast<int>(DeviceType::WebSocketServer);
 #endif
         deviceTypes << static_cast<int>(DeviceType::LocalSocket);
         deviceTypes << static_cast<int>(DeviceType::LocalServer);
+        deviceTypes << static_cast<int>(DeviceType::Replay);
+        deviceTypes << static_cast<int>(DeviceType::Generator);
         deviceTypes << static_cast<int>(DeviceType::ChartsTest);
     }
 
@@ -98,6 +110,16 @@ QString deviceName(int type)
         return QObject::tr("TCP Client");
     case static_cast<int>(DeviceType::TcpServer):
         return QObject::tr("TCP Server");
+    case static_cast<int>(DeviceType::SslTcpClient):
+        return QObject::tr("TLS TCP Client");
+    case static_cast<int>(DeviceType::SslTcpServer):
+        return QObject::tr("TLS TCP Server");
+    case static_cast<int>(DeviceType::TcpProxy):
+        return QObject::tr("TCP Proxy");
+    case static_cast<int>(DeviceType::MulticastReceiver):
+        return QObject::tr("Multicast Receiver");
+    case static_cast<int>(DeviceType::SharedMemory):
+        return QObject::tr("Shared Memory");
     case static_cast<int>(DeviceType::WebSocketClient):
         return QObject::tr("WebSocket Client");
     case static_cast<int>(DeviceType::WebSocketServer):
@@ -106,6 +128,12 @@ QString deviceName(int type)
         return QObject::tr("Local Socket");
     case static_cast<int>(DeviceType::LocalServer):
         return QObject::tr("Local Server");
+    case static_cast<int>(DeviceType::Replay):
+        return QObject::tr("Replay");
+    case static_cast<int>(DeviceType::Generator):
+        return QObject::tr("Generator");
+    case static_cast<int>(DeviceType::SerialPortSniffer):
+        return QObject::tr("Serial Port Sniffer");
     case static_cast<int>(DeviceType::ChartsTest):
         return QObject::tr("Charts Test");
     default:
@@ -432,6 +460,28 @@ void setupWebSocketDataChannel(QComboBox *comboBox)
     }
 }
 
+QString outboundQueuePolicyName(OutboundQueuePolicy policy)
+{
+    if (policy == OutboundQueuePolicy::DropOldest) {
+        return QObject::tr("Drop Oldest");
+    } else if (policy == OutboundQueuePolicy::DisconnectSlowConsumer) {
+        return QObject::tr("Disconnect Slow Consumer");
+    }
+
+    return "Unknown";
+}
+
+void setupOutboundQueuePolicy(QComboBox *comboBox)
+{
+    if (comboBox) {
+        comboBox->clear();
+        auto dropOldest = OutboundQueuePolicy::DropOldest;
+        auto disconnect = OutboundQueuePolicy::DisconnectSlowConsumer;
+        comboBox->addItem(outboundQueuePolicyName(dropOldest), static_cast<int>(dropOldest));
+        comboBox->addItem(outboundQueuePolicyName(disconnect), static_cast<int>(disconnect));
+    }
+}
+
 QList<int> supportedResponseOptions()
 {
     static QList<int> list;
@@ -620,6 +670,11 @@ SerialPortItem defaultSerialPortItem()
     context.ignoredBusyDevices = false;
     context.ignoredBusyDevices = false;
     context.optimizedFrame = false;
+    context.frameGap = 0;
+    context.autoFrameGap = false;
+    context.nativeBackend = false;
+    context.lowLatency = false;
+    context.ioUring = false;
 
     return context;
 }
@@ -636,6 +691,11 @@ QJsonObject saveSerialPortItem(const SerialPortItem &context)
     obj.insert(keys.flowControl, context.flowControl);
     obj.insert(keys.ignoredBusyDevices, context.ignoredBusyDevices);
     obj.insert(keys.optimizedFrame, context.optimizedFrame);
+    obj.insert(keys.frameGap, context.frameGap);
+    obj.insert(keys.autoFrameGap, context.autoFrameGap);
+    obj.insert(keys.nativeBackend, context.nativeBackend);
+    obj.insert(keys.lowLatency, context.lowLatency);
+    obj.insert(keys.ioUring, context.ioUring);
     return obj;
 }
 
@@ -651,6 +711,11 @@ SerialPortItem loadSerialPortItem(const QJsonObject &obj)
     ctx.flowControl = obj.value(keys.flowControl).toInt();
     ctx.ignoredBusyDevices = obj.value(keys.ignoredBusyDevices).toBool();
     ctx.optimizedFrame = obj.value(keys.optimizedFrame).toBool();
+    ctx.frameGap = obj.value(keys.frameGap).toInt();
+    ctx.autoFrameGap = obj.value(keys.autoFrameGap).toBool();
+    ctx.nativeBackend = obj.value(keys.nativeBackend).toBool();
+    ctx.lowLatency = obj.value(keys.lowLatency).toBool();
+    ctx.ioUring = obj.value(keys.ioUring).toBool();
     return ctx;
 }
 
@@ -724,6 +789,26 @@ SocketItem defaultSocketItem()
     item.multicastPort = 53625;
     item.enableMulticast = false;
     item.justMulticast = false;
+    item.workerThreads = 0;
+    item.queueLimit = 1024;
+    item.queuePolicy = OutboundQueuePolicy::DropOldest;
+    item.lowLatency = false;
+    item.certificate = "";
+    item.privateKey = "";
+    item.verifyPeer = false;
+    item.targetAddress = "127.0.0.1";
+    item.targetPort = 54688;
+    item.sampleInterval = 0;
+    item.ioUring = false;
+    item.idleTimeout = 60;
+    item.multicastGroups = "239.168.3.255";
+    item.multicastInterfaces = "";
+    item.sequenceOffset = -1;
+    item.sequenceWidth = 4;
+    item.timestampOffset = -1;
+    item.compression = false;
+    item.compressionThreshold = 256;
+    item.contextTakeover = true;
     return item;
 }
 
@@ -741,6 +826,26 @@ QVariantMap saveSocketItem(const SocketItem &context)
     obj.insert(keys.multicastPort, context.multicastPort);
     obj.insert(keys.enableMulticast, context.enableMulticast);
     obj.insert(keys.justMulticast, context.justMulticast);
+    obj.insert(keys.workerThreads, context.workerThreads);
+    obj.insert(keys.queueLimit, context.queueLimit);
+    obj.insert(keys.queuePolicy, static_cast<int>(context.queuePolicy));
+    obj.insert(keys.lowLatency, context.lowLatency);
+    obj.insert(keys.certificate, context.certificate);
+    obj.insert(keys.privateKey, context.privateKey);
+    obj.insert(keys.verifyPeer, context.verifyPeer);
+    obj.insert(keys.targetAddress, context.targetAddress);
+    obj.insert(keys.targetPort, context.targetPort);
+    obj.insert(keys.sampleInterval, context.sampleInterval);
+    obj.insert(keys.ioUring, context.ioUring);
+    obj.insert(keys.idleTimeout, context.idleTimeout);
+    obj.insert(keys.multicastGroups, context.multicastGroups);
+    obj.insert(keys.multicastInterfaces, context.multicastInterfaces);
+    obj.insert(keys.sequenceOffset, context.sequenceOffset);
+    obj.insert(keys.sequenceWidth, context.sequenceWidth);
+    obj.insert(keys.timestampOffset, context.timestampOffset);
+    obj.insert(keys.compression, context.compression);
+    obj.insert(keys.compressionThreshold, context.compressionThreshold);
+    obj.insert(keys.contextTakeover, context.contextTakeover);
     return obj;
 }
 
@@ -758,6 +863,26 @@ SocketItem loadSocketItem(const QVariantMap &obj)
     ctx.multicastPort = obj.value(keys.multicastPort).toInt();
     ctx.enableMulticast = obj.value(keys.enableMulticast).toBool();
     ctx.justMulticast = obj.value(keys.justMulticast).toBool();
+    ctx.workerThreads = obj.value(keys.workerThreads).toInt();
+    ctx.queueLimit = obj.value(keys.queueLimit, 1024).toInt();
+    ctx.queuePolicy = static_cast<OutboundQueuePolicy>(obj.value(keys.queuePolicy).toInt());
+    ctx.lowLatency = obj.value(keys.lowLatency).toBool();
+    ctx.certificate = obj.value(keys.certificate).toString();
+    ctx.privateKey = obj.value(keys.privateKey).toString();
+    ctx.verifyPeer = obj.value(keys.verifyPeer).toBool();
+    ctx.targetAddress = obj.value(keys.targetAddress, "127.0.0.1").toString();
+    ctx.targetPort = obj.value(keys.targetPort, 54688).toInt();
+    ctx.sampleInterval = obj.value(keys.sampleInterval).toInt();
+    ctx.ioUring = obj.value(keys.ioUring).toBool();
+    ctx.idleTimeout = obj.value(keys.idleTimeout, 60).toInt();
+    ctx.multicastGroups = obj.value(keys.multicastGroups, "239.168.3.255").toString();
+    ctx.multicastInterfaces = obj.value(keys.multicastInterfaces).toString();
+    ctx.sequenceOffset = obj.value(keys.sequenceOffset, -1).toInt();
+    ctx.sequenceWidth = obj.value(keys.sequenceWidth, 4).toInt();
+    ctx.timestampOffset = obj.value(keys.timestampOffset, -1).toInt();
+    ctx.compression = obj.value(keys.compression, false).toBool();
+    ctx.compressionThreshold = obj.value(keys.compressionThreshold, 256).toInt();
+    ctx.contextTakeover = obj.value(keys.contextTakeover, true).toBool();
     return ctx;
 }
 
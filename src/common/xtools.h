@@ -1,4 +1,4 @@
-/***************************************************************************************************
+﻿/***************************************************************************************************
  * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
  *
  * The file is encoded in "utf8 with bom", it is a part of xTools project.
@@ -16,12 +16,6 @@
 
 /**************************************************************************************************/
 // Compatibility
-#if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
-#define xWebSocketErrorOccurred &QWebSocket::errorOccurred
-#else
-#define xWebSocketErrorOccurred qOverload<QAbstractSocket::SocketError>(&QWebSocket::error)
-#endif
-
 #if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
 #define xEnableColorScheme 1
 #else
@@ -53,6 +47,14 @@ enum class DeviceType {
     WebSocketServer,
     LocalSocket,
     LocalServer,
+    SerialPortSniffer,
+    SslTcpClient,
+    SslTcpServer,
+    TcpProxy,
+    MulticastReceiver,
+    SharedMemory,
+    Replay,
+    Generator,
     //----------------------------------------------------------------------------------------------
     Hid = 0x00200000,
     SctpClient,
@@ -93,6 +95,11 @@ enum class WebSocketDataChannel { Text, Binary };
 QString webSocketDataChannelName(WebSocketDataChannel channel);
 void setupWebSocketDataChannel(QComboBox *comboBox);
 
+/**************************************************************************************************/
+enum class OutboundQueuePolicy { DropOldest, DisconnectSlowConsumer };
+QString outboundQueuePolicyName(OutboundQueuePolicy policy);
+void setupOutboundQueuePolicy(QComboBox *comboBox);
+
 /**************************************************************************************************/
 enum class ResponseOption {
     Echo,   // Response data is the data received.
@@ -153,6 +160,11 @@ struct SerialPortItem
     int flowControl;
     bool ignoredBusyDevices;
     bool optimizedFrame;
+    int frameGap; // The idle gap(us) that terminates a frame, 0 means 3.5 characters.
+    bool autoFrameGap; // Apply the frame gap proposed by the inter-byte gap analyser.
+    bool nativeBackend; // Linux only, use termios2 and epoll instead of QSerialPort.
+    bool lowLatency;    // Native backend only, ASYNC_LOW_LATENCY and a 1ms FTDI latency timer.
+    bool ioUring;       // Native backend only, the reader waits on io_uring instead of epoll.
 };
 struct SerialPortItemKeys
 {
@@ -164,6 +176,11 @@ struct SerialPortItemKeys
     const QString flowControl{"flowControl"};
     const QString ignoredBusyDevices{"ignoredBusyDevices"};
     const QString optimizedFrame{"optimizedFrame"};
+    const QString frameGap{"frameGap"};
+    const QString autoFrameGap{"autoFrameGap"};
+    const QString nativeBackend{"nativeBackend"};
+    const QString lowLatency{"lowLatency"};
+    const QString ioUring{"ioUring"};
 };
 SerialPortItem defaultSerialPortItem();
 QJsonObject saveSerialPortItem(const SerialPortItem &context);
@@ -190,6 +207,26 @@ struct SocketItem
     quint16 multicastPort;
     bool enableMulticast;
     bool justMulticast;
+    int workerThreads; // TCP server only, 0 means the Qt backend is used
+    int queueLimit;    // KiB per client, 0 means unlimited
+    OutboundQueuePolicy queuePolicy;
+    bool lowLatency;
+    QString certificate; // TLS, the server certificate or the CA certificate of the client
+    QString privateKey;  // TLS server only
+    bool verifyPeer;
+    QString targetAddress; // TCP proxy, the connections are forwarded to the target
+    quint16 targetPort;
+    int sampleInterval; // TCP proxy, ms between sampled copies, 0 means nothing is sampled
+    bool ioUring;       // TCP server worker threads only, io_uring instead of epoll
+    int idleTimeout;    // UDP server, s without a datagram before a peer is dropped, 0 means never
+    QString multicastGroups;     // Multicast receiver, "group" or "group@source", comma separated
+    QString multicastInterfaces; // Multicast receiver, interface names, empty means the default
+    int sequenceOffset;  // UDP, offset of the sequence number of a datagram, -1 means no analysis
+    int sequenceWidth;   // UDP, bytes of the sequence number(big endian)
+    int timestampOffset; // UDP, offset of a 64 bit sender timestamp(us, big endian), -1 means none
+    bool compression;         // WebSocket, permessage-deflate
+    int compressionThreshold; // WebSocket, bytes, smaller messages are not compressed
+    bool contextTakeover;     // WebSocket, the compression window is kept from message to message
 };
 struct SocketItemKeys
 {
@@ -203,6 +240,26 @@ struct SocketItemKeys
     const QString multicastPort{"multicastPort"};
     const QString enableMulticast{"enableMulticast"};
     const QString justMulticast{"justMulticast"};
+    const QString workerThreads{"workerThreads"};
+    const QString queueLimit{"queueLimit"};
+    const QString queuePolicy{"queuePolicy"};
+    const QString lowLatency{"lowLatency"};
+    const QString certificate{"certificate"};
+    const QString privateKey{"privateKey"};
+    const QString verifyPeer{"verifyPeer"};
+    const QString targetAddress{"targetAddress"};
+    const QString targetPort{"targetPort"};
+    const QString sampleInterval{"sampleInterval"};
+    const QString ioUring{"ioUring"};
+    const QString idleTimeout{"idleTimeout"};
+    const QString multicastGroups{"multicastGroups"};
+    const QString multicastInterfaces{"multicastInterfaces"};
+    const QString sequenceOffset{"sequenceOffset"};
+    const QString sequenceWidth{"sequenceWidth"};
+    const QString timestampOffset{"timestampOffset"};
+    const QString compression{"compression"};
+    const QString compressionThreshold{"compressionThreshold"};
+    const QString contextTakeover{"contextTakeover"};
 };
 SocketItem defaultSocketItem();
 QVariantMap saveSocketItem(const SocketItem &context);
@@ -59,6 +59,11 @@ void Device::load(const QVariantMap &parameters)
     m_parametersMutex.unlock();
 }
 
+QList<QPair<QString, QString>> Device::metrics() const
+{
+    return QList<QPair<QString, QString>>();
+}
+
 void Device::run()
 {
     QObject *obj = initDevice();
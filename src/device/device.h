@@ -8,7 +8,9 @@
  **************************************************************************************************/
 #pragma once
 
+#include <QList>
 #include <QMutex>
+#include <QPair>
 #include <QThread>
 #include <QVariantMap>
 
@@ -27,6 +29,9 @@ public:
     Q_INVOKABLE virtual void load(const QVariantMap &parameters);
     virtual QObject *initDevice() { return nullptr; };
     virtual void deinitDevice() {};
+    // Label-value pairs such as handshake times or throughput, they are polled by
+    // DeviceMetricsView from the ui thread.
+    virtual QList<QPair<QString, QString>> metrics() const;
 
 signals:
     void opened();
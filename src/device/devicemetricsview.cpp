@@ -0,0 +1,59 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "devicemetricsview.h"
+
+#include "device.h"
+
+DeviceMetricsView::DeviceMetricsView(Device *device, QWidget *parent)
+    : QWidget(parent)
+    , m_device(device)
+{
+    m_layout = new QFormLayout(this);
+    m_layout->setContentsMargins(0, 0, 0, 0);
+
+    QTimer *refreshTimer = new QTimer(this);
+    refreshTimer->setInterval(500);
+    connect(refreshTimer, &QTimer::timeout, this, [=]() {
+        if (isVisible()) {
+            refresh();
+        }
+    });
+    refreshTimer->start();
+    refresh();
+}
+
+DeviceMetricsView::~DeviceMetricsView() {}
+
+void DeviceMetricsView::refresh()
+{
+    QList<QPair<QString, QString>> metrics = m_device->metrics();
+    QStringList labels;
+    for (const auto &metric : metrics) {
+        labels.append(metric.first);
+    }
+
+    // The rows are only rebuilt when the set of metrics changes, e.g. after reopening the device.
+    if (labels != m_labels) {
+        while (m_layout->rowCount() > 0) {
+            m_layout->removeRow(0);
+        }
+        m_values.clear();
+        for (const QString &label : labels) {
+            QLabel *value = new QLabel(this);
+            value->setTextInteractionFlags(Qt::TextSelectableByMouse);
+            m_layout->addRow(label, value);
+            m_values.append(value);
+        }
+        m_labels = labels;
+    }
+
+    for (int i = 0; i < metrics.size(); ++i) {
+        m_values.at(i)->setText(metrics.at(i).second);
+    }
+}
@@ -0,0 +1,32 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QFormLayout>
+#include <QLabel>
+#include <QTimer>
+#include <QWidget>
+
+class Device;
+class DeviceMetricsView : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit DeviceMetricsView(Device *device, QWidget *parent = nullptr);
+    ~DeviceMetricsView() override;
+
+private:
+    Device *m_device;
+    QFormLayout *m_layout;
+    QList<QLabel *> m_values;
+    QStringList m_labels;
+
+private:
+    void refresh();
+};
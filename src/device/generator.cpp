@@ -0,0 +1,278 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "generator.h"
+
+#include <QJsonObject>
+#include <QLocale>
+#include <QtEndian>
+
+#include "common/xtools.h"
+
+Generator::Generator(QObject *parent)
+    : Device(parent)
+{}
+
+Generator::~Generator() {}
+
+QList<int> Generator::supportedArrivals()
+{
+    return QList<int>{static_cast<int>(Arrival::Constant),
+                      static_cast<int>(Arrival::Burst),
+                      static_cast<int>(Arrival::Poisson)};
+}
+
+QString Generator::arrivalName(int arrival)
+{
+    switch (arrival) {
+    case static_cast<int>(Arrival::Constant):
+        return tr("Constant");
+    case static_cast<int>(Arrival::Burst):
+        return tr("Burst");
+    case static_cast<int>(Arrival::Poisson):
+        return tr("Poisson");
+    default:
+        return "Unknown";
+    }
+}
+
+QList<int> Generator::supportedSizeDistributions()
+{
+    return QList<int>{static_cast<int>(SizeDistribution::Fixed),
+                      static_cast<int>(SizeDistribution::Uniform),
+                      static_cast<int>(SizeDistribution::Normal)};
+}
+
+QString Generator::sizeDistributionName(int distribution)
+{
+    switch (distribution) {
+    case static_cast<int>(SizeDistribution::Fixed):
+        return tr("Fixed");
+    case static_cast<int>(SizeDistribution::Uniform):
+        return tr("Uniform");
+    case static_cast<int>(SizeDistribution::Normal):
+        return tr("Normal");
+    default:
+        return "Unknown";
+    }
+}
+
+QList<int> Generator::supportedPatterns()
+{
+    return QList<int>{static_cast<int>(Pattern::Counter),
+                      static_cast<int>(Pattern::Random),
+                      static_cast<int>(Pattern::Fixed),
+                      static_cast<int>(Pattern::Template)};
+}
+
+QString Generator::patternName(int pattern)
+{
+    switch (pattern) {
+    case static_cast<int>(Pattern::Counter):
+        return tr("Counter");
+    case static_cast<int>(Pattern::Random):
+        return tr("Random");
+    case static_cast<int>(Pattern::Fixed):
+        return tr("Fixed");
+    case static_cast<int>(Pattern::Template):
+        return tr("Template");
+    default:
+        return "Unknown";
+    }
+}
+
+QObject *Generator::initDevice()
+{
+    QVariantMap parameters = save();
+    GeneratorParametersKeys keys;
+    m_rate = qBound(0.001, parameters.value(keys.rate, 1000).toDouble(), 100.0 * 1000 * 1000);
+    m_interval = 1e9 / m_rate;
+    m_arrival = static_cast<Arrival>(parameters.value(keys.arrival).toInt());
+    m_burstSize = qMax(1, parameters.value(keys.burstSize, 1).toInt());
+    m_sizeDistribution = static_cast<SizeDistribution>(
+        parameters.value(keys.sizeDistribution).toInt());
+    m_minSize = qMax(0, parameters.value(keys.minSize, 64).toInt());
+    m_maxSize = qMax(m_minSize, parameters.value(keys.maxSize, 64).toInt());
+    m_pattern = static_cast<Pattern>(parameters.value(keys.pattern).toInt());
+    m_fillByte = static_cast<char>(parameters.value(keys.fillByte, 0x55).toInt());
+    m_batch = qMax(1, parameters.value(keys.batch, 1).toInt());
+
+    const QVariantMap textItem = parameters.value(keys.textItem).toMap();
+    m_template = textItem2array(textItem.isEmpty()
+                                    ? defaultTextItem()
+                                    : loadTextItem(QJsonObject::fromVariantMap(textItem)));
+
+    const quint32 seed = parameters.value(keys.seed, 0).toUInt();
+    m_random.seed(seed ? seed : QRandomGenerator::global()->generate());
+    m_exponential = std::exponential_distribution<double>(m_rate / 1e9);
+    m_normal = std::normal_distribution<double>((m_minSize + m_maxSize) / 2.0,
+                                                qMax(1.0, (m_maxSize - m_minSize) / 6.0));
+
+    // Random frames are slices of a pool, filling every frame would be slower than the consumers.
+    m_randomPool.clear();
+    if (m_pattern == Pattern::Random) {
+        m_randomPool.resize((m_maxSize / 4 + 16 * 1024) * 4);
+        m_random.fillRange(reinterpret_cast<quint32 *>(m_randomPool.data()),
+                           m_randomPool.size() / 4);
+    }
+
+    m_flag = tr("Generator");
+    m_byteMeter.reset();
+    m_frameMeter.reset();
+    m_missed = 0;
+    m_lag = 0;
+    m_sequence = 0;
+    m_burstIndex = 0;
+    m_next = 0;
+    m_clock.start();
+
+    m_timer = new QTimer();
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, m_timer, [this]() { generateFrames(); });
+    m_timer->start(0);
+
+    qInfo() << "Generating" << m_rate << "frames per second,"
+            << arrivalName(static_cast<int>(m_arrival)) << "arrival,"
+            << patternName(static_cast<int>(m_pattern)) << "pattern";
+    return m_timer;
+}
+
+void Generator::deinitDevice()
+{
+    if (m_timer) {
+        m_timer->stop();
+        m_timer->deleteLater();
+        m_timer = nullptr;
+    }
+}
+
+QList<QPair<QString, QString>> Generator::metrics() const
+{
+    QLocale locale;
+    QList<QPair<QString, QString>> list;
+    list.append(qMakePair(tr("Generated"),
+                          tr("%1, %2 now, %3 sustained")
+                              .arg(locale.formattedDataSize(m_byteMeter.totalBytes()),
+                                   ThroughputMeter::formattedRate(m_byteMeter.bytesPerSecond()),
+                                   ThroughputMeter::formattedRate(
+                                       m_byteMeter.averageBytesPerSecond()))));
+    list.append(qMakePair(tr("Frames"),
+                          tr("%1, %2/s now, %3/s sustained")
+                              .arg(locale.toString(m_frameMeter.totalBytes()),
+                                   locale.toString(m_frameMeter.bytesPerSecond()),
+                                   locale.toString(m_frameMeter.averageBytesPerSecond()))));
+    list.append(qMakePair(tr("Missed"), locale.toString(m_missed.load())));
+    list.append(qMakePair(tr("Behind schedule"),
+                          tr("%1 ms").arg(locale.toString(m_lag / 1000000.0, 'f', 3))));
+    return list;
+}
+
+void Generator::generateFrames()
+{
+    // Everything due is generated at once, a timer of 1 ms is enough for any rate.
+    const qint64 now = m_clock.nsecsElapsed();
+    if (now - m_next > maxLag) {
+        m_missed += static_cast<qint64>((now - m_next) / m_interval);
+        m_next = now;
+    }
+
+    QByteArray bytes;
+    int frames = 0;
+    int batchFrames = 0;
+    qint64 tickBytes = 0;
+    auto flush = [&]() {
+        tickBytes += bytes.size();
+        emit bytesRead(bytes, m_flag);
+        bytes = QByteArray();
+        batchFrames = 0;
+    };
+
+    m_lag = qMax<qint64>(0, now - static_cast<qint64>(m_next));
+    while (m_next <= now && frames < maxTickFrames && tickBytes < maxTickBytes) {
+        if (batchFrames == 0) {
+            const int size = m_pattern == Pattern::Template ? m_template.size() : m_maxSize;
+            bytes.reserve(static_cast<int>(
+                qMin(static_cast<qint64>(m_batch) * size, static_cast<qint64>(maxTickBytes))));
+        }
+
+        appendFrame(bytes);
+        frames += 1;
+        batchFrames += 1;
+        if (batchFrames == m_batch) {
+            flush();
+        }
+
+        advance();
+    }
+
+    if (batchFrames > 0) {
+        flush();
+    }
+
+    m_byteMeter.addBytes(tickBytes);
+    m_frameMeter.addBytes(frames);
+    const qint64 wait = qMax<qint64>(0, static_cast<qint64>(m_next) - m_clock.nsecsElapsed());
+    m_timer->start(static_cast<int>(qMin<qint64>(wait / 1000000, 1000)));
+}
+
+void Generator::appendFrame(QByteArray &bytes)
+{
+    if (m_pattern == Pattern::Template) {
+        bytes.append(m_template);
+        m_sequence += 1;
+        return;
+    }
+
+    const int size = frameSize();
+    if (m_pattern == Pattern::Random) {
+        const int offset = static_cast<int>(m_random.bounded(m_randomPool.size() - size + 1));
+        bytes.append(m_randomPool.constData() + offset, size);
+    } else if (m_pattern == Pattern::Fixed) {
+        bytes.append(size, m_fillByte);
+    } else {
+        const int offset = bytes.size();
+        bytes.resize(offset + size);
+        uchar *data = reinterpret_cast<uchar *>(bytes.data()) + offset;
+        for (int i = 0; i < size; ++i) {
+            data[i] = static_cast<uchar>(m_sequence + i);
+        }
+        if (size >= 8) {
+            qToBigEndian<quint64>(m_sequence, data);
+        }
+    }
+
+    m_sequence += 1;
+}
+
+int Generator::frameSize()
+{
+    if (m_sizeDistribution == SizeDistribution::Uniform) {
+        return static_cast<int>(m_random.bounded(m_minSize, m_maxSize + 1));
+    } else if (m_sizeDistribution == SizeDistribution::Normal && m_maxSize > m_minSize) {
+        return qBound(m_minSize, qRound(m_normal(m_random)), m_maxSize);
+    }
+
+    return m_minSize;
+}
+
+void Generator::advance()
+{
+    if (m_arrival == Arrival::Poisson) {
+        m_next += m_exponential(m_random);
+    } else if (m_arrival == Arrival::Burst) {
+        // The frames of a burst are due at once, the bursts keep the average rate.
+        m_burstIndex += 1;
+        if (m_burstIndex == m_burstSize) {
+            m_burstIndex = 0;
+            m_next += m_interval * m_burstSize;
+        }
+    } else {
+        m_next += m_interval;
+    }
+}
@@ -0,0 +1,107 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <random>
+
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QTimer>
+
+#include "device.h"
+#include "utilities/throughputmeter.h"
+
+struct GeneratorParametersKeys
+{
+    const QString rate{"rate"}; // Frames per second
+    const QString arrival{"arrival"};
+    const QString burstSize{"burstSize"};
+    const QString sizeDistribution{"sizeDistribution"};
+    const QString minSize{"minSize"};
+    const QString maxSize{"maxSize"};
+    const QString pattern{"pattern"};
+    const QString fillByte{"fillByte"};
+    const QString textItem{"textItem"};
+    const QString batch{"batch"}; // Frames per bytesRead()
+    const QString seed{"seed"};   // 0 for a random seed
+};
+
+// A synthetic source for load tests and throughput benchmarks of the page and of everything behind
+// it. Frames are generated in the device thread at the configured rate and emitted with
+// bytesRead(), batch frames per signal. A counter frame starts with its big-endian 64-bit sequence
+// number. With a seed the same frames are generated on every run. Frames that can not be generated
+// in time are skipped after a second and counted as missed, so the rate never runs away.
+class Generator : public Device
+{
+    Q_OBJECT
+public:
+    enum class Arrival { Constant, Burst, Poisson };
+    Q_ENUM(Arrival);
+    enum class SizeDistribution { Fixed, Uniform, Normal };
+    Q_ENUM(SizeDistribution);
+    enum class Pattern { Counter, Random, Fixed, Template };
+    Q_ENUM(Pattern);
+
+public:
+    explicit Generator(QObject *parent = nullptr);
+    ~Generator() override;
+
+    static QList<int> supportedArrivals();
+    static QString arrivalName(int arrival);
+    static QList<int> supportedSizeDistributions();
+    static QString sizeDistributionName(int distribution);
+    static QList<int> supportedPatterns();
+    static QString patternName(int pattern);
+
+    QObject *initDevice() override;
+    void deinitDevice() override;
+    QList<QPair<QString, QString>> metrics() const override;
+
+private:
+    static const int maxTickFrames = 64 * 1024;
+    static const int maxTickBytes = 16 * 1024 * 1024;
+    static const qint64 maxLag = 1000 * 1000 * 1000; // ns
+
+private:
+    QTimer *m_timer{nullptr};
+    QElapsedTimer m_clock;
+    QString m_flag;
+    Arrival m_arrival{Arrival::Constant};
+    SizeDistribution m_sizeDistribution{SizeDistribution::Fixed};
+    Pattern m_pattern{Pattern::Counter};
+    double m_rate{1000};
+    double m_interval{0}; // ns
+    int m_burstSize{1};
+    int m_minSize{0};
+    int m_maxSize{0};
+    char m_fillByte{0};
+    int m_batch{1};
+    QByteArray m_template;
+    QByteArray m_randomPool;
+    QRandomGenerator m_random;
+    std::exponential_distribution<double> m_exponential;
+    std::normal_distribution<double> m_normal;
+
+    double m_next{0}; // ns of m_clock, of the next frame
+    int m_burstIndex{0};
+    quint64 m_sequence{0};
+
+    // Polled by metrics() from the ui thread
+    ThroughputMeter m_byteMeter;
+    ThroughputMeter m_frameMeter; // Counts frames
+    std::atomic<qint64> m_missed{0};
+    std::atomic<qint64> m_lag{0}; // ns
+
+private:
+    void generateFrames();
+    void appendFrame(QByteArray &bytes);
+    int frameSize();
+    void advance();
+};
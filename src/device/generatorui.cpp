@@ -0,0 +1,139 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "generatorui.h"
+#include "ui_generatorui.h"
+
+#include "common/xtools.h"
+#include "devicemetricsview.h"
+#include "generator.h"
+#include "page/utilities/textitemeditor.h"
+
+GeneratorUi::GeneratorUi(QWidget *parent)
+    : DeviceUi(parent)
+    , ui(new Ui::GeneratorUi)
+{
+    ui->setupUi(this);
+    for (int arrival : Generator::supportedArrivals()) {
+        ui->comboBoxArrival->addItem(Generator::arrivalName(arrival), arrival);
+    }
+    for (int distribution : Generator::supportedSizeDistributions()) {
+        ui->comboBoxSize->addItem(Generator::sizeDistributionName(distribution), distribution);
+    }
+    for (int pattern : Generator::supportedPatterns()) {
+        ui->comboBoxPattern->addItem(Generator::patternName(pattern), pattern);
+    }
+
+    m_textItem = saveTextItem(defaultTextItem());
+    updateTemplateLabel();
+    connect(ui->pushButtonTemplate,
+            &QPushButton::clicked,
+            this,
+            &GeneratorUi::onTemplateButtonClicked);
+}
+
+GeneratorUi::~GeneratorUi()
+{
+    delete m_metricsView;
+    delete ui;
+}
+
+QVariantMap GeneratorUi::save() const
+{
+    QVariantMap map = DeviceUi::save();
+    GeneratorParametersKeys keys;
+    map[keys.rate] = ui->spinBoxRate->value();
+    map[keys.arrival] = ui->comboBoxArrival->currentData().toInt();
+    map[keys.burstSize] = ui->spinBoxBurstSize->value();
+    map[keys.sizeDistribution] = ui->comboBoxSize->currentData().toInt();
+    map[keys.minSize] = ui->spinBoxMinSize->value();
+    map[keys.maxSize] = ui->spinBoxMaxSize->value();
+    map[keys.pattern] = ui->comboBoxPattern->currentData().toInt();
+    map[keys.fillByte] = ui->spinBoxFillByte->value();
+    map[keys.textItem] = m_textItem.toVariantMap();
+    map[keys.batch] = ui->spinBoxBatch->value();
+    map[keys.seed] = ui->spinBoxSeed->value();
+    return map;
+}
+
+void GeneratorUi::load(const QVariantMap &parameters)
+{
+    DeviceUi::load(parameters);
+    GeneratorParametersKeys keys;
+    auto setCurrentData = [](QComboBox *comboBox, const QVariant &data) {
+        int index = comboBox->findData(data.toInt());
+        comboBox->setCurrentIndex(index < 0 ? 0 : index);
+    };
+
+    ui->spinBoxRate->setValue(parameters.value(keys.rate, 1000).toInt());
+    setCurrentData(ui->comboBoxArrival, parameters.value(keys.arrival));
+    ui->spinBoxBurstSize->setValue(parameters.value(keys.burstSize, 1).toInt());
+    setCurrentData(ui->comboBoxSize, parameters.value(keys.sizeDistribution));
+    ui->spinBoxMinSize->setValue(parameters.value(keys.minSize, 64).toInt());
+    ui->spinBoxMaxSize->setValue(parameters.value(keys.maxSize, 64).toInt());
+    setCurrentData(ui->comboBoxPattern, parameters.value(keys.pattern));
+    ui->spinBoxFillByte->setValue(parameters.value(keys.fillByte, 0x55).toInt());
+    ui->spinBoxBatch->setValue(parameters.value(keys.batch, 1).toInt());
+    ui->spinBoxSeed->setValue(parameters.value(keys.seed, 0).toInt());
+
+    const QVariantMap textItem = parameters.value(keys.textItem).toMap();
+    if (!textItem.isEmpty()) {
+        m_textItem = QJsonObject::fromVariantMap(textItem);
+    }
+    updateTemplateLabel();
+}
+
+void GeneratorUi::setUiEnabled(bool enabled)
+{
+    const QList<QWidget *> widgets{ui->spinBoxRate,
+                                   ui->comboBoxArrival,
+                                   ui->spinBoxBurstSize,
+                                   ui->comboBoxSize,
+                                   ui->spinBoxMinSize,
+                                   ui->spinBoxMaxSize,
+                                   ui->comboBoxPattern,
+                                   ui->spinBoxFillByte,
+                                   ui->pushButtonTemplate,
+                                   ui->spinBoxBatch,
+                                   ui->spinBoxSeed};
+    for (QWidget *widget : widgets) {
+        widget->setEnabled(enabled);
+    }
+}
+
+QList<QWidget *> GeneratorUi::deviceControllers()
+{
+    if (!m_metricsView) {
+        m_metricsView = new DeviceMetricsView(device());
+    }
+
+    return QList<QWidget *>{m_metricsView};
+}
+
+Device *GeneratorUi::newDevice()
+{
+    return new Generator(this);
+}
+
+void GeneratorUi::onTemplateButtonClicked()
+{
+    TextItemEditor editor(this);
+    editor.setMinimumWidth(700);
+    editor.load(m_textItem);
+    if (editor.exec() == QDialog::Accepted) {
+        m_textItem = editor.save();
+        updateTemplateLabel();
+    }
+}
+
+void GeneratorUi::updateTemplateLabel()
+{
+    const QString text = textItem2string(loadTextItem(m_textItem));
+    ui->labelTemplate->setText(text);
+    ui->labelTemplate->setToolTip(text);
+}
@@ -0,0 +1,43 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QJsonObject>
+
+#include "deviceui.h"
+
+namespace Ui {
+class GeneratorUi;
+}
+
+class DeviceMetricsView;
+class GeneratorUi : public DeviceUi
+{
+    Q_OBJECT
+public:
+    explicit GeneratorUi(QWidget *parent = nullptr);
+    ~GeneratorUi() override;
+
+    QVariantMap save() const override;
+    void load(const QVariantMap &parameters) override;
+    void setUiEnabled(bool enabled) override;
+    QList<QWidget *> deviceControllers() override;
+
+protected:
+    Device *newDevice() override;
+
+private:
+    Ui::GeneratorUi *ui{nullptr};
+    DeviceMetricsView *m_metricsView{nullptr};
+    QJsonObject m_textItem;
+
+private:
+    void onTemplateButtonClicked();
+    void updateTemplateLabel();
+};
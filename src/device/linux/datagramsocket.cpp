@@ -0,0 +1,429 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "datagramsocket.h"
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <QSocketNotifier>
+
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+#ifndef IPV6_MULTICAST_ALL
+#define IPV6_MULTICAST_ALL 29
+#endif
+
+namespace {
+
+const int maxBatchesPerRead = 8;
+
+socklen_t toSockAddr(const QHostAddress &address,
+                     quint16 port,
+                     int family,
+                     struct sockaddr_storage *addr)
+{
+    memset(addr, 0, sizeof(*addr));
+    if (family == AF_INET6) {
+        // An IPv4 destination of an IPv6 socket is mapped(::ffff:a.b.c.d).
+        auto *addr6 = reinterpret_cast<struct sockaddr_in6 *>(addr);
+        addr6->sin6_family = AF_INET6;
+        addr6->sin6_port = htons(port);
+        Q_IPV6ADDR ip = address.toIPv6Address();
+        memcpy(&addr6->sin6_addr, &ip, sizeof(addr6->sin6_addr));
+        return sizeof(struct sockaddr_in6);
+    }
+
+    bool ok = false;
+    quint32 ip = address.toIPv4Address(&ok);
+    if (!ok) {
+        return 0;
+    }
+
+    auto *addr4 = reinterpret_cast<struct sockaddr_in *>(addr);
+    addr4->sin_family = AF_INET;
+    addr4->sin_port = htons(port);
+    addr4->sin_addr.s_addr = htonl(ip);
+    return sizeof(struct sockaddr_in);
+}
+
+quint16 portOf(const struct sockaddr_storage &addr)
+{
+    return addr.ss_family == AF_INET6
+               ? ntohs(reinterpret_cast<const struct sockaddr_in6 *>(&addr)->sin6_port)
+               : ntohs(reinterpret_cast<const struct sockaddr_in *>(&addr)->sin_port);
+}
+
+} // namespace
+
+// Allocated once per socket, every recvmmsg() reuses the buffers.
+struct DatagramSocket::Batch
+{
+    struct mmsghdr messages[batchSize];
+    struct iovec iovs[batchSize];
+    struct sockaddr_storage addrs[batchSize];
+    char controls[batchSize][CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(struct in_pktinfo))
+                             + CMSG_SPACE(sizeof(struct in6_pktinfo))
+                             + CMSG_SPACE(sizeof(quint32))];
+    QByteArray buffers{batchSize * bufferSize, Qt::Uninitialized};
+};
+
+DatagramSocket::DatagramSocket(QObject *parent)
+    : QObject(parent)
+{}
+
+DatagramSocket::~DatagramSocket()
+{
+    close();
+}
+
+bool DatagramSocket::open(QAbstractSocket::NetworkLayerProtocol protocol)
+{
+    return create(protocol == QAbstractSocket::IPv6Protocol ? AF_INET6 : AF_INET);
+}
+
+bool DatagramSocket::bind(const QHostAddress &address, quint16 port, bool reusePort)
+{
+    if (!create(address.protocol() == QAbstractSocket::IPv6Protocol ? AF_INET6 : AF_INET)) {
+        return false;
+    }
+
+    int on = 1;
+    ::setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (reusePort && ::setsockopt(m_fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0) {
+        setError();
+        close();
+        return false;
+    }
+
+    struct sockaddr_storage addr;
+    socklen_t addrLength = toSockAddr(address, port, m_family, &addr);
+    if (addrLength == 0
+        || ::bind(m_fd, reinterpret_cast<struct sockaddr *>(&addr), addrLength) < 0) {
+        setError();
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void DatagramSocket::close()
+{
+    delete m_notifier;
+    m_notifier = nullptr;
+    delete m_writeNotifier;
+    m_writeNotifier = nullptr;
+    delete m_batch;
+    m_batch = nullptr;
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+bool DatagramSocket::joinMulticastGroup(const QHostAddress &group,
+                                        int interfaceIndex,
+                                        const QHostAddress &source)
+{
+    // The protocol independent API(RFC 3678), the level is the one of the group, an IPv4 group can
+    // be joined by a dual stack socket as well.
+    const bool v6 = group.protocol() == QAbstractSocket::IPv6Protocol;
+    const int level = v6 ? IPPROTO_IPV6 : IPPROTO_IP;
+    const int family = v6 ? AF_INET6 : AF_INET;
+    int ret = -1;
+    if (source.isNull()) {
+        struct group_req req;
+        memset(&req, 0, sizeof(req));
+        req.gr_interface = static_cast<uint32_t>(interfaceIndex);
+        toSockAddr(group, 0, family, &req.gr_group);
+        ret = ::setsockopt(m_fd, level, MCAST_JOIN_GROUP, &req, sizeof(req));
+    } else {
+        struct group_source_req req;
+        memset(&req, 0, sizeof(req));
+        req.gsr_interface = static_cast<uint32_t>(interfaceIndex);
+        toSockAddr(group, 0, family, &req.gsr_group);
+        toSockAddr(source, 0, family, &req.gsr_source);
+        ret = ::setsockopt(m_fd, level, MCAST_JOIN_SOURCE_GROUP, &req, sizeof(req));
+    }
+
+    if (ret < 0) {
+        setError();
+        return false;
+    }
+
+    return true;
+}
+
+void DatagramSocket::setMulticastAll(bool enabled)
+{
+    int on = enabled ? 1 : 0;
+    ::setsockopt(m_fd, IPPROTO_IP, IP_MULTICAST_ALL, &on, sizeof(on));
+    if (m_family == AF_INET6) {
+        ::setsockopt(m_fd, IPPROTO_IPV6, IPV6_MULTICAST_ALL, &on, sizeof(on));
+    }
+}
+
+void DatagramSocket::setGro(bool enabled)
+{
+    // Linux 5.0 or later, the option is ignored otherwise.
+    int on = enabled ? 1 : 0;
+    ::setsockopt(m_fd, IPPROTO_UDP, UDP_GRO, &on, sizeof(on));
+}
+
+void DatagramSocket::setReceiveDestination(bool enabled)
+{
+    int on = enabled ? 1 : 0;
+    ::setsockopt(m_fd, IPPROTO_IP, IP_PKTINFO, &on, sizeof(on));
+    if (m_family == AF_INET6) {
+        ::setsockopt(m_fd, IPPROTO_IPV6, IPV6_RECVPKTINFO, &on, sizeof(on));
+    }
+}
+
+void DatagramSocket::setReceiveBufferSize(int size)
+{
+    // SO_RCVBUFFORCE ignores net.core.rmem_max but needs CAP_NET_ADMIN.
+    if (::setsockopt(m_fd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) < 0) {
+        ::setsockopt(m_fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    }
+
+    int on = 1;
+    ::setsockopt(m_fd, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on));
+}
+
+quint32 DatagramSocket::drops() const
+{
+    return m_drops;
+}
+
+int DatagramSocket::socketDescriptor() const
+{
+    return m_fd;
+}
+
+QString DatagramSocket::errorString() const
+{
+    return m_errorString;
+}
+
+QList<Datagram> DatagramSocket::readDatagrams()
+{
+    QList<Datagram> datagrams;
+    if (m_fd < 0) {
+        return datagrams;
+    }
+
+    for (int batch = 0; batch < maxBatchesPerRead; ++batch) {
+        for (int i = 0; i < batchSize; ++i) {
+            m_batch->iovs[i].iov_base = m_batch->buffers.data() + i * bufferSize;
+            m_batch->iovs[i].iov_len = bufferSize;
+            struct msghdr &hdr = m_batch->messages[i].msg_hdr;
+            memset(&hdr, 0, sizeof(hdr));
+            hdr.msg_name = &m_batch->addrs[i];
+            hdr.msg_namelen = sizeof(m_batch->addrs[i]);
+            hdr.msg_iov = &m_batch->iovs[i];
+            hdr.msg_iovlen = 1;
+            hdr.msg_control = m_batch->controls[i];
+            hdr.msg_controllen = sizeof(m_batch->controls[i]);
+        }
+
+        int n = ::recvmmsg(m_fd, m_batch->messages, batchSize, MSG_DONTWAIT, nullptr);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                setError();
+            }
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            // Empty datagrams are dropped, as by the Qt backend.
+            const int length = static_cast<int>(m_batch->messages[i].msg_len);
+            if (length <= 0) {
+                continue;
+            }
+
+            const char *data = static_cast<const char *>(m_batch->iovs[i].iov_base);
+            const struct sockaddr_storage &addr = m_batch->addrs[i];
+            const QHostAddress address(reinterpret_cast<const struct sockaddr *>(&addr));
+            const quint16 port = portOf(addr);
+
+            int segmentSize = length;
+            QHostAddress destination;
+            struct msghdr *msg = &m_batch->messages[i].msg_hdr;
+            for (struct cmsghdr *cm = CMSG_FIRSTHDR(msg); cm; cm = CMSG_NXTHDR(msg, cm)) {
+                if (cm->cmsg_level == IPPROTO_UDP && cm->cmsg_type == UDP_GRO) {
+                    memcpy(&segmentSize, CMSG_DATA(cm), sizeof(segmentSize));
+                } else if (cm->cmsg_level == IPPROTO_IP && cm->cmsg_type == IP_PKTINFO) {
+                    struct in_pktinfo info;
+                    memcpy(&info, CMSG_DATA(cm), sizeof(info));
+                    destination.setAddress(ntohl(info.ipi_addr.s_addr));
+                } else if (cm->cmsg_level == IPPROTO_IPV6 && cm->cmsg_type == IPV6_PKTINFO) {
+                    struct in6_pktinfo info;
+                    memcpy(&info, CMSG_DATA(cm), sizeof(info));
+                    destination.setAddress(info.ipi6_addr.s6_addr);
+                } else if (cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SO_RXQ_OVFL) {
+                    // The total since the socket was opened
+                    quint32 drops = 0;
+                    memcpy(&drops, CMSG_DATA(cm), sizeof(drops));
+                    m_drops = drops;
+                }
+            }
+            if (segmentSize <= 0) {
+                segmentSize = length;
+            }
+
+            for (int offset = 0; offset < length; offset += segmentSize) {
+                Datagram datagram;
+                datagram.data = QByteArray(data + offset, qMin(segmentSize, length - offset));
+                datagram.address = address;
+                datagram.port = port;
+                datagram.destination = destination;
+                datagrams.append(datagram);
+            }
+        }
+
+        if (n < batchSize) {
+            break;
+        }
+    }
+
+    return datagrams;
+}
+
+int DatagramSocket::writeDatagrams(const QList<Datagram> &datagrams,
+                                   QList<DatagramError> *errors)
+{
+    if (m_fd < 0) {
+        return 0;
+    }
+
+    struct mmsghdr messages[batchSize];
+    struct iovec iovs[batchSize];
+    struct sockaddr_storage addrs[batchSize];
+    int index = 0;
+    while (index < datagrams.size()) {
+        // Destinations the socket can not address are skipped, they never reach the kernel.
+        int count = 0;
+        int indexes[batchSize];
+        while (count < batchSize && index < datagrams.size()) {
+            const Datagram &datagram = datagrams.at(index);
+            socklen_t addrLength = toSockAddr(datagram.address,
+                                              datagram.port,
+                                              m_family,
+                                              &addrs[count]);
+            if (addrLength == 0) {
+                if (errors) {
+                    errors->append(DatagramError{index, EAFNOSUPPORT});
+                }
+                index++;
+                continue;
+            }
+
+            iovs[count].iov_base = const_cast<char *>(datagram.data.constData());
+            iovs[count].iov_len = static_cast<size_t>(datagram.data.size());
+            memset(&messages[count], 0, sizeof(messages[count]));
+            messages[count].msg_hdr.msg_name = &addrs[count];
+            messages[count].msg_hdr.msg_namelen = addrLength;
+            messages[count].msg_hdr.msg_iov = &iovs[count];
+            messages[count].msg_hdr.msg_iovlen = 1;
+            indexes[count] = index;
+            count++;
+            index++;
+        }
+
+        // sendmmsg() stops at the first datagram that fails. A full send buffer fails the ones
+        // behind it as well, the rest is written when the socket is writable again. Any other
+        // error is the datagram's own, it is reported and skipped.
+        int offset = 0;
+        while (offset < count) {
+            int n = ::sendmmsg(m_fd, messages + offset, count - offset, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                setError();
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+                    // The destinations skipped behind it are looked at again then.
+                    const int done = indexes[offset];
+                    while (errors && !errors->isEmpty() && errors->last().index > done) {
+                        errors->removeLast();
+                    }
+                    m_writeNotifier->setEnabled(true);
+                    return done;
+                }
+
+                if (errors) {
+                    errors->append(DatagramError{indexes[offset], errno});
+                }
+                offset++;
+                continue;
+            }
+
+            offset += n;
+        }
+    }
+
+    return datagrams.size();
+}
+
+bool DatagramSocket::isDestinationError(int error)
+{
+    switch (error) {
+    case EAFNOSUPPORT:
+    case EINVAL:
+    case EDESTADDRREQ:
+    case EHOSTUNREACH:
+    case ENETUNREACH:
+    case EADDRNOTAVAIL:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool DatagramSocket::create(int family)
+{
+    close();
+    m_fd = ::socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_fd < 0) {
+        setError();
+        return false;
+    }
+
+    if (family == AF_INET6) {
+        // Dual stack, like QUdpSocket does it for QHostAddress::Any.
+        int off = 0;
+        ::setsockopt(m_fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+    }
+
+    m_family = family;
+    m_batch = new Batch;
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &DatagramSocket::readyRead);
+    m_writeNotifier = new QSocketNotifier(m_fd, QSocketNotifier::Write, this);
+    m_writeNotifier->setEnabled(false);
+    connect(m_writeNotifier, &QSocketNotifier::activated, this, [this]() {
+        m_writeNotifier->setEnabled(false);
+        emit readyWrite();
+    });
+    return true;
+}
+
+void DatagramSocket::setError()
+{
+    m_errorString = QString::fromLocal8Bit(strerror(errno));
+}
@@ -0,0 +1,99 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <atomic>
+
+#include <QHostAddress>
+#include <QList>
+#include <QObject>
+
+class QSocketNotifier;
+
+struct Datagram
+{
+    QByteArray data;
+    QHostAddress address;
+    quint16 port{0};
+    QHostAddress destination; // The group of a multicast datagram, see setReceiveDestination()
+};
+
+// A datagram writeDatagrams() has given up on.
+struct DatagramError
+{
+    int index; // In the list passed to writeDatagrams()
+    int error; // errno
+};
+
+// A UDP socket of the Linux native backend that is read and written in batches: one recvmmsg()
+// takes up to batchSize datagrams into buffers allocated once, one sendmmsg() sends up to batchSize
+// datagrams to any destinations. With GRO the kernel may coalesce the datagrams of a sender into
+// one buffer, they are split again by the segment size it reports. The socket is served by
+// QSocketNotifiers of the thread the object lives in.
+class DatagramSocket : public QObject
+{
+    Q_OBJECT
+public:
+    static const int batchSize = 32;
+    static const int bufferSize = 64 * 1024; // The largest datagram, or a GRO train of them
+
+public:
+    explicit DatagramSocket(QObject *parent = nullptr);
+    ~DatagramSocket() override;
+
+    // An unbound socket, it is bound to an ephemeral port by the first write.
+    bool open(QAbstractSocket::NetworkLayerProtocol protocol);
+    // With reusePort several sockets can be bound to the same port(SO_REUSEPORT).
+    bool bind(const QHostAddress &address, quint16 port, bool reusePort = false);
+    void close();
+    // interfaceIndex 0 is the default interface, a source makes it a source-specific membership.
+    bool joinMulticastGroup(const QHostAddress &group,
+                            int interfaceIndex = 0,
+                            const QHostAddress &source = QHostAddress());
+    // Off: only the groups joined by this socket are received, not the groups joined by any socket
+    // of the system that is bound to the same port(IP_MULTICAST_ALL).
+    void setMulticastAll(bool enabled);
+    void setGro(bool enabled);
+    // The destination address of every datagram is reported(IP_PKTINFO).
+    void setReceiveDestination(bool enabled);
+    // The kernel counts the datagrams it drops because the receive buffer is full(SO_RXQ_OVFL).
+    void setReceiveBufferSize(int size);
+    quint32 drops() const;
+    int socketDescriptor() const;
+    QString errorString() const;
+
+    // Everything pending, but at most a few batches, a flooding sender must not starve the thread.
+    QList<Datagram> readDatagrams();
+    // Sends the datagrams from the start of the list and returns how many of them are done with,
+    // sent or given up on(added to errors). While the send buffer is full(EAGAIN, ENOBUFS) nothing
+    // is given up on: fewer datagrams are done with, readyWrite() tells when to write the rest.
+    int writeDatagrams(const QList<Datagram> &datagrams, QList<DatagramError> *errors = nullptr);
+    // The destination can not be reached at all, rather than the datagram being the problem.
+    static bool isDestinationError(int error);
+
+signals:
+    void readyRead();
+    void readyWrite();
+
+private:
+    struct Batch;
+
+private:
+    int m_fd{-1};
+    int m_family{0};
+    QSocketNotifier *m_notifier{nullptr};
+    QSocketNotifier *m_writeNotifier{nullptr}; // Enabled while the send buffer is full
+    Batch *m_batch{nullptr};
+    std::atomic<quint32> m_drops{0};
+    QString m_errorString;
+
+private:
+    bool create(int family);
+    void setError();
+};
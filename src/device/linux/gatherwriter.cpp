@@ -0,0 +1,71 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "gatherwriter.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+qint64 GatherWriter::write(QLocalSocket *socket, const QList<QByteArray> &messages)
+{
+    const int fd = static_cast<int>(socket->socketDescriptor());
+    if (fd < 0 || socket->bytesToWrite() > 0 || messages.size() < 2) {
+        qint64 written = 0;
+        for (const QByteArray &message : messages) {
+            const qint64 ret = socket->write(message);
+            if (ret < 0) {
+                return -1;
+            }
+            written += ret;
+        }
+        return written;
+    }
+
+    struct iovec iovs[maxMessages];
+    const int count = qMin(int(messages.size()), int(maxMessages));
+    for (int i = 0; i < count; ++i) {
+        iovs[i].iov_base = const_cast<char *>(messages.at(i).constData());
+        iovs[i].iov_len = static_cast<size_t>(messages.at(i).size());
+    }
+
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = iovs;
+    message.msg_iovlen = static_cast<size_t>(count);
+    ssize_t sent = -1;
+    do {
+        sent = ::sendmsg(fd, &message, MSG_NOSIGNAL | MSG_DONTWAIT);
+    } while (sent < 0 && errno == EINTR);
+    if (sent < 0) {
+        // The socket is full, everything is left to QLocalSocket. Other errors are reported by it.
+        sent = 0;
+    }
+
+    // The rest of the message the kernel took partly, and the messages it did not take at all.
+    qint64 written = sent;
+    qint64 offset = sent;
+    for (int i = 0; i < messages.size(); ++i) {
+        const QByteArray &bytes = messages.at(i);
+        if (i < count && offset >= bytes.size()) {
+            offset -= bytes.size();
+            continue;
+        }
+
+        const qint64 skip = i < count ? offset : 0;
+        offset = 0;
+        const qint64 ret = socket->write(bytes.constData() + skip, bytes.size() - skip);
+        if (ret < 0) {
+            return -1;
+        }
+        written += ret;
+    }
+
+    return written;
+}
@@ -0,0 +1,26 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QLocalSocket>
+
+// Writes the queued messages of a local socket with one sendmsg()(writev() with MSG_NOSIGNAL),
+// the messages are not copied into one buffer and the kernel is entered once for all of them. The
+// part the kernel does not take now is written by QLocalSocket. Nothing is written directly while
+// Qt still buffers bytes, the order of the messages is kept.
+class GatherWriter
+{
+public:
+    static const int maxMessages = 64; // iovecs per sendmsg()
+
+public:
+    static qint64 write(QLocalSocket *socket, const QList<QByteArray> &messages);
+};
@@ -0,0 +1,98 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "serialportmonitor.h"
+
+#include <errno.h>
+#include <linux/netlink.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <QDebug>
+#include <QSocketNotifier>
+
+SerialPortMonitor::SerialPortMonitor(QObject *parent)
+    : QObject(parent)
+{}
+
+SerialPortMonitor::~SerialPortMonitor()
+{
+    close();
+}
+
+bool SerialPortMonitor::open()
+{
+    close();
+
+    m_fd = ::socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if (m_fd < 0) {
+        qWarning() << "Failed to create uevent socket:" << strerror(errno);
+        return false;
+    }
+
+    struct sockaddr_nl addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_pid = 0;
+    addr.nl_groups = 1; // Kernel events, udevd is not required.
+    if (::bind(m_fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0) {
+        qWarning() << "Failed to bind uevent socket:" << strerror(errno);
+        ::close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &SerialPortMonitor::readUevents);
+    return true;
+}
+
+void SerialPortMonitor::close()
+{
+    if (m_notifier) {
+        m_notifier->setEnabled(false);
+        m_notifier->deleteLater();
+        m_notifier = nullptr;
+    }
+
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+void SerialPortMonitor::readUevents()
+{
+    // A uevent is "action@devpath" followed by NUL separated KEY=VALUE pairs.
+    char buffer[8192];
+    bool changed = false;
+    while (true) {
+        ssize_t len = ::recv(m_fd, buffer, sizeof(buffer) - 1, 0);
+        if (len <= 0) {
+            break;
+        }
+
+        buffer[len] = '\0';
+        const char *action = buffer;
+        if (strncmp(action, "add@", 4) != 0 && strncmp(action, "remove@", 7) != 0) {
+            continue;
+        }
+
+        for (ssize_t i = strlen(buffer) + 1; i < len; i += strlen(buffer + i) + 1) {
+            if (strcmp(buffer + i, "SUBSYSTEM=tty") == 0) {
+                changed = true;
+                break;
+            }
+        }
+    }
+
+    if (changed) {
+        emit portsChanged();
+    }
+}
@@ -0,0 +1,35 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QObject>
+
+class QSocketNotifier;
+// Listens to the kernel uevents(NETLINK_KOBJECT_UEVENT) and reports tty devices being added or
+// removed, so the serial port list is refreshed only when something has changed.
+class SerialPortMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SerialPortMonitor(QObject *parent = nullptr);
+    ~SerialPortMonitor() override;
+
+    bool open();
+    void close();
+
+signals:
+    void portsChanged();
+
+private:
+    void readUevents();
+
+private:
+    int m_fd{-1};
+    QSocketNotifier *m_notifier{nullptr};
+};
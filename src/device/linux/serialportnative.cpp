@@ -0,0 +1,656 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "serialportnative.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <QDebug>
+#include <QFile>
+#include <QSerialPort>
+
+// <asm/termbits.h> provides termios2 and BOTHER, it can not be mixed with <termios.h>.
+#include <asm/termbits.h>
+#include <linux/serial.h>
+
+#include "uring.h"
+
+namespace {
+
+// Read as much as the driver has buffered on every wake-up, a USB adapter running at several Mbaud
+// hands over a few KB per URB.
+const int readBufferSize = 64 * 1024;
+// The user data of the entries of the ring, there is one port per ring.
+enum UringOperation : quint64 {
+    UringWakeup = 1,
+    UringTimer,
+    UringPollIn,
+    UringRead,
+    UringPollOut,
+    UringWrite
+};
+const unsigned uringEntries = 16;
+
+} // namespace
+
+SerialPortNative::SerialPortNative(QObject *parent)
+    : QThread(parent)
+{}
+
+SerialPortNative::~SerialPortNative()
+{
+    close();
+}
+
+bool SerialPortNative::open(const SerialPortItem &item)
+{
+    close();
+
+    m_portName = item.portName;
+    m_ioUring = item.ioUring;
+    m_stopping = false;
+    QByteArray path = devicePath(item.portName).toLocal8Bit();
+    m_fd = ::open(path.constData(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (m_fd < 0) {
+        m_errorString = QString::fromLocal8Bit(strerror(errno));
+        return false;
+    }
+
+    if (::ioctl(m_fd, TIOCEXCL) < 0) {
+        qWarning() << "Failed to lock" << m_portName << "exclusively:" << strerror(errno);
+    }
+
+    if (!setupTermios(item)) {
+        m_errorString = QString::fromLocal8Bit(strerror(errno));
+        ::close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+
+    if (item.lowLatency) {
+        setupLowLatency();
+    }
+
+    m_wakeupFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    m_epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    m_timerFd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (m_wakeupFd < 0 || m_epollFd < 0 || m_timerFd < 0) {
+        m_errorString = QString::fromLocal8Bit(strerror(errno));
+        close();
+        return false;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = m_fd;
+    ::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_fd, &ev);
+    ev.data.fd = m_wakeupFd;
+    ::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeupFd, &ev);
+    ev.data.fd = m_timerFd;
+    ::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_timerFd, &ev);
+
+    start(QThread::TimeCriticalPriority);
+    return true;
+}
+
+void SerialPortNative::close()
+{
+    if (isRunning()) {
+        m_stopping = true;
+        quint64 value = 1;
+        if (::write(m_wakeupFd, &value, sizeof(value)) < 0) {
+            qWarning() << "Failed to wake up the reader:" << strerror(errno);
+        }
+        wait();
+    }
+
+    if (m_timerFd >= 0) {
+        ::close(m_timerFd);
+        m_timerFd = -1;
+    }
+
+    if (m_epollFd >= 0) {
+        ::close(m_epollFd);
+        m_epollFd = -1;
+    }
+
+    if (m_wakeupFd >= 0) {
+        ::close(m_wakeupFd);
+        m_wakeupFd = -1;
+    }
+
+    m_writeBuffer.clear();
+
+    if (m_fd >= 0) {
+        restoreLowLatency();
+        ::ioctl(m_fd, TIOCNXCL);
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+qint64 SerialPortNative::write(const QByteArray &bytes)
+{
+    if (m_fd < 0) {
+        return -1;
+    }
+
+    QMutexLocker locker(&m_writeMutex);
+    if (m_writeBuffer.size() + bytes.size() > maxWriteBufferSize) {
+        m_errorString = tr("The output buffer is full");
+        return -1;
+    }
+
+    // The bytes buffered earlier go out first, the reader thread is already waiting to write them.
+    if (!m_writeBuffer.isEmpty()) {
+        m_writeBuffer.append(bytes);
+        return bytes.size();
+    }
+
+    qint64 written = writeSome(bytes.constData(), bytes.size());
+    if (written < 0) {
+        m_errorString = QString::fromLocal8Bit(strerror(errno));
+        return -1;
+    }
+
+    if (written < bytes.size()) {
+        m_writeBuffer = bytes.mid(static_cast<int>(written));
+        watchWritable(true);
+    }
+
+    return bytes.size();
+}
+
+qint64 SerialPortNative::writeSome(const char *data, qint64 size)
+{
+    qint64 written = 0;
+    while (written < size) {
+        ssize_t ret = ::write(m_fd, data + written, size - written);
+        if (ret > 0) {
+            written += ret;
+        } else if (ret < 0 && errno == EINTR) {
+            continue;
+        } else if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break; // The tty output buffer is full
+        } else {
+            return -1;
+        }
+    }
+
+    return written;
+}
+
+void SerialPortNative::flushWriteBuffer()
+{
+    QMutexLocker locker(&m_writeMutex);
+    qint64 written = writeSome(m_writeBuffer.constData(), m_writeBuffer.size());
+    if (written < 0) {
+        QString errorString = QString::fromLocal8Bit(strerror(errno));
+        m_writeBuffer.clear();
+        watchWritable(false);
+        locker.unlock();
+        emit errorOccurred(errorString);
+        return;
+    }
+
+    m_writeBuffer.remove(0, static_cast<int>(written));
+    if (m_writeBuffer.isEmpty()) {
+        watchWritable(false);
+    }
+}
+
+void SerialPortNative::watchWritable(bool enabled)
+{
+    // The ring has no epoll set, it is woken up and picks up the buffered bytes itself.
+    if (m_uringActive) {
+        quint64 value = 1;
+        if (enabled && ::write(m_wakeupFd, &value, sizeof(value)) < 0) {
+            qWarning() << "Failed to wake up the reader:" << strerror(errno);
+        }
+        return;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = enabled ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    ev.data.fd = m_fd;
+    ::epoll_ctl(m_epollFd, EPOLL_CTL_MOD, m_fd, &ev);
+}
+
+void SerialPortNative::setFrameGap(qint64 us)
+{
+    m_frameGap = us;
+}
+
+QString SerialPortNative::portName() const
+{
+    return m_portName;
+}
+
+QString SerialPortNative::errorString() const
+{
+    return m_errorString;
+}
+
+void SerialPortNative::run()
+{
+    if (m_ioUring) {
+        if (runUring()) {
+            flushFrame();
+            return;
+        }
+
+        emit errorOccurred(tr("io_uring is not available(%1), epoll is used instead.")
+                               .arg(QString::fromLocal8Bit(strerror(errno))));
+    }
+
+    runEpoll();
+    flushFrame();
+}
+
+void SerialPortNative::runEpoll()
+{
+    QByteArray buffer(readBufferSize, Qt::Uninitialized);
+    while (!m_stopping) {
+        struct epoll_event events[3];
+        int n = ::epoll_wait(m_epollFd, events, 3, -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            emit errorOccurred(QString::fromLocal8Bit(strerror(errno)));
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.fd == m_wakeupFd) {
+                break;
+            }
+
+            if (events[i].data.fd == m_timerFd) {
+                quint64 expirations = 0;
+                if (::read(m_timerFd, &expirations, sizeof(expirations)) > 0) {
+                    flushFrame();
+                }
+                continue;
+            }
+
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                emit errorOccurred(tr("The serial port %1 has been removed").arg(m_portName));
+                return;
+            }
+
+            if (events[i].events & EPOLLOUT) {
+                flushWriteBuffer();
+            }
+
+            if (events[i].events & EPOLLIN) {
+                readAvailable(buffer.data(), buffer.size());
+            }
+        }
+    }
+}
+
+bool SerialPortNative::runUring()
+{
+    // The registered buffers outlive the ring, it is closed first.
+    QByteArray readBuffer(readBufferSize, Qt::Uninitialized);
+    QByteArray writeBuffer(readBufferSize, Qt::Uninitialized);
+    Uring uring;
+    if (!uring.open(uringEntries)) {
+        return false;
+    }
+
+    for (uint8_t opcode : {IORING_OP_POLL_ADD, IORING_OP_READ_FIXED, IORING_OP_WRITE_FIXED}) {
+        if (!uring.supports(opcode)) {
+            errno = EOPNOTSUPP;
+            return false;
+        }
+    }
+
+    struct iovec buffers[2];
+    buffers[0].iov_base = readBuffer.data();
+    buffers[0].iov_len = readBuffer.size();
+    buffers[1].iov_base = writeBuffer.data();
+    buffers[1].iov_len = writeBuffer.size();
+    if (!uring.registerBuffers(buffers, 2)) {
+        return false;
+    }
+
+    // A poll linked to the read, the read is started once the tty has bytes. The port is
+    // non-blocking, an unlinked read would fail with EAGAIN instead of waiting.
+    auto prepareRead = [this, &uring, &readBuffer]() {
+        uring.preparePoll(m_fd, POLLIN, false, UringPollIn);
+        uring.linkToNext();
+        uring.prepareReadFixed(m_fd, readBuffer.data(), readBuffer.size(), 0, UringRead);
+    };
+    // The caller holds m_writeMutex. The head of m_writeBuffer stays there until it is written.
+    int writing = 0;
+    auto prepareWrite = [this, &uring, &writeBuffer, &writing]() {
+        writing = qMin(m_writeBuffer.size(), writeBuffer.size());
+        if (writing > 0) {
+            memcpy(writeBuffer.data(), m_writeBuffer.constData(), writing);
+            uring.preparePoll(m_fd, POLLOUT, false, UringPollOut);
+            uring.linkToNext();
+            uring.prepareWriteFixed(m_fd, writeBuffer.constData(), writing, 1, UringWrite);
+        }
+    };
+
+    uring.preparePoll(m_wakeupFd, POLLIN, true, UringWakeup);
+    uring.preparePoll(m_timerFd, POLLIN, true, UringTimer);
+    prepareRead();
+    m_writeMutex.lock();
+    m_uringActive = true;
+    prepareWrite();
+    m_writeMutex.unlock();
+
+    bool running = true;
+    bool removed = false;
+    while (running && !removed && !m_stopping) {
+        // Busy means the completion queue is full, it is drained below.
+        if (uring.submit(1) < 0 && errno != EBUSY && errno != EAGAIN) {
+            emit errorOccurred(QString::fromLocal8Bit(strerror(errno)));
+            break;
+        }
+
+        QByteArray bytes;
+        uring.handleCompletions([&](const struct io_uring_cqe &cqe) {
+            const bool more = cqe.flags & IORING_CQE_F_MORE;
+            if (cqe.user_data == UringWakeup) {
+                quint64 value = 0;
+                if (::read(m_wakeupFd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+                    qWarning() << "Failed to read the wake-up event:" << strerror(errno);
+                }
+                if (!more) {
+                    uring.preparePoll(m_wakeupFd, POLLIN, true, UringWakeup);
+                }
+
+                QMutexLocker locker(&m_writeMutex);
+                if (writing == 0) {
+                    prepareWrite();
+                }
+            } else if (cqe.user_data == UringTimer) {
+                quint64 expirations = 0;
+                if (::read(m_timerFd, &expirations, sizeof(expirations)) > 0) {
+                    flushFrame();
+                }
+                if (!more) {
+                    uring.preparePoll(m_timerFd, POLLIN, true, UringTimer);
+                }
+            } else if (cqe.user_data == UringPollIn) {
+                if (cqe.res > 0 && (cqe.res & (POLLERR | POLLHUP))) {
+                    removed = true;
+                } else if (cqe.res < 0 && cqe.res != -ECANCELED) {
+                    emit errorOccurred(QString::fromLocal8Bit(strerror(-cqe.res)));
+                    running = false;
+                }
+            } else if (cqe.user_data == UringRead) {
+                if (cqe.res > 0) {
+                    bytes.append(readBuffer.constData(), cqe.res);
+                } else if (cqe.res == 0 || cqe.res == -EIO) {
+                    removed = true;
+                } else if (cqe.res != -EAGAIN && cqe.res != -EINTR && cqe.res != -ECANCELED) {
+                    emit errorOccurred(QString::fromLocal8Bit(strerror(-cqe.res)));
+                }
+                if (!removed) {
+                    prepareRead();
+                }
+            } else if (cqe.user_data == UringWrite) {
+                QMutexLocker locker(&m_writeMutex);
+                if (cqe.res > 0) {
+                    m_writeBuffer.remove(0, cqe.res);
+                } else if (cqe.res != -EAGAIN && cqe.res != -EINTR && cqe.res != -ECANCELED) {
+                    m_writeBuffer.clear();
+                    locker.unlock();
+                    emit errorOccurred(QString::fromLocal8Bit(strerror(-cqe.res)));
+                    locker.relock();
+                }
+                prepareWrite();
+            }
+        });
+
+        if (!bytes.isEmpty()) {
+            emitRead(bytes);
+        }
+        if (removed) {
+            emit errorOccurred(tr("The serial port %1 has been removed").arg(m_portName));
+        }
+    }
+
+    m_writeMutex.lock();
+    m_uringActive = false;
+    m_writeMutex.unlock();
+    return true;
+}
+
+void SerialPortNative::readAvailable(char *buffer, int size)
+{
+    // Read as much as the driver has buffered on every wake-up, a USB adapter running at several
+    // Mbaud hands over a few KB per URB.
+    QByteArray bytes;
+    while (true) {
+        ssize_t ret = ::read(m_fd, buffer, size);
+        if (ret > 0) {
+            bytes.append(buffer, static_cast<int>(ret));
+            if (ret < size) {
+                break;
+            }
+        } else if (ret < 0 && errno == EINTR) {
+            continue;
+        } else {
+            break;
+        }
+    }
+
+    if (!bytes.isEmpty()) {
+        emitRead(bytes);
+    }
+}
+
+void SerialPortNative::emitRead(const QByteArray &bytes)
+{
+    emit bytesRead(bytes);
+    appendToFrame(bytes);
+}
+
+void SerialPortNative::appendToFrame(const QByteArray &bytes)
+{
+    const qint64 frameGap = m_frameGap;
+    if (frameGap <= 0) {
+        flushFrame();
+        return;
+    }
+
+    // The same limit as the frames of the Qt backend, a stream without gaps is not held back.
+    m_frame.append(bytes);
+    if (m_frame.size() > 1024) {
+        flushFrame();
+        return;
+    }
+
+    // The timer is re-armed by every chunk, it expires once the line has been idle for the gap.
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.it_value.tv_sec = frameGap / 1000000;
+    spec.it_value.tv_nsec = (frameGap % 1000000) * 1000;
+    ::timerfd_settime(m_timerFd, 0, &spec, nullptr);
+}
+
+void SerialPortNative::flushFrame()
+{
+    if (m_frame.isEmpty()) {
+        return;
+    }
+
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    ::timerfd_settime(m_timerFd, 0, &spec, nullptr);
+
+    emit frameRead(m_frame);
+    m_frame.clear();
+}
+
+bool SerialPortNative::setupTermios(const SerialPortItem &item)
+{
+    struct termios2 tio;
+    if (::ioctl(m_fd, TCGETS2, &tio) < 0) {
+        return false;
+    }
+
+    // Raw mode, the same as cfmakeraw().
+    tio.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON | IXOFF
+                     | IXANY | INPCK);
+    tio.c_oflag &= ~OPOST;
+    tio.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+    tio.c_cflag &= ~(CSIZE | PARENB | PARODD | CMSPAR | CSTOPB | CRTSCTS);
+    tio.c_cflag |= CLOCAL | CREAD;
+
+    // Any baud rate, the driver picks the closest divisor it can generate.
+    tio.c_cflag &= ~(CBAUD | (CBAUD << IBSHIFT));
+    tio.c_cflag |= BOTHER | (BOTHER << IBSHIFT);
+    tio.c_ispeed = static_cast<speed_t>(item.baudRate);
+    tio.c_ospeed = static_cast<speed_t>(item.baudRate);
+
+    switch (item.dataBits) {
+    case QSerialPort::Data5:
+        tio.c_cflag |= CS5;
+        break;
+    case QSerialPort::Data6:
+        tio.c_cflag |= CS6;
+        break;
+    case QSerialPort::Data7:
+        tio.c_cflag |= CS7;
+        break;
+    default:
+        tio.c_cflag |= CS8;
+        break;
+    }
+
+    switch (item.parity) {
+    case QSerialPort::EvenParity:
+        tio.c_cflag |= PARENB;
+        tio.c_iflag |= INPCK;
+        break;
+    case QSerialPort::OddParity:
+        tio.c_cflag |= PARENB | PARODD;
+        tio.c_iflag |= INPCK;
+        break;
+    case QSerialPort::SpaceParity:
+        tio.c_cflag |= PARENB | CMSPAR;
+        tio.c_iflag |= INPCK;
+        break;
+    case QSerialPort::MarkParity:
+        tio.c_cflag |= PARENB | CMSPAR | PARODD;
+        tio.c_iflag |= INPCK;
+        break;
+    default:
+        break;
+    }
+
+    if (item.stopBits == QSerialPort::TwoStop) {
+        tio.c_cflag |= CSTOPB;
+    }
+
+    if (item.flowControl == QSerialPort::HardwareControl) {
+        tio.c_cflag |= CRTSCTS;
+    } else if (item.flowControl == QSerialPort::SoftwareControl) {
+        tio.c_iflag |= IXON | IXOFF;
+    }
+
+    // The non-blocking reads ignore VMIN and VTIME, but with VTIME 0 the line discipline reports
+    // the tty readable to epoll only once VMIN bytes are buffered. VMIN 1 wakes the reader up on
+    // the first byte whatever the previous owner of the port left behind.
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+
+    if (::ioctl(m_fd, TCSETS2, &tio) < 0) {
+        return false;
+    }
+
+    ::ioctl(m_fd, TCFLSH, TCIOFLUSH);
+    return true;
+}
+
+void SerialPortNative::setupLowLatency()
+{
+    struct serial_struct serial;
+    if (::ioctl(m_fd, TIOCGSERIAL, &serial) == 0 && !(serial.flags & ASYNC_LOW_LATENCY)) {
+        const int flags = serial.flags;
+        serial.flags |= ASYNC_LOW_LATENCY;
+        if (::ioctl(m_fd, TIOCSSERIAL, &serial) == 0) {
+            m_serialFlags = flags;
+        } else {
+            qInfo() << "ASYNC_LOW_LATENCY is not supported by" << m_portName;
+        }
+    }
+
+    // FTDI adapters batch received bytes for 16ms by default. The setting outlives the port, it is
+    // put back by restoreLowLatency().
+    QFile latencyTimer(latencyTimerPath());
+    if (!latencyTimer.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QByteArray value = latencyTimer.readAll().trimmed();
+    latencyTimer.close();
+    if (value.isEmpty() || value == "1" || !latencyTimer.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    if (latencyTimer.write("1") > 0 && latencyTimer.flush()) {
+        m_latencyTimer = value;
+    }
+}
+
+void SerialPortNative::restoreLowLatency()
+{
+    if (m_serialFlags >= 0) {
+        struct serial_struct serial;
+        if (::ioctl(m_fd, TIOCGSERIAL, &serial) == 0) {
+            serial.flags = m_serialFlags;
+            if (::ioctl(m_fd, TIOCSSERIAL, &serial) < 0) {
+                qWarning() << "Failed to restore the flags of" << m_portName << strerror(errno);
+            }
+        }
+        m_serialFlags = -1;
+    }
+
+    if (!m_latencyTimer.isEmpty()) {
+        QFile latencyTimer(latencyTimerPath());
+        if (!latencyTimer.open(QIODevice::WriteOnly) || latencyTimer.write(m_latencyTimer) < 0
+            || !latencyTimer.flush()) {
+            qWarning() << "Failed to restore the latency timer of" << m_portName;
+        }
+        m_latencyTimer.clear();
+    }
+}
+
+QString SerialPortNative::devicePath(const QString &portName) const
+{
+    if (portName.startsWith('/')) {
+        return portName;
+    }
+
+    return QString("/dev/%1").arg(portName);
+}
+
+QString SerialPortNative::latencyTimerPath() const
+{
+    QString name = devicePath(m_portName).section('/', -1);
+    return QString("/sys/bus/usb-serial/devices/%1/latency_timer").arg(name);
+}
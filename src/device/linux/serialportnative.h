@@ -0,0 +1,84 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <atomic>
+
+#include <QMutex>
+#include <QThread>
+
+#include "common/xtools.h"
+
+// Linux native serial port backend. The port is configured with termios2(BOTHER), so any baud
+// rate the driver accepts can be used. With the low latency option ASYNC_LOW_LATENCY is requested
+// from the driver, the settings that are changed for it are restored when the port is closed. The
+// thread itself is the reader: it waits on epoll and drains the tty with large reads. Writes never
+// block the caller, what the tty does not take at once is buffered and written by the reader thread
+// when epoll reports the tty writable. With a frame gap the reader also splits the input into
+// frames, a timerfd in the same epoll set measures the idle time with microsecond resolution.
+// Optionally the reader waits on an io_uring instead: a poll linked to a fixed read gets a chunk
+// with one syscall, the bytes land in a registered buffer and the buffered writes leave from one.
+class SerialPortNative : public QThread
+{
+    Q_OBJECT
+public:
+    explicit SerialPortNative(QObject *parent = nullptr);
+    ~SerialPortNative() override;
+
+    bool open(const SerialPortItem &item);
+    void close();
+    qint64 write(const QByteArray &bytes);
+    void setFrameGap(qint64 us); // 0 means the bytes are not framed, it can be changed while open
+
+    QString portName() const;
+    QString errorString() const;
+
+signals:
+    void bytesRead(const QByteArray &bytes); // Every chunk read from the tty
+    void frameRead(const QByteArray &bytes); // Only if a frame gap is set
+    void errorOccurred(const QString &errorString);
+
+protected:
+    void run() override;
+
+private:
+    void runEpoll();
+    bool runUring();
+    void readAvailable(char *buffer, int size);
+    void emitRead(const QByteArray &bytes);
+    qint64 writeSome(const char *data, qint64 size);
+    void flushWriteBuffer();
+    void watchWritable(bool enabled);
+    void appendToFrame(const QByteArray &bytes);
+    void flushFrame();
+    bool setupTermios(const SerialPortItem &item);
+    void setupLowLatency();
+    void restoreLowLatency();
+    QString devicePath(const QString &portName) const;
+    QString latencyTimerPath() const;
+
+private:
+    // The bytes buffered for a slow port, at most this many of them.
+    static const int maxWriteBufferSize = 4 * 1024 * 1024;
+    int m_fd{-1};
+    int m_wakeupFd{-1};
+    int m_epollFd{-1};
+    int m_timerFd{-1};
+    bool m_ioUring{false};
+    bool m_uringActive{false};         // Guarded by m_writeMutex, writes wake the ring up
+    std::atomic_bool m_stopping{false};
+    std::atomic<qint64> m_frameGap{0}; // us
+    QByteArray m_frame;                // Only used by the reader thread
+    QMutex m_writeMutex;               // Guards m_writeBuffer, the reader thread flushes it
+    QByteArray m_writeBuffer;          // Written when the tty is writable again
+    QString m_portName;
+    QString m_errorString;
+    int m_serialFlags{-1};     // serial_struct.flags before ASYNC_LOW_LATENCY, -1 if untouched
+    QByteArray m_latencyTimer; // The FTDI latency timer before it is lowered, empty if untouched
+};
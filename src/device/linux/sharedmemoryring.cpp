@@ -0,0 +1,142 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "sharedmemoryring.h"
+
+#include <string.h>
+
+#include <QDebug>
+
+SharedMemoryRing::SharedMemoryRing(QObject *parent)
+    : QThread(parent)
+{
+    memset(&m_ring, 0, sizeof(m_ring));
+}
+
+SharedMemoryRing::~SharedMemoryRing()
+{
+    close();
+}
+
+bool SharedMemoryRing::open(const QString &name, quint32 cells, int spinTime, bool replace)
+{
+    close();
+
+    QByteArray path = name.toLocal8Bit();
+    const int flags = replace ? XTOOLS_RING_REPLACE : 0;
+    int ret = xtools_ring_create(&m_ring, path.constData(), cells, flags);
+    if (ret == -EEXIST) {
+        m_errorString = tr("The name is used by another process or was left by a crashed one, "
+                           "enable \"Replace\" to take it over.");
+        return false;
+    } else if (ret < 0) {
+        m_errorString = QString::fromLocal8Bit(strerror(-ret));
+        return false;
+    }
+
+    m_name = name;
+    m_spinTime = spinTime;
+    m_messages = 0;
+    start(QThread::TimeCriticalPriority);
+    return true;
+}
+
+void SharedMemoryRing::close()
+{
+    if (!m_ring.header) {
+        return;
+    }
+
+    // The reader and the attached processes see the segment closed, the reader leaves its loop.
+    xtools_ring_close(&m_ring);
+    wait();
+    xtools_ring_detach(&m_ring);
+}
+
+qint64 SharedMemoryRing::write(const QByteArray &bytes)
+{
+    if (!m_ring.header) {
+        return -1;
+    }
+
+    const qint64 maxLength = xtools_ring_max_length(&m_ring);
+    qint64 written = 0;
+    while (written < bytes.size()) {
+        const qint64 length = qMin(maxLength, bytes.size() - written);
+        int ret = xtools_ring_write(&m_ring,
+                                    XTOOLS_RING_OUT,
+                                    bytes.constData() + written,
+                                    static_cast<uint32_t>(length));
+        if (ret < 0) {
+            // A full ring is not waited for, the reader is too slow or there is none.
+            if (ret != -EAGAIN) {
+                m_errorString = QString::fromLocal8Bit(strerror(-ret));
+            }
+            break;
+        }
+
+        written += length;
+    }
+
+    return written;
+}
+
+QString SharedMemoryRing::name() const
+{
+    return m_name;
+}
+
+QString SharedMemoryRing::errorString() const
+{
+    return m_errorString;
+}
+
+quint64 SharedMemoryRing::segmentSize() const
+{
+    return m_ring.size;
+}
+
+quint64 SharedMemoryRing::messages() const
+{
+    return m_messages;
+}
+
+quint64 SharedMemoryRing::dropped(int ring) const
+{
+    return m_ring.header ? xtools_ring_dropped(&m_ring, ring) : 0;
+}
+
+void SharedMemoryRing::run()
+{
+    // Everything available is handed over at once: an idle producer gets each message through
+    // with the latency of one wake-up, a busy one does not flood the receivers with signals.
+    while (true) {
+        int ret = xtools_ring_wait(&m_ring, XTOOLS_RING_IN, 100 * 1000, m_spinTime);
+        if (ret < 0) {
+            break;
+        } else if (ret == 0) {
+            continue;
+        }
+
+        QByteArray bytes;
+        quint64 count = 0;
+        const void *data = nullptr;
+        uint32_t length = 0;
+        while (bytes.size() < maxBytes
+               && xtools_ring_peek(&m_ring, XTOOLS_RING_IN, &data, &length) > 0) {
+            bytes.append(static_cast<const char *>(data), static_cast<int>(length));
+            xtools_ring_release(&m_ring, XTOOLS_RING_IN);
+            ++count;
+        }
+
+        if (!bytes.isEmpty()) {
+            m_messages += count;
+            emit bytesRead(bytes);
+        }
+    }
+}
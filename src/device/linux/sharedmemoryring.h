@@ -0,0 +1,55 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <atomic>
+
+#include <QThread>
+
+#include "xtoolsring.h"
+
+// The xTools side of a shared-memory segment(see xtoolsring.h). The segment is created by open()
+// and removed by close(). The thread itself is the reader of the IN ring: it waits on the futex of
+// the ring and hands over everything available at once, up to maxBytes per bytesRead(). write()
+// puts messages into the OUT ring, the caller is the only producer of it.
+class SharedMemoryRing : public QThread
+{
+    Q_OBJECT
+public:
+    static const int maxBytes = 1024 * 1024;
+
+public:
+    explicit SharedMemoryRing(QObject *parent = nullptr);
+    ~SharedMemoryRing() override;
+
+    // Fails if the name is taken already, unless the existing segment is to be replaced.
+    bool open(const QString &name, quint32 cells, int spinTime, bool replace);
+    void close();
+    // Bytes larger than a message of the ring are split, returns the bytes written.
+    qint64 write(const QByteArray &bytes);
+
+    QString name() const;
+    QString errorString() const;
+    quint64 segmentSize() const;
+    quint64 messages() const; // Read from the IN ring
+    quint64 dropped(int ring) const;
+
+signals:
+    void bytesRead(const QByteArray &bytes);
+
+protected:
+    void run() override;
+
+private:
+    struct xtools_ring m_ring;
+    QString m_name;
+    QString m_errorString;
+    int m_spinTime{0}; // us
+    std::atomic<quint64> m_messages{0};
+};
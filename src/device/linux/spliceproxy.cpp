@@ -0,0 +1,431 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "spliceproxy.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <QDebug>
+#include <QHostAddress>
+
+#include "device/utilities/lowlatency.h"
+
+namespace {
+
+socklen_t makeSocketAddress(const QHostAddress &host, quint16 port, struct sockaddr_storage *addr)
+{
+    memset(addr, 0, sizeof(struct sockaddr_storage));
+    if (host.protocol() == QAbstractSocket::IPv6Protocol) {
+        auto *addr6 = reinterpret_cast<struct sockaddr_in6 *>(addr);
+        addr6->sin6_family = AF_INET6;
+        addr6->sin6_port = htons(port);
+        Q_IPV6ADDR ip = host.toIPv6Address();
+        memcpy(&addr6->sin6_addr, &ip, sizeof(addr6->sin6_addr));
+        return sizeof(struct sockaddr_in6);
+    }
+
+    auto *addr4 = reinterpret_cast<struct sockaddr_in *>(addr);
+    addr4->sin_family = AF_INET;
+    addr4->sin_port = htons(port);
+    addr4->sin_addr.s_addr = htonl(host.toIPv4Address());
+    return sizeof(struct sockaddr_in);
+}
+
+} // namespace
+
+SpliceProxy::SpliceProxy(QObject *parent)
+    : QThread(parent)
+{}
+
+SpliceProxy::~SpliceProxy()
+{
+    close();
+}
+
+void SpliceProxy::setLowLatency(bool lowLatency)
+{
+    m_lowLatency = lowLatency;
+}
+
+void SpliceProxy::setSampleInterval(int msec)
+{
+    m_sampleInterval = msec;
+}
+
+bool SpliceProxy::open(const QString &address,
+                       quint16 port,
+                       const QString &targetAddress,
+                       quint16 targetPort)
+{
+    close();
+
+    QHostAddress host(address);
+    QHostAddress target(targetAddress);
+    if (host.isNull() || target.isNull()) {
+        m_errorString = tr("Invalid address: %1").arg(host.isNull() ? address : targetAddress);
+        return false;
+    }
+
+    struct sockaddr_storage addr;
+    socklen_t addrLength = makeSocketAddress(host, port, &addr);
+    struct sockaddr_storage targetAddr;
+    socklen_t targetAddrLength = makeSocketAddress(target, targetPort, &targetAddr);
+    m_targetAddress = QByteArray(reinterpret_cast<const char *>(&targetAddr), targetAddrLength);
+
+    m_listenFd = ::socket(addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    m_epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    m_wakeupFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_listenFd < 0 || m_epollFd < 0 || m_wakeupFd < 0 || !openPipe(m_samplePipe)) {
+        m_errorString = QString::fromLocal8Bit(strerror(errno));
+        close();
+        return false;
+    }
+
+    int on = 1;
+    ::setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (::bind(m_listenFd, reinterpret_cast<struct sockaddr *>(&addr), addrLength) < 0
+        || ::listen(m_listenFd, SOMAXCONN) < 0) {
+        m_errorString = QString::fromLocal8Bit(strerror(errno));
+        close();
+        return false;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = m_listenFd;
+    ::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_listenFd, &ev);
+    ev.data.fd = m_wakeupFd;
+    ::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeupFd, &ev);
+
+    m_clock.start();
+    start();
+    return true;
+}
+
+void SpliceProxy::close()
+{
+    if (isRunning()) {
+        quint64 value = 1;
+        if (::write(m_wakeupFd, &value, sizeof(value)) < 0) {
+            qWarning() << "Failed to wake up the proxy:" << strerror(errno);
+        }
+        wait();
+    }
+
+    // Every session is in the hash twice, once for each of its sockets.
+    QList<Session *> sessions;
+    m_sessionsMutex.lock();
+    for (auto it = m_sessions.cbegin(); it != m_sessions.cend(); ++it) {
+        if (it.key() == it.value()->clientFd) {
+            sessions.append(it.value());
+        }
+    }
+    m_sessions.clear();
+    m_sessionsMutex.unlock();
+    for (Session *session : sessions) {
+        ::close(session->clientFd);
+        ::close(session->targetFd);
+        closePipe(session->toTarget);
+        closePipe(session->toClient);
+        delete session;
+    }
+
+    closePipe(m_samplePipe);
+    for (int *fd : {&m_listenFd, &m_epollFd, &m_wakeupFd}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+void SpliceProxy::disconnectAllSessions()
+{
+    // Only shut down, the proxy thread sees the hang-up and closes the sockets itself.
+    QMutexLocker locker(&m_sessionsMutex);
+    for (auto it = m_sessions.cbegin(); it != m_sessions.cend(); ++it) {
+        ::shutdown(it.key(), SHUT_RDWR);
+    }
+}
+
+int SpliceProxy::sessionCount()
+{
+    QMutexLocker locker(&m_sessionsMutex);
+    return m_sessions.size() / 2;
+}
+
+QString SpliceProxy::errorString() const
+{
+    return m_errorString;
+}
+
+void SpliceProxy::run()
+{
+    bool running = true;
+    while (running) {
+        struct epoll_event events[64];
+        int n = ::epoll_wait(m_epollFd, events, 64, -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            emit errorOccurred(QString::fromLocal8Bit(strerror(errno)));
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == m_wakeupFd) {
+                running = false;
+                break;
+            }
+
+            if (fd == m_listenFd) {
+                acceptClients();
+                continue;
+            }
+
+            // An earlier event of this round may have closed the session already.
+            m_sessionsMutex.lock();
+            Session *session = m_sessions.value(fd, nullptr);
+            m_sessionsMutex.unlock();
+            if (session) {
+                handleEvent(session, fd, events[i].events);
+            }
+        }
+    }
+}
+
+void SpliceProxy::acceptClients()
+{
+    while (true) {
+        struct sockaddr_storage addr;
+        socklen_t addrLength = sizeof(addr);
+        int fd = ::accept4(m_listenFd,
+                           reinterpret_cast<struct sockaddr *>(&addr),
+                           &addrLength,
+                           SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                emit errorOccurred(QString::fromLocal8Bit(strerror(errno)));
+            }
+            break;
+        }
+
+        auto *target = reinterpret_cast<const struct sockaddr *>(m_targetAddress.constData());
+        int targetFd = ::socket(target->sa_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (targetFd < 0
+            || (::connect(targetFd, target, m_targetAddress.size()) < 0 && errno != EINPROGRESS)) {
+            emit errorOccurred(tr("Failed to connect to the target: %1")
+                                   .arg(QString::fromLocal8Bit(strerror(errno))));
+            if (targetFd >= 0) {
+                ::close(targetFd);
+            }
+            ::close(fd);
+            continue;
+        }
+
+        Session *session = new Session;
+        session->clientFd = fd;
+        session->targetFd = targetFd;
+        if (!openPipe(session->toTarget) || !openPipe(session->toClient)) {
+            emit errorOccurred(QString::fromLocal8Bit(strerror(errno)));
+            ::close(fd);
+            ::close(targetFd);
+            closePipe(session->toTarget);
+            closePipe(session->toClient);
+            delete session;
+            continue;
+        }
+
+        // The same format as Socket::makeFlag().
+        QHostAddress peerAddress(reinterpret_cast<struct sockaddr *>(&addr));
+        quint16 peerPort = addr.ss_family == AF_INET6
+                               ? ntohs(reinterpret_cast<struct sockaddr_in6 *>(&addr)->sin6_port)
+                               : ntohs(reinterpret_cast<struct sockaddr_in *>(&addr)->sin_port);
+        session->flag = QString("%1:%2").arg(peerAddress.toString()).arg(peerPort);
+
+        if (m_lowLatency) {
+            LowLatency::setup(fd, true);
+            LowLatency::setup(targetFd, true);
+        }
+
+        m_sessionsMutex.lock();
+        m_sessions.insert(fd, session);
+        m_sessions.insert(targetFd, session);
+        m_sessionsMutex.unlock();
+
+        // Edge triggered, every event pumps both directions until the kernel would block.
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.fd = fd;
+        ::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &ev);
+        ev.data.fd = targetFd;
+        ::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, targetFd, &ev);
+
+        emit sessionOpened(session->flag);
+    }
+}
+
+void SpliceProxy::handleEvent(Session *session, int fd, quint32 events)
+{
+    if (fd == session->targetFd && !session->connected) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length);
+        if (error != 0) {
+            emit errorOccurred(tr("Failed to connect to the target: %1")
+                                   .arg(QString::fromLocal8Bit(strerror(error))));
+            closeSession(session);
+            return;
+        }
+
+        if (!(events & EPOLLOUT)) {
+            return;
+        }
+        session->connected = true;
+    }
+
+    if (!session->connected) {
+        // The client may already have sent bytes, they wait in its socket until the target is up.
+        if (events & (EPOLLERR | EPOLLHUP)) {
+            closeSession(session);
+        }
+        return;
+    }
+
+    if (!pump(session, session->clientFd, session->targetFd, session->toTarget, true)
+        || !pump(session, session->targetFd, session->clientFd, session->toClient, false)) {
+        closeSession(session);
+        return;
+    }
+
+    // Both sides have shut down their sending side and everything has been forwarded.
+    bool drained = session->toTarget.pending == 0 && session->toClient.pending == 0;
+    if (drained && session->toTarget.eof && session->toClient.eof) {
+        closeSession(session);
+    }
+}
+
+bool SpliceProxy::pump(Session *session, int src, int dst, Pipe &pipe, bool toTarget)
+{
+    const unsigned int flags = SPLICE_F_MOVE | SPLICE_F_NONBLOCK;
+    while (true) {
+        if (pipe.pending > 0) {
+            sample(session, pipe, toTarget);
+            ssize_t ret = ::splice(pipe.r, nullptr, dst, nullptr, pipe.pending, flags);
+            if (ret > 0) {
+                pipe.pending -= ret;
+                emit bytesForwarded(ret, toTarget);
+                continue;
+            } else if (ret < 0 && errno == EINTR) {
+                continue;
+            }
+
+            // The destination is full, its EPOLLOUT continues.
+            return ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+
+        if (pipe.eof) {
+            return true;
+        }
+
+        ssize_t ret = ::splice(src, nullptr, pipe.w, nullptr, 1 << 20, flags);
+        if (ret > 0) {
+            pipe.pending += ret;
+        } else if (ret == 0) {
+            pipe.eof = true;
+            ::shutdown(dst, SHUT_WR);
+            return true;
+        } else if (errno == EINTR) {
+            continue;
+        } else {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+    }
+}
+
+void SpliceProxy::sample(Session *session, Pipe &pipe, bool toTarget)
+{
+    if (m_sampleInterval <= 0 || m_clock.elapsed() < pipe.nextSample) {
+        return;
+    }
+
+    // tee() copies the pipe buffers by reference, the forwarded bytes are not consumed.
+    const qint64 maxSampleSize = 4096;
+    size_t length = static_cast<size_t>(qMin(pipe.pending, maxSampleSize));
+    ssize_t ret = ::tee(pipe.r, m_samplePipe.w, length, SPLICE_F_NONBLOCK);
+    if (ret <= 0) {
+        return;
+    }
+
+    QByteArray bytes(static_cast<int>(ret), Qt::Uninitialized);
+    ssize_t readLength = ::read(m_samplePipe.r, bytes.data(), bytes.size());
+    if (readLength > 0) {
+        bytes.truncate(static_cast<int>(readLength));
+        emit bytesSampled(bytes, session->flag, toTarget);
+    }
+    pipe.nextSample = m_clock.elapsed() + m_sampleInterval;
+}
+
+void SpliceProxy::closeSession(Session *session)
+{
+    m_sessionsMutex.lock();
+    m_sessions.remove(session->clientFd);
+    m_sessions.remove(session->targetFd);
+    m_sessionsMutex.unlock();
+
+    ::epoll_ctl(m_epollFd, EPOLL_CTL_DEL, session->clientFd, nullptr);
+    ::epoll_ctl(m_epollFd, EPOLL_CTL_DEL, session->targetFd, nullptr);
+    ::close(session->clientFd);
+    ::close(session->targetFd);
+    closePipe(session->toTarget);
+    closePipe(session->toClient);
+    emit sessionClosed(session->flag);
+    delete session;
+}
+
+bool SpliceProxy::openPipe(Pipe &pipe)
+{
+    int fds[2];
+    if (::pipe2(fds, O_NONBLOCK | O_CLOEXEC) < 0) {
+        return false;
+    }
+
+    // A larger pipe moves more per splice() call, the default of 64 KiB is kept if it is refused.
+    ::fcntl(fds[1], F_SETPIPE_SZ, 1 << 20);
+    pipe.r = fds[0];
+    pipe.w = fds[1];
+    return true;
+}
+
+void SpliceProxy::closePipe(Pipe &pipe)
+{
+    for (int *fd : {&pipe.r, &pipe.w}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+    pipe.pending = 0;
+}
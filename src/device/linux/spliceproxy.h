@@ -0,0 +1,92 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QThread>
+
+// Forwards every accepted connection to a target address in the kernel. Both directions are moved
+// with splice() through a pipe of their own, the bytes never reach user space. Optionally a sample
+// of the forwarded bytes is duplicated with tee() and reported with bytesSampled().
+class SpliceProxy : public QThread
+{
+    Q_OBJECT
+public:
+    explicit SpliceProxy(QObject *parent = nullptr);
+    ~SpliceProxy() override;
+
+    void setLowLatency(bool lowLatency);
+    // At most one sample of each direction per interval, 0 means nothing is sampled.
+    void setSampleInterval(int msec);
+    bool open(const QString &address,
+              quint16 port,
+              const QString &targetAddress,
+              quint16 targetPort);
+    void close();
+    void disconnectAllSessions();
+    int sessionCount();
+
+    QString errorString() const;
+
+signals:
+    void sessionOpened(const QString &flag);
+    void sessionClosed(const QString &flag);
+    // toTarget: the bytes are sent by the client to the target, otherwise the other way round.
+    void bytesForwarded(qint64 bytes, bool toTarget);
+    void bytesSampled(const QByteArray &bytes, const QString &flag, bool toTarget);
+    void errorOccurred(const QString &errorString);
+
+protected:
+    void run() override;
+
+private:
+    struct Pipe
+    {
+        int r{-1};
+        int w{-1};
+        qint64 pending{0}; // Bytes in the pipe
+        bool eof{false};   // The source has shut down its sending side
+        qint64 nextSample{0};
+    };
+    struct Session
+    {
+        int clientFd{-1};
+        int targetFd{-1};
+        bool connected{false}; // The target connection is established
+        QString flag;
+        Pipe toTarget;
+        Pipe toClient;
+    };
+
+private:
+    void acceptClients();
+    void handleEvent(Session *session, int fd, quint32 events);
+    bool pump(Session *session, int src, int dst, Pipe &pipe, bool toTarget);
+    void sample(Session *session, Pipe &pipe, bool toTarget);
+    void closeSession(Session *session);
+    bool openPipe(Pipe &pipe);
+    void closePipe(Pipe &pipe);
+
+private:
+    int m_listenFd{-1};
+    int m_epollFd{-1};
+    int m_wakeupFd{-1};
+    Pipe m_samplePipe;
+    QByteArray m_targetAddress; // struct sockaddr_storage
+    QString m_errorString;
+    bool m_lowLatency{false};
+    int m_sampleInterval{0};
+    QElapsedTimer m_clock;
+
+    // The proxy thread opens and closes sessions, the device thread shuts them down.
+    QHash<int, Session *> m_sessions; // client fd and target fd -> session
+    QMutex m_sessionsMutex;
+};
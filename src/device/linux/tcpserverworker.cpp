@@ -0,0 +1,676 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "tcpserverworker.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <QDebug>
+#include <QHostAddress>
+
+#include "device/utilities/lowlatency.h"
+
+namespace {
+
+// The user data of an entry: the operation(4 bits), the client id(28 bits) and the fd(32 bits).
+enum UringOperation : quint64 { UringAccept = 1, UringWakeup, UringRecv, UringPollOut };
+const unsigned uringEntries = 256;
+const unsigned uringBufferCount = 256;
+const unsigned uringBufferSize = 16 * 1024;
+const uint16_t uringBufferGroup = 0;
+
+quint64 uringUserData(quint64 operation, quint32 id, int fd)
+{
+    return (operation << 60) | (static_cast<quint64>(id & 0x0fffffff) << 32)
+           | static_cast<quint32>(fd);
+}
+
+} // namespace
+
+TcpServerWorker::TcpServerWorker(QObject *parent)
+    : QThread(parent)
+{}
+
+TcpServerWorker::~TcpServerWorker()
+{
+    close();
+}
+
+void TcpServerWorker::setQueueLimit(qint64 limit, OutboundQueuePolicy policy)
+{
+    m_queueLimit = limit;
+    m_queuePolicy = policy;
+}
+
+void TcpServerWorker::setLowLatency(bool lowLatency)
+{
+    m_lowLatency = lowLatency;
+}
+
+void TcpServerWorker::setIoUring(bool ioUring)
+{
+    m_ioUring = ioUring;
+}
+
+bool TcpServerWorker::open(const QString &address, quint16 port)
+{
+    close();
+
+    QHostAddress host(address);
+    if (host.isNull()) {
+        m_errorString = tr("Invalid address: %1").arg(address);
+        return false;
+    }
+
+    struct sockaddr_storage addr;
+    memset(&addr, 0, sizeof(addr));
+    socklen_t addrLength = 0;
+    if (host.protocol() == QAbstractSocket::IPv6Protocol) {
+        auto *addr6 = reinterpret_cast<struct sockaddr_in6 *>(&addr);
+        addr6->sin6_family = AF_INET6;
+        addr6->sin6_port = htons(port);
+        Q_IPV6ADDR ip = host.toIPv6Address();
+        memcpy(&addr6->sin6_addr, &ip, sizeof(addr6->sin6_addr));
+        addrLength = sizeof(struct sockaddr_in6);
+    } else {
+        auto *addr4 = reinterpret_cast<struct sockaddr_in *>(&addr);
+        addr4->sin_family = AF_INET;
+        addr4->sin_port = htons(port);
+        addr4->sin_addr.s_addr = htonl(host.toIPv4Address());
+        addrLength = sizeof(struct sockaddr_in);
+    }
+
+    m_listenFd = ::socket(addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    m_epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    m_wakeupFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_listenFd < 0 || m_epollFd < 0 || m_wakeupFd < 0) {
+        m_errorString = QString::fromLocal8Bit(strerror(errno));
+        close();
+        return false;
+    }
+
+    int on = 1;
+    ::setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (::setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0
+        || ::bind(m_listenFd, reinterpret_cast<struct sockaddr *>(&addr), addrLength) < 0
+        || ::listen(m_listenFd, SOMAXCONN) < 0) {
+        m_errorString = QString::fromLocal8Bit(strerror(errno));
+        close();
+        return false;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = m_listenFd;
+    ::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_listenFd, &ev);
+    ev.data.fd = m_wakeupFd;
+    ::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeupFd, &ev);
+
+    m_stopping = false;
+    start();
+    return true;
+}
+
+void TcpServerWorker::close()
+{
+    if (isRunning()) {
+        m_stopping = true;
+        quint64 value = 1;
+        if (::write(m_wakeupFd, &value, sizeof(value)) < 0) {
+            qWarning() << "Failed to wake up the worker:" << strerror(errno);
+        }
+        wait();
+    }
+
+    m_clientsMutex.lock();
+    for (auto it = m_clients.cbegin(); it != m_clients.cend(); ++it) {
+        ::close(it->fd);
+    }
+    m_clients.clear();
+    m_fds.clear();
+    m_pendingWritable.clear();
+    m_clientsMutex.unlock();
+
+    for (int *fd : {&m_listenFd, &m_epollFd, &m_wakeupFd}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+int TcpServerWorker::write(const QByteArray &bytes, const QString &flag, QString *lastFlag)
+{
+    QMutexLocker locker(&m_clientsMutex);
+    if (!flag.isEmpty()) {
+        auto fd = m_fds.constFind(flag);
+        if (fd == m_fds.constEnd()) {
+            return 0;
+        }
+
+        if (!sendBytes(m_clients[*fd], bytes)) {
+            ::shutdown(*fd, SHUT_RDWR);
+            return 0;
+        }
+
+        if (lastFlag) {
+            *lastFlag = flag;
+        }
+        return 1;
+    }
+
+    int count = 0;
+    for (auto it = m_clients.begin(); it != m_clients.end(); ++it) {
+        if (sendBytes(it.value(), bytes)) {
+            if (lastFlag) {
+                *lastFlag = it->flag;
+            }
+            count++;
+        } else {
+            ::shutdown(it->fd, SHUT_RDWR);
+        }
+    }
+
+    return count;
+}
+
+void TcpServerWorker::disconnectAllClients()
+{
+    // The sockets are only shut down here, the worker sees the hang-up and closes them, so a file
+    // descriptor is never reused while the worker may still refer to it.
+    QMutexLocker locker(&m_clientsMutex);
+    for (auto it = m_clients.cbegin(); it != m_clients.cend(); ++it) {
+        ::shutdown(it->fd, SHUT_RDWR);
+    }
+}
+
+QHash<QString, qint64> TcpServerWorker::queueDepths()
+{
+    QHash<QString, qint64> depths;
+    QMutexLocker locker(&m_clientsMutex);
+    for (auto it = m_clients.cbegin(); it != m_clients.cend(); ++it) {
+        qint64 depth = it->head.size() + it->queue.size();
+        if (depth > 0) {
+            depths.insert(it->flag, depth);
+        }
+    }
+
+    return depths;
+}
+
+QString TcpServerWorker::errorString() const
+{
+    return m_errorString;
+}
+
+void TcpServerWorker::run()
+{
+    if (m_ioUring) {
+        if (openUring()) {
+            runUring();
+            m_uringActive = false;
+            m_uring.close();
+            if (!m_uringUnsupported) {
+                return;
+            }
+
+            // The accept never worked, so there is no client to hand over to epoll.
+            errno = EINVAL;
+        }
+
+        emit errorOccurred(tr("io_uring is not available(%1), epoll is used instead.")
+                               .arg(QString::fromLocal8Bit(strerror(errno))));
+    }
+
+    runEpoll();
+}
+
+void TcpServerWorker::runEpoll()
+{
+    const int bufferSize = 64 * 1024;
+    QByteArray buffer(bufferSize, Qt::Uninitialized);
+
+    bool running = true;
+    while (running) {
+        struct epoll_event events[64];
+        int n = ::epoll_wait(m_epollFd, events, 64, -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            emit errorOccurred(QString::fromLocal8Bit(strerror(errno)));
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == m_wakeupFd) {
+                running = false;
+                break;
+            }
+
+            if (fd == m_listenFd) {
+                acceptClients();
+                continue;
+            }
+
+            if (events[i].events & EPOLLOUT) {
+                flushClient(fd);
+            }
+
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP)) {
+                readClient(fd, buffer);
+            }
+        }
+    }
+}
+
+void TcpServerWorker::acceptClients()
+{
+    while (true) {
+        struct sockaddr_storage addr;
+        socklen_t addrLength = sizeof(addr);
+        int fd = ::accept4(m_listenFd,
+                           reinterpret_cast<struct sockaddr *>(&addr),
+                           &addrLength,
+                           SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                emit errorOccurred(QString::fromLocal8Bit(strerror(errno)));
+            }
+            break;
+        }
+
+        addClient(fd, addr);
+    }
+}
+
+void TcpServerWorker::addClient(int fd, const struct sockaddr_storage &addr)
+{
+    // The same format as Socket::makeFlag(), the flags of both backends can not be told apart.
+    QHostAddress peerAddress(reinterpret_cast<const struct sockaddr *>(&addr));
+    quint16 peerPort = addr.ss_family == AF_INET6
+                           ? ntohs(reinterpret_cast<const struct sockaddr_in6 *>(&addr)->sin6_port)
+                           : ntohs(reinterpret_cast<const struct sockaddr_in *>(&addr)->sin_port);
+    const QString flag = QString("%1:%2").arg(peerAddress.toString()).arg(peerPort);
+
+    if (m_lowLatency) {
+        LowLatency::setup(fd, true);
+    }
+
+    Client client;
+    client.fd = fd;
+    client.id = m_nextClientId++;
+    client.flag = flag;
+    client.queue.setLimit(m_queueLimit, m_queuePolicy);
+    m_clientsMutex.lock();
+    m_clients.insert(fd, client);
+    m_fds.insert(flag, fd);
+    m_clientsMutex.unlock();
+
+    if (m_uringActive) {
+        m_uring.prepareMultishotRecv(fd, uringUserData(UringRecv, client.id, fd));
+    } else {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        ::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    emit clientConnected(flag);
+}
+
+void TcpServerWorker::readClient(int fd, QByteArray &buffer)
+{
+    m_clientsMutex.lock();
+    auto it = m_clients.constFind(fd);
+    const QString flag = it == m_clients.constEnd() ? QString() : it->flag;
+    m_clientsMutex.unlock();
+    if (flag.isEmpty()) {
+        return;
+    }
+
+    // At most 16 reads per wake-up, a fast sender must not starve the other clients of the worker.
+    QByteArray bytes;
+    bool closed = false;
+    for (int i = 0; i < 16; ++i) {
+        ssize_t ret = ::recv(fd, buffer.data(), buffer.size(), 0);
+        if (ret > 0) {
+            bytes.append(buffer.constData(), static_cast<int>(ret));
+            if (ret < buffer.size()) {
+                break;
+            }
+        } else if (ret < 0 && errno == EINTR) {
+            continue;
+        } else if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            closed = true;
+            break;
+        }
+    }
+
+    if (!bytes.isEmpty()) {
+        if (m_lowLatency) {
+            LowLatency::rearmQuickAck(fd);
+        }
+        emit bytesRead(bytes, flag);
+    }
+
+    if (closed) {
+        removeClient(fd);
+    }
+}
+
+void TcpServerWorker::flushClient(int fd)
+{
+    QMutexLocker locker(&m_clientsMutex);
+    auto it = m_clients.find(fd);
+    if (it == m_clients.end()) {
+        return;
+    }
+
+    // A failed send is not handled here, EPOLLERR or EPOLLHUP is reported with the same event.
+    while (sendHead(it.value()) && it->head.isEmpty() && !it->queue.isEmpty()) {
+        it->head = it->queue.dequeue();
+    }
+
+    if (it->head.isEmpty()) {
+        setWritable(fd, false);
+    } else if (m_uringActive) {
+        // A poll of the ring fires once.
+        setWritable(fd, true);
+    }
+}
+
+void TcpServerWorker::removeClient(int fd)
+{
+    m_clientsMutex.lock();
+    Client client = m_clients.take(fd);
+    if (m_fds.value(client.flag, -1) == fd) {
+        m_fds.remove(client.flag);
+    }
+    m_clientsMutex.unlock();
+
+    if (m_uringActive) {
+        // The receive has ended already, only a pending POLLOUT still refers to the socket.
+        if (client.pollingOut) {
+            m_uring.prepareCancel(uringUserData(UringPollOut, client.id, fd));
+        }
+    } else {
+        ::epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+    ::close(fd);
+    emit clientDisconnected(client.flag);
+}
+
+bool TcpServerWorker::sendBytes(Client &client, const QByteArray &bytes)
+{
+    // Keep the order, nothing is sent while older bytes are still waiting for EPOLLOUT. False is
+    // returned for a full queue with the DisconnectSlowConsumer policy.
+    if (!client.head.isEmpty()) {
+        return client.queue.enqueue(bytes);
+    }
+
+    client.head = bytes;
+    if (!sendHead(client)) {
+        client.head.clear();
+        return false;
+    }
+
+    if (!client.head.isEmpty()) {
+        setWritable(client.fd, true);
+    }
+
+    return true;
+}
+
+bool TcpServerWorker::sendHead(Client &client)
+{
+    qint64 written = 0;
+    bool ok = true;
+    while (written < client.head.size()) {
+        ssize_t ret = ::send(client.fd,
+                             client.head.constData() + written,
+                             client.head.size() - written,
+                             MSG_NOSIGNAL);
+        if (ret > 0) {
+            written += ret;
+        } else if (ret < 0 && errno == EINTR) {
+            continue;
+        } else if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            ok = false;
+            break;
+        }
+    }
+
+    client.head.remove(0, static_cast<int>(written));
+    return ok;
+}
+
+void TcpServerWorker::setWritable(int fd, bool writable)
+{
+    // The callers hold m_clientsMutex.
+    if (m_uringActive) {
+        if (!writable) {
+            return;
+        }
+
+        // Only the worker thread may submit to the ring, the other threads leave the socket to
+        // the worker and wake it up.
+        if (QThread::currentThread() != this) {
+            m_pendingWritable.append(fd);
+            quint64 value = 1;
+            if (::write(m_wakeupFd, &value, sizeof(value)) < 0) {
+                qWarning() << "Failed to wake up the worker:" << strerror(errno);
+            }
+            return;
+        }
+
+        auto it = m_clients.find(fd);
+        if (it != m_clients.end() && !it->pollingOut) {
+            it->pollingOut = true;
+            m_uring.preparePoll(fd, POLLOUT, false, uringUserData(UringPollOut, it->id, fd));
+        }
+        return;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLRDHUP | (writable ? EPOLLOUT : 0);
+    ev.data.fd = fd;
+    ::epoll_ctl(m_epollFd, EPOLL_CTL_MOD, fd, &ev);
+}
+
+bool TcpServerWorker::openUring()
+{
+    // The ring is created by the worker thread, it is the only thread that submits to it.
+    m_uringUnsupported = false;
+    m_uringAccepted = false;
+    if (!m_uring.open(uringEntries)) {
+        return false;
+    }
+
+    // Multishot accept(5.19) and receive(6.0) are flags, not operations, so they cannot be probed.
+    // IORING_OP_SEND_ZC came with 6.0 and stands in for them, older kernels reject them(EINVAL).
+    for (uint8_t opcode : {IORING_OP_ACCEPT,
+                           IORING_OP_RECV,
+                           IORING_OP_POLL_ADD,
+                           IORING_OP_PROVIDE_BUFFERS,
+                           IORING_OP_SEND_ZC}) {
+        if (!m_uring.supports(opcode)) {
+            m_uring.close();
+            errno = EOPNOTSUPP;
+            return false;
+        }
+    }
+
+    if (!m_uring.setupBuffers(uringBufferGroup, uringBufferCount, uringBufferSize)) {
+        int error = errno;
+        m_uring.close();
+        errno = error;
+        return false;
+    }
+
+    m_uringActive = true;
+    m_uring.prepareMultishotAccept(m_listenFd, uringUserData(UringAccept, 0, m_listenFd));
+    m_uring.preparePoll(m_wakeupFd, POLLIN, true, uringUserData(UringWakeup, 0, m_wakeupFd));
+    return true;
+}
+
+void TcpServerWorker::runUring()
+{
+    QHash<int, QByteArray> received;
+    while (!m_stopping && !m_uringUnsupported) {
+        // Busy means the completion queue is full, it is drained below.
+        if (m_uring.submit(1) < 0 && errno != EBUSY && errno != EAGAIN) {
+            emit errorOccurred(QString::fromLocal8Bit(strerror(errno)));
+            break;
+        }
+
+        // The bytes of all completions of a client are emitted at once.
+        m_uring.handleCompletions([this, &received](const struct io_uring_cqe &cqe) {
+            handleCompletion(cqe, received);
+        });
+        const QList<int> fds = received.keys();
+        for (int fd : fds) {
+            emitReceived(fd, received);
+        }
+    }
+}
+
+void TcpServerWorker::handleCompletion(const struct io_uring_cqe &cqe,
+                                       QHash<int, QByteArray> &received)
+{
+    // Provided buffers and cancellations
+    if (cqe.user_data == 0) {
+        return;
+    }
+
+    const quint64 operation = cqe.user_data >> 60;
+    const quint32 id = static_cast<quint32>(cqe.user_data >> 32) & 0x0fffffff;
+    const int fd = static_cast<int>(static_cast<quint32>(cqe.user_data));
+    const bool more = cqe.flags & IORING_CQE_F_MORE;
+
+    if (operation == UringAccept) {
+        if (cqe.res >= 0) {
+            struct sockaddr_storage addr;
+            memset(&addr, 0, sizeof(addr));
+            socklen_t addrLength = sizeof(addr);
+            ::getpeername(cqe.res, reinterpret_cast<struct sockaddr *>(&addr), &addrLength);
+            addClient(cqe.res, addr);
+            m_uringAccepted = true;
+        } else if (cqe.res == -EINVAL && !m_uringAccepted) {
+            // Multishot accept is not supported after all, the worker falls back to epoll.
+            m_uringUnsupported = true;
+            return;
+        } else if (cqe.res != -ECONNABORTED && cqe.res != -EINTR) {
+            emit errorOccurred(QString::fromLocal8Bit(strerror(-cqe.res)));
+        }
+
+        if (!more) {
+            m_uring.prepareMultishotAccept(m_listenFd, cqe.user_data);
+        }
+        return;
+    }
+
+    if (operation == UringWakeup) {
+        quint64 value = 0;
+        if (::read(m_wakeupFd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+            qWarning() << "Failed to read the wake-up event:" << strerror(errno);
+        }
+        if (!more) {
+            m_uring.preparePoll(m_wakeupFd, POLLIN, true, cqe.user_data);
+        }
+        armPendingWritable();
+        return;
+    }
+
+    m_clientsMutex.lock();
+    auto it = m_clients.find(fd);
+    bool isCurrent = it != m_clients.end() && it->id == id;
+    if (isCurrent && operation == UringPollOut) {
+        it->pollingOut = false;
+    }
+    m_clientsMutex.unlock();
+
+    if (operation == UringPollOut) {
+        if (isCurrent) {
+            flushClient(fd);
+        }
+        return;
+    }
+
+    // UringRecv, the buffer goes back to the kernel with the next submission.
+    if (cqe.flags & IORING_CQE_F_BUFFER) {
+        uint16_t bufferId = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        if (isCurrent && cqe.res > 0) {
+            received[fd].append(m_uring.buffer(bufferId), cqe.res);
+        }
+        m_uring.recycleBuffer(bufferId);
+    }
+
+    if (!isCurrent || more) {
+        return;
+    }
+
+    if (cqe.res > 0 || cqe.res == -ENOBUFS) {
+        // Ended because it was out of buffers, they are provided again before it is re-armed.
+        m_uring.prepareMultishotRecv(fd, cqe.user_data);
+    } else if (cqe.res != -ECANCELED) {
+        emitReceived(fd, received);
+        removeClient(fd);
+    }
+}
+
+void TcpServerWorker::emitReceived(int fd, QHash<int, QByteArray> &received)
+{
+    QByteArray bytes = received.take(fd);
+    if (bytes.isEmpty()) {
+        return;
+    }
+
+    m_clientsMutex.lock();
+    auto it = m_clients.constFind(fd);
+    const QString flag = it == m_clients.constEnd() ? QString() : it->flag;
+    m_clientsMutex.unlock();
+    if (flag.isEmpty()) {
+        return;
+    }
+
+    if (m_lowLatency) {
+        LowLatency::rearmQuickAck(fd);
+    }
+    emit bytesRead(bytes, flag);
+}
+
+void TcpServerWorker::armPendingWritable()
+{
+    QMutexLocker locker(&m_clientsMutex);
+    for (auto it = m_pendingWritable.cbegin(); it != m_pendingWritable.cend(); ++it) {
+        setWritable(*it, true);
+    }
+    m_pendingWritable.clear();
+}
@@ -0,0 +1,108 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <atomic>
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QThread>
+
+#include "device/linux/uring.h"
+#include "device/utilities/outboundqueue.h"
+
+// One shard of the multi-threaded TCP server backend. Every worker owns a listening socket bound
+// with SO_REUSEPORT to the same address, the kernel spreads incoming connections over the workers.
+// The thread itself waits on epoll, accepts clients and reads them; writes are sent directly from
+// the calling thread, only what the kernel does not take is queued and left to the
+// worker(EPOLLOUT). With io_uring enabled the worker waits on its own ring instead of epoll: one
+// multishot accept, one multishot receive per client into provided buffers and one-shot POLLOUT
+// polls, all completions of a wake-up are handled in one pass and the next entries are submitted
+// with a single syscall.
+class TcpServerWorker : public QThread
+{
+    Q_OBJECT
+public:
+    explicit TcpServerWorker(QObject *parent = nullptr);
+    ~TcpServerWorker() override;
+
+    void setQueueLimit(qint64 limit, OutboundQueuePolicy policy);
+    void setLowLatency(bool lowLatency);
+    void setIoUring(bool ioUring);
+    bool open(const QString &address, quint16 port);
+    void close();
+    // An empty flag writes to all clients of the worker, returns the number of clients written.
+    int write(const QByteArray &bytes, const QString &flag, QString *lastFlag = nullptr);
+    void disconnectAllClients();
+    QHash<QString, qint64> queueDepths();
+
+    QString errorString() const;
+
+signals:
+    void clientConnected(const QString &flag);
+    void clientDisconnected(const QString &flag);
+    void bytesRead(const QByteArray &bytes, const QString &flag);
+    void errorOccurred(const QString &errorString);
+
+protected:
+    void run() override;
+
+private:
+    struct Client
+    {
+        int fd;
+        quint32 id; // Tells the completions of a reused file descriptor apart(io_uring)
+        bool pollingOut{false};
+        QString flag;
+        QByteArray head;     // The rest of the message the kernel has partly accepted
+        OutboundQueue queue; // The messages behind the head
+    };
+
+private:
+    void runEpoll();
+    void acceptClients();
+    void addClient(int fd, const struct sockaddr_storage &addr);
+    void readClient(int fd, QByteArray &buffer);
+    void flushClient(int fd);
+    void removeClient(int fd);
+    bool sendBytes(Client &client, const QByteArray &bytes);
+    bool sendHead(Client &client);
+    void setWritable(int fd, bool writable);
+
+    bool openUring();
+    void runUring();
+    void handleCompletion(const struct io_uring_cqe &cqe, QHash<int, QByteArray> &received);
+    void emitReceived(int fd, QHash<int, QByteArray> &received);
+    void armPendingWritable();
+
+private:
+    int m_listenFd{-1};
+    int m_epollFd{-1};
+    int m_wakeupFd{-1};
+    QString m_errorString;
+    qint64 m_queueLimit{0};
+    OutboundQueuePolicy m_queuePolicy{OutboundQueuePolicy::DropOldest};
+    bool m_lowLatency{false};
+    bool m_ioUring{false};
+    std::atomic_bool m_stopping{false};
+
+    // Touched by the worker thread only, except m_uringActive.
+    Uring m_uring;
+    std::atomic_bool m_uringActive{false};
+    bool m_uringUnsupported{false};
+    bool m_uringAccepted{false};
+    quint32 m_nextClientId{0};
+
+    // The worker thread adds and removes clients, the device thread writes to them.
+    QHash<int, Client> m_clients; // fd -> client
+    QHash<QString, int> m_fds;    // flag -> fd
+    QList<int> m_pendingWritable; // POLLOUT asked for by the device thread(io_uring)
+    QMutex m_clientsMutex;
+};
@@ -0,0 +1,346 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "uring.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+Uring::Uring() {}
+
+Uring::~Uring()
+{
+    close();
+}
+
+bool Uring::open(unsigned entries)
+{
+    close();
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    // Only the owning thread submits, the kernel may skip some locking and defer task work to
+    // io_uring_enter().
+    params.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN;
+    m_fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+    if (m_fd < 0) {
+        // Kernels before 6.0 do not know the flags.
+        memset(&params, 0, sizeof(params));
+        m_fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+    }
+    if (m_fd < 0) {
+        return false;
+    }
+
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+    }
+
+    m_sqRing = ::mmap(nullptr,
+                      m_sqRingSize,
+                      PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE,
+                      m_fd,
+                      IORING_OFF_SQ_RING);
+    if (m_sqRing == MAP_FAILED) {
+        m_sqRing = nullptr;
+        close();
+        return false;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        m_cqRing = m_sqRing;
+    } else {
+        m_cqRing = ::mmap(nullptr,
+                          m_cqRingSize,
+                          PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE,
+                          m_fd,
+                          IORING_OFF_CQ_RING);
+        if (m_cqRing == MAP_FAILED) {
+            m_cqRing = nullptr;
+            close();
+            return false;
+        }
+    }
+
+    m_sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = ::mmap(nullptr,
+                        m_sqesSize,
+                        PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE,
+                        m_fd,
+                        IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        close();
+        return false;
+    }
+    m_sqes = static_cast<struct io_uring_sqe *>(sqes);
+
+    char *sq = static_cast<char *>(m_sqRing);
+    m_sqHead = reinterpret_cast<std::atomic<unsigned> *>(sq + params.sq_off.head);
+    m_sqTail = reinterpret_cast<std::atomic<unsigned> *>(sq + params.sq_off.tail);
+    m_sqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    m_sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    m_sqEntries = params.sq_entries;
+    m_sqLocalTail = m_sqTail->load(std::memory_order_relaxed);
+
+    char *cq = static_cast<char *>(m_cqRing);
+    m_cqHead = reinterpret_cast<std::atomic<unsigned> *>(cq + params.cq_off.head);
+    m_cqTail = reinterpret_cast<std::atomic<unsigned> *>(cq + params.cq_off.tail);
+    m_cqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    m_cqes = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+    return true;
+}
+
+void Uring::close()
+{
+    delete[] m_buffers;
+    m_buffers = nullptr;
+    m_bufferCount = 0;
+
+    if (m_sqes) {
+        ::munmap(m_sqes, m_sqesSize);
+        m_sqes = nullptr;
+    }
+    if (m_cqRing && m_cqRing != m_sqRing) {
+        ::munmap(m_cqRing, m_cqRingSize);
+    }
+    m_cqRing = nullptr;
+    if (m_sqRing) {
+        ::munmap(m_sqRing, m_sqRingSize);
+        m_sqRing = nullptr;
+    }
+
+    // Provided buffers are released with the ring.
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+bool Uring::isOpen() const
+{
+    return m_fd >= 0;
+}
+
+bool Uring::supports(uint8_t opcode) const
+{
+    // The kernel fills in at most 256 operations.
+    const unsigned count = 256;
+    std::vector<char> buffer(sizeof(struct io_uring_probe)
+                                 + count * sizeof(struct io_uring_probe_op),
+                             0);
+    auto *probe = reinterpret_cast<struct io_uring_probe *>(buffer.data());
+    if (::syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_PROBE, probe, count) < 0) {
+        return false;
+    }
+
+    return opcode <= probe->last_op && (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED);
+}
+
+struct io_uring_sqe *Uring::nextSqe()
+{
+    // A full queue is handed to the kernel first, a batch is never larger than the queue.
+    unsigned head = m_sqHead->load(std::memory_order_acquire);
+    if (m_sqLocalTail - head >= m_sqEntries) {
+        submit(0);
+        head = m_sqHead->load(std::memory_order_acquire);
+        if (m_sqLocalTail - head >= m_sqEntries) {
+            return nullptr;
+        }
+    }
+
+    unsigned index = m_sqLocalTail & m_sqMask;
+    struct io_uring_sqe *sqe = &m_sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    m_sqArray[index] = index;
+    m_sqLocalTail++;
+    return sqe;
+}
+
+int Uring::submit(unsigned waitFor)
+{
+    unsigned tail = m_sqTail->load(std::memory_order_relaxed);
+    unsigned toSubmit = m_sqLocalTail - tail;
+    m_sqTail->store(m_sqLocalTail, std::memory_order_release);
+
+    unsigned flags = waitFor > 0 ? IORING_ENTER_GETEVENTS : 0;
+    while (true) {
+        long ret = ::syscall(__NR_io_uring_enter, m_fd, toSubmit, waitFor, flags, nullptr, 0);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+
+        return static_cast<int>(ret);
+    }
+}
+
+bool Uring::setupBuffers(uint16_t group, unsigned count, unsigned size)
+{
+    // Buffer ids are 16 bits wide.
+    if (count == 0 || count > 65536 || size == 0) {
+        errno = EINVAL;
+        return false;
+    }
+
+    delete[] m_buffers;
+    m_buffers = new char[static_cast<size_t>(count) * size];
+    m_bufferCount = count;
+    m_bufferSize = size;
+    m_bufferGroup = group;
+
+    // Provided with IORING_OP_PROVIDE_BUFFERS rather than a registered buffer ring
+    // (IORING_REGISTER_PBUF_RING), some kernels accept the ring but never select from it.
+    struct io_uring_sqe *sqe = nextSqe();
+    if (!sqe) {
+        errno = EBUSY;
+        return false;
+    }
+
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = static_cast<int>(count);
+    sqe->addr = reinterpret_cast<uint64_t>(m_buffers);
+    sqe->len = size;
+    sqe->off = 0;
+    sqe->buf_group = group;
+    sqe->user_data = 0;
+    return submit(0) >= 0;
+}
+
+char *Uring::buffer(uint16_t id) const
+{
+    return m_buffers + static_cast<size_t>(id) * m_bufferSize;
+}
+
+void Uring::recycleBuffer(uint16_t id)
+{
+    // Handed back with the next submit(), together with everything else prepared.
+    struct io_uring_sqe *sqe = nextSqe();
+    if (!sqe) {
+        return;
+    }
+
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = 1;
+    sqe->addr = reinterpret_cast<uint64_t>(buffer(id));
+    sqe->len = m_bufferSize;
+    sqe->off = id;
+    sqe->buf_group = m_bufferGroup;
+    sqe->user_data = 0;
+}
+
+bool Uring::registerBuffers(const struct iovec *buffers, unsigned count)
+{
+    return ::syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_BUFFERS, buffers, count) == 0;
+}
+
+void Uring::prepareMultishotAccept(int fd, uint64_t userData)
+{
+    struct io_uring_sqe *sqe = nextSqe();
+    if (!sqe) {
+        return;
+    }
+
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = userData;
+}
+
+void Uring::prepareMultishotRecv(int fd, uint64_t userData)
+{
+    struct io_uring_sqe *sqe = nextSqe();
+    if (!sqe) {
+        return;
+    }
+
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = m_bufferGroup;
+    sqe->user_data = userData;
+}
+
+void Uring::preparePoll(int fd, unsigned events, bool multishot, uint64_t userData)
+{
+    struct io_uring_sqe *sqe = nextSqe();
+    if (!sqe) {
+        return;
+    }
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = events;
+    sqe->len = multishot ? IORING_POLL_ADD_MULTI : 0;
+    sqe->user_data = userData;
+}
+
+void Uring::prepareCancel(uint64_t targetUserData)
+{
+    struct io_uring_sqe *sqe = nextSqe();
+    if (!sqe) {
+        return;
+    }
+
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = targetUserData;
+    sqe->user_data = 0;
+}
+
+void Uring::prepareReadFixed(int fd, char *data, unsigned size, uint16_t index, uint64_t userData)
+{
+    struct io_uring_sqe *sqe = nextSqe();
+    if (!sqe) {
+        return;
+    }
+
+    // No offset, the file position of a character device or a stream is not used.
+    sqe->opcode = IORING_OP_READ_FIXED;
+    sqe->fd = fd;
+    sqe->off = static_cast<uint64_t>(-1);
+    sqe->addr = reinterpret_cast<uint64_t>(data);
+    sqe->len = size;
+    sqe->buf_index = index;
+    sqe->user_data = userData;
+}
+
+void Uring::prepareWriteFixed(
+    int fd, const char *data, unsigned size, uint16_t index, uint64_t userData)
+{
+    struct io_uring_sqe *sqe = nextSqe();
+    if (!sqe) {
+        return;
+    }
+
+    sqe->opcode = IORING_OP_WRITE_FIXED;
+    sqe->fd = fd;
+    sqe->off = static_cast<uint64_t>(-1);
+    sqe->addr = reinterpret_cast<uint64_t>(data);
+    sqe->len = size;
+    sqe->buf_index = index;
+    sqe->user_data = userData;
+}
+
+void Uring::linkToNext()
+{
+    if (m_sqLocalTail != m_sqTail->load(std::memory_order_relaxed)) {
+        m_sqes[(m_sqLocalTail - 1) & m_sqMask].flags |= IOSQE_IO_LINK;
+    }
+}
@@ -0,0 +1,101 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+// A minimal io_uring built on the raw syscalls, no liburing is required. It is meant to be used by
+// one thread only: prepared entries are submitted in a batch by submit(), received bytes land in a
+// group of buffers provided to the kernel, so multishot receives can pick them. Fixed reads and
+// writes use buffers registered once, the kernel does not map them for every operation. Internal
+// entries (provided buffers, cancellations) complete with user data 0.
+class Uring
+{
+public:
+    Uring();
+    ~Uring();
+
+    bool open(unsigned entries);
+    void close();
+    bool isOpen() const;
+    // Asks the kernel with IORING_REGISTER_PROBE, false if it cannot tell.
+    bool supports(uint8_t opcode) const;
+
+    // Returns nullptr if the submission queue is still full after submitting the prepared entries.
+    struct io_uring_sqe *nextSqe();
+    // Submits everything prepared with one syscall, waits for at least waitFor completions.
+    int submit(unsigned waitFor);
+
+    // Calls handler(const io_uring_cqe &) for every completion, returns how many were handled.
+    template<typename Handler>
+    unsigned handleCompletions(Handler handler);
+
+    bool setupBuffers(uint16_t group, unsigned count, unsigned size);
+    char *buffer(uint16_t id) const;
+    void recycleBuffer(uint16_t id);
+    // IORING_REGISTER_BUFFERS, the buffers are used by index with the fixed reads and writes.
+    bool registerBuffers(const struct iovec *buffers, unsigned count);
+
+    void prepareMultishotAccept(int fd, uint64_t userData);
+    void prepareMultishotRecv(int fd, uint64_t userData);
+    void preparePoll(int fd, unsigned events, bool multishot, uint64_t userData);
+    void prepareCancel(uint64_t targetUserData);
+    void prepareReadFixed(int fd, char *data, unsigned size, uint16_t index, uint64_t userData);
+    void prepareWriteFixed(
+        int fd, const char *data, unsigned size, uint16_t index, uint64_t userData);
+    // The next entry starts once the last prepared one has completed successfully, it has to be
+    // prepared before anything else is.
+    void linkToNext();
+
+private:
+    int m_fd{-1};
+    void *m_sqRing{nullptr};
+    void *m_cqRing{nullptr};
+    size_t m_sqRingSize{0};
+    size_t m_cqRingSize{0};
+    struct io_uring_sqe *m_sqes{nullptr};
+    size_t m_sqesSize{0};
+
+    std::atomic<unsigned> *m_sqHead{nullptr};
+    std::atomic<unsigned> *m_sqTail{nullptr};
+    unsigned m_sqMask{0};
+    unsigned *m_sqArray{nullptr};
+    unsigned m_sqLocalTail{0}; // Prepared but not published yet
+    unsigned m_sqEntries{0};
+
+    std::atomic<unsigned> *m_cqHead{nullptr};
+    std::atomic<unsigned> *m_cqTail{nullptr};
+    unsigned m_cqMask{0};
+    struct io_uring_cqe *m_cqes{nullptr};
+
+    // Provided buffers
+    char *m_buffers{nullptr};
+    unsigned m_bufferCount{0};
+    unsigned m_bufferSize{0};
+    uint16_t m_bufferGroup{0};
+};
+
+template<typename Handler>
+unsigned Uring::handleCompletions(Handler handler)
+{
+    unsigned head = m_cqHead->load(std::memory_order_relaxed);
+    const unsigned tail = m_cqTail->load(std::memory_order_acquire);
+    unsigned count = 0;
+    for (; head != tail; ++head, ++count) {
+        handler(m_cqes[head & m_cqMask]);
+    }
+
+    m_cqHead->store(head, std::memory_order_release);
+    return count;
+}
@@ -0,0 +1,472 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+/*
+ * Shared-memory message rings of the shared memory device, header-only and usable from C and C++
+ * (gcc or clang, Linux). Copy the file into a process to attach to a segment created by xTools:
+ *
+ *     struct xtools_ring ring;
+ *     while (xtools_ring_attach(&ring, "/xtools.shm") == -EAGAIN) usleep(1000);
+ *     xtools_ring_write(&ring, XTOOLS_RING_IN, data, length); // to xTools
+ *     xtools_ring_wait(&ring, XTOOLS_RING_OUT, 100000, 50);   // from xTools
+ *     while (xtools_ring_peek(&ring, XTOOLS_RING_OUT, &data, &length) > 0) {
+ *         ...
+ *         xtools_ring_release(&ring, XTOOLS_RING_OUT);
+ *     }
+ *     xtools_ring_detach(&ring);
+ *
+ * A segment holds two rings of 64-byte cells, each of them takes messages of any number of
+ * producers(threads or processes) and is read by one consumer. A message starts at a cell with
+ * {length, cell count} and is never split at the end of a ring, the rest of the ring is skipped
+ * with a padding record instead. A producer reserves its cells with one compare-and-swap of the
+ * head, copies the message and publishes it by storing position + 1 into the stamp of its first
+ * cell; the consumer takes the record at the tail when its stamp matches, so a record is read in
+ * the order it was reserved and never before it is complete. A producer that is preempted between
+ * reserving and publishing holds up the consumer until it continues.
+ *
+ * A full ring is not waited for, the message is counted as dropped and -EAGAIN is returned. An
+ * idle consumer spins for a while and then sleeps on a futex in the segment, a producer wakes it
+ * only if it is sleeping, so no syscall is made while the consumer keeps up.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define XTOOLS_RING_MAGIC 0x48535458u /* "XTSH" */
+#define XTOOLS_RING_VERSION 1u
+#define XTOOLS_RING_CELL 64u
+#define XTOOLS_RING_OFFSET 4096u /* The rings start at the second page of the segment */
+#define XTOOLS_RING_MIN_CELLS 64u
+#define XTOOLS_RING_MAX_CELLS (1u << 26) /* 4 GiB per ring */
+#define XTOOLS_RING_PADDING 0xffffffffu
+
+#define XTOOLS_RING_IN 0  /* To xTools */
+#define XTOOLS_RING_OUT 1 /* From xTools */
+
+#define XTOOLS_RING_REPLACE 1 /* Of xtools_ring_create(), take the name over from a segment */
+
+/* The fields written by the producers, by the consumer and by both do not share a cache line. */
+struct xtools_ring_control
+{
+    uint64_t head; /* Reserved by the producers, in cells */
+    char headPadding[56];
+    uint64_t tail; /* Released by the consumer, in cells */
+    char tailPadding[56];
+    uint32_t wake;    /* Futex word, incremented to wake the consumer */
+    uint32_t waiting; /* Set by the consumer before it sleeps */
+    char wakePadding[56];
+    uint64_t dropped; /* Messages not written because the ring was full */
+    char droppedPadding[56];
+};
+
+struct xtools_shm_header
+{
+    uint32_t magic; /* Stored last by the creator */
+    uint32_t version;
+    uint32_t cells; /* Of each ring, a power of two */
+    uint32_t closed;
+    uint64_t size; /* Of the segment */
+    char padding[40];
+    struct xtools_ring_control rings[2];
+};
+
+struct xtools_ring_record
+{
+    uint32_t length; /* Of the message, XTOOLS_RING_PADDING for a padding record */
+    uint32_t cells;  /* Taken by the record */
+};
+
+/* Process-local handle of a mapped segment. */
+struct xtools_ring
+{
+    struct xtools_shm_header *header;
+    size_t size;
+    uint32_t cells;
+    int creator;
+    char name[256];
+    dev_t device; /* Of the created segment, the name is only unlinked while it refers to it */
+    ino_t inode;
+};
+
+static inline size_t xtools_ring_segment_size(uint32_t cells)
+{
+    return XTOOLS_RING_OFFSET + 2 * (size_t) cells * (sizeof(uint64_t) + XTOOLS_RING_CELL);
+}
+
+/* The largest message a ring of the segment takes. */
+static inline uint32_t xtools_ring_max_length(const struct xtools_ring *ring)
+{
+    return ring->cells / 2 * XTOOLS_RING_CELL - (uint32_t) sizeof(struct xtools_ring_record);
+}
+
+static inline uint64_t *xtools_ring_stamps(const struct xtools_ring *ring, int which)
+{
+    size_t offset = XTOOLS_RING_OFFSET
+                    + (size_t) which * ring->cells * (sizeof(uint64_t) + XTOOLS_RING_CELL);
+    return (uint64_t *) ((char *) ring->header + offset);
+}
+
+static inline struct xtools_ring_record *xtools_ring_cell(const struct xtools_ring *ring,
+                                                          int which,
+                                                          uint64_t position)
+{
+    char *cells = (char *) (xtools_ring_stamps(ring, which) + ring->cells);
+    size_t index = (size_t) (position & (ring->cells - 1));
+    return (struct xtools_ring_record *) (cells + index * XTOOLS_RING_CELL);
+}
+
+static inline long xtools_ring_futex(uint32_t *word, int op, uint32_t value,
+                                     const struct timespec *timeout)
+{
+    return syscall(SYS_futex, word, op, value, timeout, NULL, 0);
+}
+
+/*
+ * Creates the segment. Returns -EEXIST if the name is taken, by a running xTools or by a segment a
+ * crashed process left behind. With XTOOLS_RING_REPLACE the existing segment is unlinked and a new
+ * one is created, the processes attached to the old one keep it mapped but are no longer reached.
+ */
+static inline int xtools_ring_create(struct xtools_ring *ring,
+                                     const char *name,
+                                     uint32_t cells,
+                                     int flags)
+{
+    memset(ring, 0, sizeof(*ring));
+    if (cells < XTOOLS_RING_MIN_CELLS || cells > XTOOLS_RING_MAX_CELLS || (cells & (cells - 1))
+        || strlen(name) >= sizeof(ring->name)) {
+        return -EINVAL;
+    }
+
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    if (fd < 0 && errno == EEXIST && (flags & XTOOLS_RING_REPLACE)) {
+        shm_unlink(name);
+        fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    }
+    if (fd < 0) {
+        return -errno;
+    }
+
+    struct stat st;
+    size_t size = xtools_ring_segment_size(cells);
+    if (fstat(fd, &st) < 0 || ftruncate(fd, (off_t) size) < 0) {
+        int error = errno;
+        close(fd);
+        shm_unlink(name);
+        return -error;
+    }
+
+    void *address = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int error = errno;
+    close(fd);
+    if (address == MAP_FAILED) {
+        shm_unlink(name);
+        return -error;
+    }
+
+    /* The segment is zero-filled by ftruncate(), the rings are empty. */
+    struct xtools_shm_header *header = (struct xtools_shm_header *) address;
+    header->version = XTOOLS_RING_VERSION;
+    header->cells = cells;
+    header->size = size;
+    __atomic_store_n(&header->magic, XTOOLS_RING_MAGIC, __ATOMIC_RELEASE);
+
+    ring->header = header;
+    ring->size = size;
+    ring->cells = cells;
+    ring->creator = 1;
+    strcpy(ring->name, name);
+    ring->device = st.st_dev;
+    ring->inode = st.st_ino;
+    return 0;
+}
+
+/* Returns -ENOENT or -EAGAIN while the segment is not created completely, retry later. */
+static inline int xtools_ring_attach(struct xtools_ring *ring, const char *name)
+{
+    memset(ring, 0, sizeof(*ring));
+    int fd = shm_open(name, O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return -errno;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        int error = errno;
+        close(fd);
+        return -error;
+    }
+
+    if ((size_t) st.st_size < XTOOLS_RING_OFFSET) {
+        close(fd);
+        return -EAGAIN;
+    }
+
+    size_t size = (size_t) st.st_size;
+    void *address = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int error = errno;
+    close(fd);
+    if (address == MAP_FAILED) {
+        return -error;
+    }
+
+    struct xtools_shm_header *header = (struct xtools_shm_header *) address;
+    int ret = 0;
+    if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != XTOOLS_RING_MAGIC) {
+        ret = -EAGAIN;
+    } else if (header->version != XTOOLS_RING_VERSION || header->size != size
+               || xtools_ring_segment_size(header->cells) != size) {
+        ret = -EPROTO;
+    }
+
+    if (ret < 0) {
+        munmap(address, size);
+        return ret;
+    }
+
+    ring->header = header;
+    ring->size = size;
+    ring->cells = header->cells;
+    return 0;
+}
+
+/* Tells the other side the segment is going away, the sleeping consumers are woken. */
+static inline void xtools_ring_close(struct xtools_ring *ring)
+{
+    __atomic_store_n(&ring->header->closed, 1, __ATOMIC_RELEASE);
+    for (int i = 0; i < 2; ++i) {
+        __atomic_add_fetch(&ring->header->rings[i].wake, 1, __ATOMIC_RELEASE);
+        xtools_ring_futex(&ring->header->rings[i].wake, FUTEX_WAKE, INT_MAX, NULL);
+    }
+}
+
+static inline int xtools_ring_is_closed(const struct xtools_ring *ring)
+{
+    return __atomic_load_n(&ring->header->closed, __ATOMIC_ACQUIRE) != 0;
+}
+
+/* Unmaps the segment, the creator unlinks it too unless it has been replaced meanwhile. */
+static inline void xtools_ring_detach(struct xtools_ring *ring)
+{
+    if (ring->header) {
+        munmap(ring->header, ring->size);
+        ring->header = NULL;
+    }
+
+    if (ring->creator) {
+        int fd = shm_open(ring->name, O_RDONLY | O_CLOEXEC, 0);
+        if (fd >= 0) {
+            struct stat st;
+            if (fstat(fd, &st) == 0 && st.st_dev == ring->device && st.st_ino == ring->inode) {
+                shm_unlink(ring->name);
+            }
+            close(fd);
+        }
+        ring->creator = 0;
+    }
+}
+
+static inline uint64_t xtools_ring_dropped(const struct xtools_ring *ring, int which)
+{
+    return __atomic_load_n(&ring->header->rings[which].dropped, __ATOMIC_RELAXED);
+}
+
+/* Returns 0, -EAGAIN if the ring is full, -EMSGSIZE or -EPIPE if the segment is closed. */
+static inline int xtools_ring_write(struct xtools_ring *ring,
+                                    int which,
+                                    const void *data,
+                                    uint32_t length)
+{
+    struct xtools_ring_control *control = &ring->header->rings[which];
+    const uint64_t cells = ring->cells;
+    const uint64_t count = ((uint64_t) length + sizeof(struct xtools_ring_record)
+                            + XTOOLS_RING_CELL - 1)
+                           / XTOOLS_RING_CELL;
+    if (count > cells / 2) {
+        return -EMSGSIZE;
+    }
+
+    if (xtools_ring_is_closed(ring)) {
+        return -EPIPE;
+    }
+
+    uint64_t head = __atomic_load_n(&control->head, __ATOMIC_RELAXED);
+    uint64_t padding = 0;
+    for (;;) {
+        /* The tail is read after the head, it passes a stale head if the ring has been drained. */
+        uint64_t tail = __atomic_load_n(&control->tail, __ATOMIC_ACQUIRE);
+        if ((int64_t) (head - tail) < 0) {
+            head = __atomic_load_n(&control->head, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        uint64_t index = head & (cells - 1);
+        padding = index + count > cells ? cells - index : 0;
+        if (head + padding + count - tail > cells) {
+            __atomic_add_fetch(&control->dropped, 1, __ATOMIC_RELAXED);
+            return -EAGAIN;
+        }
+
+        if (__atomic_compare_exchange_n(&control->head,
+                                        &head,
+                                        head + padding + count,
+                                        1,
+                                        __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+
+    uint64_t *stamps = xtools_ring_stamps(ring, which);
+    if (padding) {
+        struct xtools_ring_record *record = xtools_ring_cell(ring, which, head);
+        record->length = XTOOLS_RING_PADDING;
+        record->cells = (uint32_t) padding;
+        __atomic_store_n(&stamps[head & (cells - 1)], head + 1, __ATOMIC_RELEASE);
+        head += padding;
+    }
+
+    struct xtools_ring_record *record = xtools_ring_cell(ring, which, head);
+    record->length = length;
+    record->cells = (uint32_t) count;
+    memcpy(record + 1, data, length);
+    __atomic_store_n(&stamps[head & (cells - 1)], head + 1, __ATOMIC_RELEASE);
+
+    /* Pairs with the fence of xtools_ring_wait(): the consumer sees the stamp or we see it wait. */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&control->waiting, __ATOMIC_RELAXED)) {
+        __atomic_add_fetch(&control->wake, 1, __ATOMIC_RELEASE);
+        xtools_ring_futex(&control->wake, FUTEX_WAKE, 1, NULL);
+    }
+
+    return 0;
+}
+
+/* The consumer side, one thread of one process per ring. */
+static inline int xtools_ring_is_ready(const struct xtools_ring *ring, int which)
+{
+    uint64_t tail = __atomic_load_n(&ring->header->rings[which].tail, __ATOMIC_RELAXED);
+    uint64_t *stamp = &xtools_ring_stamps(ring, which)[tail & (ring->cells - 1)];
+    return __atomic_load_n(stamp, __ATOMIC_ACQUIRE) == tail + 1;
+}
+
+/* Returns 1 and the oldest message, it stays valid until xtools_ring_release(), or 0. */
+static inline int xtools_ring_peek(struct xtools_ring *ring,
+                                   int which,
+                                   const void **data,
+                                   uint32_t *length)
+{
+    struct xtools_ring_control *control = &ring->header->rings[which];
+    while (xtools_ring_is_ready(ring, which)) {
+        uint64_t tail = __atomic_load_n(&control->tail, __ATOMIC_RELAXED);
+        struct xtools_ring_record *record = xtools_ring_cell(ring, which, tail);
+        if (record->length == XTOOLS_RING_PADDING) {
+            __atomic_store_n(&control->tail, tail + record->cells, __ATOMIC_RELEASE);
+            continue;
+        }
+
+        *data = record + 1;
+        *length = record->length;
+        return 1;
+    }
+
+    return 0;
+}
+
+static inline void xtools_ring_release(struct xtools_ring *ring, int which)
+{
+    struct xtools_ring_control *control = &ring->header->rings[which];
+    uint64_t tail = __atomic_load_n(&control->tail, __ATOMIC_RELAXED);
+    struct xtools_ring_record *record = xtools_ring_cell(ring, which, tail);
+    __atomic_store_n(&control->tail, tail + record->cells, __ATOMIC_RELEASE);
+}
+
+/* Copies the oldest message, returns its length, 0 if there is none or -EMSGSIZE. */
+static inline int64_t xtools_ring_read(struct xtools_ring *ring,
+                                       int which,
+                                       void *buffer,
+                                       uint32_t size)
+{
+    const void *data;
+    uint32_t length;
+    if (!xtools_ring_peek(ring, which, &data, &length)) {
+        return 0;
+    }
+
+    if (length > size) {
+        return -EMSGSIZE;
+    }
+
+    memcpy(buffer, data, length);
+    xtools_ring_release(ring, which);
+    return length;
+}
+
+static inline int64_t xtools_ring_elapsed_us(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t) (now.tv_sec - start->tv_sec) * 1000000
+           + (now.tv_nsec - start->tv_nsec) / 1000;
+}
+
+/*
+ * Waits for a message: spins for spinUs first(the latency of a futex wake-up is several µs),
+ * then sleeps for at most timeoutUs. Returns 1 if a message is ready, 0 on timeout or -EPIPE if
+ * the segment is closed and the ring is empty.
+ */
+static inline int xtools_ring_wait(struct xtools_ring *ring, int which, int timeoutUs, int spinUs)
+{
+    struct xtools_ring_control *control = &ring->header->rings[which];
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (unsigned i = 0;; ++i) {
+        if (xtools_ring_is_ready(ring, which)) {
+            return 1;
+        }
+
+        if (xtools_ring_is_closed(ring)) {
+            return -EPIPE;
+        }
+
+        if ((i & 63) == 63 && xtools_ring_elapsed_us(&start) >= spinUs) {
+            break;
+        }
+
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+    uint32_t wake = __atomic_load_n(&control->wake, __ATOMIC_ACQUIRE);
+    __atomic_store_n(&control->waiting, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (!xtools_ring_is_ready(ring, which) && !xtools_ring_is_closed(ring)) {
+        struct timespec timeout;
+        timeout.tv_sec = timeoutUs / 1000000;
+        timeout.tv_nsec = (long) (timeoutUs % 1000000) * 1000;
+        xtools_ring_futex(&control->wake, FUTEX_WAIT, wake, &timeout);
+    }
+
+    __atomic_store_n(&control->waiting, 0, __ATOMIC_RELAXED);
+    if (xtools_ring_is_ready(ring, which)) {
+        return 1;
+    }
+
+    return xtools_ring_is_closed(ring) ? -EPIPE : 0;
+}
@@ -0,0 +1,173 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "zerocopywriter.h"
+
+#include <errno.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <QLocale>
+#include <QTimer>
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
+
+void ZeroCopyStats::reset()
+{
+    zeroCopyBytes = 0;
+    directBytes = 0;
+    copiedSends = 0;
+}
+
+QList<QPair<QString, QString>> ZeroCopyStats::metrics() const
+{
+    QList<QPair<QString, QString>> list;
+    list.append(qMakePair(QObject::tr("Zero copy"),
+                          QObject::tr("%1, %2 sends copied by the kernel")
+                              .arg(QLocale().formattedDataSize(zeroCopyBytes))
+                              .arg(copiedSends.load())));
+    list.append(qMakePair(QObject::tr("Direct send"), QLocale().formattedDataSize(directBytes)));
+    return list;
+}
+
+ZeroCopyWriter::ZeroCopyWriter(QTcpSocket *socket, ZeroCopyStats *stats)
+    : QObject(socket)
+    , m_socket(socket)
+    , m_stats(stats)
+{
+    m_fd = static_cast<int>(socket->socketDescriptor());
+    int on = 1;
+    m_zeroCopy = m_fd >= 0 && setsockopt(m_fd, SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(on)) == 0;
+
+    // The completions make the socket readable for poll(POLLERR), they are reaped soon so that the
+    // event loop does not wake up for them again and again.
+    m_reapTimer = new QTimer(this);
+    m_reapTimer->setInterval(1);
+    connect(m_reapTimer, &QTimer::timeout, this, &ZeroCopyWriter::reapCompletions);
+}
+
+ZeroCopyWriter::~ZeroCopyWriter() {}
+
+qint64 ZeroCopyWriter::write(const QByteArray &bytes)
+{
+    if (m_fd < 0 || bytes.size() < threshold || m_socket->bytesToWrite() > 0) {
+        return m_socket->write(bytes);
+    }
+
+    qint64 sent = sendDirectly(bytes);
+    if (sent < 0) {
+        return -1;
+    }
+
+    if (sent < bytes.size()) {
+        qint64 ret = m_socket->write(bytes.constData() + sent, bytes.size() - sent);
+        return ret < 0 ? -1 : sent + ret;
+    }
+
+    return sent;
+}
+
+qint64 ZeroCopyWriter::write(QTcpSocket *socket, const QByteArray &bytes)
+{
+    auto writer = socket->findChild<ZeroCopyWriter *>(QString(), Qt::FindDirectChildrenOnly);
+    return writer ? writer->write(bytes) : socket->write(bytes);
+}
+
+qint64 ZeroCopyWriter::sendDirectly(const QByteArray &bytes)
+{
+    reapCompletions();
+
+    const int flags = MSG_DONTWAIT | MSG_NOSIGNAL | (m_zeroCopy ? MSG_ZEROCOPY : 0);
+    qint64 sent = 0;
+    bool referenced = false;
+    while (sent < bytes.size()) {
+        ssize_t ret = ::send(m_fd, bytes.constData() + sent, bytes.size() - sent, flags);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            // The socket buffer is full or the pages can not be pinned(optmem), Qt writes the rest.
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+                break;
+            }
+
+            return sent > 0 ? sent : -1;
+        }
+
+        sent += ret;
+        if (m_zeroCopy) {
+            m_stats->zeroCopyBytes += ret;
+            m_nextId++;
+            referenced = true;
+        } else {
+            m_stats->directBytes += ret;
+        }
+    }
+
+    if (referenced) {
+        m_pending.append(qMakePair(m_nextId - 1, bytes));
+        m_reapTimer->start();
+    }
+
+    return sent;
+}
+
+void ZeroCopyWriter::reapCompletions()
+{
+    while (!m_pending.isEmpty()) {
+        char control[128];
+        struct msghdr msg = {};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (::recvmsg(m_fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            break;
+        }
+
+        for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+            bool recvErr = (cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR)
+                           || (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR);
+            if (!recvErr) {
+                continue;
+            }
+
+            auto *err = reinterpret_cast<struct sock_extended_err *>(CMSG_DATA(cm));
+            if (err->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                continue;
+            }
+
+            // [ee_info, ee_data] is the range of completed ids, they complete in order for TCP.
+            if (err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                m_stats->copiedSends += static_cast<quint32>(err->ee_data - err->ee_info) + 1;
+                m_zeroCopy = false;
+            }
+
+            const quint32 last = err->ee_data;
+            while (!m_pending.isEmpty()
+                   && static_cast<qint32>(m_pending.first().first - last) <= 0) {
+                m_pending.removeFirst();
+            }
+        }
+    }
+
+    if (m_pending.isEmpty()) {
+        m_reapTimer->stop();
+    }
+}
@@ -0,0 +1,62 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <atomic>
+
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QString>
+#include <QTcpSocket>
+
+class QTimer;
+
+struct ZeroCopyStats
+{
+    std::atomic<qint64> zeroCopyBytes{0}; // Sent with MSG_ZEROCOPY
+    std::atomic<qint64> directBytes{0};   // Sent with a plain send() from the QByteArray
+    std::atomic<qint64> copiedSends{0};   // MSG_ZEROCOPY sends the kernel had to copy anyway
+
+    void reset();
+    QList<QPair<QString, QString>> metrics() const;
+};
+
+// Hands large writes of a connected QTcpSocket to the kernel directly, with MSG_ZEROCOPY the pages of
+// the QByteArray are pinned instead of being copied, the array is kept until the kernel reports the
+// completion on the error queue. If the kernel copies anyway(loopback, no scatter-gather), zero copy
+// is turned off and the bytes are sent with a plain send(), which still skips the write buffer of
+// Qt. The writer is a child of the socket, nothing is sent directly while Qt still buffers bytes.
+class ZeroCopyWriter : public QObject
+{
+    Q_OBJECT
+public:
+    static const int threshold = 64 * 1024;
+
+public:
+    explicit ZeroCopyWriter(QTcpSocket *socket, ZeroCopyStats *stats);
+    ~ZeroCopyWriter() override;
+
+    // Writes the bytes, the part the kernel does not take now is written by QTcpSocket.
+    qint64 write(const QByteArray &bytes);
+    static qint64 write(QTcpSocket *socket, const QByteArray &bytes);
+
+private:
+    QTcpSocket *m_socket;
+    ZeroCopyStats *m_stats;
+    int m_fd{-1};
+    bool m_zeroCopy{false};
+    quint32 m_nextId{0}; // The id of the next MSG_ZEROCOPY send()
+    QList<QPair<quint32, QByteArray>> m_pending; // The last id of the sends referencing the bytes
+    QTimer *m_reapTimer;
+
+private:
+    qint64 sendDirectly(const QByteArray &bytes);
+    void reapCompletions();
+};
@@ -1,4 +1,4 @@
-/***************************************************************************************************
+﻿/***************************************************************************************************
  * Copyright 2025-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
  *
  * The file is encoded using "utf8 with bom", it is a part of eTools project.
@@ -11,30 +11,32 @@
 #include <QDateTime>
 #include <QLocalSocket>
 
+#if defined(X_ENABLE_LINUX_NATIVE)
+#include "device/linux/gatherwriter.h"
+#endif
+
 LocalServer::LocalServer(QObject *parent)
     : Device(parent)
 {}
 
 LocalServer::~LocalServer() {}
 
-void LocalServer::setTarget(QLocalSocket *socket)
+void LocalServer::setTarget(const QString &name)
 {
-    m_target = socket;
+    m_targetMutex.lock();
+    m_target = name;
+    m_targetMutex.unlock();
 }
 
 QObject *LocalServer::initDevice()
 {
-    m_server = new QLocalServer(this);
-    connect(m_server, &QLocalServer::newConnection, this, [this]() {
-        QLocalSocket *socket = m_server->nextPendingConnection();
-        emit this->socketConnected(socket, getClientName(socket));
-        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() {
-            QByteArray bytes = socket->readAll();
-            emit bytesRead(bytes, getClientName(socket));
-        });
-        connect(socket, &QLocalSocket::disconnected, this, [this, socket]() {
-            emit this->socketDisconnected(socket);
-        });
+    // The same limit and policy as the defaults of the socket servers.
+    m_scheduler.setLimit(1024 * 1024, OutboundQueuePolicy::DropOldest);
+    m_server = new QLocalServer();
+    connect(m_server, &QLocalServer::newConnection, m_server, [this]() {
+        while (m_server->hasPendingConnections()) {
+            setupClient(m_server->nextPendingConnection());
+        }
     });
 
     QVariantMap parameters = save();
@@ -43,6 +45,7 @@ QObject *LocalServer::initDevice()
     if (!m_server->listen(serverName)) {
         qWarning() << "Failed to start local server:" << m_server->errorString();
         m_server->deleteLater();
+        m_server = nullptr;
         return nullptr;
     }
 
@@ -51,6 +54,17 @@ QObject *LocalServer::initDevice()
 
 void LocalServer::deinitDevice()
 {
+    // The sockets are taken first, their disconnected signals must not touch the hash.
+    QHash<QString, QLocalSocket *> sockets;
+    sockets.swap(m_sockets);
+    m_scheduler.clear();
+    for (auto it = sockets.cbegin(); it != sockets.cend(); ++it) {
+        it.value()->disconnect();
+        it.value()->abort();
+        it.value()->deleteLater();
+        emit clientDisconnected(it.key());
+    }
+
     if (m_server) {
         m_server->close();
         m_server->deleteLater();
@@ -60,30 +74,113 @@ void LocalServer::deinitDevice()
 
 void LocalServer::writeActually(const QByteArray &bytes)
 {
-    if (!m_server) {
+    // The bytes are queued per client, the clients are looked up in the registry rather than in the
+    // children of the server.
+    const QString name = target();
+    QStringList names = name.isEmpty() ? m_sockets.keys() : QStringList(name);
+    int count = 0;
+    QString lastName;
+    for (const QString &client : names) {
+        if (m_sockets.contains(client) && m_scheduler.enqueue(client, bytes)) {
+            lastName = client;
+            count++;
+        }
+    }
+
+    // A broadcast is reported once, not once per client.
+    if (count == 1) {
+        emit bytesWritten(bytes, lastName);
+    } else if (count > 1) {
+        emit bytesWritten(bytes, tr("%1 clients").arg(count));
+    }
+
+    drainQueues();
+}
+
+void LocalServer::setupClient(QLocalSocket *socket)
+{
+    const QString name = makeClientName();
+    m_sockets.insert(name, socket);
+    m_scheduler.addClient(name);
+    emit clientConnected(name);
+
+    connect(socket, &QLocalSocket::readyRead, socket, [=]() {
+        QByteArray bytes = socket->readAll();
+        const QString currentName = target();
+        if (currentName.isEmpty() || currentName == name) {
+            emit bytesRead(bytes, name);
+        }
+    });
+    connect(socket, &QLocalSocket::bytesWritten, socket, [=]() { drainQueues(name); });
+    connect(socket, &QLocalSocket::disconnected, socket, [=]() { removeSocket(socket, name); });
+    connect(socket, &QLocalSocket::errorOccurred, socket, [=]() { removeSocket(socket, name); });
+}
+
+void LocalServer::removeSocket(QLocalSocket *socket, const QString &name)
+{
+    // Both errorOccurred and disconnected may be emitted for the same socket.
+    if (m_sockets.value(name, nullptr) != socket) {
         return;
     }
 
-    if (m_target == nullptr) {
-        for (QLocalSocket *socket : m_server->findChildren<QLocalSocket *>()) {
+    m_sockets.remove(name);
+    m_scheduler.removeClient(name);
+    emit clientDisconnected(name);
+    socket->deleteLater();
+}
+
+void LocalServer::drainQueues(const QString &name)
+{
+    // A socket takes the next messages only when most of the previous ones have been handed to the
+    // kernel. The messages queued meanwhile are written together, with one system call on Linux.
+    const qint64 highWaterMark = 64 * 1024;
+#if defined(X_ENABLE_LINUX_NATIVE)
+    const int maxMessages = GatherWriter::maxMessages;
+#else
+    const int maxMessages = 64;
+#endif
+    auto isWritable = [this, highWaterMark](const QString &client) {
+        QLocalSocket *socket = m_sockets.value(client, nullptr);
+        return socket && socket->bytesToWrite() < highWaterMark;
+    };
+    auto write = [this](const QString &client, const QList<QByteArray> &messages) {
+        QLocalSocket *socket = m_sockets.value(client, nullptr);
+        if (!socket) {
+            return;
+        }
+
+#if defined(X_ENABLE_LINUX_NATIVE)
+        GatherWriter::write(socket, messages);
+#else
+        for (const QByteArray &bytes : messages) {
             socket->write(bytes);
         }
+#endif
+    };
+
+    if (name.isEmpty()) {
+        m_scheduler.drain(maxMessages, isWritable, write);
     } else {
-        for (QLocalSocket *socket : m_server->findChildren<QLocalSocket *>()) {
-            if (socket == m_target) {
-                socket->write(bytes);
-                break;
-            }
-        }
+        m_scheduler.drainClient(name, maxMessages, isWritable, write);
     }
 }
 
-QString LocalServer::getClientName(QLocalSocket *socket)
+QString LocalServer::makeClientName() const
 {
-    if (socket->objectName().isEmpty()) {
-        QString dt = QDateTime::currentDateTime().toString("hh:mm:ss.zzz");
-        socket->setObjectName(dt);
+    // Local sockets have no peer address, the clients are named after the time they connected.
+    const QString dt = QDateTime::currentDateTime().toString("hh:mm:ss.zzz");
+    QString name = tr("Client") + QString("[%1]").arg(dt);
+    for (int i = 2; m_sockets.contains(name); ++i) {
+        name = tr("Client") + QString("[%1 #%2]").arg(dt).arg(i);
     }
 
-    return tr("Client") + QString("[%1]").arg(socket->objectName());
-}
\ No newline at end of file
+    return name;
+}
+
+QString LocalServer::target() const
+{
+    m_targetMutex.lock();
+    QString name = m_target;
+    m_targetMutex.unlock();
+    return name;
+}
@@ -1,4 +1,4 @@
-/***************************************************************************************************
+﻿/***************************************************************************************************
  * Copyright 2025-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
  *
  * The file is encoded using "utf8 with bom", it is a part of eTools project.
@@ -8,10 +8,13 @@
  **************************************************************************************************/
 #pragma once
 
+#include <QHash>
 #include <QLocalServer>
 #include <QLocalSocket>
+#include <QMutex>
 
 #include "device.h"
+#include "utilities/outboundqueue.h"
 
 struct LocalServerParametersKeys
 {
@@ -24,22 +27,31 @@ class LocalServer : public Device
 public:
     explicit LocalServer(QObject *parent = nullptr);
     ~LocalServer() override;
-    void setTarget(QLocalSocket *socket);
+    // An empty name means all clients.
+    void setTarget(const QString &name);
 
     QObject *initDevice() override;
     void deinitDevice() override;
 
 signals:
-    void socketConnected(QLocalSocket *socket, const QString &socketName);
-    void socketDisconnected(QLocalSocket *socket);
+    void clientConnected(const QString &name);
+    void clientDisconnected(const QString &name);
 
 protected:
-    void writeActually(const QByteArray &bytes);
+    void writeActually(const QByteArray &bytes) override;
 
 private:
-    QString getClientName(QLocalSocket *socket);
+    QLocalServer *m_server{nullptr};
+    QHash<QString, QLocalSocket *> m_sockets; // name -> socket
+    OutboundScheduler m_scheduler;
+    QString m_target;
+    mutable QMutex m_targetMutex;
 
 private:
-    QLocalServer *m_server{nullptr};
-    QLocalSocket *m_target{nullptr};
-};
\ No newline at end of file
+    void setupClient(QLocalSocket *socket);
+    void removeSocket(QLocalSocket *socket, const QString &name);
+    // All queues, or the queue of the client with the given name only.
+    void drainQueues(const QString &name = QString());
+    QString makeClientName() const;
+    QString target() const;
+};
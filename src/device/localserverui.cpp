@@ -1,4 +1,4 @@
-/***************************************************************************************************
+﻿/***************************************************************************************************
  * Copyright 2025-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
  *
  * The file is encoded using "utf8 with bom", it is a part of eTools project.
@@ -17,7 +17,7 @@ LocalServerUi::LocalServerUi(QWidget *parent)
     , ui(new Ui::LocalServerUi)
 {
     ui->setupUi(this);
-    ui->comboBoxClients->addItem(tr("All"), 0);
+    ui->comboBoxClients->addItem(tr("All"), QString());
     connect(ui->comboBoxClients, xComboBoxActivated, this, &LocalServerUi::onTargetChanged);
 }
 
@@ -51,26 +51,27 @@ void LocalServerUi::setUiEnabled(bool enabled)
 Device *LocalServerUi::newDevice()
 {
     m_server = new LocalServer(this);
-    connect(m_server, &LocalServer::socketConnected, this, &LocalServerUi::onSocketConnected);
-    connect(m_server, &LocalServer::socketDisconnected, this, &LocalServerUi::onSocketDisconnected);
+    connect(m_server, &LocalServer::clientConnected, this, &LocalServerUi::onClientConnected);
+    connect(m_server, &LocalServer::clientDisconnected, this, &LocalServerUi::onClientDisconnected);
     return m_server;
 }
 
-void LocalServerUi::onSocketConnected(QLocalSocket *socket, const QString &socketName)
+void LocalServerUi::onClientConnected(const QString &name)
 {
-    ui->comboBoxClients->addItem(socketName, QVariant::fromValue(socket));
+    ui->comboBoxClients->addItem(name, name);
 }
 
-void LocalServerUi::onSocketDisconnected(QLocalSocket *socket)
+void LocalServerUi::onClientDisconnected(const QString &name)
 {
-    int index = ui->comboBoxClients->findData(QVariant::fromValue(socket));
+    int index = ui->comboBoxClients->findData(name);
     if (index != -1) {
         ui->comboBoxClients->removeItem(index);
+        // The current item may have been removed.
+        onTargetChanged();
     }
 }
 
 void LocalServerUi::onTargetChanged()
 {
-    QLocalSocket *socket = ui->comboBoxClients->currentData().value<QLocalSocket *>();
-    m_server->setTarget(socket);
+    m_server->setTarget(ui->comboBoxClients->currentData().toString());
 }
\ No newline at end of file
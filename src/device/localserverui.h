@@ -1,4 +1,4 @@
-/***************************************************************************************************
+﻿/***************************************************************************************************
  * Copyright 2025-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
  *
  * The file is encoded using "utf8 with bom", it is a part of eTools project.
@@ -8,8 +8,6 @@
  **************************************************************************************************/
 #pragma once
 
-#include <QLocalSocket>
-
 #include "deviceui.h"
 
 namespace Ui {
@@ -33,8 +31,8 @@ protected:
     Device *newDevice() override;
 
 private:
-    void onSocketConnected(QLocalSocket *socket, const QString &socketName);
-    void onSocketDisconnected(QLocalSocket *socket);
+    void onClientConnected(const QString &name);
+    void onClientDisconnected(const QString &name);
     void onTargetChanged();
 
 private:
@@ -0,0 +1,246 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "multicastreceiver.h"
+
+#include <QLocale>
+#include <QNetworkInterface>
+#include <QThread>
+
+#include "linux/datagramsocket.h"
+#include "utilities/lowlatency.h"
+
+MulticastReceiver::MulticastReceiver(QObject *parent)
+    : Socket(parent)
+{}
+
+MulticastReceiver::~MulticastReceiver() {}
+
+QObject *MulticastReceiver::initDevice()
+{
+    QList<Membership> memberships;
+    QList<int> interfaces;
+    if (!parseMemberships(memberships) || !parseInterfaces(interfaces)) {
+        return nullptr;
+    }
+
+    m_rxMeter.reset();
+    m_sequenceAnalyser.reset(m_sequenceOffset, m_sequenceWidth, m_timestampOffset);
+    m_groupsMutex.lock();
+    m_groupDatagrams.clear();
+    for (const Membership &membership : memberships) {
+        m_groupDatagrams.insert(membership.group.toString(), 0);
+    }
+    m_groupsMutex.unlock();
+
+    // More shards than groups would have nothing to receive.
+    const int count = qMin(qMax(1, m_workerThreads), memberships.size());
+    for (int i = 0; i < count; ++i) {
+        QList<Membership> shardMemberships;
+        for (int j = i; j < memberships.size(); j += count) {
+            shardMemberships.append(memberships.at(j));
+        }
+
+        DatagramSocket *socket = newShardSocket(shardMemberships, interfaces);
+        if (!socket) {
+            deleteShards();
+            return nullptr;
+        }
+
+        // The socket is set up here and read in its own thread, the notifier moves with it.
+        Shard shard;
+        shard.thread = new QThread();
+        shard.socket = socket;
+        socket->moveToThread(shard.thread);
+        connect(socket, &DatagramSocket::readyRead, socket, [this, socket]() {
+            readDatagrams(socket);
+        });
+        shard.thread->start();
+        m_groupsMutex.lock();
+        m_shards.append(shard);
+        m_groupsMutex.unlock();
+    }
+
+    qInfo() << "Multicast receiver joined" << memberships.size() << "groups on port"
+            << m_multicastPort << "with" << m_shards.size() << "sockets";
+    return m_shards.first().thread;
+}
+
+void MulticastReceiver::deinitDevice()
+{
+    deleteShards();
+}
+
+void MulticastReceiver::writeActually(const QByteArray &bytes)
+{
+    Q_UNUSED(bytes);
+    qWarning() << "The multicast receiver does not send, use a UDP client to send to a group.";
+}
+
+QList<QPair<QString, QString>> MulticastReceiver::metrics() const
+{
+    QList<QPair<QString, QString>> list;
+    list.append(throughputMetrics().last()); // Received
+
+    QMutexLocker locker(&m_groupsMutex);
+    quint32 drops = 0;
+    for (const Shard &shard : m_shards) {
+        drops += shard.socket->drops();
+    }
+    list.append(qMakePair(tr("Dropped by the kernel"), QLocale().toString(drops)));
+    for (auto it = m_groupDatagrams.cbegin(); it != m_groupDatagrams.cend(); ++it) {
+        list.append(qMakePair(it.key(), tr("%1 datagrams").arg(QLocale().toString(it.value()))));
+    }
+
+    return list;
+}
+
+bool MulticastReceiver::parseMemberships(QList<Membership> &memberships) const
+{
+    // Every group must be of the family of the first one, a socket receives one family only.
+    const QStringList texts = m_multicastGroups.split(',', Qt::SkipEmptyParts);
+    for (const QString &text : texts) {
+        const QStringList parts = text.trimmed().split('@');
+        Membership membership;
+        membership.group = QHostAddress(parts.first().trimmed());
+        if (parts.size() > 1) {
+            membership.source = QHostAddress(parts.at(1).trimmed());
+        }
+
+        if (!membership.group.isMulticast() || parts.size() > 2
+            || (parts.size() > 1 && membership.source.isNull())) {
+            qWarning() << "Invalid multicast group:" << text.trimmed();
+            return false;
+        }
+
+        if (!memberships.isEmpty()
+            && memberships.first().group.protocol() != membership.group.protocol()) {
+            qWarning() << "Skip the multicast group" << text.trimmed()
+                       << ", it is not of the family of the first group.";
+            continue;
+        }
+
+        memberships.append(membership);
+    }
+
+    if (memberships.isEmpty()) {
+        qWarning() << "No multicast group to join.";
+        return false;
+    }
+
+    return true;
+}
+
+bool MulticastReceiver::parseInterfaces(QList<int> &interfaces) const
+{
+    const QStringList names = m_multicastInterfaces.split(',', Qt::SkipEmptyParts);
+    for (const QString &name : names) {
+        int index = QNetworkInterface::interfaceIndexFromName(name.trimmed());
+        if (index <= 0) {
+            qWarning() << "Unknown network interface:" << name.trimmed();
+            return false;
+        }
+
+        interfaces.append(index);
+    }
+
+    if (interfaces.isEmpty()) {
+        interfaces.append(0); // The default interface
+    }
+
+    return true;
+}
+
+DatagramSocket *MulticastReceiver::newShardSocket(const QList<Membership> &memberships,
+                                                  const QList<int> &interfaces)
+{
+    const bool ipv6 = memberships.first().group.protocol() == QAbstractSocket::IPv6Protocol;
+    auto socket = new DatagramSocket();
+    const QHostAddress address = ipv6 ? QHostAddress::AnyIPv6 : QHostAddress::AnyIPv4;
+    if (!socket->bind(address, m_multicastPort, true)) {
+        qWarning() << "Failed to bind to the multicast port" << m_multicastPort << ":"
+                   << socket->errorString();
+        delete socket;
+        return nullptr;
+    }
+
+    socket->setMulticastAll(false);
+    socket->setReceiveDestination(true);
+    socket->setReceiveBufferSize(8 * 1024 * 1024);
+    if (m_lowLatency) {
+        LowLatency::setup(socket->socketDescriptor(), false);
+    }
+
+    for (const Membership &membership : memberships) {
+        for (int interfaceIndex : interfaces) {
+            if (!socket->joinMulticastGroup(membership.group, interfaceIndex, membership.source)) {
+                qWarning() << "Failed to join the multicast group" << membership.group.toString()
+                           << "on interface" << interfaceIndex << ":" << socket->errorString();
+                delete socket;
+                return nullptr;
+            }
+        }
+    }
+
+    return socket;
+}
+
+void MulticastReceiver::readDatagrams(DatagramSocket *socket)
+{
+    // Called in the thread of the shard, the counters are merged once per batch.
+    const QList<Datagram> datagrams = socket->readDatagrams();
+    if (datagrams.isEmpty()) {
+        return;
+    }
+
+    const bool analyse = m_sequenceAnalyser.isEnabled();
+    QHash<QString, qint64> counts;
+    QHostAddress lastAddress;
+    quint16 lastPort = 0;
+    QHostAddress lastGroup;
+    QString group;
+    QString flag;
+    for (const Datagram &datagram : datagrams) {
+        if (flag.isEmpty() || datagram.port != lastPort || datagram.address != lastAddress
+            || datagram.destination != lastGroup) {
+            lastAddress = datagram.address;
+            lastPort = datagram.port;
+            lastGroup = datagram.destination;
+            group = lastGroup.toString();
+            flag = QString("%1 (%2)").arg(makeFlag(lastAddress.toString(), lastPort), group);
+        }
+
+        counts[group] += 1;
+        m_rxMeter.addBytes(datagram.data.size());
+        if (analyse) {
+            m_sequenceAnalyser.addDatagram(flag, datagram.data);
+        }
+        emit bytesRead(datagram.data, flag);
+    }
+
+    QMutexLocker locker(&m_groupsMutex);
+    for (auto it = counts.cbegin(); it != counts.cend(); ++it) {
+        m_groupDatagrams[it.key()] += it.value();
+    }
+}
+
+void MulticastReceiver::deleteShards()
+{
+    // Not waited for with the lock held, the shards take it to count their datagrams.
+    m_groupsMutex.lock();
+    const QList<Shard> shards = m_shards;
+    m_shards.clear();
+    m_groupsMutex.unlock();
+
+    for (const Shard &shard : shards) {
+        shard.socket->deleteLater();
+        shard.thread->quit();
+        shard.thread->wait();
+        delete shard.thread;
+    }
+}
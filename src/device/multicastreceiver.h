@@ -0,0 +1,60 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QHash>
+#include <QHostAddress>
+#include <QMutex>
+
+#include "socket.h"
+
+class QThread;
+class DatagramSocket;
+
+// Receives any number of multicast groups(any-source or source-specific) on one port and on one or
+// more interfaces. The kernel delivers a multicast datagram to every socket bound to its port, so
+// the SO_REUSEPORT sockets of the worker threads do not share the datagrams of a group, they share
+// the groups: a group is joined by one of them only and each of them receives its own groups only.
+class MulticastReceiver : public Socket
+{
+    Q_OBJECT
+public:
+    explicit MulticastReceiver(QObject *parent = nullptr);
+    ~MulticastReceiver() override;
+
+    QObject *initDevice() override;
+    void deinitDevice() override;
+    void writeActually(const QByteArray &bytes) override;
+    QList<QPair<QString, QString>> metrics() const override;
+
+private:
+    struct Membership
+    {
+        QHostAddress group;
+        QHostAddress source; // Null for an any-source group
+    };
+    struct Shard
+    {
+        QThread *thread{nullptr};
+        DatagramSocket *socket{nullptr};
+    };
+
+private:
+    QList<Shard> m_shards;
+    QHash<QString, qint64> m_groupDatagrams; // The datagrams received of the groups
+    mutable QMutex m_groupsMutex; // Guards the shards and the counters
+
+private:
+    bool parseMemberships(QList<Membership> &memberships) const;
+    bool parseInterfaces(QList<int> &interfaces) const;
+    DatagramSocket *newShardSocket(const QList<Membership> &memberships,
+                                   const QList<int> &interfaces);
+    void readDatagrams(DatagramSocket *socket);
+    void deleteShards();
+};
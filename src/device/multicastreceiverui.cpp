@@ -0,0 +1,55 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "multicastreceiverui.h"
+
+#include "devicemetricsview.h"
+#include "sequenceanalyserview.h"
+#include "multicastreceiver.h"
+
+MulticastReceiverUi::MulticastReceiverUi(QWidget *parent)
+    : SocketClientUi(parent)
+{
+    setServerWidgetsVisible(false);
+    setWriteToWidgetsVisible(false);
+    setChannelWidgetsVisible(false);
+    setAuthenticationWidgetsVisible(false);
+    setMulticastWidgetsVisible(false);
+    setMulticastReceiverWidgetsVisible(true);
+    setSequenceWidgetsVisible(true);
+}
+
+MulticastReceiverUi::~MulticastReceiverUi()
+{
+    delete m_metricsView;
+    delete m_sequenceView;
+}
+
+Device *MulticastReceiverUi::newDevice()
+{
+    return new MulticastReceiver(this);
+}
+
+void MulticastReceiverUi::setUiEnabled(bool enabled)
+{
+    setMulticastReceiverWidgetsEnabled(enabled);
+    setSequenceWidgetsEnabled(enabled);
+    setLowLatencyWidgetsEnabled(enabled);
+}
+
+QList<QWidget *> MulticastReceiverUi::deviceControllers()
+{
+    if (!m_metricsView) {
+        m_metricsView = new DeviceMetricsView(device());
+    }
+    if (!m_sequenceView) {
+        m_sequenceView = new SequenceAnalyserView(qobject_cast<Socket *>(device()));
+    }
+
+    return QList<QWidget *>{m_metricsView, m_sequenceView};
+}
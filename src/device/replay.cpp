@@ -0,0 +1,204 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "replay.h"
+
+#include <QFileInfo>
+#include <QLocale>
+
+#include "common/xtools.h"
+
+Replay::Replay(QObject *parent)
+    : Device(parent)
+{}
+
+Replay::~Replay() {}
+
+QList<int> Replay::supportedTimings()
+{
+    return QList<int>{static_cast<int>(Timing::Original),
+                      static_cast<int>(Timing::FixedInterval),
+                      static_cast<int>(Timing::MaximumSpeed)};
+}
+
+QString Replay::timingName(int timing)
+{
+    switch (timing) {
+    case static_cast<int>(Timing::Original):
+        return tr("Original");
+    case static_cast<int>(Timing::FixedInterval):
+        return tr("Fixed Interval");
+    case static_cast<int>(Timing::MaximumSpeed):
+        return tr("Maximum Speed");
+    default:
+        return "Unknown";
+    }
+}
+
+QObject *Replay::initDevice()
+{
+    QVariantMap parameters = save();
+    ReplayParametersKeys keys;
+    const QString fileName = parameters.value(keys.fileName).toString();
+    m_timing = static_cast<Timing>(parameters.value(keys.timing).toInt());
+    m_speed = qMax(0.001, parameters.value(keys.speed, 1.0).toDouble());
+    m_interval = parameters.value(keys.interval, 10000).toLongLong() * 1000;
+    m_loop = parameters.value(keys.loop, false).toBool();
+
+    CaptureFile::TextOptions options;
+    options.format = parameters.value(keys.textFormat, static_cast<int>(TextFormat::Hex)).toInt();
+    options.date = parameters.value(keys.logDate, false).toBool();
+    options.time = parameters.value(keys.logTime, false).toBool();
+    options.ms = parameters.value(keys.logMs, false).toBool();
+    if (!m_file.open(fileName, options)) {
+        emit errorOccurred(tr("Failed to open %1: %2").arg(fileName, m_file.errorString()));
+        return nullptr;
+    }
+
+    m_flag = QFileInfo(fileName).fileName();
+    m_meter.reset();
+    m_records = 0;
+    m_loops = 0;
+    m_lag = 0;
+    m_finished = false;
+    m_anchorTimestamp = -1;
+    m_loopRecords = 0;
+    m_clock.start();
+    m_due = -m_interval;
+    m_anchorDue = 0;
+
+    m_timer = new QTimer();
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, m_timer, [this]() { replayRecords(); });
+
+    m_hasRecord = loadRecord();
+    if (!m_hasRecord) {
+        emit errorOccurred(tr("No record in %1.").arg(fileName));
+        delete m_timer;
+        m_timer = nullptr;
+        m_file.close();
+        return nullptr;
+    }
+
+    qInfo() << "Replaying" << fileName << (m_file.isBinary() ? "(capture)" : "(log)") << "with"
+            << timingName(static_cast<int>(m_timing)) << "timing";
+    m_timer->start(0);
+    return m_timer;
+}
+
+void Replay::deinitDevice()
+{
+    if (m_timer) {
+        m_timer->stop();
+        m_timer->deleteLater();
+        m_timer = nullptr;
+    }
+
+    m_file.close();
+}
+
+QList<QPair<QString, QString>> Replay::metrics() const
+{
+    QLocale locale;
+    QList<QPair<QString, QString>> list;
+    list.append(qMakePair(tr("Replayed"),
+                          tr("%1, %2 now, %3 sustained")
+                              .arg(locale.formattedDataSize(m_meter.totalBytes()),
+                                   ThroughputMeter::formattedRate(m_meter.bytesPerSecond()),
+                                   ThroughputMeter::formattedRate(
+                                       m_meter.averageBytesPerSecond()))));
+    list.append(qMakePair(tr("Records"), locale.toString(m_records.load())));
+    list.append(qMakePair(tr("Loops"), locale.toString(m_loops.load())));
+    list.append(qMakePair(tr("Behind schedule"),
+                          tr("%1 ms").arg(locale.toString(m_lag / 1000000.0, 'f', 3))));
+    list.append(qMakePair(tr("State"), m_finished ? tr("Finished") : tr("Replaying")));
+    return list;
+}
+
+void Replay::replayRecords()
+{
+    // Everything due is emitted at once, a timer of 1 ms is enough for any rate. A batch is
+    // limited, so writing and closing the device are not held up at the maximum speed.
+    const qint64 now = m_clock.nsecsElapsed();
+    int records = 0;
+    qint64 bytes = 0;
+    while (m_hasRecord && m_due <= now && records < maxBatchRecords && bytes < maxBatchBytes) {
+        if (m_record.isRx) {
+            emit bytesRead(m_record.bytes, m_flag);
+        } else {
+            emit bytesWritten(m_record.bytes, m_flag);
+        }
+
+        m_lag = now - m_due;
+        records += 1;
+        bytes += m_record.bytes.size();
+        m_hasRecord = loadRecord();
+    }
+
+    m_meter.addBytes(bytes);
+    m_records += records;
+    if (!m_hasRecord) {
+        m_finished = true;
+        qInfo() << "Replaying" << m_flag << "finished," << m_records.load() << "records";
+        return;
+    }
+
+    const qint64 wait = qMax<qint64>(0, m_due - m_clock.nsecsElapsed()) / 1000000;
+    m_timer->start(static_cast<int>(wait));
+}
+
+bool Replay::loadRecord()
+{
+    if (m_file.readRecord(m_record)) {
+        m_loopRecords += 1;
+        m_due = dueTime(m_record);
+        return true;
+    }
+
+    if (!m_file.errorString().isEmpty()) {
+        emit warningOccurred(m_file.errorString());
+    }
+
+    // An empty file is not looped forever.
+    if (!m_loop || m_loopRecords == 0 || !m_file.rewind()) {
+        return false;
+    }
+
+    m_loops += 1;
+    m_loopRecords = 0;
+    m_anchorTimestamp = -1;
+    if (!m_file.readRecord(m_record)) {
+        return false;
+    }
+
+    m_loopRecords += 1;
+    m_due = dueTime(m_record);
+    return true;
+}
+
+qint64 Replay::dueTime(const CaptureFile::Record &record)
+{
+    // m_due is the time of the last record still, the first one is due at once.
+    if (m_timing == Timing::MaximumSpeed) {
+        return 0;
+    } else if (m_timing == Timing::FixedInterval || record.timestamp < 0) {
+        return m_due + m_interval;
+    }
+
+    // The first record with a timestamp(of every loop) is the one the others are relative to.
+    if (m_anchorTimestamp < 0) {
+        m_anchorTimestamp = record.timestamp;
+        m_anchorDue = m_due + m_interval;
+        return m_anchorDue;
+    }
+
+    // A record older than the last one(the clock of the capture was set back) is due at once.
+    const double offset = (record.timestamp - m_anchorTimestamp) * 1000.0 / m_speed;
+    return qMax(m_anchorDue + static_cast<qint64>(offset), m_due);
+}
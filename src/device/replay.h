@@ -0,0 +1,87 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <atomic>
+
+#include <QElapsedTimer>
+#include <QTimer>
+
+#include "device.h"
+#include "utilities/capturefile.h"
+#include "utilities/throughputmeter.h"
+
+struct ReplayParametersKeys
+{
+    const QString fileName{"fileName"};
+    const QString timing{"timing"};
+    const QString speed{"speed"};
+    const QString interval{"interval"}; // us
+    const QString loop{"loop"};
+    const QString textFormat{"textFormat"};
+    const QString logDate{"logDate"};
+    const QString logTime{"logTime"};
+    const QString logMs{"logMs"};
+};
+
+// Feeds a capture(see CaptureFile) back through the pipeline: received records are emitted with
+// bytesRead(), sent ones with bytesWritten(). The records are emitted at their original times
+// (scaled by the speed), at a fixed interval or as fast as the event loop allows; records without
+// a timestamp keep the interval in every mode but the last one.
+class Replay : public Device
+{
+    Q_OBJECT
+public:
+    enum class Timing { Original, FixedInterval, MaximumSpeed };
+    Q_ENUM(Timing);
+
+public:
+    explicit Replay(QObject *parent = nullptr);
+    ~Replay() override;
+
+    static QList<int> supportedTimings();
+    static QString timingName(int timing);
+
+    QObject *initDevice() override;
+    void deinitDevice() override;
+    QList<QPair<QString, QString>> metrics() const override;
+
+private:
+    static const int maxBatchRecords = 1024;
+    static const int maxBatchBytes = 1024 * 1024;
+
+private:
+    CaptureFile m_file;
+    QTimer *m_timer{nullptr};
+    QElapsedTimer m_clock;
+    QString m_flag;
+    Timing m_timing{Timing::Original};
+    double m_speed{1.0};
+    qint64 m_interval{0}; // ns
+    bool m_loop{false};
+
+    CaptureFile::Record m_record;
+    bool m_hasRecord{false};
+    qint64 m_due{0};              // ns of m_clock, of the current record
+    qint64 m_anchorTimestamp{-1}; // us, the timestamp the times of the loop are relative to
+    qint64 m_anchorDue{0};        // ns of m_clock
+    qint64 m_loopRecords{0};
+
+    // Polled by metrics() from the ui thread
+    ThroughputMeter m_meter;
+    std::atomic<qint64> m_records{0};
+    std::atomic<qint64> m_loops{0};
+    std::atomic<qint64> m_lag{0}; // ns, of the last record
+    std::atomic<bool> m_finished{false};
+
+private:
+    void replayRecords();
+    bool loadRecord();
+    qint64 dueTime(const CaptureFile::Record &record);
+};
@@ -0,0 +1,123 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "replayui.h"
+#include "ui_replayui.h"
+
+#include <QFileDialog>
+
+#include "common/xtools.h"
+#include "devicemetricsview.h"
+#include "replay.h"
+
+ReplayUi::ReplayUi(QWidget *parent)
+    : DeviceUi(parent)
+    , ui(new Ui::ReplayUi)
+{
+    ui->setupUi(this);
+    for (int timing : Replay::supportedTimings()) {
+        ui->comboBoxTiming->addItem(Replay::timingName(timing), timing);
+    }
+    setupTextFormat(ui->comboBoxTextFormat);
+
+    connect(ui->toolButtonBrowse, &QToolButton::clicked, this, &ReplayUi::onBrowseButtonClicked);
+    connect(ui->comboBoxTiming, xComboBoxActivated, this, &ReplayUi::onTimingChanged);
+    onTimingChanged();
+}
+
+ReplayUi::~ReplayUi()
+{
+    delete m_metricsView;
+    delete ui;
+}
+
+QVariantMap ReplayUi::save() const
+{
+    QVariantMap map = DeviceUi::save();
+    ReplayParametersKeys keys;
+    map[keys.fileName] = ui->lineEditFileName->text();
+    map[keys.timing] = ui->comboBoxTiming->currentData().toInt();
+    map[keys.speed] = ui->doubleSpinBoxSpeed->value();
+    map[keys.interval] = ui->spinBoxInterval->value();
+    map[keys.loop] = ui->checkBoxLoop->isChecked();
+    map[keys.textFormat] = ui->comboBoxTextFormat->currentData().toInt();
+    map[keys.logDate] = ui->checkBoxLogDate->isChecked();
+    map[keys.logTime] = ui->checkBoxLogTime->isChecked();
+    map[keys.logMs] = ui->checkBoxLogMs->isChecked();
+    return map;
+}
+
+void ReplayUi::load(const QVariantMap &parameters)
+{
+    DeviceUi::load(parameters);
+    ReplayParametersKeys keys;
+    ui->lineEditFileName->setText(parameters.value(keys.fileName).toString());
+    int index = ui->comboBoxTiming->findData(parameters.value(keys.timing).toInt());
+    ui->comboBoxTiming->setCurrentIndex(index < 0 ? 0 : index);
+    ui->doubleSpinBoxSpeed->setValue(parameters.value(keys.speed, 1.0).toDouble());
+    ui->spinBoxInterval->setValue(parameters.value(keys.interval, 10000).toInt());
+    ui->checkBoxLoop->setChecked(parameters.value(keys.loop, false).toBool());
+
+    const int hex = static_cast<int>(TextFormat::Hex);
+    index = ui->comboBoxTextFormat->findData(parameters.value(keys.textFormat, hex).toInt());
+    ui->comboBoxTextFormat->setCurrentIndex(index < 0 ? 0 : index);
+    ui->checkBoxLogDate->setChecked(parameters.value(keys.logDate, false).toBool());
+    ui->checkBoxLogTime->setChecked(parameters.value(keys.logTime, false).toBool());
+    ui->checkBoxLogMs->setChecked(parameters.value(keys.logMs, false).toBool());
+    onTimingChanged();
+}
+
+void ReplayUi::setUiEnabled(bool enabled)
+{
+    ui->lineEditFileName->setEnabled(enabled);
+    ui->toolButtonBrowse->setEnabled(enabled);
+    ui->comboBoxTiming->setEnabled(enabled);
+    ui->checkBoxLoop->setEnabled(enabled);
+    ui->comboBoxTextFormat->setEnabled(enabled);
+    ui->checkBoxLogDate->setEnabled(enabled);
+    ui->checkBoxLogTime->setEnabled(enabled);
+    ui->checkBoxLogMs->setEnabled(enabled);
+    if (enabled) {
+        onTimingChanged();
+    } else {
+        ui->doubleSpinBoxSpeed->setEnabled(false);
+        ui->spinBoxInterval->setEnabled(false);
+    }
+}
+
+QList<QWidget *> ReplayUi::deviceControllers()
+{
+    if (!m_metricsView) {
+        m_metricsView = new DeviceMetricsView(device());
+    }
+
+    return QList<QWidget *>{m_metricsView};
+}
+
+Device *ReplayUi::newDevice()
+{
+    return new Replay(this);
+}
+
+void ReplayUi::onBrowseButtonClicked()
+{
+    QString fileName = QFileDialog::getOpenFileName(this,
+                                                    tr("Open Capture"),
+                                                    ui->lineEditFileName->text());
+    if (!fileName.isEmpty()) {
+        ui->lineEditFileName->setText(fileName);
+    }
+}
+
+void ReplayUi::onTimingChanged()
+{
+    // The interval is the one of the records without a timestamp in the original timing.
+    const int timing = ui->comboBoxTiming->currentData().toInt();
+    ui->doubleSpinBoxSpeed->setEnabled(timing == static_cast<int>(Replay::Timing::Original));
+    ui->spinBoxInterval->setEnabled(timing != static_cast<int>(Replay::Timing::MaximumSpeed));
+}
@@ -0,0 +1,152 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "sequenceanalyserview.h"
+
+#include <QAction>
+#include <QPainter>
+
+#include "socket.h"
+
+static const int maxSamples = 120; // s
+static const int maxToolTipStreams = 16;
+
+SequenceAnalyserView::SequenceAnalyserView(Socket *socket, QWidget *parent)
+    : QWidget(parent)
+    , m_socket(socket)
+{
+    setMinimumSize(240, 120);
+
+    QAction *clearAction = new QAction(tr("Clear"), this);
+    connect(clearAction, &QAction::triggered, this, [=]() {
+        m_socket->sequenceAnalyser()->clear();
+        clear();
+    });
+    addAction(clearAction);
+    setContextMenuPolicy(Qt::ActionsContextMenu);
+
+    // The history is sampled even when the view is hidden, the analyser only keeps totals.
+    m_refreshTimer = new QTimer(this);
+    m_refreshTimer->setInterval(1000);
+    connect(m_refreshTimer, &QTimer::timeout, this, &SequenceAnalyserView::refresh);
+    m_refreshTimer->start();
+}
+
+SequenceAnalyserView::~SequenceAnalyserView() {}
+
+void SequenceAnalyserView::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().base());
+
+    QFontMetrics fm = painter.fontMetrics();
+    QRect area = rect().adjusted(4, fm.height() + 4, -4, -4);
+    qint64 maxEvents = 0;
+    double maxJitter = 0;
+    for (const Sample &sample : m_samples) {
+        maxEvents = qMax(maxEvents, qMax<qint64>(sample.lost, qint64(sample.reordered)));
+        maxJitter = qMax(maxJitter, sample.jitter);
+    }
+
+    // The lost(red) and reordered(orange) datagrams of every second as bars, the jitter as a line
+    // scaled to its own maximum. The newest second is on the right.
+    qreal const step = qreal(area.width()) / maxSamples;
+    qreal const left = area.right() - m_samples.size() * step;
+    if (maxEvents > 0) {
+        for (int i = 0; i < m_samples.size(); ++i) {
+            const Sample &sample = m_samples.at(i);
+            qreal const x = left + i * step;
+            qreal const lost = area.height() * qreal(qMax<qint64>(0, sample.lost)) / maxEvents;
+            qreal const reordered = area.height() * qreal(sample.reordered) / maxEvents;
+            painter.fillRect(QRectF(x, area.bottom() - lost, qMax(1.0, step / 2), lost), Qt::red);
+            painter.fillRect(QRectF(x + step / 2, area.bottom() - reordered, qMax(1.0, step / 2),
+                                    reordered),
+                             QColor(255, 165, 0));
+        }
+    }
+
+    if (maxJitter > 0) {
+        QPolygonF line;
+        for (int i = 0; i < m_samples.size(); ++i) {
+            if (m_samples.at(i).jitter >= 0) {
+                qreal const y = area.bottom() - area.height() * m_samples.at(i).jitter / maxJitter;
+                line.append(QPointF(left + (i + 0.5) * step, y));
+            }
+        }
+
+        painter.setPen(palette().highlight().color());
+        painter.drawPolyline(line);
+    }
+
+    painter.setPen(palette().text().color());
+    QString info = tr("Lost: %1, duplicates: %2, reordered: %3")
+                       .arg(m_total.lost())
+                       .arg(m_total.duplicates)
+                       .arg(m_total.reordered);
+    if (m_total.jitter >= 0) {
+        info += QString(", ") + tr("jitter: %1us").arg(m_total.jitter, 0, 'f', 1);
+    }
+    painter.drawText(QPointF(4, fm.ascent() + 2), info);
+}
+
+void SequenceAnalyserView::refresh()
+{
+    SequenceAnalyser *analyser = m_socket->sequenceAnalyser();
+    if (!analyser->isEnabled()) {
+        return;
+    }
+
+    const QList<SequenceAnalyser::Statistics> streams = analyser->statistics();
+    const SequenceAnalyser::Statistics total = analyser->total();
+
+    // The analyser is reset when the device is reopened, the counters may go backwards.
+    Sample sample;
+    if (m_hasLast && total.expected >= m_total.expected) {
+        sample.lost = total.lost() - m_total.lost();
+        sample.reordered = total.reordered - qMin(total.reordered, m_total.reordered);
+    }
+    sample.jitter = total.jitter;
+    m_total = total;
+    m_hasLast = true;
+    m_samples.append(sample);
+    if (m_samples.size() > maxSamples) {
+        m_samples.removeFirst();
+    }
+
+    QStringList lines;
+    for (int i = 0; i < streams.size() && i < maxToolTipStreams; ++i) {
+        const auto &statistics = streams.at(i);
+        QString line = tr("%1: %2 received, %3 lost, %4 duplicates, %5 reordered")
+                           .arg(statistics.flag)
+                           .arg(statistics.received)
+                           .arg(statistics.lost())
+                           .arg(statistics.duplicates)
+                           .arg(statistics.reordered);
+        if (statistics.jitter >= 0) {
+            line += QString(", ") + tr("jitter %1us").arg(statistics.jitter, 0, 'f', 1);
+        }
+        lines.append(line);
+    }
+    if (streams.size() > maxToolTipStreams) {
+        lines.append(tr("%1 more senders").arg(streams.size() - maxToolTipStreams));
+    }
+    setToolTip(lines.join('\n'));
+
+    if (isVisible()) {
+        update();
+    }
+}
+
+void SequenceAnalyserView::clear()
+{
+    m_total = SequenceAnalyser::Statistics();
+    m_samples.clear();
+    m_hasLast = false;
+    update();
+}
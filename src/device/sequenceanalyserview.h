@@ -0,0 +1,46 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QTimer>
+#include <QVector>
+#include <QWidget>
+
+#include "utilities/sequenceanalyser.h"
+
+class Socket;
+class SequenceAnalyserView : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit SequenceAnalyserView(Socket *socket, QWidget *parent = nullptr);
+    ~SequenceAnalyserView() override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    struct Sample
+    {
+        qint64 lost{0};
+        quint64 reordered{0};
+        double jitter{-1}; // us
+    };
+
+private:
+    Socket *m_socket;
+    QTimer *m_refreshTimer;
+    SequenceAnalyser::Statistics m_total;
+    QVector<Sample> m_samples; // One per second, the oldest first
+    bool m_hasLast{false};
+
+private:
+    void refresh();
+    void clear();
+};
@@ -8,12 +8,14 @@
  **************************************************************************************************/
 #include "serialport.h"
 
-#include <QElapsedTimer>
-#include <QTimer>
 #include <QtMath>
 
 #include "common/xtools.h"
 
+#if defined(X_ENABLE_LINUX_NATIVE)
+#include "device/linux/serialportnative.h"
+#endif
+
 SerialPort::SerialPort(QObject *parent)
     : Device(parent)
 {}
@@ -24,6 +26,69 @@ QObject *SerialPort::initDevice()
 {
     QVariantMap tmp = save();
     SerialPortItem item = loadSerialPortItem(QJsonObject::fromVariantMap(tmp));
+    m_portName = item.portName;
+    m_frameBytes.clear();
+    m_gapAnalyser.reset(item.baudRate);
+
+#if defined(X_ENABLE_LINUX_NATIVE)
+    if (item.nativeBackend) {
+        return initNativeDevice(item);
+    }
+#endif
+
+    return initQtDevice(item);
+}
+
+void SerialPort::deinitDevice()
+{
+    if (m_serialPort) {
+        flushFrameBytes();
+        m_frameTimer = nullptr;
+        m_serialPort->close();
+        m_serialPort->deleteLater();
+        m_serialPort = nullptr;
+    }
+
+#if defined(X_ENABLE_LINUX_NATIVE)
+    if (m_nativePort) {
+        m_nativePort->close();
+        flushFrameBytes();
+        m_frameTimer = nullptr;
+        m_nativePort->deleteLater();
+        m_nativePort = nullptr;
+    }
+#endif
+}
+
+void SerialPort::writeActually(const QByteArray &bytes)
+{
+#if defined(X_ENABLE_LINUX_NATIVE)
+    if (m_nativePort) {
+        qint64 ret = m_nativePort->write(bytes);
+        if (ret == bytes.size()) {
+            emit bytesWritten(bytes, m_portName);
+        } else {
+            qWarning() << "Failed to write bytes:" << m_nativePort->errorString();
+        }
+        return;
+    }
+#endif
+
+    if (m_serialPort) {
+        qint64 ret = m_serialPort->write(bytes);
+        if (ret == bytes.size()) {
+            emit bytesWritten(bytes, m_serialPort->portName());
+        }
+    }
+}
+
+GapAnalyser *SerialPort::gapAnalyser()
+{
+    return &m_gapAnalyser;
+}
+
+QObject *SerialPort::initQtDevice(const SerialPortItem &item)
+{
     m_serialPort = new QSerialPort();
     m_serialPort->setPortName(item.portName);
     m_serialPort->setBaudRate(item.baudRate);
@@ -38,6 +103,7 @@ QObject *SerialPort::initDevice()
             << "flowControl:" << m_serialPort->flowControl();
 
     if (m_serialPort->open(QIODevice::ReadWrite)) {
+        initFrameTimer(item, m_serialPort);
         connect(m_serialPort, &QSerialPort::readyRead, m_serialPort, [this]() {
             this->readBytesFromDevice();
         });
@@ -56,22 +122,71 @@ QObject *SerialPort::initDevice()
     return m_serialPort;
 }
 
-void SerialPort::deinitDevice()
+#if defined(X_ENABLE_LINUX_NATIVE)
+QObject *SerialPort::initNativeDevice(const SerialPortItem &item)
 {
-    if (m_serialPort) {
-        m_serialPort->close();
-        m_serialPort->deleteLater();
-        m_serialPort = nullptr;
+    qInfo() << "portName:" << item.portName << "baudRate:" << item.baudRate
+            << "dataBits:" << item.dataBits << "parity:" << item.parity
+            << "stopBits:" << item.stopBits << "flowControl:" << item.flowControl << "(native)";
+
+    m_nativePort = new SerialPortNative();
+    if (!m_nativePort->open(item)) {
+        emit errorOccurred(tr("Failed to open serial port: %1").arg(m_nativePort->errorString()));
+        m_nativePort->deleteLater();
+        m_nativePort = nullptr;
+        return nullptr;
+    }
+
+    initFrameTimer(item, m_nativePort);
+    connect(m_nativePort, &SerialPortNative::errorOccurred, m_nativePort, [this](const QString &e) {
+        emit errorOccurred(e);
+    });
+    connect(
+        m_nativePort,
+        &SerialPortNative::bytesRead,
+        m_nativePort,
+        [this](const QByteArray &bytes) { m_gapAnalyser.addChunk(bytes.size()); },
+        Qt::DirectConnection);
+
+    // The bytes are forwarded from the reader thread directly. The reader splits the frames itself,
+    // its timerfd keeps the microsecond resolution of the frame gap.
+    if (m_optimizedFrame) {
+        m_nativePort->setFrameGap(m_frameGap);
+        connect(
+            m_nativePort,
+            &SerialPortNative::frameRead,
+            m_nativePort,
+            [this](const QByteArray &bytes) { emit bytesRead(bytes, m_portName); },
+            Qt::DirectConnection);
+    } else {
+        connect(
+            m_nativePort,
+            &SerialPortNative::bytesRead,
+            m_nativePort,
+            [this](const QByteArray &bytes) { readBytesFromDeviceNormal(bytes); },
+            Qt::DirectConnection);
     }
+
+    return m_nativePort;
 }
+#endif
 
-void SerialPort::writeActually(const QByteArray &bytes)
+void SerialPort::initFrameTimer(const SerialPortItem &item, QObject *context)
 {
-    if (m_serialPort) {
-        qint64 ret = m_serialPort->write(bytes);
-        if (ret == bytes.size()) {
-            emit bytesWritten(bytes, m_serialPort->portName());
-        }
+    m_optimizedFrame = item.optimizedFrame;
+    m_frameGap = calculateInterFrameGap(item.frameGap, item.baudRate);
+    m_frameTimer = new QTimer(context);
+    m_frameTimer->setSingleShot(true);
+    m_frameTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_frameTimer, &QTimer::timeout, context, [this]() { onFrameTimerTimeout(); });
+
+    if (m_optimizedFrame && item.autoFrameGap) {
+        QTimer *autoFrameGapTimer = new QTimer(context);
+        autoFrameGapTimer->setInterval(1000);
+        connect(autoFrameGapTimer, &QTimer::timeout, context, [this]() {
+            onAutoFrameGapTimerTimeout();
+        });
+        autoFrameGapTimer->start();
     }
 }
 
@@ -81,63 +196,99 @@ void SerialPort::readBytesFromDevice()
         return;
     }
 
-    QVariantMap tmp = save();
-    SerialPortItem item = loadSerialPortItem(QJsonObject::fromVariantMap(tmp));
-    if (item.optimizedFrame) {
-        readBytesFromDeviceOptimized();
+    QByteArray const bytes = m_serialPort->readAll();
+    m_gapAnalyser.addChunk(bytes.size());
+    if (m_optimizedFrame) {
+        readBytesFromDeviceOptimized(bytes);
     } else {
-        readBytesFromDeviceNormal();
+        readBytesFromDeviceNormal(bytes);
     }
 }
 
-void SerialPort::readBytesFromDeviceNormal()
+void SerialPort::readBytesFromDeviceNormal(const QByteArray &bytes)
 {
-    QByteArray bytes = m_serialPort->readAll();
     if (!bytes.isEmpty()) {
-        emit bytesRead(bytes, m_serialPort->portName());
+        emit bytesRead(bytes, m_portName);
     }
 }
 
-void SerialPort::readBytesFromDeviceOptimized()
+void SerialPort::readBytesFromDeviceOptimized(const QByteArray &bytes)
 {
-    QElapsedTimer elapsedTimer;
-    elapsedTimer.start();
-    QByteArray tmp;
-    int delay = calculateInterFrameDelay();
-    while (1) {
-        QByteArray const data = m_serialPort->readAll();
-        if (data.size() == 0) {
-            if (elapsedTimer.elapsed() > delay) {
-                if (!tmp.isEmpty()) {
-                    emit bytesRead(tmp, m_serialPort->portName());
-                }
-
-                return;
-            } else {
-                continue;
-            }
-        }
+    if (bytes.isEmpty()) {
+        return;
+    }
 
-        tmp.append(data);
-        if (tmp.size() > 1024) {
-            emit bytesRead(tmp, m_serialPort->portName());
-            tmp.clear();
+    m_frameBytes.append(bytes);
+    m_frameElapsedTimer.start();
+    if (m_frameBytes.size() > 1024) {
+        flushFrameBytes();
+        return;
+    }
+
+    // The timer is not restarted for every chunk, the timeout handler checks the real idle time
+    // and re-arms the timer with the remaining time instead. QTimer counts whole milliseconds, so
+    // the gap is rounded up to them, only the native backend frames with microsecond resolution.
+    if (!m_frameTimer->isActive()) {
+        m_frameTimer->start(static_cast<int>(qMax<qint64>(1, (m_frameGap + 999) / 1000)));
+    }
+}
+
+void SerialPort::onFrameTimerTimeout()
+{
+    if (m_frameBytes.isEmpty()) {
+        return;
+    }
+
+    qint64 const idle = m_frameElapsedTimer.nsecsElapsed() / 1000;
+    if (idle < m_frameGap) {
+        qint64 const remaining = m_frameGap - idle;
+        m_frameTimer->start(static_cast<int>(qMax<qint64>(1, (remaining + 999) / 1000)));
+        return;
+    }
+
+    flushFrameBytes();
+}
+
+void SerialPort::onAutoFrameGapTimerTimeout()
+{
+    qint64 const gap = m_gapAnalyser.proposedGap();
+    if (gap > 0 && gap != m_frameGap) {
+        qInfo() << "The frame gap of" << m_portName << "is tuned from" << m_frameGap << "us to"
+                << gap << "us";
+        m_frameGap = gap;
+#if defined(X_ENABLE_LINUX_NATIVE)
+        if (m_nativePort) {
+            m_nativePort->setFrameGap(gap);
         }
+#endif
     }
 }
 
-int SerialPort::calculateInterFrameDelay()
+void SerialPort::flushFrameBytes()
 {
-    // The spec recommends a timeout value of 1.750 msec. Without such
-    // precise single-shot timers use a approximated value of 1.750 msec.
-    int delayMilliSeconds = 2;
-    qint32 baudRate = m_serialPort->baudRate();
-    if (baudRate < 19200) {
-        // Example: 9600 baud, 11 bit per packet -> 872 char/sec so:
-        // 1000 ms / 872 char = 1.147 ms/char * 3.5 character = 4.0145 ms
-        // Always round up because the spec requests at least 3.5 char.
-        delayMilliSeconds = qCeil(3500. / (qreal(baudRate) / 11.));
-    }
-
-    return qMax(2, delayMilliSeconds);
+    if (m_frameTimer) {
+        m_frameTimer->stop();
+    }
+
+    if (!m_frameBytes.isEmpty()) {
+        emit bytesRead(m_frameBytes, m_portName);
+        m_frameBytes.clear();
+    }
+}
+
+qint64 SerialPort::calculateInterFrameGap(int frameGap, qint32 baudRate) const
+{
+    if (frameGap > 0) {
+        return frameGap;
+    }
+
+    // The spec recommends a fixed timeout value of 1750us for baud rates greater than 19200.
+    if (baudRate <= 0 || baudRate > 19200) {
+        return 1750;
+    }
+
+    // Example: 9600 baud, 11 bit per packet -> 872 char/sec so:
+    // 1000000 us / 872 char = 1146 us/char * 3.5 character = 4011 us
+    // Always round up because the spec requests at least 3.5 char.
+    return qCeil(3.5 * 11 * 1000000.0 / qreal(baudRate));
 }
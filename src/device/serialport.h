@@ -8,11 +8,17 @@
  **************************************************************************************************/
 #pragma once
 
+#include <QElapsedTimer>
 #include <QSerialPort>
 #include <QTimer>
 
 #include "device.h"
+#include "utilities/gapanalyser.h"
 
+struct SerialPortItem;
+#if defined(X_ENABLE_LINUX_NATIVE)
+class SerialPortNative;
+#endif
 class SerialPort : public Device
 {
     Q_OBJECT
@@ -24,12 +30,32 @@ public:
     void deinitDevice() override;
     void writeActually(const QByteArray &bytes) override;
 
+    GapAnalyser *gapAnalyser();
+
 private:
     QSerialPort *m_serialPort{nullptr};
+#if defined(X_ENABLE_LINUX_NATIVE)
+    SerialPortNative *m_nativePort{nullptr};
+#endif
+    QString m_portName;
+    QTimer *m_frameTimer{nullptr};
+    QElapsedTimer m_frameElapsedTimer;
+    QByteArray m_frameBytes;
+    bool m_optimizedFrame{false};
+    qint64 m_frameGap{0}; // us
+    GapAnalyser m_gapAnalyser;
 
 private:
+    QObject *initQtDevice(const SerialPortItem &item);
+#if defined(X_ENABLE_LINUX_NATIVE)
+    QObject *initNativeDevice(const SerialPortItem &item);
+#endif
+    void initFrameTimer(const SerialPortItem &item, QObject *context);
     void readBytesFromDevice();
-    void readBytesFromDeviceNormal();
-    void readBytesFromDeviceOptimized();
-    int calculateInterFrameDelay();
+    void readBytesFromDeviceNormal(const QByteArray &bytes);
+    void readBytesFromDeviceOptimized(const QByteArray &bytes);
+    void onFrameTimerTimeout();
+    void onAutoFrameGapTimerTimeout();
+    void flushFrameBytes();
+    qint64 calculateInterFrameGap(int frameGap, qint32 baudRate) const;
 };
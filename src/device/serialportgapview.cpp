@@ -0,0 +1,110 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "serialportgapview.h"
+
+#include <QAction>
+#include <QPainter>
+#include <QtMath>
+
+#include "serialport.h"
+
+SerialPortGapView::SerialPortGapView(SerialPort *serialPort, QWidget *parent)
+    : QWidget(parent)
+    , m_serialPort(serialPort)
+{
+    setMinimumSize(240, 120);
+    setToolTip(tr("Idle gaps between reads(log scale), the red line is the proposed frame gap."));
+
+    QAction *clearAction = new QAction(tr("Clear"), this);
+    connect(clearAction, &QAction::triggered, this, [=]() {
+        m_serialPort->gapAnalyser()->clear();
+        refresh();
+    });
+    QAction *applyAction = new QAction(tr("Use the Proposed Frame Gap"), this);
+    connect(applyAction, &QAction::triggered, this, [=]() {
+        if (m_histogram.proposedGap > 0) {
+            emit applyProposedGap(static_cast<int>(m_histogram.proposedGap));
+        }
+    });
+    addAction(clearAction);
+    addAction(applyAction);
+    setContextMenuPolicy(Qt::ActionsContextMenu);
+
+    m_refreshTimer = new QTimer(this);
+    m_refreshTimer->setInterval(500);
+    connect(m_refreshTimer, &QTimer::timeout, this, &SerialPortGapView::refresh);
+    m_refreshTimer->start();
+}
+
+SerialPortGapView::~SerialPortGapView() {}
+
+void SerialPortGapView::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().base());
+
+    QFontMetrics fm = painter.fontMetrics();
+    QRect area = rect().adjusted(4, fm.height() + 4, -4, -(fm.height() + 4));
+    const QVector<quint64> &counts = m_histogram.counts;
+    quint64 maxCount = 0;
+    for (quint64 count : counts) {
+        maxCount = qMax(maxCount, count);
+    }
+
+    // Bars are scaled with log(count) so that the few inter-frame gaps are visible next to the
+    // many intra-frame gaps.
+    if (maxCount > 0 && !counts.isEmpty()) {
+        qreal const barWidth = qreal(area.width()) / counts.size();
+        qreal const maxHeight = qLn(qreal(maxCount) + 1);
+        for (int i = 0; i < counts.size(); ++i) {
+            if (counts.at(i) == 0) {
+                continue;
+            }
+
+            qreal const h = area.height() * qLn(qreal(counts.at(i)) + 1) / maxHeight;
+            QRectF bar(area.left() + i * barWidth, area.bottom() - h, qMax(1.0, barWidth - 1), h);
+            painter.fillRect(bar, palette().highlight());
+        }
+
+        if (m_histogram.proposedGap > 0) {
+            int const index = GapAnalyser::bucketIndex(m_histogram.proposedGap);
+            qreal const x = area.left() + index * barWidth;
+            painter.setPen(Qt::red);
+            painter.drawLine(QPointF(x, area.top()), QPointF(x, area.bottom()));
+        }
+    }
+
+    // Axis labels, 1us, 1ms and 1s.
+    painter.setPen(palette().text().color());
+    if (!counts.isEmpty()) {
+        qreal const barWidth = qreal(area.width()) / counts.size();
+        const QList<QPair<qint64, QString>> ticks{{1, "1us"}, {1000, "1ms"}, {1000000, "1s"}};
+        for (const auto &tick : ticks) {
+            qreal const x = area.left() + GapAnalyser::bucketIndex(tick.first) * barWidth;
+            painter.drawText(QPointF(x, rect().bottom() - 2), tick.second);
+        }
+    }
+
+    QString info = tr("Samples: %1").arg(m_histogram.samples);
+    if (m_histogram.proposedGap > 0) {
+        info += QString(", ") + tr("proposed frame gap: %1us").arg(m_histogram.proposedGap);
+    }
+    painter.drawText(QPointF(4, fm.ascent() + 2), info);
+}
+
+void SerialPortGapView::refresh()
+{
+    if (!isVisible()) {
+        return;
+    }
+
+    m_histogram = m_serialPort->gapAnalyser()->histogram();
+    update();
+}
@@ -0,0 +1,37 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QTimer>
+#include <QWidget>
+
+#include "utilities/gapanalyser.h"
+
+class SerialPort;
+class SerialPortGapView : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit SerialPortGapView(SerialPort *serialPort, QWidget *parent = nullptr);
+    ~SerialPortGapView() override;
+
+signals:
+    void applyProposedGap(int gap);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    SerialPort *m_serialPort;
+    QTimer *m_refreshTimer;
+    GapAnalyser::Histogram m_histogram;
+
+private:
+    void refresh();
+};
@@ -0,0 +1,147 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "serialportsniffer.h"
+
+#include <algorithm>
+
+#include "common/xtools.h"
+#include "serialport.h"
+
+SerialPortSniffer::SerialPortSniffer(QObject *parent)
+    : Device(parent)
+{}
+
+SerialPortSniffer::~SerialPortSniffer() {}
+
+QObject *SerialPortSniffer::initDevice()
+{
+    QVariantMap parameters = save();
+    SerialPortSnifferKeys keys;
+    QStringList portNames = parameters.value(keys.portNames).toStringList();
+    if (portNames.isEmpty()) {
+        emit errorOccurred(tr("No serial port is selected."));
+        return nullptr;
+    }
+
+    m_reorderWindow = parameters.value(keys.reorderWindow, 20).toLongLong() * 1000000;
+    m_chunks.clear();
+    m_elapsedTimer.start();
+
+    m_mergeTimer = new QTimer();
+    m_mergeTimer->setInterval(10);
+    connect(m_mergeTimer, &QTimer::timeout, m_mergeTimer, [this]() { mergeChunks(false); });
+
+    for (const QString &portName : portNames) {
+        SerialPortItem item = loadSerialPortItem(QJsonObject::fromVariantMap(parameters));
+        item.portName = portName;
+        // The chunks must be stamped when they are read, not when a frame is completed.
+        item.optimizedFrame = false;
+
+        // Every port runs in its own device thread, the chunks are stamped in that thread.
+        SerialPort *port = new SerialPort();
+        port->load(saveSerialPortItem(item).toVariantMap());
+        connect(
+            port,
+            &SerialPort::bytesRead,
+            this,
+            [this, portName](const QByteArray &bytes, const QString &) {
+                appendChunk(portName, bytes);
+            },
+            Qt::DirectConnection);
+        connect(port, &SerialPort::errorOccurred, m_mergeTimer, [this](const QString &error) {
+            emit errorOccurred(error);
+        });
+
+        m_ports.append(port);
+        port->openDevice();
+    }
+
+    m_mergeTimer->start();
+    qInfo() << "Sniffing serial ports:" << portNames;
+    return m_mergeTimer;
+}
+
+void SerialPortSniffer::deinitDevice()
+{
+    for (SerialPort *port : m_ports) {
+        disconnect(port, nullptr, this, nullptr);
+        port->closeDevice();
+        delete port;
+    }
+    m_ports.clear();
+
+    if (m_mergeTimer) {
+        mergeChunks(true);
+        m_mergeTimer->stop();
+        m_mergeTimer->deleteLater();
+        m_mergeTimer = nullptr;
+    }
+}
+
+void SerialPortSniffer::appendChunk(const QString &portName, const QByteArray &bytes)
+{
+    Chunk chunk;
+    chunk.timestamp = m_elapsedTimer.nsecsElapsed();
+    chunk.portName = portName;
+    chunk.bytes = bytes;
+
+    m_chunksMutex.lock();
+    m_chunks.append(chunk);
+    m_chunksMutex.unlock();
+}
+
+void SerialPortSniffer::mergeChunks(bool flushAll)
+{
+    // A chunk may be appended a little later than it was stamped, so only the chunks that are
+    // older than the reorder window are put onto the timeline.
+    const qint64 deadline = m_elapsedTimer.nsecsElapsed() - m_reorderWindow;
+    QList<Chunk> ready;
+    m_chunksMutex.lock();
+    if (flushAll) {
+        ready.swap(m_chunks);
+    } else {
+        QList<Chunk> pending;
+        for (const Chunk &chunk : m_chunks) {
+            if (chunk.timestamp <= deadline) {
+                ready.append(chunk);
+            } else {
+                pending.append(chunk);
+            }
+        }
+        m_chunks.swap(pending);
+    }
+    m_chunksMutex.unlock();
+
+    if (ready.isEmpty()) {
+        return;
+    }
+
+    std::stable_sort(ready.begin(), ready.end(), [](const Chunk &a, const Chunk &b) {
+        return a.timestamp < b.timestamp;
+    });
+
+    // Consecutive chunks of the same port are output as one record stamped with the first chunk.
+    int i = 0;
+    while (i < ready.size()) {
+        Chunk record = ready.at(i);
+        int j = i + 1;
+        while (j < ready.size() && ready.at(j).portName == record.portName) {
+            record.bytes.append(ready.at(j).bytes);
+            ++j;
+        }
+
+        emit bytesRead(record.bytes, chunkFlag(record));
+        i = j;
+    }
+}
+
+QString SerialPortSniffer::chunkFlag(const Chunk &chunk) const
+{
+    return QString("%1 +%2s").arg(chunk.portName).arg(chunk.timestamp / 1e9, 0, 'f', 6);
+}
@@ -0,0 +1,54 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QTimer>
+
+#include "device.h"
+
+struct SerialPortSnifferKeys
+{
+    const QString portNames{"portNames"};
+    const QString reorderWindow{"reorderWindow"};
+};
+
+class SerialPort;
+class SerialPortSniffer : public Device
+{
+    Q_OBJECT
+public:
+    explicit SerialPortSniffer(QObject *parent = nullptr);
+    ~SerialPortSniffer() override;
+
+    QObject *initDevice() override;
+    void deinitDevice() override;
+
+private:
+    struct Chunk
+    {
+        qint64 timestamp; // ns, since the capture was started
+        QString portName;
+        QByteArray bytes;
+    };
+
+private:
+    QList<SerialPort *> m_ports;
+    QTimer *m_mergeTimer{nullptr};
+    QElapsedTimer m_elapsedTimer;
+    QList<Chunk> m_chunks;
+    QMutex m_chunksMutex;
+    qint64 m_reorderWindow{0}; // ns
+
+private:
+    void appendChunk(const QString &portName, const QByteArray &bytes);
+    void mergeChunks(bool flushAll);
+    QString chunkFlag(const Chunk &chunk) const;
+};
@@ -0,0 +1,142 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "serialportsnifferui.h"
+#include "ui_serialportsnifferui.h"
+
+#include <QSerialPort>
+
+#include "common/xtools.h"
+#include "serialportsniffer.h"
+#include "utilities/serialportscanner.h"
+
+SerialPortSnifferUi::SerialPortSnifferUi(QWidget *parent)
+    : DeviceUi(parent)
+    , ui(new Ui::SerialPortSnifferUi)
+{
+    ui->setupUi(this);
+
+    m_scanner = SerialPortScanner::instance();
+    connect(m_scanner,
+            &SerialPortScanner::portNamesChanged,
+            this,
+            &SerialPortSnifferUi::onPortNamesChanged);
+
+    setupBaudRate(ui->comboBoxBaudRate);
+    setupDataBits(ui->comboBoxDataBits);
+    setupParity(ui->comboBoxParity);
+    setupStopBits(ui->comboBoxStopBits);
+    onPortNamesChanged(m_scanner->portNames());
+}
+
+QVariantMap SerialPortSnifferUi::save() const
+{
+    SerialPortItem item = defaultSerialPortItem();
+    item.baudRate = ui->comboBoxBaudRate->currentText().toInt();
+    item.dataBits = ui->comboBoxDataBits->currentData().toInt();
+    item.parity = ui->comboBoxParity->currentData().toInt();
+    item.stopBits = ui->comboBoxStopBits->currentData().toInt();
+
+    QVariantMap map = saveSerialPortItem(item).toVariantMap();
+    SerialPortSnifferKeys keys;
+    map[keys.portNames] = checkedPortNames();
+    map[keys.reorderWindow] = ui->spinBoxReorderWindow->value();
+    return map;
+}
+
+void SerialPortSnifferUi::load(const QVariantMap &map)
+{
+    if (map.isEmpty()) {
+        return;
+    }
+
+    SerialPortItem item = loadSerialPortItem(QJsonObject::fromVariantMap(map));
+    SerialPortSnifferKeys keys;
+    QStringList portNames = map.value(keys.portNames).toStringList();
+    int reorderWindow = map.value(keys.reorderWindow, 20).toInt();
+
+    ui->comboBoxBaudRate->setCurrentText(QString::number(item.baudRate));
+    ui->comboBoxDataBits->setCurrentIndex(ui->comboBoxDataBits->findData(item.dataBits));
+    ui->comboBoxParity->setCurrentIndex(ui->comboBoxParity->findData(item.parity));
+    ui->comboBoxStopBits->setCurrentIndex(ui->comboBoxStopBits->findData(item.stopBits));
+    ui->spinBoxReorderWindow->setValue(reorderWindow);
+
+    // The ports may not have been scanned yet, keep them in the list unchecked or checked.
+    for (const QString &portName : portNames) {
+        if (ui->listWidgetPorts->findItems(portName, Qt::MatchExactly).isEmpty()) {
+            ui->listWidgetPorts->addItem(portName);
+        }
+    }
+
+    for (int i = 0; i < ui->listWidgetPorts->count(); ++i) {
+        QListWidgetItem *listItem = ui->listWidgetPorts->item(i);
+        listItem->setFlags(listItem->flags() | Qt::ItemIsUserCheckable);
+        bool checked = portNames.contains(listItem->text());
+        listItem->setCheckState(checked ? Qt::Checked : Qt::Unchecked);
+    }
+}
+
+void SerialPortSnifferUi::setUiEnabled(bool enabled)
+{
+    ui->listWidgetPorts->setEnabled(enabled);
+    ui->comboBoxBaudRate->setEnabled(enabled);
+    ui->comboBoxDataBits->setEnabled(enabled);
+    ui->comboBoxParity->setEnabled(enabled);
+    ui->comboBoxStopBits->setEnabled(enabled);
+    ui->spinBoxReorderWindow->setEnabled(enabled);
+}
+
+Device *SerialPortSnifferUi::newDevice()
+{
+    return new SerialPortSniffer(this);
+}
+
+void SerialPortSnifferUi::onPortNamesChanged(const QStringList &portNames)
+{
+    if (!ui->listWidgetPorts->isEnabled()) {
+        return;
+    }
+
+    QStringList checked = checkedPortNames();
+    QStringList items;
+    for (int i = 0; i < ui->listWidgetPorts->count(); ++i) {
+        items.append(ui->listWidgetPorts->item(i)->text());
+    }
+
+    // Checked ports are kept even if they are not present now, they may be plugged in later.
+    QStringList names = portNames;
+    for (const QString &name : checked) {
+        if (!names.contains(name)) {
+            names.append(name);
+        }
+    }
+
+    if (items == names) {
+        return;
+    }
+
+    ui->listWidgetPorts->clear();
+    for (const QString &name : names) {
+        QListWidgetItem *listItem = new QListWidgetItem(name, ui->listWidgetPorts);
+        listItem->setFlags(listItem->flags() | Qt::ItemIsUserCheckable);
+        listItem->setCheckState(checked.contains(name) ? Qt::Checked : Qt::Unchecked);
+    }
+}
+
+QStringList SerialPortSnifferUi::checkedPortNames() const
+{
+    QStringList portNames;
+    for (int i = 0; i < ui->listWidgetPorts->count(); ++i) {
+        QListWidgetItem *listItem = ui->listWidgetPorts->item(i);
+        if (listItem->checkState() == Qt::Checked) {
+            portNames.append(listItem->text());
+        }
+    }
+
+    return portNames;
+}
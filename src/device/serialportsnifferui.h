@@ -0,0 +1,40 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include "deviceui.h"
+
+QT_BEGIN_NAMESPACE
+namespace Ui {
+class SerialPortSnifferUi;
+}
+QT_END_NAMESPACE
+
+class SerialPortScanner;
+class SerialPortSnifferUi : public DeviceUi
+{
+    Q_OBJECT
+public:
+    SerialPortSnifferUi(QWidget *parent = nullptr);
+
+    QVariantMap save() const override;
+    void load(const QVariantMap &parameters) override;
+    void setUiEnabled(bool enabled) override;
+
+protected:
+    Device *newDevice() override;
+
+private:
+    void onPortNamesChanged(const QStringList &portNames);
+    QStringList checkedPortNames() const;
+
+private:
+    Ui::SerialPortSnifferUi *ui;
+    SerialPortScanner *m_scanner{nullptr};
+};
@@ -14,6 +14,7 @@
 
 #include "common/xtools.h"
 #include "serialport.h"
+#include "serialportgapview.h"
 #include "utilities/serialportscanner.h"
 
 SerialPortUi::SerialPortUi(QWidget *parent)
@@ -24,20 +25,54 @@ SerialPortUi::SerialPortUi(QWidget *parent)
 #if defined(Q_OS_LINUX)
     ui->comboBoxPortName->setEditable(true);
 #endif
+#if !defined(X_ENABLE_LINUX_NATIVE)
+    ui->checkBoxNativeBackend->setVisible(false);
+    ui->checkBoxLowLatency->setVisible(false);
+    ui->checkBoxIoUring->setVisible(false);
+#endif
 
-    m_scanner = new SerialPortScanner(this);
+    m_scanner = SerialPortScanner::instance();
     connect(m_scanner, &SerialPortScanner::portNamesChanged, this, &SerialPortUi::onPortNameChanged);
-    m_scanner->start();
-
     connect(ui->checkBoxIgnoredBusyDevices, &QCheckBox::clicked, this, [=](bool checked) {
-        m_scanner->setIsBusyDevicesIgnored(checked);
+        setIsBusyDevicesIgnored(checked);
     });
 
+    ui->spinBoxFrameGap->setEnabled(false);
+    ui->checkBoxAutoFrameGap->setEnabled(false);
+    connect(ui->checkBoxOptimizedFrame,
+            &QCheckBox::clicked,
+            ui->spinBoxFrameGap,
+            &QSpinBox::setEnabled);
+    connect(ui->checkBoxOptimizedFrame,
+            &QCheckBox::clicked,
+            ui->checkBoxAutoFrameGap,
+            &QCheckBox::setEnabled);
+    ui->checkBoxLowLatency->setEnabled(false);
+    connect(ui->checkBoxNativeBackend,
+            &QCheckBox::clicked,
+            ui->checkBoxLowLatency,
+            &QCheckBox::setEnabled);
+    ui->checkBoxIoUring->setEnabled(false);
+    connect(ui->checkBoxNativeBackend,
+            &QCheckBox::clicked,
+            ui->checkBoxIoUring,
+            &QCheckBox::setEnabled);
+
     setupBaudRate(ui->comboBoxBaudRate);
     setupDataBits(ui->comboBoxDataBits);
     setupParity(ui->comboBoxParity);
     setupStopBits(ui->comboBoxStopBits);
     setupFlowControl(ui->comboBoxFlowControl);
+    onPortNameChanged(m_scanner->portNames());
+}
+
+SerialPortUi::~SerialPortUi()
+{
+    setIsBusyDevicesIgnored(false);
+
+    // The view is moved to the device settings menu, it is not a child of this widget, and it
+    // must not outlive the device.
+    delete m_gapView;
 }
 
 QVariantMap SerialPortUi::save() const
@@ -52,6 +87,11 @@ QVariantMap SerialPortUi::save() const
     map[keys.flowControl] = ui->comboBoxFlowControl->currentData().toInt();
     map[keys.ignoredBusyDevices] = ui->checkBoxIgnoredBusyDevices->isChecked();
     map[keys.optimizedFrame] = ui->checkBoxOptimizedFrame->isChecked();
+    map[keys.frameGap] = ui->spinBoxFrameGap->value();
+    map[keys.autoFrameGap] = ui->checkBoxAutoFrameGap->isChecked();
+    map[keys.nativeBackend] = ui->checkBoxNativeBackend->isChecked();
+    map[keys.lowLatency] = ui->checkBoxLowLatency->isChecked();
+    map[keys.ioUring] = ui->checkBoxIoUring->isChecked();
     return map;
 }
 
@@ -70,8 +110,13 @@ void SerialPortUi::load(const QVariantMap &map)
     int fc = map.value(keys.flowControl, static_cast<int>(QSerialPort::NoFlowControl)).toInt();
     bool ignoredBusyDevices = map.value(keys.ignoredBusyDevices, false).toBool();
     bool optimizedFrame = map.value(keys.optimizedFrame, false).toBool();
+    int frameGap = map.value(keys.frameGap, 0).toInt();
+    bool autoFrameGap = map.value(keys.autoFrameGap, false).toBool();
+    bool nativeBackend = map.value(keys.nativeBackend, false).toBool();
+    bool lowLatency = map.value(keys.lowLatency, false).toBool();
+    bool ioUring = map.value(keys.ioUring, false).toBool();
 
-    m_scanner->setIsBusyDevicesIgnored(ignoredBusyDevices);
+    setIsBusyDevicesIgnored(ignoredBusyDevices);
 
     ui->comboBoxPortName->setCurrentText(portName);
     ui->comboBoxBaudRate->setCurrentText(QString::number(baudRate));
@@ -81,6 +126,27 @@ void SerialPortUi::load(const QVariantMap &map)
     ui->comboBoxFlowControl->setCurrentIndex(ui->comboBoxFlowControl->findData(fc));
     ui->checkBoxIgnoredBusyDevices->setChecked(ignoredBusyDevices);
     ui->checkBoxOptimizedFrame->setChecked(optimizedFrame);
+    ui->spinBoxFrameGap->setValue(frameGap);
+    ui->spinBoxFrameGap->setEnabled(optimizedFrame);
+    ui->checkBoxAutoFrameGap->setChecked(autoFrameGap);
+    ui->checkBoxAutoFrameGap->setEnabled(optimizedFrame);
+    ui->checkBoxNativeBackend->setChecked(nativeBackend);
+    ui->checkBoxLowLatency->setChecked(lowLatency);
+    ui->checkBoxLowLatency->setEnabled(nativeBackend);
+    ui->checkBoxIoUring->setChecked(ioUring);
+    ui->checkBoxIoUring->setEnabled(nativeBackend);
+}
+
+QList<QWidget *> SerialPortUi::deviceControllers()
+{
+    if (!m_gapView) {
+        m_gapView = new SerialPortGapView(qobject_cast<SerialPort *>(device()));
+        connect(m_gapView, &SerialPortGapView::applyProposedGap, this, [=](int gap) {
+            ui->spinBoxFrameGap->setValue(gap);
+        });
+    }
+
+    return QList<QWidget *>{m_gapView};
 }
 
 Device *SerialPortUi::newDevice()
@@ -93,12 +159,30 @@ void SerialPortUi::refresh()
     setupPortName(ui->comboBoxPortName);
 }
 
-void SerialPortUi::onPortNameChanged(const QStringList &portName)
+void SerialPortUi::setIsBusyDevicesIgnored(bool ignored)
+{
+    if (m_isBusyDevicesIgnored == ignored) {
+        return;
+    }
+
+    m_isBusyDevicesIgnored = ignored;
+    m_scanner->requestBusyDevicesChecking(ignored);
+}
+
+void SerialPortUi::onPortNameChanged(const QStringList &allPortNames)
 {
     if (!ui->comboBoxPortName->isEnabled()) {
         return;
     }
 
+    QStringList portName = allPortNames;
+    if (m_isBusyDevicesIgnored) {
+        const QStringList busyPortNames = m_scanner->busyPortNames();
+        for (const QString &busyPortName : busyPortNames) {
+            portName.removeAll(busyPortName);
+        }
+    }
+
     QStringList items;
     for (int i = 0; i < ui->comboBoxPortName->count(); i++) {
         items.append(ui->comboBoxPortName->itemText(i));
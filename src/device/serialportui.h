@@ -17,23 +17,29 @@ class SerialPortUi;
 QT_END_NAMESPACE
 
 class SerialPortScanner;
+class SerialPortGapView;
 class SerialPortUi : public DeviceUi
 {
     Q_OBJECT
 public:
     SerialPortUi(QWidget *parent = nullptr);
+    ~SerialPortUi() override;
 
     QVariantMap save() const override;
     void load(const QVariantMap &parameters) override;
+    QList<QWidget *> deviceControllers() override;
 
 protected:
     Device *newDevice() override;
 
 private:
     void refresh();
-    void onPortNameChanged(const QStringList &portName);
+    void setIsBusyDevicesIgnored(bool ignored);
+    void onPortNameChanged(const QStringList &allPortNames);
 
 private:
     Ui::SerialPortUi *ui;
     SerialPortScanner *m_scanner{nullptr};
+    bool m_isBusyDevicesIgnored{false};
+    SerialPortGapView *m_gapView{nullptr};
 };
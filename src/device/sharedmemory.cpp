@@ -0,0 +1,123 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "sharedmemory.h"
+
+#include <QLocale>
+
+#include "linux/sharedmemoryring.h"
+
+SharedMemory::SharedMemory(QObject *parent)
+    : Device(parent)
+{}
+
+SharedMemory::~SharedMemory() {}
+
+QObject *SharedMemory::initDevice()
+{
+    QVariantMap parameters = save();
+    SharedMemoryParametersKeys keys;
+    QString name = parameters.value(keys.name, QString("/xtools.shm")).toString().trimmed();
+    if (!name.startsWith('/')) {
+        name.prepend('/');
+    }
+
+    // The capacity is a power of two, so is the number of cells.
+    const quint32 capacity = parameters.value(keys.capacity, 16).toUInt();
+    const quint32 cells = qMax(1u, capacity) * 1024 * 1024 / XTOOLS_RING_CELL;
+    const int spinTime = parameters.value(keys.spinTime, 50).toInt();
+    const bool replace = parameters.value(keys.replace, false).toBool();
+
+    m_rxMeter.reset();
+    m_txMeter.reset();
+    auto ring = new SharedMemoryRing();
+    if (!ring->open(name, cells, spinTime, replace)) {
+        emit errorOccurred(tr("Failed to create the shared memory %1: %2")
+                               .arg(name, ring->errorString()));
+        delete ring;
+        return nullptr;
+    }
+
+    // Forwarded from the reader thread directly, the device thread is not woken per message.
+    connect(
+        ring,
+        &SharedMemoryRing::bytesRead,
+        ring,
+        [this, name](const QByteArray &bytes) {
+            m_rxMeter.addBytes(bytes.size());
+            emit bytesRead(bytes, name);
+        },
+        Qt::DirectConnection);
+
+    m_ringMutex.lock();
+    m_ring = ring;
+    m_ringMutex.unlock();
+
+    qInfo() << "Shared memory" << name << "created," << ring->segmentSize() << "bytes";
+    return ring;
+}
+
+void SharedMemory::deinitDevice()
+{
+    m_ringMutex.lock();
+    SharedMemoryRing *ring = m_ring;
+    m_ring = nullptr;
+    m_ringMutex.unlock();
+
+    if (ring) {
+        ring->close();
+        ring->deleteLater();
+    }
+}
+
+QList<QPair<QString, QString>> SharedMemory::metrics() const
+{
+    auto text = [](const ThroughputMeter &meter) {
+        return tr("%1, %2 now, %3 sustained")
+            .arg(QLocale().formattedDataSize(meter.totalBytes()),
+                 ThroughputMeter::formattedRate(meter.bytesPerSecond()),
+                 ThroughputMeter::formattedRate(meter.averageBytesPerSecond()));
+    };
+
+    QList<QPair<QString, QString>> list;
+    list.append(qMakePair(tr("Sent"), text(m_txMeter)));
+    list.append(qMakePair(tr("Received"), text(m_rxMeter)));
+
+    QMutexLocker locker(&m_ringMutex);
+    if (m_ring) {
+        QLocale locale;
+        list.append(qMakePair(tr("Messages received"), locale.toString(m_ring->messages())));
+        list.append(qMakePair(tr("Dropped by the writers(ring full)"),
+                              locale.toString(m_ring->dropped(XTOOLS_RING_IN))));
+        list.append(qMakePair(tr("Dropped by xTools(ring full)"),
+                              locale.toString(m_ring->dropped(XTOOLS_RING_OUT))));
+    }
+
+    return list;
+}
+
+void SharedMemory::writeActually(const QByteArray &bytes)
+{
+    // The device thread is the only writer of the OUT ring, no lock is required.
+    if (!m_ring) {
+        return;
+    }
+
+    qint64 ret = m_ring->write(bytes);
+    if (ret < bytes.size()) {
+        emit warningOccurred(tr("The shared memory ring is full, %1 of %2 bytes are dropped.")
+                                 .arg(bytes.size() - qMax(0ll, ret))
+                                 .arg(bytes.size()));
+    }
+
+    if (ret > 0) {
+        m_txMeter.addBytes(ret);
+        const QByteArray written = ret == bytes.size() ? bytes : bytes.left(static_cast<int>(ret));
+        emit bytesWritten(written, m_ring->name());
+    }
+}
@@ -0,0 +1,46 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QMutex>
+
+#include "device.h"
+#include "utilities/throughputmeter.h"
+
+struct SharedMemoryParametersKeys
+{
+    const QString name{"name"};
+    const QString capacity{"capacity"}; // MiB of each ring
+    const QString spinTime{"spinTime"}; // us
+    const QString replace{"replace"};   // Take the name over from an existing segment
+};
+
+class SharedMemoryRing;
+// Same-host IPC without a copy through the kernel: other processes attach to the segment with
+// src/device/linux/xtoolsring.h, write to its IN ring and read the OUT ring.
+class SharedMemory : public Device
+{
+    Q_OBJECT
+public:
+    explicit SharedMemory(QObject *parent = nullptr);
+    ~SharedMemory() override;
+
+    QObject *initDevice() override;
+    void deinitDevice() override;
+    QList<QPair<QString, QString>> metrics() const override;
+
+protected:
+    void writeActually(const QByteArray &bytes) override;
+
+private:
+    SharedMemoryRing *m_ring{nullptr};
+    mutable QMutex m_ringMutex; // The ring is polled by metrics() from the ui thread
+    ThroughputMeter m_rxMeter;
+    ThroughputMeter m_txMeter;
+};
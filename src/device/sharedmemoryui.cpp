@@ -0,0 +1,80 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "sharedmemoryui.h"
+#include "ui_sharedmemoryui.h"
+
+#include "devicemetricsview.h"
+#include "sharedmemory.h"
+
+SharedMemoryUi::SharedMemoryUi(QWidget *parent)
+    : DeviceUi(parent)
+    , ui(new Ui::SharedMemoryUi)
+{
+    ui->setupUi(this);
+    const QList<int> capacities{1, 4, 16, 64, 256, 1024};
+    for (int capacity : capacities) {
+        ui->comboBoxCapacity->addItem(QString("%1 MiB").arg(capacity), capacity);
+    }
+}
+
+SharedMemoryUi::~SharedMemoryUi()
+{
+    delete m_metricsView;
+    delete ui;
+}
+
+QVariantMap SharedMemoryUi::save() const
+{
+    QVariantMap map = DeviceUi::save();
+    SharedMemoryParametersKeys keys;
+    map[keys.name] = ui->lineEditName->text();
+    map[keys.capacity] = ui->comboBoxCapacity->currentData().toInt();
+    map[keys.spinTime] = ui->spinBoxSpinTime->value();
+    map[keys.replace] = ui->checkBoxReplace->isChecked();
+    return map;
+}
+
+void SharedMemoryUi::load(const QVariantMap &parameters)
+{
+    DeviceUi::load(parameters);
+    SharedMemoryParametersKeys keys;
+    QString defaultName = QString("/xtools.shm");
+    QString name = parameters.value(keys.name, defaultName).toString();
+    if (name.isEmpty()) {
+        name = defaultName;
+    }
+    ui->lineEditName->setText(name);
+
+    int index = ui->comboBoxCapacity->findData(parameters.value(keys.capacity, 16).toInt());
+    ui->comboBoxCapacity->setCurrentIndex(index < 0 ? ui->comboBoxCapacity->findData(16) : index);
+    ui->spinBoxSpinTime->setValue(parameters.value(keys.spinTime, 50).toInt());
+    ui->checkBoxReplace->setChecked(parameters.value(keys.replace, false).toBool());
+}
+
+void SharedMemoryUi::setUiEnabled(bool enabled)
+{
+    ui->lineEditName->setEnabled(enabled);
+    ui->comboBoxCapacity->setEnabled(enabled);
+    ui->spinBoxSpinTime->setEnabled(enabled);
+    ui->checkBoxReplace->setEnabled(enabled);
+}
+
+QList<QWidget *> SharedMemoryUi::deviceControllers()
+{
+    if (!m_metricsView) {
+        m_metricsView = new DeviceMetricsView(device());
+    }
+
+    return QList<QWidget *>{m_metricsView};
+}
+
+Device *SharedMemoryUi::newDevice()
+{
+    return new SharedMemory(this);
+}
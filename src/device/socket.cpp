@@ -8,6 +8,8 @@
  **************************************************************************************************/
 #include "socket.h"
 
+#include <QLocale>
+
 #include "common/xtools.h"
 
 Socket::Socket(QObject *parent)
@@ -31,6 +33,26 @@ void Socket::load(const QVariantMap &parameters)
     m_multicastPort = item.multicastPort;
     m_enableMulticast = item.enableMulticast;
     m_justMulticast = item.justMulticast;
+    m_workerThreads = item.workerThreads;
+    m_queueLimit = static_cast<qint64>(item.queueLimit) * 1024;
+    m_queuePolicy = static_cast<int>(item.queuePolicy);
+    m_lowLatency = item.lowLatency;
+    m_certificate = item.certificate;
+    m_privateKey = item.privateKey;
+    m_verifyPeer = item.verifyPeer;
+    m_targetAddress = item.targetAddress;
+    m_targetPort = item.targetPort;
+    m_sampleInterval = item.sampleInterval;
+    m_ioUring = item.ioUring;
+    m_idleTimeout = item.idleTimeout;
+    m_multicastGroups = item.multicastGroups;
+    m_multicastInterfaces = item.multicastInterfaces;
+    m_sequenceOffset = item.sequenceOffset;
+    m_sequenceWidth = item.sequenceWidth;
+    m_timestampOffset = item.timestampOffset;
+    m_compression = item.compression;
+    m_compressionThreshold = item.compressionThreshold;
+    m_contextTakeover = item.contextTakeover;
 }
 
 void Socket::setDataChannel(int channel)
@@ -41,6 +63,33 @@ void Socket::setDataChannel(int channel)
     m_channel = channel;
 }
 
+SequenceAnalyser *Socket::sequenceAnalyser()
+{
+    return &m_sequenceAnalyser;
+}
+
+void Socket::writeFile(const QString &fileName)
+{
+    if (isRunning()) {
+        emit invokeWriteFile(fileName);
+    }
+}
+
+QList<QPair<QString, QString>> Socket::throughputMetrics() const
+{
+    auto text = [](const ThroughputMeter &meter) {
+        return tr("%1, %2 now, %3 sustained")
+            .arg(QLocale().formattedDataSize(meter.totalBytes()),
+                 ThroughputMeter::formattedRate(meter.bytesPerSecond()),
+                 ThroughputMeter::formattedRate(meter.averageBytesPerSecond()));
+    };
+
+    QList<QPair<QString, QString>> list;
+    list.append(qMakePair(tr("Sent"), text(m_txMeter)));
+    list.append(qMakePair(tr("Received"), text(m_rxMeter)));
+    return list;
+}
+
 QString Socket::makeFlag(const QString &address, quint16 port) const
 {
     return QString("%1:%2").arg(address).arg(port);
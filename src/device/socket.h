@@ -11,6 +11,11 @@
 #include <QPair>
 
 #include "device.h"
+#include "utilities/sequenceanalyser.h"
+#include "utilities/throughputmeter.h"
+#if defined(X_ENABLE_ZLIB)
+#include "utilities/permessagedeflate.h"
+#endif
 
 class Socket : public Device
 {
@@ -19,6 +24,14 @@ public:
     explicit Socket(QObject *parent = nullptr);
     void load(const QVariantMap &parameters) override;
     void setDataChannel(int channel);
+    SequenceAnalyser *sequenceAnalyser();
+    // WebSocket devices, the file is sent as one message in parts, see WebSocketConnection.
+    void writeFile(const QString &fileName);
+
+signals:
+    void streamProgressChanged(const QString &to, qint64 bytes, bool finished);
+    // Connected to the context object by the devices which can stream files.
+    void invokeWriteFile(const QString &fileName);
 
 protected:
     quint16 m_serverPort{12347};
@@ -34,7 +47,39 @@ protected:
     bool m_enableMulticast{false};
     bool m_justMulticast{false};
 
+    int m_workerThreads{0};
+    qint64 m_queueLimit{1024 * 1024}; // bytes
+    int m_queuePolicy{0};
+    bool m_lowLatency{false};
+    QString m_certificate;
+    QString m_privateKey;
+    bool m_verifyPeer{false};
+    QString m_targetAddress;
+    quint16 m_targetPort{0};
+    int m_sampleInterval{0};
+    bool m_ioUring{false};
+    int m_idleTimeout{0}; // s
+    QString m_multicastGroups;
+    QString m_multicastInterfaces;
+    int m_sequenceOffset{-1};
+    int m_sequenceWidth{4};
+    int m_timestampOffset{-1};
+    bool m_compression{false};
+    int m_compressionThreshold{256};
+    bool m_contextTakeover{true};
+
+    // Application bytes, the devices that report them reset the meters when they are opened.
+    ThroughputMeter m_txMeter;
+    ThroughputMeter m_rxMeter;
+    // Datagram devices, reset when they are opened.
+    SequenceAnalyser m_sequenceAnalyser;
+#if defined(X_ENABLE_ZLIB)
+    // WebSocket devices, reset when they are opened.
+    DeflateStatistics m_deflateStatistics;
+#endif
+
 protected:
+    QList<QPair<QString, QString>> throughputMetrics() const;
     QString makeFlag(const QString &address, quint16 port) const;
     QPair<QString, quint16> splitFlag(const QString &flag) const;
     bool isValidFlag(const QPair<QString, quint16> &pair) const;
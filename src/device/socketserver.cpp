@@ -8,18 +8,43 @@
  **************************************************************************************************/
 #include "socketserver.h"
 
+#include <algorithm>
+
 SocketServer::SocketServer(QObject *parent)
     : Socket(parent)
 {}
 
 QStringList SocketServer::clients() const
 {
+    // Cleared before the copy, a change made after this point is notified again.
+    m_clientsChangedPending.store(false);
+
     m_clientsMutex.lock();
-    QStringList clients = m_clients;
+    QList<QPair<quint64, QString>> ordered;
+    ordered.reserve(m_clients.size());
+    for (auto it = m_clients.cbegin(); it != m_clients.cend(); ++it) {
+        ordered.append(qMakePair(it.value(), it.key()));
+    }
     m_clientsMutex.unlock();
+
+    std::sort(ordered.begin(), ordered.end());
+    QStringList clients;
+    clients.reserve(ordered.size());
+    for (const auto &client : ordered) {
+        clients.append(client.second);
+    }
+
     return clients;
 }
 
+QHash<QString, qint64> SocketServer::clientQueueDepths() const
+{
+    m_clientsMutex.lock();
+    QHash<QString, qint64> depths = m_clientQueueDepths;
+    m_clientsMutex.unlock();
+    return depths;
+}
+
 QString SocketServer::currentClientFlag() const
 {
     m_currentClientMutex.lock();
@@ -40,28 +65,55 @@ void SocketServer::addClient(const QString &flag)
     bool changed = false;
     m_clientsMutex.lock();
     if (!m_clients.contains(flag)) {
-        m_clients.append(flag);
+        m_clients.insert(flag, m_clientSequence++);
         changed = true;
     }
     m_clientsMutex.unlock();
 
     if (changed) {
-        emit clientsChanged();
+        notifyClientsChanged();
     }
 }
 
 void SocketServer::removeClient(const QString &flag)
+{
+    m_clientsMutex.lock();
+    bool changed = m_clients.remove(flag) > 0;
+    m_clientsMutex.unlock();
+
+    if (changed) {
+        notifyClientsChanged();
+    }
+}
+
+void SocketServer::addClients(const QStringList &flags)
 {
     bool changed = false;
     m_clientsMutex.lock();
-    if (m_clients.contains(flag)) {
-        m_clients.removeAll(flag);
-        changed = true;
+    for (const QString &flag : flags) {
+        if (!m_clients.contains(flag)) {
+            m_clients.insert(flag, m_clientSequence++);
+            changed = true;
+        }
     }
     m_clientsMutex.unlock();
 
     if (changed) {
-        emit clientsChanged();
+        notifyClientsChanged();
+    }
+}
+
+void SocketServer::removeClients(const QStringList &flags)
+{
+    bool changed = false;
+    m_clientsMutex.lock();
+    for (const QString &flag : flags) {
+        changed |= m_clients.remove(flag) > 0;
+    }
+    m_clientsMutex.unlock();
+
+    if (changed) {
+        notifyClientsChanged();
     }
 }
 
@@ -69,6 +121,30 @@ void SocketServer::clearClients()
 {
     m_clientsMutex.lock();
     m_clients.clear();
+    m_clientQueueDepths.clear();
     m_clientsMutex.unlock();
-    emit clientsChanged();
+    notifyClientsChanged();
+}
+
+void SocketServer::setClientQueueDepths(const QHash<QString, qint64> &depths)
+{
+    m_clientsMutex.lock();
+    bool changed = m_clientQueueDepths != depths;
+    if (changed) {
+        m_clientQueueDepths = depths;
+    }
+    m_clientsMutex.unlock();
+
+    if (changed) {
+        notifyClientsChanged();
+    }
+}
+
+void SocketServer::notifyClientsChanged()
+{
+    // Thousands of clients connecting at once would flood the ui thread with signals, the
+    // listener fetches the whole list anyway.
+    if (!m_clientsChangedPending.exchange(true)) {
+        emit clientsChanged();
+    }
 }
@@ -8,6 +8,9 @@
  **************************************************************************************************/
 #pragma once
 
+#include <atomic>
+
+#include <QHash>
 #include <QMutex>
 
 #include "socket.h"
@@ -21,20 +24,32 @@ public:
     virtual void disconnectAllClients() {};
 
     Q_INVOKABLE QStringList clients() const;
+    QHash<QString, qint64> clientQueueDepths() const;
     Q_INVOKABLE QString currentClientFlag() const;
     Q_INVOKABLE void setCurrentClientFlag(const QString &flag);
 
 signals:
+    // Changes are batched, the signal is not emitted again until clients() has been called.
     void clientsChanged();
 
 protected:
     void addClient(const QString &flag);
     void removeClient(const QString &flag);
+    // One lock and at most one notification for all of them.
+    void addClients(const QStringList &flags);
+    void removeClients(const QStringList &flags);
     void clearClients();
+    void setClientQueueDepths(const QHash<QString, qint64> &depths);
 
 private:
-    QStringList m_clients;
+    QHash<QString, quint64> m_clients; // flag -> sequence number, the order of connections
+    quint64 m_clientSequence{0};
+    QHash<QString, qint64> m_clientQueueDepths; // flag -> queued bytes, empty queues are omitted
     mutable QMutex m_clientsMutex;
+    mutable std::atomic_bool m_clientsChangedPending{false};
     QString m_currentClientFlag;
     mutable QMutex m_currentClientMutex;
+
+private:
+    void notifyClientsChanged();
 };
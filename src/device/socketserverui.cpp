@@ -18,7 +18,10 @@ SocketServerUi::~SocketServerUi() {}
 
 void SocketServerUi::setupServer(SocketServer *server)
 {
-    connect(server, &SocketServer::clientsChanged, this, [=]() { setupClients(server->clients()); });
+    connect(server, &SocketServer::clientsChanged, this, [=]() {
+        QStringList clients = server->clients();
+        setupClients(clients, server->clientQueueDepths());
+    });
     connect(this, &SocketServerUi::invokeDisconnectAll, server, &SocketServer::disconnectAllClients);
     connect(this, &SocketServerUi::currentClientChanged, server, [=](const QString &flag) {
         server->setCurrentClientFlag(flag);
@@ -9,6 +9,8 @@
 #include "socketui.h"
 #include "ui_socketui.h"
 
+#include <QFileDialog>
+
 #include "common/xtools.h"
 #include "device/socket.h"
 
@@ -19,7 +21,25 @@ SocketUi::SocketUi(QWidget *parent)
     ui->setupUi(this);
     ui->spinBoxServerPort->setValue(34455);
     setupSocketAddress(ui->comboBoxServerIp);
+    setupSocketAddress(ui->comboBoxTargetAddress);
     setupWebSocketDataChannel(ui->comboBoxChannel);
+    setupOutboundQueuePolicy(ui->comboBoxQueuePolicy);
+    for (int width : QList<int>{1, 2, 4, 8}) {
+        ui->comboBoxSequenceWidth->addItem(tr("%1 bytes").arg(width), width);
+    }
+    ui->comboBoxSequenceWidth->setCurrentIndex(2);
+    setWorkerThreadsWidgetsVisible(false);
+    setQueueWidgetsVisible(false);
+    setSslWidgetsVisible(false);
+    setProxyWidgetsVisible(false);
+    setIdleTimeoutWidgetsVisible(false);
+    // Not the helper, it would hide the multicast port of the clients too.
+    ui->labelMulticastGroups->setVisible(false);
+    ui->lineEditMulticastGroups->setVisible(false);
+    ui->labelMulticastInterfaces->setVisible(false);
+    ui->lineEditMulticastInterfaces->setVisible(false);
+    setSequenceWidgetsVisible(false);
+    setCompressionWidgetsVisible(false);
 
     setupClients(QStringList());
     connect(ui->comboBoxWriteTo, xComboBoxActivated, this, [this]() {
@@ -30,6 +50,24 @@ SocketUi::SocketUi(QWidget *parent)
             &QToolButton::clicked,
             this,
             &SocketUi::invokeDisconnectAll);
+    connect(ui->toolButtonCertificate, &QToolButton::clicked, this, [this]() {
+        QString fileName = QFileDialog::getOpenFileName(this,
+                                                        tr("Select Certificate"),
+                                                        ui->lineEditCertificate->text(),
+                                                        tr("PEM files (*.pem *.crt *.cer);;All (*)"));
+        if (!fileName.isEmpty()) {
+            ui->lineEditCertificate->setText(fileName);
+        }
+    });
+    connect(ui->toolButtonPrivateKey, &QToolButton::clicked, this, [this]() {
+        QString fileName = QFileDialog::getOpenFileName(this,
+                                                        tr("Select Private Key"),
+                                                        ui->lineEditPrivateKey->text(),
+                                                        tr("PEM files (*.pem *.key);;All (*)"));
+        if (!fileName.isEmpty()) {
+            ui->lineEditPrivateKey->setText(fileName);
+        }
+    });
     connect(ui->comboBoxChannel, xComboBoxActivated, this, [this]() {
         if (this->m_socket) {
             this->m_socket->setDataChannel(ui->comboBoxChannel->currentIndex());
@@ -52,6 +90,27 @@ QVariantMap SocketUi::save() const
     item.multicastPort = ui->spinBoxMulticastPort->value();
     item.enableMulticast = ui->checkBoxEnableMulticast->isChecked();
     item.justMulticast = ui->checkBoxJustMulticast->isChecked();
+    item.workerThreads = ui->spinBoxWorkerThreads->value();
+    item.queueLimit = ui->spinBoxQueueLimit->value();
+    item.queuePolicy = static_cast<OutboundQueuePolicy>(
+        ui->comboBoxQueuePolicy->currentData().toInt());
+    item.lowLatency = ui->checkBoxLowLatency->isChecked();
+    item.certificate = ui->lineEditCertificate->text();
+    item.privateKey = ui->lineEditPrivateKey->text();
+    item.verifyPeer = ui->checkBoxVerifyPeer->isChecked();
+    item.targetAddress = ui->comboBoxTargetAddress->currentText();
+    item.targetPort = ui->spinBoxTargetPort->value();
+    item.sampleInterval = ui->spinBoxSampleInterval->value();
+    item.ioUring = ui->checkBoxIoUring->isChecked();
+    item.idleTimeout = ui->spinBoxIdleTimeout->value();
+    item.multicastGroups = ui->lineEditMulticastGroups->text();
+    item.multicastInterfaces = ui->lineEditMulticastInterfaces->text();
+    item.sequenceOffset = ui->spinBoxSequenceOffset->value();
+    item.sequenceWidth = ui->comboBoxSequenceWidth->currentData().toInt();
+    item.timestampOffset = ui->spinBoxTimestampOffset->value();
+    item.compression = ui->checkBoxCompression->isChecked();
+    item.compressionThreshold = ui->spinBoxCompressionThreshold->value();
+    item.contextTakeover = ui->checkBoxContextTakeover->isChecked();
 
     return saveSocketItem(item);
 }
@@ -74,6 +133,28 @@ void SocketUi::load(const QVariantMap &parameters)
     ui->spinBoxMulticastPort->setValue(item.multicastPort);
     ui->checkBoxEnableMulticast->setChecked(item.enableMulticast);
     ui->checkBoxJustMulticast->setChecked(item.justMulticast);
+    ui->spinBoxWorkerThreads->setValue(item.workerThreads);
+    ui->spinBoxQueueLimit->setValue(item.queueLimit);
+    int index = ui->comboBoxQueuePolicy->findData(static_cast<int>(item.queuePolicy));
+    ui->comboBoxQueuePolicy->setCurrentIndex(index < 0 ? 0 : index);
+    ui->checkBoxLowLatency->setChecked(item.lowLatency);
+    ui->lineEditCertificate->setText(item.certificate);
+    ui->lineEditPrivateKey->setText(item.privateKey);
+    ui->checkBoxVerifyPeer->setChecked(item.verifyPeer);
+    ui->comboBoxTargetAddress->setCurrentText(item.targetAddress);
+    ui->spinBoxTargetPort->setValue(item.targetPort);
+    ui->spinBoxSampleInterval->setValue(item.sampleInterval);
+    ui->checkBoxIoUring->setChecked(item.ioUring);
+    ui->spinBoxIdleTimeout->setValue(item.idleTimeout);
+    ui->lineEditMulticastGroups->setText(item.multicastGroups);
+    ui->lineEditMulticastInterfaces->setText(item.multicastInterfaces);
+    ui->spinBoxSequenceOffset->setValue(item.sequenceOffset);
+    index = ui->comboBoxSequenceWidth->findData(item.sequenceWidth);
+    ui->comboBoxSequenceWidth->setCurrentIndex(index < 0 ? 2 : index);
+    ui->spinBoxTimestampOffset->setValue(item.timestampOffset);
+    ui->checkBoxCompression->setChecked(item.compression);
+    ui->spinBoxCompressionThreshold->setValue(item.compressionThreshold);
+    ui->checkBoxContextTakeover->setChecked(item.contextTakeover);
 }
 
 void SocketUi::setServerWidgetsVisible(bool visible)
@@ -116,6 +197,85 @@ void SocketUi::setMulticastWidgetsVisible(bool visible)
     ui->checkBoxJustMulticast->setVisible(visible);
 }
 
+void SocketUi::setWorkerThreadsWidgetsVisible(bool visible)
+{
+    ui->labelWorkerThreads->setVisible(visible);
+    ui->spinBoxWorkerThreads->setVisible(visible);
+    ui->checkBoxIoUring->setVisible(visible);
+}
+
+void SocketUi::setQueueWidgetsVisible(bool visible)
+{
+    ui->labelQueueLimit->setVisible(visible);
+    ui->spinBoxQueueLimit->setVisible(visible);
+    ui->labelQueuePolicy->setVisible(visible);
+    ui->comboBoxQueuePolicy->setVisible(visible);
+}
+
+void SocketUi::setSslWidgetsVisible(bool visible)
+{
+    ui->labelCertificate->setVisible(visible);
+    ui->lineEditCertificate->setVisible(visible);
+    ui->toolButtonCertificate->setVisible(visible);
+    setPrivateKeyWidgetsVisible(visible);
+    ui->checkBoxVerifyPeer->setVisible(visible);
+}
+
+void SocketUi::setPrivateKeyWidgetsVisible(bool visible)
+{
+    ui->labelPrivateKey->setVisible(visible);
+    ui->lineEditPrivateKey->setVisible(visible);
+    ui->toolButtonPrivateKey->setVisible(visible);
+}
+
+void SocketUi::setProxyWidgetsVisible(bool visible)
+{
+    ui->labelTargetAddress->setVisible(visible);
+    ui->comboBoxTargetAddress->setVisible(visible);
+    ui->labelTargetPort->setVisible(visible);
+    ui->spinBoxTargetPort->setVisible(visible);
+    ui->labelSampleInterval->setVisible(visible);
+    ui->spinBoxSampleInterval->setVisible(visible);
+}
+
+void SocketUi::setIdleTimeoutWidgetsVisible(bool visible)
+{
+    ui->labelIdleTimeout->setVisible(visible);
+    ui->spinBoxIdleTimeout->setVisible(visible);
+}
+
+void SocketUi::setMulticastReceiverWidgetsVisible(bool visible)
+{
+    ui->labelMulticastGroups->setVisible(visible);
+    ui->lineEditMulticastGroups->setVisible(visible);
+    ui->labelMulticastInterfaces->setVisible(visible);
+    ui->lineEditMulticastInterfaces->setVisible(visible);
+    // The groups are received on the multicast port, sharded over the worker threads.
+    ui->labelMulticastPort->setVisible(visible);
+    ui->spinBoxMulticastPort->setVisible(visible);
+    ui->labelWorkerThreads->setVisible(visible);
+    ui->spinBoxWorkerThreads->setVisible(visible);
+}
+
+void SocketUi::setSequenceWidgetsVisible(bool visible)
+{
+    ui->labelSequence->setVisible(visible);
+    ui->spinBoxSequenceOffset->setVisible(visible);
+    ui->comboBoxSequenceWidth->setVisible(visible);
+    ui->labelTimestamp->setVisible(visible);
+    ui->spinBoxTimestampOffset->setVisible(visible);
+}
+
+void SocketUi::setCompressionWidgetsVisible(bool visible)
+{
+#if !defined(X_ENABLE_ZLIB)
+    visible = false; // Built without zlib
+#endif
+    ui->checkBoxCompression->setVisible(visible);
+    ui->spinBoxCompressionThreshold->setVisible(visible);
+    ui->checkBoxContextTakeover->setVisible(visible);
+}
+
 void SocketUi::setServerWidgetsEnabled(bool enabled)
 {
     ui->labelServerIp->setEnabled(enabled);
@@ -156,14 +316,107 @@ void SocketUi::setMulticastWidgetsEnabled(bool enabled)
     ui->checkBoxJustMulticast->setEnabled(enabled);
 }
 
-void SocketUi::setupClients(const QStringList &clients)
+void SocketUi::setWorkerThreadsWidgetsEnabled(bool enabled)
 {
+    ui->labelWorkerThreads->setEnabled(enabled);
+    ui->spinBoxWorkerThreads->setEnabled(enabled);
+    ui->checkBoxIoUring->setEnabled(enabled);
+}
+
+void SocketUi::setQueueWidgetsEnabled(bool enabled)
+{
+    ui->labelQueueLimit->setEnabled(enabled);
+    ui->spinBoxQueueLimit->setEnabled(enabled);
+    ui->labelQueuePolicy->setEnabled(enabled);
+    ui->comboBoxQueuePolicy->setEnabled(enabled);
+}
+
+void SocketUi::setLowLatencyWidgetsEnabled(bool enabled)
+{
+    ui->checkBoxLowLatency->setEnabled(enabled);
+}
+
+void SocketUi::setSslWidgetsEnabled(bool enabled)
+{
+    ui->labelCertificate->setEnabled(enabled);
+    ui->lineEditCertificate->setEnabled(enabled);
+    ui->toolButtonCertificate->setEnabled(enabled);
+    ui->labelPrivateKey->setEnabled(enabled);
+    ui->lineEditPrivateKey->setEnabled(enabled);
+    ui->toolButtonPrivateKey->setEnabled(enabled);
+    ui->checkBoxVerifyPeer->setEnabled(enabled);
+}
+
+void SocketUi::setProxyWidgetsEnabled(bool enabled)
+{
+    ui->labelTargetAddress->setEnabled(enabled);
+    ui->comboBoxTargetAddress->setEnabled(enabled);
+    ui->labelTargetPort->setEnabled(enabled);
+    ui->spinBoxTargetPort->setEnabled(enabled);
+    ui->labelSampleInterval->setEnabled(enabled);
+    ui->spinBoxSampleInterval->setEnabled(enabled);
+}
+
+void SocketUi::setIdleTimeoutWidgetsEnabled(bool enabled)
+{
+    ui->labelIdleTimeout->setEnabled(enabled);
+    ui->spinBoxIdleTimeout->setEnabled(enabled);
+}
+
+void SocketUi::setMulticastReceiverWidgetsEnabled(bool enabled)
+{
+    ui->labelMulticastGroups->setEnabled(enabled);
+    ui->lineEditMulticastGroups->setEnabled(enabled);
+    ui->labelMulticastInterfaces->setEnabled(enabled);
+    ui->lineEditMulticastInterfaces->setEnabled(enabled);
+    ui->labelMulticastPort->setEnabled(enabled);
+    ui->spinBoxMulticastPort->setEnabled(enabled);
+    ui->labelWorkerThreads->setEnabled(enabled);
+    ui->spinBoxWorkerThreads->setEnabled(enabled);
+}
+
+void SocketUi::setSequenceWidgetsEnabled(bool enabled)
+{
+    ui->labelSequence->setEnabled(enabled);
+    ui->spinBoxSequenceOffset->setEnabled(enabled);
+    ui->comboBoxSequenceWidth->setEnabled(enabled);
+    ui->labelTimestamp->setEnabled(enabled);
+    ui->spinBoxTimestampOffset->setEnabled(enabled);
+}
+
+void SocketUi::setCompressionWidgetsEnabled(bool enabled)
+{
+    ui->checkBoxCompression->setEnabled(enabled);
+    ui->spinBoxCompressionThreshold->setEnabled(enabled);
+    ui->checkBoxContextTakeover->setEnabled(enabled);
+}
+
+void SocketUi::setupClients(const QStringList &clients, const QHash<QString, qint64> &queueDepths)
+{
+    auto text = [&queueDepths](const QString &client) {
+        qint64 depth = queueDepths.value(client, 0);
+        return depth > 0 ? tr("%1 (%2 bytes queued)").arg(client).arg(depth) : client;
+    };
+
+    // Only the queue depths have changed, the texts are updated in place so that an opened popup
+    // is not closed every time.
+    bool sameClients = ui->comboBoxWriteTo->count() == clients.count() + 1;
+    for (int i = 0; sameClients && i < clients.count(); ++i) {
+        sameClients = ui->comboBoxWriteTo->itemData(i + 1).toString() == clients.at(i);
+    }
+    if (sameClients) {
+        for (int i = 0; i < clients.count(); ++i) {
+            ui->comboBoxWriteTo->setItemText(i + 1, text(clients.at(i)));
+        }
+        return;
+    }
+
     QString current = ui->comboBoxWriteTo->currentData().toString();
     ui->comboBoxWriteTo->clear();
     ui->comboBoxWriteTo->addItem(tr("All clients"), QString(""));
 
     for (const QString &client : clients) {
-        ui->comboBoxWriteTo->addItem(client, client);
+        ui->comboBoxWriteTo->addItem(text(client), client);
     }
 
     int index = ui->comboBoxWriteTo->findData(current);
@@ -8,6 +8,8 @@
  **************************************************************************************************/
 #pragma once
 
+#include <QHash>
+
 #include "deviceui.h"
 
 QT_BEGIN_NAMESPACE
@@ -40,14 +42,33 @@ protected:
     void setAuthenticationWidgetsVisible(bool visible);
     void setWriteToWidgetsVisible(bool visible);
     void setMulticastWidgetsVisible(bool visible);
+    void setWorkerThreadsWidgetsVisible(bool visible);
+    void setQueueWidgetsVisible(bool visible);
+    void setSslWidgetsVisible(bool visible);
+    void setPrivateKeyWidgetsVisible(bool visible);
+    void setProxyWidgetsVisible(bool visible);
+    void setIdleTimeoutWidgetsVisible(bool visible);
+    void setMulticastReceiverWidgetsVisible(bool visible);
+    void setSequenceWidgetsVisible(bool visible);
+    void setCompressionWidgetsVisible(bool visible);
 
     void setServerWidgetsEnabled(bool enabled);
     void setChannelWidgetsEnabled(bool enabled);
     void setAuthenticationWidgetsEnabled(bool enabled);
     void setWriteToWidgetsEnabled(bool enabled);
     void setMulticastWidgetsEnabled(bool enabled);
+    void setWorkerThreadsWidgetsEnabled(bool enabled);
+    void setQueueWidgetsEnabled(bool enabled);
+    void setLowLatencyWidgetsEnabled(bool enabled);
+    void setSslWidgetsEnabled(bool enabled);
+    void setProxyWidgetsEnabled(bool enabled);
+    void setIdleTimeoutWidgetsEnabled(bool enabled);
+    void setMulticastReceiverWidgetsEnabled(bool enabled);
+    void setSequenceWidgetsEnabled(bool enabled);
+    void setCompressionWidgetsEnabled(bool enabled);
 
-    void setupClients(const QStringList &clients);
+    void setupClients(const QStringList &clients,
+                      const QHash<QString, qint64> &queueDepths = QHash<QString, qint64>());
 
 private:
     Ui::SocketUi *ui;
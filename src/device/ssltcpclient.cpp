@@ -0,0 +1,146 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "ssltcpclient.h"
+
+#include <QSslCertificate>
+
+#include "utilities/lowlatency.h"
+
+SslTcpClient::SslTcpClient(QObject *parent)
+    : SocketClient(parent)
+{}
+
+SslTcpClient::~SslTcpClient() {}
+
+QObject *SslTcpClient::initDevice()
+{
+    QSslConfiguration configuration = sessionConfiguration();
+    bool ticketOffered = !configuration.sessionTicket().isEmpty();
+
+    m_sslSocket = new QSslSocket();
+    m_sslSocket->setSslConfiguration(configuration);
+    connect(m_sslSocket, &QSslSocket::readyRead, m_sslSocket, [this]() { readBytesFromDevice(); });
+    connect(m_sslSocket, &QSslSocket::connected, m_sslSocket, [this]() {
+        m_handshakeTimer.start();
+    });
+    connect(m_sslSocket, &QSslSocket::encrypted, m_sslSocket, [=]() {
+        m_stats.addHandshake(m_sslSocket, m_handshakeTimer.nsecsElapsed(), ticketOffered);
+        saveSessionConfiguration();
+    });
+    // TLS 1.3 tickets are sent after the handshake.
+    connect(m_sslSocket, &QSslSocket::newSessionTicketReceived, m_sslSocket, [this]() {
+        saveSessionConfiguration();
+    });
+    connect(m_sslSocket, &QSslSocket::errorOccurred, m_sslSocket, [this]() {
+        emit errorOccurred(m_sslSocket->errorString());
+    });
+    connect(m_sslSocket,
+            qOverload<const QList<QSslError> &>(&QSslSocket::sslErrors),
+            m_sslSocket,
+            [this](const QList<QSslError> &errors) {
+                QStringList errorStrings;
+                for (const QSslError &error : errors) {
+                    errorStrings.append(error.errorString());
+                }
+                emit errorOccurred(errorStrings.join("\n"));
+            });
+
+    m_sslSocket->connectToHostEncrypted(m_serverAddress, m_serverPort);
+    if (!m_sslSocket->waitForEncrypted()) {
+        m_stats.addFailedHandshake();
+        m_sslSocket->deleteLater();
+        m_sslSocket = nullptr;
+        return nullptr;
+    }
+
+    if (m_lowLatency) {
+        LowLatency::setup(m_sslSocket);
+    }
+
+    qInfo() << "server address:" << m_serverAddress << "port:" << m_serverPort;
+    return m_sslSocket;
+}
+
+void SslTcpClient::deinitDevice()
+{
+    // The session is saved before closing, the socket forgets it afterwards.
+    saveSessionConfiguration();
+    m_sslSocket->disconnectFromHost();
+    m_sslSocket->close();
+    m_sslSocket->deleteLater();
+    m_sslSocket = nullptr;
+}
+
+void SslTcpClient::writeActually(const QByteArray &bytes)
+{
+    qint64 ret = m_sslSocket->write(bytes);
+    if (m_lowLatency) {
+        m_sslSocket->flush();
+    }
+
+    if (ret == bytes.length()) {
+        m_stats.addWrittenBytes(ret);
+        emit bytesWritten(bytes, makeFlag(m_serverAddress, m_serverPort));
+    } else {
+        emit errorOccurred(m_sslSocket->errorString());
+    }
+}
+
+QList<QPair<QString, QString>> SslTcpClient::metrics() const
+{
+    return m_stats.metrics(true);
+}
+
+QSslConfiguration SslTcpClient::sessionConfiguration()
+{
+    // A session is only resumed with the same server and the same trust settings.
+    QString key = QString("%1:%2:%3:%4")
+                      .arg(m_serverAddress)
+                      .arg(m_serverPort)
+                      .arg(m_certificate)
+                      .arg(m_verifyPeer ? 1 : 0);
+
+    if (m_sessionKey != key || m_sessionConfiguration.isNull()) {
+        QSslConfiguration configuration = QSslConfiguration::defaultConfiguration();
+        configuration.setSslOption(QSsl::SslOptionDisableSessionTickets, false);
+        configuration.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+        configuration.setPeerVerifyMode(m_verifyPeer ? QSslSocket::VerifyPeer
+                                                     : QSslSocket::VerifyNone);
+        if (!m_certificate.isEmpty()) {
+            QList<QSslCertificate> certificates = QSslCertificate::fromPath(m_certificate);
+            if (certificates.isEmpty()) {
+                emit warningOccurred(tr("No certificate is found in %1.").arg(m_certificate));
+            }
+            configuration.addCaCertificates(certificates);
+        }
+
+        m_sessionConfiguration = configuration;
+        m_sessionKey = key;
+        m_stats.reset();
+    }
+
+    return m_sessionConfiguration;
+}
+
+void SslTcpClient::saveSessionConfiguration()
+{
+    QSslConfiguration configuration = m_sslSocket->sslConfiguration();
+    if (configuration.sessionTicket().isEmpty()) {
+        return;
+    }
+
+    m_sessionConfiguration = configuration;
+}
+
+void SslTcpClient::readBytesFromDevice()
+{
+    QByteArray bytes = m_sslSocket->readAll();
+    m_stats.addReadBytes(bytes.size());
+    emit bytesRead(bytes, makeFlag(m_serverAddress, m_serverPort));
+}
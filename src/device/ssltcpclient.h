@@ -0,0 +1,44 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QElapsedTimer>
+#include <QSslConfiguration>
+#include <QSslSocket>
+
+#include "socketclient.h"
+#include "utilities/sslsessionstats.h"
+
+class SslTcpClient : public SocketClient
+{
+    Q_OBJECT
+public:
+    explicit SslTcpClient(QObject *parent = nullptr);
+    ~SslTcpClient() override;
+
+    QObject *initDevice() override;
+    void deinitDevice() override;
+    void writeActually(const QByteArray &bytes) override;
+    QList<QPair<QString, QString>> metrics() const override;
+
+private:
+    QSslSocket *m_sslSocket{nullptr};
+    QElapsedTimer m_handshakeTimer;
+    SslSessionStats m_stats;
+
+    // The device object lives across reopening, the configuration of the last session keeps its
+    // session ticket, so the next handshake of a reconnect loop is resumed if the server accepts it.
+    QSslConfiguration m_sessionConfiguration;
+    QString m_sessionKey; // The parameters the session configuration was made for
+
+private:
+    QSslConfiguration sessionConfiguration();
+    void saveSessionConfiguration();
+    void readBytesFromDevice();
+};
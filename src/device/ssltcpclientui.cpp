@@ -0,0 +1,49 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "ssltcpclientui.h"
+
+#include "devicemetricsview.h"
+#include "ssltcpclient.h"
+
+SslTcpClientUi::SslTcpClientUi(QWidget *parent)
+    : SocketClientUi(parent)
+{
+    setWriteToWidgetsVisible(false);
+    setChannelWidgetsVisible(false);
+    setAuthenticationWidgetsVisible(false);
+    setMulticastWidgetsVisible(false);
+    setSslWidgetsVisible(true);
+    setPrivateKeyWidgetsVisible(false);
+}
+
+SslTcpClientUi::~SslTcpClientUi()
+{
+    delete m_metricsView;
+}
+
+Device *SslTcpClientUi::newDevice()
+{
+    return new SslTcpClient(this);
+}
+
+void SslTcpClientUi::setUiEnabled(bool enabled)
+{
+    setServerWidgetsEnabled(enabled);
+    setLowLatencyWidgetsEnabled(enabled);
+    setSslWidgetsEnabled(enabled);
+}
+
+QList<QWidget *> SslTcpClientUi::deviceControllers()
+{
+    if (!m_metricsView) {
+        m_metricsView = new DeviceMetricsView(device());
+    }
+
+    return QList<QWidget *>{m_metricsView};
+}
@@ -0,0 +1,280 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "ssltcpserver.h"
+
+#include <QFile>
+#include <QSslCertificate>
+#include <QSslKey>
+#include <QTimer>
+
+#include "utilities/lowlatency.h"
+
+SslTcpListener::SslTcpListener(QObject *parent)
+    : QTcpServer(parent)
+{}
+
+void SslTcpListener::incomingConnection(qintptr socketDescriptor)
+{
+    QSslSocket *socket = new QSslSocket(this);
+    if (socket->setSocketDescriptor(socketDescriptor)) {
+        addPendingConnection(socket);
+    } else {
+        delete socket;
+    }
+}
+
+SslTcpServer::SslTcpServer(QObject *parent)
+    : SocketServer(parent)
+{}
+
+SslTcpServer::~SslTcpServer() {}
+
+QObject *SslTcpServer::initDevice()
+{
+    if (!setupConfiguration()) {
+        return nullptr;
+    }
+
+    m_stats.reset();
+    m_clock.start();
+    m_scheduler.setLimit(m_queueLimit, static_cast<OutboundQueuePolicy>(m_queuePolicy));
+    m_tcpServer = new SslTcpListener();
+    connect(m_tcpServer, &QTcpServer::newConnection, m_tcpServer, [this]() {
+        while (m_tcpServer->hasPendingConnections()) {
+            auto socket = qobject_cast<QSslSocket *>(m_tcpServer->nextPendingConnection());
+            if (socket) {
+                setupClient(socket);
+            }
+        }
+    });
+    connect(m_tcpServer, &QTcpServer::acceptError, m_tcpServer, [this]() {
+        emit errorOccurred(m_tcpServer->errorString());
+    });
+
+    if (!m_tcpServer->listen(QHostAddress(m_serverAddress), m_serverPort)) {
+        emit errorOccurred(m_tcpServer->errorString());
+        m_tcpServer->deleteLater();
+        m_tcpServer = nullptr;
+        return nullptr;
+    }
+
+    QTimer *timer = new QTimer(m_tcpServer);
+    connect(timer, &QTimer::timeout, timer, [this]() { setClientQueueDepths(m_scheduler.depths()); });
+    timer->start(500);
+
+    qInfo() << "The server is listening on" << m_serverAddress << m_serverPort;
+    return m_tcpServer;
+}
+
+void SslTcpServer::deinitDevice()
+{
+    disconnectAllClients();
+
+    m_tcpServer->close();
+    m_tcpServer->deleteLater();
+    m_tcpServer = nullptr;
+}
+
+void SslTcpServer::writeActually(const QByteArray &bytes)
+{
+    QString flag = currentClientFlag();
+    QStringList flags = flag.isEmpty() ? m_sockets.keys() : QStringList(flag);
+    int count = 0;
+    QString lastFlag;
+    for (const QString &client : flags) {
+        QSslSocket *socket = m_sockets.value(client, nullptr);
+        if (!socket) {
+            continue;
+        }
+
+        if (m_scheduler.enqueue(client, bytes)) {
+            lastFlag = client;
+            count++;
+        } else {
+            emit warningOccurred(
+                tr("The outbound queue of %1 is full, the client is disconnected.").arg(client));
+            socket->disconnect();
+            socket->abort();
+            removeSocket(socket, client);
+        }
+    }
+
+    // A broadcast is reported once, not once per client.
+    if (count == 1) {
+        emit bytesWritten(bytes, lastFlag);
+    } else if (count > 1) {
+        emit bytesWritten(bytes, tr("%1 clients").arg(count));
+    }
+
+    drainQueues();
+}
+
+QList<QPair<QString, QString>> SslTcpServer::metrics() const
+{
+    return m_stats.metrics(false);
+}
+
+void SslTcpServer::disconnectAllClients()
+{
+    // The sockets in handshake are children of the listener, they are deleted with it.
+    QHash<QString, QSslSocket *> sockets;
+    sockets.swap(m_sockets);
+    m_scheduler.clear();
+    for (auto client : sockets) {
+        client->disconnect();
+        client->disconnectFromHost();
+        client->close();
+        client->deleteLater();
+    }
+    clearClients();
+}
+
+bool SslTcpServer::setupConfiguration()
+{
+    QList<QSslCertificate> certificates = QSslCertificate::fromPath(m_certificate);
+    if (certificates.isEmpty()) {
+        emit errorOccurred(tr("No certificate is found in \"%1\".").arg(m_certificate));
+        return false;
+    }
+
+    QFile file(m_privateKey);
+    if (!file.open(QFile::ReadOnly)) {
+        emit errorOccurred(tr("Failed to open the private key: %1").arg(file.errorString()));
+        return false;
+    }
+
+    QByteArray pem = file.readAll();
+    file.close();
+    QSslKey key(pem, QSsl::Rsa);
+    if (key.isNull()) {
+        key = QSslKey(pem, QSsl::Ec);
+    }
+    if (key.isNull()) {
+        emit errorOccurred(tr("The private key is neither an RSA key nor an EC key."));
+        return false;
+    }
+
+    // The first certificate is the one of the server, the others are the chain.
+    QSslConfiguration configuration = QSslConfiguration::defaultConfiguration();
+    configuration.setLocalCertificateChain(certificates);
+    configuration.setPrivateKey(key);
+    configuration.setSslOption(QSsl::SslOptionDisableSessionTickets, false);
+    configuration.setPeerVerifyMode(m_verifyPeer ? QSslSocket::VerifyPeer : QSslSocket::VerifyNone);
+    m_sslConfiguration = configuration;
+    return true;
+}
+
+void SslTcpServer::setupClient(QSslSocket *socket)
+{
+    // The client is listed when the handshake is done, bytes must not be written before.
+    const QString flag = makeFlag(socket->peerAddress().toString(), socket->peerPort());
+    const qint64 started = m_clock.nsecsElapsed();
+    if (m_lowLatency) {
+        LowLatency::setup(socket);
+    }
+
+    connect(socket, &QSslSocket::encrypted, socket, [=]() {
+        m_stats.addHandshake(socket, m_clock.nsecsElapsed() - started, false);
+        setupEncryptedClient(socket, flag);
+    });
+    connect(socket,
+            qOverload<const QList<QSslError> &>(&QSslSocket::sslErrors),
+            socket,
+            [=](const QList<QSslError> &errors) {
+                for (const QSslError &error : errors) {
+                    emit warningOccurred(QString("%1: %2").arg(flag, error.errorString()));
+                }
+            });
+    connect(socket, &QSslSocket::disconnected, socket, [=]() { removeSocket(socket, flag); });
+    connect(socket, &QSslSocket::errorOccurred, socket, [=]() { removeSocket(socket, flag); });
+
+    socket->setSslConfiguration(m_sslConfiguration);
+    socket->startServerEncryption();
+}
+
+void SslTcpServer::setupEncryptedClient(QSslSocket *socket, const QString &flag)
+{
+    m_sockets.insert(flag, socket);
+    m_scheduler.addClient(flag);
+    addClient(flag);
+
+    connect(socket, &QSslSocket::readyRead, socket, [=]() { readBytes(socket, flag); });
+    connect(socket, &QSslSocket::encryptedBytesWritten, socket, [=]() { drainQueues(flag); });
+
+    // Bytes may have arrived with the last handshake record.
+    readBytes(socket, flag);
+}
+
+bool SslTcpServer::writeActually(QSslSocket *socket, const QByteArray &bytes)
+{
+    qint64 ret = socket->write(bytes);
+    if (m_lowLatency) {
+        socket->flush();
+    }
+
+    if (ret == bytes.length()) {
+        m_stats.addWrittenBytes(ret);
+        return true;
+    }
+
+    emit errorOccurred(socket->errorString());
+    return false;
+}
+
+void SslTcpServer::readBytes(QSslSocket *socket, const QString &flag)
+{
+    QString currentFlag = currentClientFlag();
+    QByteArray bytes = socket->readAll();
+    if (bytes.isEmpty()) {
+        return;
+    }
+
+    m_stats.addReadBytes(bytes.size());
+    if (currentFlag.isEmpty() || currentFlag == flag) {
+        emit bytesRead(bytes, flag);
+    }
+}
+
+void SslTcpServer::removeSocket(QSslSocket *socket, const QString &flag)
+{
+    // Both errorOccurred and disconnected may be emitted for the same socket, a socket that has
+    // not finished its handshake is not listed.
+    if (m_sockets.value(flag, nullptr) == socket) {
+        m_sockets.remove(flag);
+        m_scheduler.removeClient(flag);
+        removeClient(flag);
+    } else {
+        m_stats.addFailedHandshake();
+    }
+
+    socket->disconnect();
+    socket->deleteLater();
+}
+
+void SslTcpServer::drainQueues(const QString &flag)
+{
+    // See TcpServer::drainQueues(), the plain bytes waiting for encryption are limited the same way.
+    const qint64 highWaterMark = 64 * 1024;
+    auto isWritable = [this, highWaterMark](const QString &client) {
+        QSslSocket *socket = m_sockets.value(client, nullptr);
+        return socket && socket->bytesToWrite() < highWaterMark;
+    };
+    auto write = [this](const QString &client, const QByteArray &bytes) {
+        QSslSocket *socket = m_sockets.value(client, nullptr);
+        if (socket) {
+            writeActually(socket, bytes);
+        }
+    };
+
+    if (flag.isEmpty()) {
+        m_scheduler.drain(isWritable, write);
+    } else {
+        m_scheduler.drainClient(flag, isWritable, write);
+    }
+}
@@ -0,0 +1,63 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSslConfiguration>
+#include <QSslSocket>
+#include <QTcpServer>
+
+#include "socketserver.h"
+#include "utilities/outboundqueue.h"
+#include "utilities/sslsessionstats.h"
+
+// Accepted connections are QSslSocket objects, nextPendingConnection() can be cast to QSslSocket.
+class SslTcpListener : public QTcpServer
+{
+    Q_OBJECT
+public:
+    explicit SslTcpListener(QObject *parent = nullptr);
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override;
+};
+
+class SslTcpServer : public SocketServer
+{
+    Q_OBJECT
+public:
+    explicit SslTcpServer(QObject *parent = nullptr);
+    ~SslTcpServer() override;
+
+    QObject *initDevice() override;
+    void deinitDevice() override;
+    void writeActually(const QByteArray &bytes) override;
+    QList<QPair<QString, QString>> metrics() const override;
+
+    void disconnectAllClients() override;
+
+private:
+    SslTcpListener *m_tcpServer{nullptr};
+    QSslConfiguration m_sslConfiguration;
+    QHash<QString, QSslSocket *> m_sockets; // flag -> socket, the encrypted ones only
+    OutboundScheduler m_scheduler;
+    QElapsedTimer m_clock;
+    SslSessionStats m_stats;
+
+private:
+    bool setupConfiguration();
+    void setupClient(QSslSocket *socket);
+    void setupEncryptedClient(QSslSocket *socket, const QString &flag);
+    bool writeActually(QSslSocket *socket, const QByteArray &bytes);
+    void readBytes(QSslSocket *socket, const QString &flag);
+    void removeSocket(QSslSocket *socket, const QString &flag);
+    // All queues, or the queue of the client with the given flag only.
+    void drainQueues(const QString &flag = QString());
+};
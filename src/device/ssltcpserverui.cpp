@@ -0,0 +1,51 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "ssltcpserverui.h"
+
+#include "devicemetricsview.h"
+#include "ssltcpserver.h"
+
+SslTcpServerUi::SslTcpServerUi(QWidget *parent)
+    : SocketServerUi(parent)
+{
+    setChannelWidgetsVisible(false);
+    setMulticastWidgetsVisible(false);
+    setAuthenticationWidgetsVisible(false);
+    setQueueWidgetsVisible(true);
+    setSslWidgetsVisible(true);
+}
+
+SslTcpServerUi::~SslTcpServerUi()
+{
+    delete m_metricsView;
+}
+
+Device *SslTcpServerUi::newDevice()
+{
+    auto server = new SslTcpServer(this);
+    setupServer(server);
+    return server;
+}
+
+void SslTcpServerUi::setUiEnabled(bool enabled)
+{
+    setServerWidgetsEnabled(enabled);
+    setQueueWidgetsEnabled(enabled);
+    setLowLatencyWidgetsEnabled(enabled);
+    setSslWidgetsEnabled(enabled);
+}
+
+QList<QWidget *> SslTcpServerUi::deviceControllers()
+{
+    if (!m_metricsView) {
+        m_metricsView = new DeviceMetricsView(device());
+    }
+
+    return QList<QWidget *>{m_metricsView};
+}
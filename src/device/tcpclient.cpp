@@ -10,6 +10,8 @@
 
 #include <QHostAddress>
 
+#include "utilities/lowlatency.h"
+
 TcpClient::TcpClient(QObject *parent)
     : SocketClient(parent)
 {}
@@ -46,6 +48,17 @@ QObject *TcpClient::initDevice()
         return nullptr;
     }
 
+    if (m_lowLatency) {
+        LowLatency::setup(m_tcpSocket);
+    }
+
+    m_txMeter.reset();
+    m_rxMeter.reset();
+#if defined(X_ENABLE_LINUX_NATIVE)
+    m_zeroCopyStats.reset();
+    new ZeroCopyWriter(m_tcpSocket, &m_zeroCopyStats);
+#endif
+
     qInfo() << "server address:" << m_serverAddress << "port:" << m_serverPort;
     return m_tcpSocket;
 }
@@ -60,16 +73,36 @@ void TcpClient::deinitDevice()
 
 void TcpClient::writeActually(const QByteArray &bytes)
 {
+#if defined(X_ENABLE_LINUX_NATIVE)
+    qint64 ret = ZeroCopyWriter::write(m_tcpSocket, bytes);
+#else
     qint64 ret = m_tcpSocket->write(bytes);
+#endif
+    if (m_lowLatency) {
+        // Handed to the kernel now rather than when the event loop is entered again.
+        m_tcpSocket->flush();
+    }
+
     if (ret == bytes.length()) {
+        m_txMeter.addBytes(ret);
         emit bytesWritten(bytes, makeFlag(m_serverAddress, m_serverPort));
     } else {
         emit errorOccurred(m_tcpSocket->errorString());
     }
 }
 
+QList<QPair<QString, QString>> TcpClient::metrics() const
+{
+    QList<QPair<QString, QString>> list = throughputMetrics();
+#if defined(X_ENABLE_LINUX_NATIVE)
+    list.append(m_zeroCopyStats.metrics());
+#endif
+    return list;
+}
+
 void TcpClient::readBytesFromDevice()
 {
     QByteArray bytes = m_tcpSocket->readAll();
+    m_rxMeter.addBytes(bytes.size());
     emit bytesRead(bytes, makeFlag(m_serverAddress, m_serverPort));
 }
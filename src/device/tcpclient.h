@@ -12,6 +12,10 @@
 
 #include "socketclient.h"
 
+#if defined(X_ENABLE_LINUX_NATIVE)
+#include "device/linux/zerocopywriter.h"
+#endif
+
 class TcpClient : public SocketClient
 {
     Q_OBJECT
@@ -22,9 +26,13 @@ public:
     QObject *initDevice() override;
     void deinitDevice() override;
     void writeActually(const QByteArray &bytes) override;
+    QList<QPair<QString, QString>> metrics() const override;
 
 private:
     QTcpSocket *m_tcpSocket{nullptr};
+#if defined(X_ENABLE_LINUX_NATIVE)
+    ZeroCopyStats m_zeroCopyStats;
+#endif
 
 private:
     void readBytesFromDevice();
@@ -8,6 +8,7 @@
  **************************************************************************************************/
 #include "tcpclientui.h"
 
+#include "devicemetricsview.h"
 #include "tcpclient.h"
 
 TcpClientUi::TcpClientUi(QWidget *parent)
@@ -19,7 +20,10 @@ TcpClientUi::TcpClientUi(QWidget *parent)
     setMulticastWidgetsVisible(false);
 }
 
-TcpClientUi::~TcpClientUi() {}
+TcpClientUi::~TcpClientUi()
+{
+    delete m_metricsView;
+}
 
 Device *TcpClientUi::newDevice()
 {
@@ -29,4 +33,14 @@ Device *TcpClientUi::newDevice()
 void TcpClientUi::setUiEnabled(bool enabled)
 {
     setServerWidgetsEnabled(enabled);
+    setLowLatencyWidgetsEnabled(enabled);
+}
+
+QList<QWidget *> TcpClientUi::deviceControllers()
+{
+    if (!m_metricsView) {
+        m_metricsView = new DeviceMetricsView(device());
+    }
+
+    return QList<QWidget *>{m_metricsView};
 }
@@ -10,6 +10,7 @@
 
 #include "socketclientui.h"
 
+class DeviceMetricsView;
 class TcpClientUi : public SocketClientUi
 {
     Q_OBJECT
@@ -19,4 +20,8 @@ public:
 
     Device *newDevice() override;
     void setUiEnabled(bool enabled) override;
+    QList<QWidget *> deviceControllers() override;
+
+private:
+    DeviceMetricsView *m_metricsView{nullptr};
 };
@@ -0,0 +1,123 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "tcpproxy.h"
+
+#include "device/linux/spliceproxy.h"
+
+TcpProxy::TcpProxy(QObject *parent)
+    : SocketServer(parent)
+{}
+
+TcpProxy::~TcpProxy() {}
+
+QObject *TcpProxy::initDevice()
+{
+    m_txMeter.reset();
+    m_rxMeter.reset();
+    m_sessions = 0;
+
+    m_proxy = new SpliceProxy();
+    m_proxy->setLowLatency(m_lowLatency);
+    m_proxy->setSampleInterval(m_sampleInterval);
+
+    // Everything is forwarded from the proxy thread directly, like the workers of TcpServer. The
+    // bytes from the clients are shown as read, the bytes from the target as written to the clients.
+    connect(
+        m_proxy,
+        &SpliceProxy::sessionOpened,
+        m_proxy,
+        [this](const QString &flag) {
+            m_sessions++;
+            addClient(flag);
+        },
+        Qt::DirectConnection);
+    connect(
+        m_proxy,
+        &SpliceProxy::sessionClosed,
+        m_proxy,
+        [this](const QString &flag) {
+            m_sessions--;
+            removeClient(flag);
+        },
+        Qt::DirectConnection);
+    connect(
+        m_proxy,
+        &SpliceProxy::bytesForwarded,
+        m_proxy,
+        [this](qint64 bytes, bool toTarget) {
+            toTarget ? m_rxMeter.addBytes(bytes) : m_txMeter.addBytes(bytes);
+        },
+        Qt::DirectConnection);
+    connect(
+        m_proxy,
+        &SpliceProxy::bytesSampled,
+        m_proxy,
+        [this](const QByteArray &bytes, const QString &flag, bool toTarget) {
+            QString currentFlag = currentClientFlag();
+            if (!currentFlag.isEmpty() && currentFlag != flag) {
+                return;
+            }
+
+            if (toTarget) {
+                emit bytesRead(bytes, flag);
+            } else {
+                emit bytesWritten(bytes, flag);
+            }
+        },
+        Qt::DirectConnection);
+    connect(
+        m_proxy,
+        &SpliceProxy::errorOccurred,
+        m_proxy,
+        [this](const QString &errorString) { emit warningOccurred(errorString); },
+        Qt::DirectConnection);
+
+    if (!m_proxy->open(m_serverAddress, m_serverPort, m_targetAddress, m_targetPort)) {
+        emit errorOccurred(tr("Failed to listen: %1").arg(m_proxy->errorString()));
+        delete m_proxy;
+        m_proxy = nullptr;
+        return nullptr;
+    }
+
+    qInfo() << "The proxy is listening on" << m_serverAddress << m_serverPort << "and forwarding to"
+            << m_targetAddress << m_targetPort;
+    return m_proxy;
+}
+
+void TcpProxy::deinitDevice()
+{
+    m_proxy->close();
+    delete m_proxy;
+    m_proxy = nullptr;
+    m_sessions = 0;
+    clearClients();
+}
+
+void TcpProxy::writeActually(const QByteArray &bytes)
+{
+    // The sockets belong to the proxy thread, bytes from the page would interleave with spliced
+    // ones at any position.
+    Q_UNUSED(bytes);
+    emit warningOccurred(tr("The proxy only forwards, the bytes are not sent."));
+}
+
+QList<QPair<QString, QString>> TcpProxy::metrics() const
+{
+    QList<QPair<QString, QString>> list;
+    list.append(qMakePair(tr("Sessions"), QString::number(m_sessions.load())));
+    list.append(throughputMetrics());
+    return list;
+}
+
+void TcpProxy::disconnectAllClients()
+{
+    if (m_proxy) {
+        m_proxy->disconnectAllSessions();
+    }
+}
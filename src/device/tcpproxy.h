@@ -0,0 +1,33 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <atomic>
+
+#include "socketserver.h"
+
+class SpliceProxy;
+class TcpProxy : public SocketServer
+{
+    Q_OBJECT
+public:
+    explicit TcpProxy(QObject *parent = nullptr);
+    ~TcpProxy() override;
+
+    QObject *initDevice() override;
+    void deinitDevice() override;
+    void writeActually(const QByteArray &bytes) override;
+    QList<QPair<QString, QString>> metrics() const override;
+
+    void disconnectAllClients() override;
+
+private:
+    SpliceProxy *m_proxy{nullptr};
+    std::atomic_int m_sessions{0};
+};
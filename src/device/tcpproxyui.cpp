@@ -0,0 +1,49 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "tcpproxyui.h"
+
+#include "devicemetricsview.h"
+#include "tcpproxy.h"
+
+TcpProxyUi::TcpProxyUi(QWidget *parent)
+    : SocketServerUi(parent)
+{
+    setChannelWidgetsVisible(false);
+    setMulticastWidgetsVisible(false);
+    setAuthenticationWidgetsVisible(false);
+    setProxyWidgetsVisible(true);
+}
+
+TcpProxyUi::~TcpProxyUi()
+{
+    delete m_metricsView;
+}
+
+Device *TcpProxyUi::newDevice()
+{
+    auto proxy = new TcpProxy(this);
+    setupServer(proxy);
+    return proxy;
+}
+
+void TcpProxyUi::setUiEnabled(bool enabled)
+{
+    setServerWidgetsEnabled(enabled);
+    setProxyWidgetsEnabled(enabled);
+    setLowLatencyWidgetsEnabled(enabled);
+}
+
+QList<QWidget *> TcpProxyUi::deviceControllers()
+{
+    if (!m_metricsView) {
+        m_metricsView = new DeviceMetricsView(device());
+    }
+
+    return QList<QWidget *>{m_metricsView};
+}
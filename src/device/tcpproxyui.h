@@ -0,0 +1,27 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include "socketserverui.h"
+
+class DeviceMetricsView;
+class TcpProxyUi : public SocketServerUi
+{
+    Q_OBJECT
+public:
+    explicit TcpProxyUi(QWidget *parent = nullptr);
+    ~TcpProxyUi() override;
+
+    Device *newDevice() override;
+    void setUiEnabled(bool enabled) override;
+    QList<QWidget *> deviceControllers() override;
+
+private:
+    DeviceMetricsView *m_metricsView{nullptr};
+};
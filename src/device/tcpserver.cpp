@@ -9,6 +9,13 @@
 #include "tcpserver.h"
 
 #include <QTcpSocket>
+#include <QTimer>
+
+#include "utilities/lowlatency.h"
+
+#if defined(X_ENABLE_LINUX_NATIVE)
+#include "device/linux/tcpserverworker.h"
+#endif
 
 TcpServer::TcpServer(QObject *parent)
     : SocketServer(parent)
@@ -18,6 +25,16 @@ TcpServer::~TcpServer() {}
 
 QObject *TcpServer::initDevice()
 {
+    m_txMeter.reset();
+    m_rxMeter.reset();
+#if defined(X_ENABLE_LINUX_NATIVE)
+    m_zeroCopyStats.reset();
+    if (m_workerThreads > 0) {
+        return initWorkers();
+    }
+#endif
+
+    m_scheduler.setLimit(m_queueLimit, static_cast<OutboundQueuePolicy>(m_queuePolicy));
     m_tcpServer = new QTcpServer();
     connect(m_tcpServer, &QTcpServer::newConnection, m_tcpServer, [this]() {
         QTcpSocket *client = m_tcpServer->nextPendingConnection();
@@ -35,11 +52,19 @@ QObject *TcpServer::initDevice()
     }
 
     qInfo() << "The server is listening on" << m_serverAddress << m_serverPort;
+    startQueueDepthTimer(m_tcpServer);
     return m_tcpServer;
 }
 
 void TcpServer::deinitDevice()
 {
+#if defined(X_ENABLE_LINUX_NATIVE)
+    if (!m_workers.isEmpty()) {
+        deinitWorkers();
+        return;
+    }
+#endif
+
     disconnectAllClients();
 
     m_tcpServer->close();
@@ -49,72 +74,281 @@ void TcpServer::deinitDevice()
 
 void TcpServer::writeActually(const QByteArray &bytes)
 {
+#if defined(X_ENABLE_LINUX_NATIVE)
+    if (!m_workers.isEmpty()) {
+        writeWorkers(bytes);
+        return;
+    }
+#endif
+
+    // The bytes are queued per client and handed to the sockets round-robin, a stalled client only
+    // fills its own queue.
     QString flag = currentClientFlag();
-    if (flag.isEmpty()) {
-        for (auto client : m_sockets) {
-            writeActually(client, bytes);
+    QStringList flags = flag.isEmpty() ? m_sockets.keys() : QStringList(flag);
+    int count = 0;
+    QString lastFlag;
+    for (const QString &client : flags) {
+        QTcpSocket *socket = m_sockets.value(client, nullptr);
+        if (!socket) {
+            continue;
         }
-    } else {
-        for (auto client : m_sockets) {
-            if (makeFlag(client->peerAddress().toString(), client->peerPort()) == flag) {
-                writeActually(client, bytes);
-                break;
-            }
+
+        if (m_scheduler.enqueue(client, bytes)) {
+            lastFlag = client;
+            count++;
+        } else {
+            emit warningOccurred(
+                tr("The outbound queue of %1 is full, the client is disconnected.").arg(client));
+            socket->disconnect();
+            socket->abort();
+            removeSocket(socket, client);
         }
     }
+
+    // A broadcast is reported once, not once per client.
+    if (count == 1) {
+        emit bytesWritten(bytes, lastFlag);
+    } else if (count > 1) {
+        emit bytesWritten(bytes, tr("%1 clients").arg(count));
+    }
+
+    drainQueues();
+}
+
+QList<QPair<QString, QString>> TcpServer::metrics() const
+{
+    QList<QPair<QString, QString>> list = throughputMetrics();
+#if defined(X_ENABLE_LINUX_NATIVE)
+    if (m_workers.isEmpty()) {
+        list.append(m_zeroCopyStats.metrics());
+    }
+#endif
+    return list;
 }
 
 void TcpServer::disconnectAllClients()
 {
-    for (auto client : m_sockets) {
+#if defined(X_ENABLE_LINUX_NATIVE)
+    // The workers report every client they have closed, the list is not cleared here.
+    if (!m_workers.isEmpty()) {
+        for (TcpServerWorker *worker : m_workers) {
+            worker->disconnectAllClients();
+        }
+        return;
+    }
+#endif
+
+    // The sockets are taken first, their disconnected signals must not touch the hash.
+    QHash<QString, QTcpSocket *> sockets;
+    sockets.swap(m_sockets);
+    m_scheduler.clear();
+    for (auto client : sockets) {
+        client->disconnect();
         client->disconnectFromHost();
         client->close();
         client->deleteLater();
     }
-    m_sockets.clear();
+    clearClients();
 }
 
-void TcpServer::writeActually(QTcpSocket *socket, const QByteArray &bytes)
+bool TcpServer::writeActually(QTcpSocket *socket, const QByteArray &bytes)
 {
+#if defined(X_ENABLE_LINUX_NATIVE)
+    qint64 ret = ZeroCopyWriter::write(socket, bytes);
+#else
     qint64 ret = socket->write(bytes);
+#endif
+    if (m_lowLatency) {
+        socket->flush();
+    }
+
     if (ret == bytes.length()) {
-        emit bytesWritten(bytes, makeFlag(socket->peerAddress().toString(), socket->peerPort()));
-    } else {
-        emit errorOccurred(socket->errorString());
+        m_txMeter.addBytes(ret);
+        return true;
     }
+
+    emit errorOccurred(socket->errorString());
+    return false;
 }
 
 void TcpServer::setupClient(QTcpSocket *socket)
 {
-    m_sockets.append(socket);
-    addClient(makeFlag(socket->peerAddress().toString(), socket->peerPort()));
+    // The flag is made once, the peer address is not available any more after disconnecting.
+    const QString flag = makeFlag(socket->peerAddress().toString(), socket->peerPort());
+    m_sockets.insert(flag, socket);
+    m_scheduler.addClient(flag);
+    if (m_lowLatency) {
+        LowLatency::setup(socket);
+    }
+#if defined(X_ENABLE_LINUX_NATIVE)
+    new ZeroCopyWriter(socket, &m_zeroCopyStats);
+#endif
 
-    connect(socket, &QTcpSocket::readyRead, socket, [socket, this]() { readBytes(socket); });
-    connect(socket, &QTcpSocket::disconnected, socket, [socket, this]() { removeSocket(socket); });
-    connect(socket, &QTcpSocket::errorOccurred, socket, [socket, this]() { removeSocket(socket); });
+    addClient(flag);
+
+    connect(socket, &QTcpSocket::readyRead, socket, [=]() { readBytes(socket, flag); });
+    connect(socket, &QTcpSocket::bytesWritten, socket, [=]() { drainQueues(flag); });
+    connect(socket, &QTcpSocket::disconnected, socket, [=]() { removeSocket(socket, flag); });
+    connect(socket, &QTcpSocket::errorOccurred, socket, [=]() { removeSocket(socket, flag); });
 }
 
-void TcpServer::readBytes(QTcpSocket *socket)
+void TcpServer::readBytes(QTcpSocket *socket, const QString &flag)
 {
     QString currentFlag = currentClientFlag();
-    if (currentFlag.isEmpty()) {
-        QByteArray bytes = socket->readAll();
-        if (!bytes.isEmpty()) {
-            emit bytesRead(bytes, makeFlag(socket->peerAddress().toString(), socket->peerPort()));
-        }
-    } else if (currentFlag == makeFlag(socket->peerAddress().toString(), socket->peerPort())) {
-        QByteArray bytes = socket->readAll();
-        if (!bytes.isEmpty()) {
-            emit bytesRead(bytes, currentFlag);
+    QByteArray bytes = socket->readAll();
+    if (bytes.isEmpty()) {
+        return;
+    }
+
+    m_rxMeter.addBytes(bytes.size());
+    if (currentFlag.isEmpty() || currentFlag == flag) {
+        emit bytesRead(bytes, flag);
+    }
+}
+
+void TcpServer::removeSocket(QTcpSocket *socket, const QString &flag)
+{
+    // Both errorOccurred and disconnected may be emitted for the same socket.
+    if (m_sockets.value(flag, nullptr) != socket) {
+        return;
+    }
+
+    m_sockets.remove(flag);
+    m_scheduler.removeClient(flag);
+    removeClient(flag);
+    socket->deleteLater();
+}
+
+void TcpServer::drainQueues(const QString &flag)
+{
+    // A socket takes the next message only when most of the previous ones have been handed to the
+    // kernel, otherwise QTcpSocket would buffer without limit again.
+    const qint64 highWaterMark = 64 * 1024;
+    auto isWritable = [this, highWaterMark](const QString &client) {
+        QTcpSocket *socket = m_sockets.value(client, nullptr);
+        return socket && socket->bytesToWrite() < highWaterMark;
+    };
+    auto write = [this](const QString &client, const QByteArray &bytes) {
+        QTcpSocket *socket = m_sockets.value(client, nullptr);
+        if (socket) {
+            writeActually(socket, bytes);
         }
+    };
+
+    // A socket that has written bytes only needs its own queue to be drained.
+    if (flag.isEmpty()) {
+        m_scheduler.drain(isWritable, write);
     } else {
-        socket->readAll();
+        m_scheduler.drainClient(flag, isWritable, write);
     }
 }
 
-void TcpServer::removeSocket(QTcpSocket *socket)
+void TcpServer::startQueueDepthTimer(QObject *context)
 {
-    removeClient(makeFlag(socket->peerAddress().toString(), socket->peerPort()));
-    socket->deleteLater();
-    m_sockets.removeAll(socket);
+    QTimer *timer = new QTimer(context);
+    connect(timer, &QTimer::timeout, timer, [this]() { updateQueueDepths(); });
+    timer->start(500);
+}
+
+void TcpServer::updateQueueDepths()
+{
+    QHash<QString, qint64> depths = m_scheduler.depths();
+#if defined(X_ENABLE_LINUX_NATIVE)
+    for (TcpServerWorker *worker : m_workers) {
+        QHash<QString, qint64> workerDepths = worker->queueDepths();
+        for (auto it = workerDepths.cbegin(); it != workerDepths.cend(); ++it) {
+            depths.insert(it.key(), it.value());
+        }
+    }
+#endif
+    setClientQueueDepths(depths);
+}
+
+#if defined(X_ENABLE_LINUX_NATIVE)
+QObject *TcpServer::initWorkers()
+{
+    for (int i = 0; i < m_workerThreads; ++i) {
+        TcpServerWorker *worker = new TcpServerWorker();
+        worker->setQueueLimit(m_queueLimit, static_cast<OutboundQueuePolicy>(m_queuePolicy));
+        worker->setLowLatency(m_lowLatency);
+        worker->setIoUring(m_ioUring);
+        m_workers.append(worker);
+
+        // Everything is forwarded from the worker threads directly, the client list is guarded by
+        // SocketServer and the signals of the device are queued to the ui thread anyway.
+        connect(
+            worker,
+            &TcpServerWorker::clientConnected,
+            worker,
+            [this](const QString &flag) { addClient(flag); },
+            Qt::DirectConnection);
+        connect(
+            worker,
+            &TcpServerWorker::clientDisconnected,
+            worker,
+            [this](const QString &flag) { removeClient(flag); },
+            Qt::DirectConnection);
+        connect(
+            worker,
+            &TcpServerWorker::bytesRead,
+            worker,
+            [this](const QByteArray &bytes, const QString &flag) {
+                m_rxMeter.addBytes(bytes.size());
+                QString currentFlag = currentClientFlag();
+                if (currentFlag.isEmpty() || currentFlag == flag) {
+                    emit bytesRead(bytes, flag);
+                }
+            },
+            Qt::DirectConnection);
+        connect(
+            worker,
+            &TcpServerWorker::errorOccurred,
+            worker,
+            [this](const QString &errorString) { emit errorOccurred(errorString); },
+            Qt::DirectConnection);
+
+        // The worker thread is started by open(), so it is connected first.
+        if (!worker->open(m_serverAddress, m_serverPort)) {
+            emit errorOccurred(tr("Failed to listen: %1").arg(worker->errorString()));
+            deinitWorkers();
+            return nullptr;
+        }
+    }
+
+    qInfo() << "The server is listening on" << m_serverAddress << m_serverPort << "with"
+            << m_workerThreads << "worker threads";
+    startQueueDepthTimer(m_workers.first());
+    return m_workers.first();
+}
+
+void TcpServer::deinitWorkers()
+{
+    for (TcpServerWorker *worker : m_workers) {
+        worker->close();
+        delete worker;
+    }
+    m_workers.clear();
+    clearClients();
+}
+
+void TcpServer::writeWorkers(const QByteArray &bytes)
+{
+    QString flag = currentClientFlag();
+    int count = 0;
+    QString lastFlag;
+    for (TcpServerWorker *worker : m_workers) {
+        count += worker->write(bytes, flag, &lastFlag);
+        if (!flag.isEmpty() && count > 0) {
+            break;
+        }
+    }
+    m_txMeter.addBytes(static_cast<qint64>(bytes.size()) * count);
+
+    // A broadcast is reported once, not once per client.
+    if (count == 1) {
+        emit bytesWritten(bytes, lastFlag);
+    } else if (count > 1) {
+        emit bytesWritten(bytes, tr("%1 clients").arg(count));
+    }
 }
+#endif
@@ -8,10 +8,19 @@
  **************************************************************************************************/
 #pragma once
 
+#include <QHash>
 #include <QTcpServer>
 
 #include "socketserver.h"
+#include "utilities/outboundqueue.h"
 
+#if defined(X_ENABLE_LINUX_NATIVE)
+#include "device/linux/zerocopywriter.h"
+#endif
+
+#if defined(X_ENABLE_LINUX_NATIVE)
+class TcpServerWorker;
+#endif
 class TcpServer : public SocketServer
 {
     Q_OBJECT
@@ -22,16 +31,31 @@ public:
     QObject *initDevice() override;
     void deinitDevice() override;
     void writeActually(const QByteArray &bytes) override;
+    QList<QPair<QString, QString>> metrics() const override;
 
     void disconnectAllClients() override;
 
 private:
     QTcpServer *m_tcpServer{nullptr};
-    QList<QTcpSocket *> m_sockets;
+    QHash<QString, QTcpSocket *> m_sockets; // flag -> socket
+    OutboundScheduler m_scheduler;
+#if defined(X_ENABLE_LINUX_NATIVE)
+    QList<TcpServerWorker *> m_workers;
+    ZeroCopyStats m_zeroCopyStats;
+#endif
 
 private:
     void setupClient(QTcpSocket *socket);
-    void writeActually(QTcpSocket *socket, const QByteArray &bytes);
-    void readBytes(QTcpSocket *socket);
-    void removeSocket(QTcpSocket *socket);
+    bool writeActually(QTcpSocket *socket, const QByteArray &bytes);
+    void readBytes(QTcpSocket *socket, const QString &flag);
+    void removeSocket(QTcpSocket *socket, const QString &flag);
+    // All queues, or the queue of the client with the given flag only.
+    void drainQueues(const QString &flag = QString());
+    void startQueueDepthTimer(QObject *context);
+    void updateQueueDepths();
+#if defined(X_ENABLE_LINUX_NATIVE)
+    QObject *initWorkers();
+    void deinitWorkers();
+    void writeWorkers(const QByteArray &bytes);
+#endif
 };
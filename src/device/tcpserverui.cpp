@@ -8,6 +8,7 @@
  **************************************************************************************************/
 #include "tcpserverui.h"
 
+#include "devicemetricsview.h"
 #include "tcpserver.h"
 
 TcpServerUi::TcpServerUi(QWidget *parent)
@@ -16,9 +17,16 @@ TcpServerUi::TcpServerUi(QWidget *parent)
     setChannelWidgetsVisible(false);
     setMulticastWidgetsVisible(false);
     setAuthenticationWidgetsVisible(false);
+    setQueueWidgetsVisible(true);
+#if defined(X_ENABLE_LINUX_NATIVE)
+    setWorkerThreadsWidgetsVisible(true);
+#endif
 }
 
-TcpServerUi::~TcpServerUi() {}
+TcpServerUi::~TcpServerUi()
+{
+    delete m_metricsView;
+}
 
 Device *TcpServerUi::newDevice()
 {
@@ -30,4 +38,16 @@ Device *TcpServerUi::newDevice()
 void TcpServerUi::setUiEnabled(bool enabled)
 {
     setServerWidgetsEnabled(enabled);
+    setWorkerThreadsWidgetsEnabled(enabled);
+    setQueueWidgetsEnabled(enabled);
+    setLowLatencyWidgetsEnabled(enabled);
+}
+
+QList<QWidget *> TcpServerUi::deviceControllers()
+{
+    if (!m_metricsView) {
+        m_metricsView = new DeviceMetricsView(device());
+    }
+
+    return QList<QWidget *>{m_metricsView};
 }
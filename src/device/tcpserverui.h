@@ -10,6 +10,7 @@
 
 #include "socketserverui.h"
 
+class DeviceMetricsView;
 class TcpServerUi : public SocketServerUi
 {
     Q_OBJECT
@@ -19,4 +20,8 @@ public:
 
     Device *newDevice() override;
     void setUiEnabled(bool enabled) override;
+    QList<QWidget *> deviceControllers() override;
+
+private:
+    DeviceMetricsView *m_metricsView{nullptr};
 };
@@ -8,6 +8,8 @@
  **************************************************************************************************/
 #include "udpclient.h"
 
+#include "utilities/lowlatency.h"
+
 UdpClient::UdpClient(QObject *parent)
     : SocketClient(parent)
 {}
@@ -16,8 +18,17 @@ UdpClient::~UdpClient() {}
 
 QObject *UdpClient::initDevice()
 {
+#if defined(X_ENABLE_LINUX_NATIVE)
+    // The family of the server address, an IPv4 multicast group can not be joined otherwise.
+    m_udpSocket = new DatagramSocket();
+    m_pendingWrites.clear();
+    m_unsent.clear();
+    m_unsentBytes = 0;
+    if (!m_udpSocket->open(QHostAddress(m_serverAddress).protocol())) {
+#else
     m_udpSocket = new QUdpSocket();
     if (!m_udpSocket->open(QUdpSocket::ReadWrite)) {
+#endif
         qWarning() << "Failed to open udp socket:" << m_udpSocket->errorString();
         m_udpSocket->deleteLater();
         m_udpSocket = Q_NULLPTR;
@@ -37,12 +48,37 @@ QObject *UdpClient::initDevice()
         }
     }
 
+#if defined(X_ENABLE_LINUX_NATIVE)
+    // The options apply to the unbound socket as well.
+    if (m_lowLatency) {
+        LowLatency::setup(m_udpSocket->socketDescriptor(), false);
+    }
+
+    connect(m_udpSocket, &DatagramSocket::readyRead, m_udpSocket, [this]() {
+        readPendingDatagrams();
+    });
+    connect(m_udpSocket, &DatagramSocket::readyWrite, m_udpSocket, [this]() {
+        flushPendingWrites();
+    });
+#else
+    // The socket is bound the same way the first writeDatagram() would do it, the options need a
+    // descriptor.
+    if (m_lowLatency) {
+        if (m_udpSocket->bind(QHostAddress::Any, 0)) {
+            LowLatency::setup(m_udpSocket);
+        } else {
+            qWarning() << "Failed to bind udp socket:" << m_udpSocket->errorString();
+        }
+    }
+
     connect(m_udpSocket, &QUdpSocket::readyRead, m_udpSocket, [this]() { readPendingDatagrams(); });
     connect(m_udpSocket, &QUdpSocket::errorOccurred, m_udpSocket, [this]() {
         qWarning() << m_udpSocket->errorString();
         emit errorOccurred(m_udpSocket->errorString());
     });
+#endif
 
+    m_sequenceAnalyser.reset(m_sequenceOffset, m_sequenceWidth, m_timestampOffset);
     qInfo() << "UDP server address:" << m_serverAddress << "port:" << m_serverPort;
 
     return m_udpSocket;
@@ -50,6 +86,11 @@ QObject *UdpClient::initDevice()
 
 void UdpClient::deinitDevice()
 {
+#if defined(X_ENABLE_LINUX_NATIVE)
+    m_pendingWrites.clear();
+    m_unsent.clear();
+    m_unsentBytes = 0;
+#endif
     m_udpSocket->close();
     m_udpSocket->deleteLater();
     m_udpSocket = nullptr;
@@ -57,6 +98,17 @@ void UdpClient::deinitDevice()
 
 void UdpClient::writeActually(const QByteArray &bytes)
 {
+#if defined(X_ENABLE_LINUX_NATIVE)
+    // The writes queued behind this one are sent with it, one sendmmsg() for all of them. Low
+    // latency sockets do not wait for them.
+    m_pendingWrites.append(bytes);
+    if (m_lowLatency) {
+        flushPendingWrites();
+    } else if (m_pendingWrites.size() == 1) {
+        QMetaObject::invokeMethod(
+            m_udpSocket, [this]() { flushPendingWrites(); }, Qt::QueuedConnection);
+    }
+#else
     if (m_enableMulticast) {
         writeDatagram(bytes, m_multicastAddress, m_multicastPort);
     }
@@ -64,20 +116,97 @@ void UdpClient::writeActually(const QByteArray &bytes)
     if (!m_justMulticast) {
         writeDatagram(bytes, m_serverAddress, m_serverPort);
     }
+#endif
 }
 
 void UdpClient::readPendingDatagrams()
 {
+    const bool analyse = m_sequenceAnalyser.isEnabled();
+#if defined(X_ENABLE_LINUX_NATIVE)
+    const QList<Datagram> datagrams = m_udpSocket->readDatagrams();
+    for (const Datagram &datagram : datagrams) {
+        const QString flag = makeFlag(datagram.address.toString(), datagram.port);
+        if (analyse) {
+            m_sequenceAnalyser.addDatagram(flag, datagram.data);
+        }
+        emit bytesRead(datagram.data, flag);
+    }
+#else
     while (m_udpSocket->hasPendingDatagrams()) {
         QByteArray datagram;
         datagram.resize(m_udpSocket->pendingDatagramSize());
         QHostAddress sender;
         quint16 senderPort;
         if (m_udpSocket->readDatagram(datagram.data(), datagram.size(), &sender, &senderPort) > 0) {
-            emit bytesRead(datagram, makeFlag(sender.toString(), senderPort));
+            const QString flag = makeFlag(sender.toString(), senderPort);
+            if (analyse) {
+                m_sequenceAnalyser.addDatagram(flag, datagram);
+            }
+            emit bytesRead(datagram, flag);
+        }
+    }
+#endif
+}
+
+#if defined(X_ENABLE_LINUX_NATIVE)
+void UdpClient::flushPendingWrites()
+{
+    if (!m_udpSocket) {
+        return;
+    }
+
+    QList<QByteArray> writes;
+    writes.swap(m_pendingWrites);
+
+    QList<Datagram> destinations;
+    if (m_enableMulticast) {
+        Datagram destination;
+        destination.address = QHostAddress(m_multicastAddress);
+        destination.port = m_multicastPort;
+        destinations.append(destination);
+    }
+    if (!m_justMulticast) {
+        Datagram destination;
+        destination.address = QHostAddress(m_serverAddress);
+        destination.port = m_serverPort;
+        destinations.append(destination);
+    }
+
+    // See UdpServer::flushPendingWrites(), the datagrams behind a full send buffer wait for it.
+    qint64 dropped = 0;
+    for (const QByteArray &bytes : writes) {
+        for (const Datagram &destination : destinations) {
+            if (m_unsentBytes + bytes.size() > maxUnsentBytes) {
+                dropped++;
+                continue;
+            }
+
+            m_unsent.append(destination);
+            m_unsent.last().data = bytes;
+            m_unsentBytes += bytes.size();
+        }
+    }
+    if (dropped > 0) {
+        emit warningOccurred(tr("The send buffer is full, %1 datagrams are dropped.").arg(dropped));
+    }
+
+    QList<DatagramError> errors;
+    const int done = m_udpSocket->writeDatagrams(m_unsent, &errors);
+    int nextError = 0;
+    for (int i = 0; i < done; ++i) {
+        const Datagram &datagram = m_unsent.at(i);
+        m_unsentBytes -= datagram.data.size();
+        if (nextError < errors.size() && errors.at(nextError).index == i) {
+            nextError++;
+            qWarning() << "Failed to write bytes:" << m_udpSocket->errorString();
+            emit errorOccurred(m_udpSocket->errorString());
+        } else {
+            emit bytesWritten(datagram.data, makeFlag(datagram.address.toString(), datagram.port));
         }
     }
+    m_unsent.erase(m_unsent.begin(), m_unsent.begin() + done);
 }
+#else
 
 void UdpClient::writeDatagram(const QByteArray &bytes, const QString &ip, quint16 port)
 {
@@ -89,3 +218,4 @@ void UdpClient::writeDatagram(const QByteArray &bytes, const QString &ip, quint1
         emit errorOccurred(m_udpSocket->errorString());
     }
 }
+#endif
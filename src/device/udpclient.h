@@ -12,6 +12,10 @@
 
 #include "socketclient.h"
 
+#if defined(X_ENABLE_LINUX_NATIVE)
+#include "device/linux/datagramsocket.h"
+#endif
+
 class UdpClient : public SocketClient
 {
     Q_OBJECT
@@ -24,9 +28,22 @@ public:
     void writeActually(const QByteArray &bytes) override;
 
 private:
+#if defined(X_ENABLE_LINUX_NATIVE)
+    // The datagrams the full send buffer has not taken yet, at most this many bytes of them.
+    static const qint64 maxUnsentBytes = 4 * 1024 * 1024;
+    DatagramSocket *m_udpSocket{nullptr};
+    QList<QByteArray> m_pendingWrites; // Sent together by flushPendingWrites()
+    QList<Datagram> m_unsent;          // Written again on readyWrite()
+    qint64 m_unsentBytes{0};
+#else
     QUdpSocket *m_udpSocket{nullptr};
+#endif
 
 private:
     void readPendingDatagrams();
+#if defined(X_ENABLE_LINUX_NATIVE)
+    void flushPendingWrites();
+#else
     void writeDatagram(const QByteArray &bytes, const QString &ip, quint16 port);
+#endif
 };
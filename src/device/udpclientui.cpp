@@ -8,6 +8,7 @@
  **************************************************************************************************/
 #include "udpclientui.h"
 
+#include "sequenceanalyserview.h"
 #include "udpclient.h"
 
 UdpClientUi::UdpClientUi(QWidget *parent)
@@ -16,9 +17,13 @@ UdpClientUi::UdpClientUi(QWidget *parent)
     setWriteToWidgetsVisible(false);
     setChannelWidgetsVisible(false);
     setAuthenticationWidgetsVisible(false);
+    setSequenceWidgetsVisible(true);
 }
 
-UdpClientUi::~UdpClientUi() {}
+UdpClientUi::~UdpClientUi()
+{
+    delete m_sequenceView;
+}
 
 Device *UdpClientUi::newDevice()
 {
@@ -29,4 +34,15 @@ void UdpClientUi::setUiEnabled(bool enabled)
 {
     setServerWidgetsEnabled(enabled);
     setMulticastWidgetsEnabled(enabled);
+    setLowLatencyWidgetsEnabled(enabled);
+    setSequenceWidgetsEnabled(enabled);
+}
+
+QList<QWidget *> UdpClientUi::deviceControllers()
+{
+    if (!m_sequenceView) {
+        m_sequenceView = new SequenceAnalyserView(qobject_cast<Socket *>(device()));
+    }
+
+    return QList<QWidget *>{m_sequenceView};
 }
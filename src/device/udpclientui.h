@@ -10,6 +10,7 @@
 
 #include "socketclientui.h"
 
+class SequenceAnalyserView;
 class UdpClientUi : public SocketClientUi
 {
     Q_OBJECT
@@ -19,4 +20,8 @@ public:
 
     Device *newDevice() override;
     void setUiEnabled(bool enabled) override;
+    QList<QWidget *> deviceControllers() override;
+
+private:
+    SequenceAnalyserView *m_sequenceView{nullptr};
 };
@@ -8,6 +8,11 @@
  **************************************************************************************************/
 #include "udpserver.h"
 
+#include <QLocale>
+#include <QTimer>
+
+#include "utilities/lowlatency.h"
+
 UdpServer::UdpServer(QObject *parent)
     : SocketServer(parent)
 {}
@@ -16,7 +21,11 @@ UdpServer::~UdpServer() {}
 
 QObject *UdpServer::initDevice()
 {
+#if defined(X_ENABLE_LINUX_NATIVE)
+    m_udpSocket = new DatagramSocket();
+#else
     m_udpSocket = new QUdpSocket();
+#endif
     if (!m_udpSocket->bind(QHostAddress(m_serverAddress), m_serverPort)) {
         qWarning() << "Failed to bind to address" << m_serverAddress << "and port" << m_serverPort;
         m_udpSocket->deleteLater();
@@ -24,10 +33,46 @@ QObject *UdpServer::initDevice()
         return nullptr;
     }
 
+#if defined(X_ENABLE_LINUX_NATIVE)
+    m_udpSocket->setGro(true);
+    m_pendingWrites.clear();
+    m_unsent.clear();
+    m_unsentTargets.clear();
+    m_unsentBytes = 0;
+    if (m_lowLatency) {
+        LowLatency::setup(m_udpSocket->socketDescriptor(), false);
+    }
+
+    connect(m_udpSocket, &DatagramSocket::readyRead, m_udpSocket, [this]() {
+        readPendingDatagrams();
+    });
+    connect(m_udpSocket, &DatagramSocket::readyWrite, m_udpSocket, [this]() {
+        flushPendingWrites();
+    });
+#else
+    if (m_lowLatency) {
+        LowLatency::setup(m_udpSocket);
+    }
+
     connect(m_udpSocket, &QUdpSocket::readyRead, m_udpSocket, [this]() { readPendingDatagrams(); });
     connect(m_udpSocket, &QUdpSocket::errorOccurred, m_udpSocket, [this]() {
         emit errorOccurred(m_udpSocket->errorString());
     });
+#endif
+
+    clearPeers();
+    m_peersMutex.lock();
+    m_droppedDatagrams = 0;
+    m_peersMutex.unlock();
+    m_clock.start();
+    m_sequenceAnalyser.reset(m_sequenceOffset, m_sequenceWidth, m_timestampOffset);
+    if (m_idleTimeout > 0) {
+        // A peer is dropped at most a quarter of the timeout(or a second) late.
+        m_expiryTimer = new QTimer(m_udpSocket);
+        m_expiryTimer->setInterval(qMin(1000, m_idleTimeout * 250));
+        connect(m_expiryTimer, &QTimer::timeout, m_udpSocket, [this]() { expirePeers(); });
+        m_expiryTimer->start();
+    }
 
     qInfo() << "Udp server is listening on" << m_serverAddress << "and port" << m_serverPort;
     return m_udpSocket;
@@ -35,6 +80,13 @@ QObject *UdpServer::initDevice()
 
 void UdpServer::deinitDevice()
 {
+#if defined(X_ENABLE_LINUX_NATIVE)
+    m_pendingWrites.clear();
+    m_unsent.clear();
+    m_unsentTargets.clear();
+    m_unsentBytes = 0;
+#endif
+    m_expiryTimer = nullptr; // Deleted with the socket
     m_udpSocket->close();
     m_udpSocket->deleteLater();
     m_udpSocket = nullptr;
@@ -42,28 +94,116 @@ void UdpServer::deinitDevice()
 
 void UdpServer::writeActually(const QByteArray &bytes)
 {
+#if defined(X_ENABLE_LINUX_NATIVE)
+    // The writes queued behind this one are sent with it, one sendmmsg() for all of them. Low
+    // latency sockets do not wait for them.
+    m_pendingWrites.append(bytes);
+    if (m_lowLatency) {
+        flushPendingWrites();
+    } else if (m_pendingWrites.size() == 1) {
+        QMetaObject::invokeMethod(
+            m_udpSocket, [this]() { flushPendingWrites(); }, Qt::QueuedConnection);
+    }
+#else
     QString currentFlag = currentClientFlag();
     if (currentFlag.isEmpty()) {
-        QStringList flags = clients();
+        m_peersMutex.lock();
+        QStringList flags = m_peerKeys.keys();
+        m_peersMutex.unlock();
+        int count = 0;
+        QString lastFlag;
         for (auto &flag : flags) {
-            writeDatagram(bytes, flag);
+            if (writeDatagram(bytes, flag)) {
+                lastFlag = flag;
+                count++;
+            }
+        }
+
+        // A broadcast is reported once, not once per peer.
+        if (count == 1) {
+            emit bytesWritten(bytes, lastFlag);
+        } else if (count > 1) {
+            emit bytesWritten(bytes, tr("%1 clients").arg(count));
         }
     } else {
         QPair<QString, int> client = splitFlag(currentFlag);
-        if (isValidFlag(client)) {
-            writeDatagram(bytes, currentFlag);
+        if (isValidFlag(client) && writeDatagram(bytes, currentFlag)) {
+            emit bytesWritten(bytes, currentFlag);
         }
     }
+#endif
+}
+
+QList<QPair<QString, QString>> UdpServer::metrics() const
+{
+    QList<QPair<QString, QString>> list;
+    const QString currentFlag = currentClientFlag();
+    QMutexLocker locker(&m_peersMutex);
+    list.append(qMakePair(tr("Peers"),
+                          tr("%1 active, %2 expired").arg(m_peers.size()).arg(m_expiredPeers)));
+    if (m_droppedDatagrams > 0) {
+        list.append(qMakePair(tr("Dropped datagrams"), QLocale().toString(m_droppedDatagrams)));
+    }
+
+    auto key = m_peerKeys.constFind(currentFlag);
+    if (key != m_peerKeys.constEnd()) {
+        const Peer peer = m_peers.value(*key);
+        const qint64 idle = m_clock.isValid() ? (m_clock.elapsed() - peer.lastSeen) / 1000 : 0;
+        list.append(qMakePair(currentFlag,
+                              tr("%1 datagrams(%2) in, %3 datagrams(%4) out, idle %5 s")
+                                  .arg(peer.rxDatagrams)
+                                  .arg(QLocale().formattedDataSize(peer.rxBytes))
+                                  .arg(peer.txDatagrams)
+                                  .arg(QLocale().formattedDataSize(peer.txBytes))
+                                  .arg(idle)));
+    }
+
+    return list;
 }
 
 void UdpServer::disconnectAllClients()
 {
-    clearClients();
+    clearPeers();
 }
 
 void UdpServer::readPendingDatagrams()
 {
     QString currentFlag = currentClientFlag();
+    QStringList newFlags;
+    const qint64 now = m_clock.elapsed();
+    const bool analyse = m_sequenceAnalyser.isEnabled();
+#if defined(X_ENABLE_LINUX_NATIVE)
+    // The table is updated for the whole batch at once, the bytes are emitted without the lock. A
+    // burst usually comes from a few senders, the peer is looked up only when the sender changes.
+    const QList<Datagram> datagrams = m_udpSocket->readDatagrams();
+    QStringList flags;
+    flags.reserve(datagrams.size());
+    m_peersMutex.lock();
+    Peer *peer = nullptr;
+    for (int i = 0; i < datagrams.size(); ++i) {
+        const Datagram &datagram = datagrams.at(i);
+        if (i == 0 || datagram.port != datagrams.at(i - 1).port
+            || datagram.address != datagrams.at(i - 1).address) {
+            peer = &touchPeer(datagram.address, datagram.port, now, newFlags);
+        }
+
+        peer->rxDatagrams++;
+        peer->rxBytes += datagram.data.size();
+        flags.append(peer->flag);
+    }
+    m_peersMutex.unlock();
+    addClients(newFlags);
+
+    for (int i = 0; i < datagrams.size(); ++i) {
+        const QString &flag = flags.at(i);
+        if (analyse) {
+            m_sequenceAnalyser.addDatagram(flag, datagrams.at(i).data);
+        }
+        if (currentFlag.isEmpty() || currentFlag == flag) {
+            emit bytesRead(datagrams.at(i).data, flag);
+        }
+    }
+#else
     while (m_udpSocket->hasPendingDatagrams()) {
         QByteArray datagram;
         datagram.resize(m_udpSocket->pendingDatagramSize());
@@ -73,21 +213,132 @@ void UdpServer::readPendingDatagrams()
             continue;
         }
 
-        QString const flag = makeFlag(sender.toString(), senderPort);
-        addClient(flag);
+        m_peersMutex.lock();
+        Peer &peer = touchPeer(sender, senderPort, now, newFlags);
+        peer.rxDatagrams++;
+        peer.rxBytes += datagram.size();
+        QString const flag = peer.flag;
+        m_peersMutex.unlock();
+
+        if (analyse) {
+            m_sequenceAnalyser.addDatagram(flag, datagram);
+        }
+
         if (currentFlag.isEmpty()) {
             emit bytesRead(datagram, flag);
         } else if (currentFlag == flag) {
             emit bytesRead(datagram, flag);
         }
     }
+    addClients(newFlags);
+#endif
 }
 
-void UdpServer::writeDatagram(const QByteArray &bytes, const QString &flag)
+#if defined(X_ENABLE_LINUX_NATIVE)
+void UdpServer::flushPendingWrites()
+{
+    if (!m_udpSocket) {
+        return;
+    }
+
+    QList<QByteArray> writes;
+    writes.swap(m_pendingWrites);
+
+    QList<Datagram> destinations;
+    QStringList destinationFlags;
+    QString currentFlag = currentClientFlag();
+    if (currentFlag.isEmpty()) {
+        m_peersMutex.lock();
+        for (auto it = m_peers.cbegin(); it != m_peers.cend(); ++it) {
+            Datagram destination;
+            destination.address = it.key().first;
+            destination.port = it.key().second;
+            destinations.append(destination);
+            destinationFlags.append(it->flag);
+        }
+        m_peersMutex.unlock();
+    } else {
+        QPair<QString, int> client = splitFlag(currentFlag);
+        if (isValidFlag(client)) {
+            Datagram destination;
+            destination.address = QHostAddress(client.first);
+            destination.port = static_cast<quint16>(client.second);
+            destinations.append(destination);
+            destinationFlags.append(currentFlag);
+        }
+    }
+
+    // The datagrams the full send buffer has not taken yet go first, in order. The backlog is
+    // bounded, the datagrams that do not fit are dropped like the kernel would drop them.
+    qint64 dropped = 0;
+    for (const QByteArray &bytes : writes) {
+        UnsentTarget target;
+        target.write = m_nextWrite++;
+        for (int i = 0; i < destinations.size(); ++i) {
+            if (m_unsentBytes + bytes.size() > maxUnsentBytes) {
+                dropped++;
+                continue;
+            }
+
+            m_unsent.append(destinations.at(i));
+            m_unsent.last().data = bytes;
+            target.flag = destinationFlags.at(i);
+            m_unsentTargets.append(target);
+            m_unsentBytes += bytes.size();
+        }
+    }
+
+    // A full send buffer is transient, the rest is written on readyWrite(). Only a destination
+    // that can not be reached removes its peer, a refused datagram is counted as dropped.
+    QList<DatagramError> errors;
+    const int done = m_udpSocket->writeDatagrams(m_unsent, &errors);
+    QStringList unreachable;
+    int nextError = 0;
+    int count = 0;
+    QString lastFlag;
+    for (int i = 0; i < done; ++i) {
+        const QString &flag = m_unsentTargets.at(i).flag;
+        const QByteArray &data = m_unsent.at(i).data;
+        m_unsentBytes -= data.size();
+        if (nextError < errors.size() && errors.at(nextError).index == i) {
+            if (DatagramSocket::isDestinationError(errors.at(nextError).error)) {
+                unreachable.append(flag);
+            } else {
+                dropped++;
+            }
+            nextError++;
+        } else {
+            countWritten(flag, data.size());
+            lastFlag = flag;
+            count++;
+        }
+
+        // A write to many peers is reported once, not once per peer.
+        if (count > 0
+            && (i + 1 == done || m_unsentTargets.at(i + 1).write != m_unsentTargets.at(i).write)) {
+            emit bytesWritten(data, count == 1 ? lastFlag : tr("%1 clients").arg(count));
+            count = 0;
+        }
+    }
+    m_unsent.erase(m_unsent.begin(), m_unsent.begin() + done);
+    m_unsentTargets.erase(m_unsentTargets.begin(), m_unsentTargets.begin() + done);
+
+    unreachable.removeDuplicates();
+    for (const QString &flag : unreachable) {
+        removePeer(flag);
+    }
+    if (dropped > 0) {
+        m_peersMutex.lock();
+        m_droppedDatagrams += dropped;
+        m_peersMutex.unlock();
+    }
+}
+#else
+bool UdpServer::writeDatagram(const QByteArray &bytes, const QString &flag)
 {
     QPair<QString, int> client = splitFlag(flag);
     if (!isValidFlag(client)) {
-        return;
+        return false;
     }
 
     QString const address = client.first;
@@ -95,12 +346,89 @@ void UdpServer::writeDatagram(const QByteArray &bytes, const QString &flag)
 
     qint64 ret = m_udpSocket->writeDatagram(bytes, QHostAddress(address), port);
     if (ret == bytes.length()) {
-        emit bytesWritten(bytes, makeFlag(address, port));
-    } else {
+        countWritten(flag, bytes.size());
+        return true;
+    }
+
 #if 0
-        emit errorOccurred(m_udpSocket->errorString());
+    emit errorOccurred(m_udpSocket->errorString());
 #else
-        removeClient(flag);
+    removePeer(flag);
 #endif
+    return false;
+}
+#endif
+
+UdpServer::Peer &UdpServer::touchPeer(const QHostAddress &address,
+                                      quint16 port,
+                                      qint64 now,
+                                      QStringList &newFlags)
+{
+    const PeerKey key(address, port);
+    auto it = m_peers.find(key);
+    if (it == m_peers.end()) {
+        Peer peer;
+        peer.flag = makeFlag(address.toString(), port);
+        it = m_peers.insert(key, peer);
+        m_peerKeys.insert(peer.flag, key);
+        newFlags.append(peer.flag);
+    }
+
+    it->lastSeen = now;
+    return it.value();
+}
+
+void UdpServer::countWritten(const QString &flag, int bytes)
+{
+    QMutexLocker locker(&m_peersMutex);
+    auto key = m_peerKeys.constFind(flag);
+    if (key != m_peerKeys.constEnd()) {
+        Peer &peer = m_peers[*key];
+        peer.txDatagrams++;
+        peer.txBytes += bytes;
+    }
+}
+
+void UdpServer::removePeer(const QString &flag)
+{
+    m_peersMutex.lock();
+    auto key = m_peerKeys.find(flag);
+    if (key != m_peerKeys.end()) {
+        m_peers.remove(*key);
+        m_peerKeys.erase(key);
     }
+    m_peersMutex.unlock();
+
+    removeClient(flag);
+}
+
+void UdpServer::clearPeers()
+{
+    m_peersMutex.lock();
+    m_peers.clear();
+    m_peerKeys.clear();
+    m_expiredPeers = 0;
+    m_peersMutex.unlock();
+
+    clearClients();
+}
+
+void UdpServer::expirePeers()
+{
+    const qint64 deadline = m_clock.elapsed() - static_cast<qint64>(m_idleTimeout) * 1000;
+    QStringList expired;
+    m_peersMutex.lock();
+    for (auto it = m_peers.begin(); it != m_peers.end();) {
+        if (it->lastSeen < deadline) {
+            expired.append(it->flag);
+            m_peerKeys.remove(it->flag);
+            it = m_peers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_expiredPeers += expired.size();
+    m_peersMutex.unlock();
+
+    removeClients(expired);
 }
@@ -8,10 +8,19 @@
  **************************************************************************************************/
 #pragma once
 
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QMutex>
 #include <QUdpSocket>
 
 #include "socketserver.h"
 
+#if defined(X_ENABLE_LINUX_NATIVE)
+#include "device/linux/datagramsocket.h"
+#endif
+
+class QTimer;
 class UdpServer : public SocketServer
 {
     Q_OBJECT
@@ -22,13 +31,62 @@ public:
     QObject *initDevice() override;
     void deinitDevice() override;
     void writeActually(const QByteArray &bytes) override;
+    QList<QPair<QString, QString>> metrics() const override;
 
     void disconnectAllClients() override;
 
 private:
+    // Every sender is a peer, the flag is made once when it is seen for the first time.
+    using PeerKey = QPair<QHostAddress, quint16>;
+    struct Peer
+    {
+        QString flag;
+        qint64 lastSeen{0}; // ms, m_clock
+        qint64 rxDatagrams{0};
+        qint64 rxBytes{0};
+        qint64 txDatagrams{0};
+        qint64 txBytes{0};
+    };
+    struct UnsentTarget
+    {
+        QString flag;
+        quint64 write{0}; // The datagrams of one write are reported together
+    };
+
+private:
+#if defined(X_ENABLE_LINUX_NATIVE)
+    // The datagrams the full send buffer has not taken yet, at most this many bytes of them.
+    static const qint64 maxUnsentBytes = 4 * 1024 * 1024;
+    DatagramSocket *m_udpSocket{nullptr};
+    QList<QByteArray> m_pendingWrites;   // Sent together by flushPendingWrites()
+    QList<Datagram> m_unsent;            // Written again on readyWrite()
+    QList<UnsentTarget> m_unsentTargets; // The peers of m_unsent
+    qint64 m_unsentBytes{0};
+    quint64 m_nextWrite{0};
+#else
     QUdpSocket *m_udpSocket{nullptr};
+#endif
+    QTimer *m_expiryTimer{nullptr};
+    QElapsedTimer m_clock;
+
+    // Updated by the device thread, read by metrics() from the ui thread.
+    QHash<PeerKey, Peer> m_peers;
+    QHash<QString, PeerKey> m_peerKeys; // flag -> key
+    qint64 m_expiredPeers{0};
+    qint64 m_droppedDatagrams{0}; // Not sent: the backlog was full or the datagram was refused
+    mutable QMutex m_peersMutex;
 
 private:
     void readPendingDatagrams();
-    void writeDatagram(const QByteArray &bytes, const QString &flag);
+#if defined(X_ENABLE_LINUX_NATIVE)
+    void flushPendingWrites();
+#else
+    bool writeDatagram(const QByteArray &bytes, const QString &flag);
+#endif
+    // The caller holds m_peersMutex, the flags of new peers are appended to newFlags.
+    Peer &touchPeer(const QHostAddress &address, quint16 port, qint64 now, QStringList &newFlags);
+    void countWritten(const QString &flag, int bytes);
+    void removePeer(const QString &flag);
+    void clearPeers();
+    void expirePeers();
 };
@@ -8,6 +8,8 @@
  **************************************************************************************************/
 #include "udpserverui.h"
 
+#include "devicemetricsview.h"
+#include "sequenceanalyserview.h"
 #include "udpserver.h"
 
 UdpServerUi::UdpServerUi(QWidget *parent)
@@ -16,9 +18,15 @@ UdpServerUi::UdpServerUi(QWidget *parent)
     setChannelWidgetsVisible(false);
     setAuthenticationWidgetsVisible(false);
     setMulticastWidgetsVisible(false);
+    setIdleTimeoutWidgetsVisible(true);
+    setSequenceWidgetsVisible(true);
 }
 
-UdpServerUi::~UdpServerUi() {}
+UdpServerUi::~UdpServerUi()
+{
+    delete m_metricsView;
+    delete m_sequenceView;
+}
 
 Device *UdpServerUi::newDevice()
 {
@@ -30,4 +38,19 @@ Device *UdpServerUi::newDevice()
 void UdpServerUi::setUiEnabled(bool enabled)
 {
     setServerWidgetsEnabled(enabled);
+    setLowLatencyWidgetsEnabled(enabled);
+    setIdleTimeoutWidgetsEnabled(enabled);
+    setSequenceWidgetsEnabled(enabled);
+}
+
+QList<QWidget *> UdpServerUi::deviceControllers()
+{
+    if (!m_metricsView) {
+        m_metricsView = new DeviceMetricsView(device());
+    }
+    if (!m_sequenceView) {
+        m_sequenceView = new SequenceAnalyserView(qobject_cast<Socket *>(device()));
+    }
+
+    return QList<QWidget *>{m_metricsView, m_sequenceView};
 }
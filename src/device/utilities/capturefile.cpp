@@ -0,0 +1,200 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "capturefile.h"
+
+#include <QDateTime>
+#include <QLocale>
+#include <QStringList>
+#include <QtEndian>
+
+#include "common/xtools.h"
+
+CaptureFile::CaptureFile() {}
+
+CaptureFile::~CaptureFile()
+{
+    close();
+}
+
+bool CaptureFile::open(const QString &fileName, const TextOptions &options)
+{
+    close();
+
+    m_errorString.clear();
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+
+    m_binary = m_file.peek(magic().size()) == magic();
+    m_options = options;
+
+    // The fields are separated by one space, a field of the locale may be several words.
+    auto tokens = [](const QString &text) { return text.simplified().split(' ').size(); };
+    const QDateTime now = QDateTime::currentDateTime();
+    const QLocale locale;
+    m_timeFormat = locale.timeFormat(QLocale::ShortFormat);
+    m_timeTokens = options.time ? tokens(now.toString(m_timeFormat)) : 0;
+    m_prefixTokens = m_timeTokens + (options.ms ? 1 : 0);
+    if (options.date) {
+        m_prefixTokens += tokens(now.toString(locale.dateFormat()));
+    }
+
+    return rewind();
+}
+
+void CaptureFile::close()
+{
+    m_file.close();
+    m_nextLine.clear();
+}
+
+bool CaptureFile::rewind()
+{
+    m_nextLine.clear();
+    m_lastTimeOfDay = -1;
+    m_days = 0;
+    if (!m_file.seek(m_binary ? magic().size() : 0)) {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+bool CaptureFile::readRecord(Record &record)
+{
+    return m_binary ? readBinaryRecord(record) : readTextRecord(record);
+}
+
+bool CaptureFile::isBinary() const
+{
+    return m_binary;
+}
+
+QString CaptureFile::errorString() const
+{
+    return m_errorString;
+}
+
+QByteArray CaptureFile::magic()
+{
+    return QByteArray("XTCAP\0\0\1", 8);
+}
+
+QByteArray CaptureFile::encodeRecord(const Record &record)
+{
+    QByteArray bytes(headerSize, Qt::Uninitialized);
+    uchar *header = reinterpret_cast<uchar *>(bytes.data());
+    qToLittleEndian<qint64>(record.timestamp, header);
+    qToLittleEndian<quint32>(static_cast<quint32>(record.bytes.size()), header + 8);
+    qToLittleEndian<quint32>(record.isRx ? 0 : TxFlag, header + 12);
+    bytes.append(record.bytes);
+    return bytes;
+}
+
+bool CaptureFile::readBinaryRecord(Record &record)
+{
+    const QByteArray header = m_file.read(headerSize);
+    if (header.size() < headerSize) {
+        return false;
+    }
+
+    const uchar *data = reinterpret_cast<const uchar *>(header.constData());
+    const quint32 length = qFromLittleEndian<quint32>(data + 8);
+    if (length > static_cast<quint32>(maxRecordSize)) {
+        m_errorString = QString("Invalid record length: %1").arg(length);
+        return false;
+    }
+
+    record.timestamp = qFromLittleEndian<qint64>(data);
+    record.isRx = !(qFromLittleEndian<quint32>(data + 12) & TxFlag);
+    record.bytes = m_file.read(length);
+    return record.bytes.size() == static_cast<int>(length);
+}
+
+bool CaptureFile::readTextRecord(Record &record)
+{
+    // The next record line has been read already, when the lines of the last record were joined.
+    QByteArray line = m_nextLine;
+    m_nextLine.clear();
+    while (!isRecordLine(line)) {
+        if (m_file.atEnd()) {
+            return false;
+        }
+
+        line = m_file.readLine();
+    }
+
+    while (!m_file.atEnd()) {
+        QByteArray next = m_file.readLine();
+        if (isRecordLine(next)) {
+            m_nextLine = next;
+            break;
+        }
+
+        line.append(next);
+    }
+
+    if (line.endsWith('\n')) {
+        line.chop(1);
+    }
+    if (line.endsWith('\r')) {
+        line.chop(1);
+    }
+
+    // "RX " or "TX ", then the fields, then the text.
+    QString text = QString::fromUtf8(line.mid(3));
+    QStringList prefix;
+    for (int i = 0; i < m_prefixTokens; ++i) {
+        int index = text.indexOf(' ');
+        if (index < 0) {
+            break;
+        }
+
+        prefix.append(text.left(index));
+        text = text.mid(index + 1);
+    }
+
+    record.isRx = line.startsWith("RX");
+    record.timestamp = parseTimestamp(prefix);
+    record.bytes = string2bytes(text, m_options.format);
+    return true;
+}
+
+bool CaptureFile::isRecordLine(const QByteArray &line) const
+{
+    return line.startsWith("RX ") || line.startsWith("TX ");
+}
+
+qint64 CaptureFile::parseTimestamp(const QStringList &prefix)
+{
+    // The time and the milliseconds are the last fields, the date is not needed.
+    if (!m_options.time || !m_options.ms || !m_timeFormat.contains('s')
+        || prefix.size() != m_prefixTokens) {
+        return -1;
+    }
+
+    const QStringList timeTokens = prefix.mid(prefix.size() - 1 - m_timeTokens, m_timeTokens);
+    const QTime time = QTime::fromString(timeTokens.join(' '), m_timeFormat);
+    bool ok = false;
+    const int ms = prefix.last().toInt(&ok);
+    if (!time.isValid() || !ok) {
+        return -1;
+    }
+
+    qint64 timeOfDay = time.msecsSinceStartOfDay() - time.msec() + ms;
+    if (m_lastTimeOfDay >= 0 && timeOfDay < m_lastTimeOfDay - 12 * 3600 * 1000) {
+        m_days += 1;
+    }
+
+    m_lastTimeOfDay = timeOfDay;
+    return (m_days * 24 * 3600 * 1000 + timeOfDay) * 1000;
+}
@@ -0,0 +1,76 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+// Reads the records of a binary capture or of a text log written by SaveThread, one by one, so a
+// capture of any size can be replayed. A binary capture starts with magic() and holds records of
+// {timestamp(8), length(4), flags(4)} followed by the bytes, little endian. A text log has a line
+// per record: "RX|TX [date] [time] [ms] text", the fields and the text format are the ones it was
+// saved with. Its records have a timestamp only if the time format of the locale has seconds and
+// the milliseconds were saved, a line the text was split into is joined again.
+class CaptureFile
+{
+public:
+    struct Record
+    {
+        qint64 timestamp{-1}; // us since epoch(of the first day for a log), negative if unknown
+        bool isRx{true};
+        QByteArray bytes;
+    };
+    struct TextOptions
+    {
+        int format{0}; // TextFormat
+        bool date{false};
+        bool time{false};
+        bool ms{false};
+    };
+
+public:
+    CaptureFile();
+    ~CaptureFile();
+
+    bool open(const QString &fileName, const TextOptions &options);
+    void close();
+    bool rewind();
+    bool readRecord(Record &record);
+    bool isBinary() const;
+    QString errorString() const;
+
+    static QByteArray magic();
+    static QByteArray encodeRecord(const Record &record);
+
+private:
+    enum RecordFlag { TxFlag = 0x01 };
+    static const int headerSize = 16;
+    static const int maxRecordSize = 64 * 1024 * 1024;
+
+private:
+    QFile m_file;
+    bool m_binary{false};
+    TextOptions m_options;
+    QString m_errorString;
+
+    // Text logs
+    int m_prefixTokens{0};
+    int m_timeTokens{0};
+    QString m_timeFormat;
+    QByteArray m_nextLine;
+    qint64 m_lastTimeOfDay{-1}; // ms
+    qint64 m_days{0};           // Passed midnight
+
+private:
+    bool readBinaryRecord(Record &record);
+    bool readTextRecord(Record &record);
+    bool isRecordLine(const QByteArray &line) const;
+    qint64 parseTimestamp(const QStringList &prefix);
+};
@@ -0,0 +1,808 @@
+﻿/***************************************************************************************************
+ * Copyright 2023-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "filetransfer.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+
+#include "common/crc.h"
+
+// Control characters of XMODEM/YMODEM
+static const char SOH = 0x01;
+static const char STX = 0x02;
+static const char EOT = 0x04;
+static const char ACK = 0x06;
+static const char NAK = 0x15;
+static const char CAN = 0x18;
+static const char CPMEOF = 0x1a;
+
+// ZMODEM, see zmodem.h of lrzsz
+static const char ZPAD = '*';
+static const char ZDLE = 0x18;
+static const char ZBIN = 'A';
+static const char ZHEX = 'B';
+static const char ZBIN32 = 'C';
+static const char ZCRCE = 'h'; // End of frame, header packet follows
+static const char ZCRCG = 'i'; // Frame continues non-stop
+static const char ZCRCQ = 'j'; // Frame continues, ZACK expected
+static const char ZCRCW = 'k'; // End of frame, ZACK expected
+static const char XON = 0x11;
+
+enum ZFrameType {
+    ZRQINIT = 0,
+    ZRINIT = 1,
+    ZACK = 3,
+    ZFILE = 4,
+    ZSKIP = 5,
+    ZNAK = 6,
+    ZABORT = 7,
+    ZFIN = 8,
+    ZRPOS = 9,
+    ZDATA = 10,
+    ZEOF = 11,
+    ZFERR = 12,
+    ZCRC = 13,
+    ZCAN = 16
+};
+
+static const quint32 CANFC32 = 0x20; // ZF0 of ZRINIT, receiver can use 32 bit CRC
+static const quint32 ESCCTL = 0x40;  // ZF0 of ZRINIT, receiver expects control characters escaped
+static const quint8 ZCBIN = 1;       // ZF0 of ZFILE, binary transfer
+static const quint8 ZCRESUM = 3;     // ZF0 of ZFILE, resume interrupted file transfer
+
+static const int maxRetries = 10;
+static const int startTimeout = 60 * 1000;
+static const int responseTimeout = 10 * 1000;
+static const int zSubpacketSize = 1024;
+static const qint64 zWindowSize = 32 * 1024; // Bytes in flight without a ZACK
+static const qint64 zQueryInterval = 8 * 1024; // A ZCRCQ is sent after this many bytes
+
+FileTransfer::FileTransfer(QObject *parent)
+    : QObject(parent)
+{
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &FileTransfer::onTimeout);
+}
+
+FileTransfer::~FileTransfer()
+{
+    m_file.close();
+}
+
+QList<int> FileTransfer::supportedProtocols()
+{
+    QList<int> protocols;
+    protocols << static_cast<int>(Protocol::XModemCrc);
+    protocols << static_cast<int>(Protocol::XModem1K);
+    protocols << static_cast<int>(Protocol::YModem);
+    protocols << static_cast<int>(Protocol::ZModem);
+    return protocols;
+}
+
+QString FileTransfer::protocolName(int protocol)
+{
+    switch (static_cast<Protocol>(protocol)) {
+    case Protocol::XModemCrc:
+        return QString("XMODEM-CRC");
+    case Protocol::XModem1K:
+        return QString("XMODEM-1K");
+    case Protocol::YModem:
+        return QString("YMODEM");
+    case Protocol::ZModem:
+        return QString("ZMODEM");
+    default:
+        return QString("Unknown");
+    }
+}
+
+void FileTransfer::start(int protocol, const QStringList &fileNames, bool resume)
+{
+    if (m_state != State::Idle) {
+        qWarning() << "A file transfer is in progress";
+        return;
+    }
+
+    m_protocol = static_cast<Protocol>(protocol);
+    m_fileNames = fileNames;
+    m_resume = resume;
+    if (m_protocol == Protocol::XModemCrc || m_protocol == Protocol::XModem1K) {
+        // XMODEM has no file name, only the first file is sent.
+        m_fileNames = fileNames.mid(0, 1);
+    }
+
+    m_rxBuffer.clear();
+    m_retries = 0;
+    m_cancels = 0;
+    m_doneBytes = 0;
+    m_zErrors = 0;
+    m_elapsedTimer.start();
+    m_progressTimer.start();
+
+    if (!openNextFile()) {
+        finish(false, tr("No file to send."));
+        return;
+    }
+
+    if (m_protocol == Protocol::ZModem) {
+        // "rz\r" starts the receiver if the other side is a shell.
+        output(QByteArray("rz\r"));
+        sendZHexHeader(ZRQINIT, 0);
+        m_state = State::ZWaitRInit;
+        restartTimer(responseTimeout);
+    } else {
+        m_state = State::WaitStart;
+        restartTimer(startTimeout);
+    }
+}
+
+void FileTransfer::cancel()
+{
+    if (m_state == State::Idle) {
+        return;
+    }
+
+    // The abort sequence of ZMODEM, it also cancels XMODEM/YMODEM receivers.
+    output(QByteArray(8, CAN) + QByteArray(8, 0x08));
+    finish(false, tr("Cancelled."));
+}
+
+void FileTransfer::inputBytes(const QByteArray &bytes)
+{
+    if (m_state == State::Idle) {
+        return;
+    }
+
+    if (m_protocol == Protocol::ZModem) {
+        m_rxBuffer.append(bytes);
+        handleZModem();
+        return;
+    }
+
+    for (char c : bytes) {
+        if (m_state == State::Idle) {
+            break;
+        }
+
+        handleXyModem(c);
+    }
+}
+
+void FileTransfer::finish(bool succeeded, const QString &message)
+{
+    qint64 const bytes = transferred();
+    m_timer->stop();
+    m_file.close();
+    m_state = State::Idle;
+    m_rxBuffer.clear();
+    m_lastPacket.clear();
+    emit finished(succeeded, message, bytes, m_elapsedTimer.elapsed());
+}
+
+void FileTransfer::output(const QByteArray &bytes)
+{
+    emit outputBytes(bytes);
+}
+
+void FileTransfer::restartTimer(int msec)
+{
+    m_timer->start(msec);
+}
+
+void FileTransfer::onTimeout()
+{
+    if (m_state == State::Idle) {
+        return;
+    }
+
+    if (++m_retries > maxRetries) {
+        finish(false, tr("The receiver does not respond."));
+        return;
+    }
+
+    switch (m_state) {
+    case State::WaitStart:
+    case State::WaitDataStart:
+    case State::WaitEndStart:
+        finish(false, tr("The receiver does not respond."));
+        return;
+    case State::ZWaitRInit:
+        sendZHexHeader(ZRQINIT, 0);
+        break;
+    case State::ZSending:
+        // Nothing has been acknowledged for a while, go back to the last acknowledged position.
+        sendZData(m_zAckedPosition);
+        return;
+    case State::ZWaitFin:
+        sendZHexHeader(ZFIN, 0);
+        break;
+    default:
+        output(m_lastPacket);
+        break;
+    }
+
+    restartTimer(responseTimeout);
+}
+
+bool FileTransfer::openNextFile()
+{
+    if (m_file.isOpen()) {
+        m_doneBytes += m_position - m_startPosition;
+        m_file.close();
+    }
+
+    while (!m_fileNames.isEmpty()) {
+        m_file.setFileName(m_fileNames.takeFirst());
+        if (m_file.open(QFile::ReadOnly)) {
+            m_position = 0;
+            m_startPosition = 0;
+            m_blockNumber = 1;
+            return true;
+        }
+
+        qWarning() << "Failed to open file:" << m_file.fileName() << m_file.errorString();
+    }
+
+    return false;
+}
+
+void FileTransfer::updateProgress(bool force)
+{
+    if (!force && m_progressTimer.elapsed() < 100) {
+        return;
+    }
+
+    m_progressTimer.restart();
+    emit progressChanged(m_file.fileName(),
+                         m_position,
+                         m_file.size(),
+                         transferred(),
+                         m_elapsedTimer.elapsed());
+}
+
+qint64 FileTransfer::transferred() const
+{
+    // The part of a resumed file that the receiver already has is not counted.
+    qint64 const current = m_file.isOpen() ? m_position - m_startPosition : 0;
+    return m_doneBytes + current;
+}
+
+void FileTransfer::handleXyModem(char c)
+{
+    if (c == CAN) {
+        // Two CANs in a row cancel the transfer.
+        if (++m_cancels >= 2) {
+            finish(false, tr("Cancelled by the receiver."));
+        }
+        return;
+    }
+    m_cancels = 0;
+
+    switch (m_state) {
+    case State::WaitStart:
+        if (c == 'C' || (c == NAK && m_protocol == Protocol::XModemCrc)) {
+            m_useCrc = (c == 'C');
+            m_retries = 0;
+            if (m_protocol == Protocol::YModem) {
+                sendXyHeader(false);
+            } else {
+                sendXyBlock();
+            }
+        }
+        break;
+    case State::WaitHeaderAck:
+        if (c == ACK) {
+            m_retries = 0;
+            if (m_endOfBatch) {
+                finish(true, tr("Done."));
+            } else {
+                m_state = State::WaitDataStart;
+                restartTimer(responseTimeout);
+            }
+        } else if (c == NAK) {
+            output(m_lastPacket);
+            restartTimer(responseTimeout);
+        }
+        break;
+    case State::WaitDataStart:
+        if (c == 'C') {
+            sendXyBlock();
+        }
+        break;
+    case State::WaitBlockAck:
+        if (c == ACK) {
+            m_retries = 0;
+            m_position += m_blockSize;
+            m_blockNumber++;
+            updateProgress(false);
+            sendXyBlock();
+        } else if (c == NAK || (c == 'C' && m_blockNumber == 1)) {
+            if (++m_retries > maxRetries) {
+                finish(false, tr("Too many errors."));
+                return;
+            }
+            output(m_lastPacket);
+            restartTimer(responseTimeout);
+        }
+        break;
+    case State::WaitEotAck:
+        if (c == ACK) {
+            m_retries = 0;
+            updateProgress(true);
+            if (m_protocol != Protocol::YModem) {
+                finish(true, tr("Done."));
+            } else if (openNextFile()) {
+                m_state = State::WaitStart;
+                restartTimer(responseTimeout);
+            } else {
+                m_state = State::WaitEndStart;
+                restartTimer(responseTimeout);
+            }
+        } else if (c == NAK) {
+            // YMODEM receivers NAK the first EOT to make sure it is not line noise.
+            output(m_lastPacket);
+            restartTimer(responseTimeout);
+        }
+        break;
+    case State::WaitEndStart:
+        if (c == 'C') {
+            sendXyHeader(true);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void FileTransfer::sendXyBlock()
+{
+    if (!m_file.seek(m_position)) {
+        finish(false, m_file.errorString());
+        return;
+    }
+
+    int size = (m_protocol == Protocol::XModemCrc) ? 128 : 1024;
+    QByteArray data = m_file.read(size);
+    if (data.isEmpty()) {
+        m_lastPacket = QByteArray(1, EOT);
+        output(m_lastPacket);
+        m_state = State::WaitEotAck;
+        restartTimer(responseTimeout);
+        return;
+    }
+
+    // The last block is sent as a 128 bytes block if it fits, that saves up to 896 bytes of
+    // padding.
+    if (data.size() <= 128) {
+        size = 128;
+    }
+
+    m_blockSize = data.size();
+    m_lastPacket = makeXyBlock(m_blockNumber, data, size);
+    output(m_lastPacket);
+    m_state = State::WaitBlockAck;
+    restartTimer(responseTimeout);
+}
+
+void FileTransfer::sendXyHeader(bool endOfBatch)
+{
+    // An empty file name in block 0 ends the batch.
+    m_endOfBatch = endOfBatch;
+    QByteArray data = endOfBatch ? QByteArray() : fileInformation(false);
+    int size = data.size() <= 128 ? 128 : 1024;
+    data.append(QByteArray(size - data.size(), '\0'));
+    m_lastPacket = makeXyBlock(0, data, size);
+    output(m_lastPacket);
+    m_state = State::WaitHeaderAck;
+    restartTimer(responseTimeout);
+}
+
+QByteArray FileTransfer::makeXyBlock(quint8 number, const QByteArray &data, int size) const
+{
+    QByteArray payload = data;
+    payload.append(QByteArray(size - data.size(), CPMEOF));
+
+    QByteArray block;
+    block.reserve(size + 5);
+    block.append(size == 1024 ? STX : SOH);
+    block.append(static_cast<char>(number));
+    block.append(static_cast<char>(~number));
+    block.append(payload);
+    if (m_useCrc) {
+        block.append(CRC::calculate(payload, static_cast<int>(CRC::Algorithm::CRC_16_XMODEM), true));
+    } else {
+        quint8 sum = 0;
+        for (char c : payload) {
+            sum += static_cast<quint8>(c);
+        }
+        block.append(static_cast<char>(sum));
+    }
+
+    return block;
+}
+
+void FileTransfer::handleZModem()
+{
+    // Five CANs in a row is the abort sequence.
+    if (m_rxBuffer.contains(QByteArray(5, CAN))) {
+        finish(false, tr("Cancelled by the receiver."));
+        return;
+    }
+
+    int type = 0;
+    quint32 position = 0;
+    while (m_state != State::Idle && takeZHeader(type, position)) {
+        handleZHeader(type, position);
+    }
+}
+
+bool FileTransfer::takeZHeader(int &type, quint32 &position)
+{
+    while (true) {
+        int start = m_rxBuffer.indexOf(ZPAD);
+        if (start < 0) {
+            // The tail is kept, an abort sequence may be split across reads.
+            m_rxBuffer = m_rxBuffer.right(4);
+            return false;
+        }
+
+        m_rxBuffer.remove(0, start);
+        int i = 0;
+        while (i < m_rxBuffer.size() && m_rxBuffer.at(i) == ZPAD) {
+            i++;
+        }
+        if (i + 1 >= m_rxBuffer.size()) {
+            return false;
+        }
+
+        if (m_rxBuffer.at(i) != ZDLE) {
+            m_rxBuffer.remove(0, i);
+            continue;
+        }
+
+        const char format = m_rxBuffer.at(i + 1);
+        int p = i + 2;
+        QByteArray raw;
+        if (format == ZHEX) {
+            if (m_rxBuffer.size() < p + 14) {
+                return false;
+            }
+
+            raw = QByteArray::fromHex(m_rxBuffer.mid(p, 14));
+            p += 14;
+        } else if (format == ZBIN || format == ZBIN32) {
+            const int length = (format == ZBIN) ? 7 : 9;
+            while (raw.size() < length && p < m_rxBuffer.size()) {
+                char c = m_rxBuffer.at(p++);
+                if (c == ZDLE) {
+                    if (p >= m_rxBuffer.size()) {
+                        break;
+                    }
+                    c = static_cast<char>(m_rxBuffer.at(p++) ^ 0x40);
+                }
+                raw.append(c);
+            }
+
+            if (raw.size() < length) {
+                return false;
+            }
+        } else {
+            m_rxBuffer.remove(0, i + 1);
+            continue;
+        }
+
+        m_rxBuffer.remove(0, p);
+        QByteArray crc;
+        if (format == ZBIN32) {
+            crc = CRC::calculate(raw.left(5), static_cast<int>(CRC::Algorithm::CRC_32), false);
+        } else {
+            crc = CRC::calculate(raw.left(5), static_cast<int>(CRC::Algorithm::CRC_16_XMODEM), true);
+        }
+        if (raw.size() != 5 + crc.size() || raw.mid(5) != crc) {
+            qWarning() << "Bad ZMODEM header:" << raw.toHex();
+            continue;
+        }
+
+        type = static_cast<quint8>(raw.at(0));
+        position = static_cast<quint8>(raw.at(1)) | (static_cast<quint8>(raw.at(2)) << 8)
+                   | (static_cast<quint8>(raw.at(3)) << 16)
+                   | (static_cast<quint32>(static_cast<quint8>(raw.at(4))) << 24);
+        return true;
+    }
+}
+
+void FileTransfer::handleZHeader(int type, quint32 position)
+{
+    switch (type) {
+    case ZRINIT:
+        if (m_state == State::ZWaitRInit || m_state == State::ZWaitEofAck) {
+            m_retries = 0;
+            const quint32 flags = position >> 24;
+            m_zCrc32 = flags & CANFC32;
+            m_zEscapeCtl = flags & ESCCTL;
+            m_zRxBufferSize = position & 0xffff;
+            if (m_state == State::ZWaitEofAck) {
+                updateProgress(true);
+                if (!openNextFile()) {
+                    sendZHexHeader(ZFIN, 0);
+                    m_state = State::ZWaitFin;
+                    restartTimer(responseTimeout);
+                    return;
+                }
+            }
+            sendZFile();
+        }
+        break;
+    case ZRPOS:
+        if (m_state == State::ZWaitRPos || m_state == State::ZSending
+            || m_state == State::ZWaitEofAck) {
+            // A ZRPOS after the data has been started means the receiver has seen an error.
+            if (m_state != State::ZWaitRPos && ++m_zErrors > maxRetries) {
+                cancel();
+                return;
+            }
+            m_retries = 0;
+            if (m_state == State::ZWaitRPos) {
+                m_startPosition = position;
+            }
+            sendZData(position);
+        }
+        break;
+    case ZACK:
+        if (m_state == State::ZSending) {
+            m_retries = 0;
+            m_zAckedPosition = qMax<qint64>(m_zAckedPosition, position);
+            m_zWaitingAck = false;
+            streamZData();
+        }
+        break;
+    case ZSKIP:
+        if (m_state == State::ZWaitRPos) {
+            qInfo() << "The receiver skipped" << m_file.fileName();
+            if (openNextFile()) {
+                sendZFile();
+            } else {
+                sendZHexHeader(ZFIN, 0);
+                m_state = State::ZWaitFin;
+                restartTimer(responseTimeout);
+            }
+        }
+        break;
+    case ZCRC: {
+        // The receiver asks for the CRC of the first "position" bytes(0 means the whole file) to
+        // decide whether a partial file can be resumed.
+        qint64 const length = position ? qint64(position) : m_file.size();
+        m_file.seek(0);
+        QByteArray const data = m_file.read(length);
+        QByteArray const crc = CRC::calculate(data, static_cast<int>(CRC::Algorithm::CRC_32), false);
+        quint32 value = 0;
+        for (int i = crc.size() - 1; i >= 0; --i) {
+            value = (value << 8) | static_cast<quint8>(crc.at(i));
+        }
+        sendZHexHeader(ZCRC, value);
+        restartTimer(responseTimeout);
+        break;
+    }
+    case ZFIN:
+        if (m_state == State::ZWaitFin) {
+            output(QByteArray("OO"));
+            finish(true, tr("Done."));
+        }
+        break;
+    case ZNAK:
+        output(m_lastPacket);
+        restartTimer(responseTimeout);
+        break;
+    case ZABORT:
+    case ZFERR:
+    case ZCAN:
+        finish(false, tr("Aborted by the receiver."));
+        break;
+    default:
+        break;
+    }
+}
+
+void FileTransfer::sendZFile()
+{
+    // ZCRESUM makes the receiver answer with ZRPOS at the end of the partial file it already has.
+    const quint8 zf0 = m_resume ? ZCRESUM : ZCBIN;
+    m_lastPacket = makeZBinaryHeader(ZFILE, static_cast<quint32>(zf0) << 24);
+    m_lastPacket.append(makeZSubpacket(fileInformation(true), ZCRCW));
+    output(m_lastPacket);
+    m_state = State::ZWaitRPos;
+    restartTimer(responseTimeout);
+}
+
+void FileTransfer::sendZData(qint64 position)
+{
+    if (position > m_file.size() || !m_file.seek(position)) {
+        finish(false, tr("Invalid file position: %1").arg(position));
+        return;
+    }
+
+    m_position = position;
+    m_zAckedPosition = position;
+    m_zSinceQuery = 0;
+    m_zWaitingAck = false;
+    output(makeZBinaryHeader(ZDATA, static_cast<quint32>(position)));
+    m_state = State::ZSending;
+    streamZData();
+}
+
+void FileTransfer::streamZData()
+{
+    // Subpackets are streamed without waiting, a ZCRCQ asks for a ZACK every zQueryInterval bytes
+    // and no more than zWindowSize bytes are in flight. A receiver with a limited buffer gets a
+    // ZCRCW at the end of every buffer instead.
+    qint64 const window = m_zRxBufferSize > 0 ? m_zRxBufferSize : zWindowSize;
+    while (m_state == State::ZSending && !m_zWaitingAck) {
+        if (m_position - m_zAckedPosition >= window) {
+            restartTimer(responseTimeout);
+            return;
+        }
+
+        QByteArray const data = m_file.read(zSubpacketSize);
+        if (data.isEmpty() && m_position < m_file.size()) {
+            finish(false, m_file.errorString());
+            return;
+        }
+
+        qint64 const next = m_position + data.size();
+        m_zSinceQuery += data.size();
+        char frameEnd = ZCRCG;
+        if (next >= m_file.size()) {
+            frameEnd = ZCRCE;
+        } else if (m_zRxBufferSize > 0 && next - m_zAckedPosition >= m_zRxBufferSize) {
+            frameEnd = ZCRCW;
+            m_zWaitingAck = true;
+        } else if (m_zSinceQuery >= zQueryInterval) {
+            frameEnd = ZCRCQ;
+            m_zSinceQuery = 0;
+        }
+
+        output(makeZSubpacket(data, frameEnd));
+        m_position = next;
+        updateProgress(false);
+
+        if (frameEnd == ZCRCE) {
+            m_lastPacket = makeZBinaryHeader(ZEOF, static_cast<quint32>(m_position));
+            output(m_lastPacket);
+            m_state = State::ZWaitEofAck;
+            restartTimer(responseTimeout);
+            return;
+        }
+    }
+
+    restartTimer(responseTimeout);
+}
+
+void FileTransfer::sendZHexHeader(int type, quint32 position)
+{
+    QByteArray raw;
+    raw.append(static_cast<char>(type));
+    raw.append(static_cast<char>(position & 0xff));
+    raw.append(static_cast<char>((position >> 8) & 0xff));
+    raw.append(static_cast<char>((position >> 16) & 0xff));
+    raw.append(static_cast<char>((position >> 24) & 0xff));
+    raw.append(CRC::calculate(raw, static_cast<int>(CRC::Algorithm::CRC_16_XMODEM), true));
+
+    QByteArray header;
+    header.append(ZPAD);
+    header.append(ZPAD);
+    header.append(ZDLE);
+    header.append(ZHEX);
+    header.append(raw.toHex());
+    header.append('\r');
+    header.append(static_cast<char>(0x8a));
+    if (type != ZACK && type != ZFIN) {
+        header.append(XON);
+    }
+
+    m_lastPacket = header;
+    output(header);
+}
+
+QByteArray FileTransfer::makeZBinaryHeader(int type, quint32 position) const
+{
+    QByteArray raw;
+    raw.append(static_cast<char>(type));
+    raw.append(static_cast<char>(position & 0xff));
+    raw.append(static_cast<char>((position >> 8) & 0xff));
+    raw.append(static_cast<char>((position >> 16) & 0xff));
+    raw.append(static_cast<char>((position >> 24) & 0xff));
+    if (m_zCrc32) {
+        raw.append(CRC::calculate(raw, static_cast<int>(CRC::Algorithm::CRC_32), false));
+    } else {
+        raw.append(CRC::calculate(raw, static_cast<int>(CRC::Algorithm::CRC_16_XMODEM), true));
+    }
+
+    QByteArray header;
+    header.append(ZPAD);
+    header.append(ZDLE);
+    header.append(m_zCrc32 ? ZBIN32 : ZBIN);
+    header.append(zdleEscape(raw));
+    return header;
+}
+
+QByteArray FileTransfer::makeZSubpacket(const QByteArray &data, char frameEnd) const
+{
+    // The CRC covers the data and the frame end character.
+    QByteArray crcData = data;
+    crcData.append(frameEnd);
+    QByteArray crc;
+    if (m_zCrc32) {
+        crc = CRC::calculate(crcData, static_cast<int>(CRC::Algorithm::CRC_32), false);
+    } else {
+        crc = CRC::calculate(crcData, static_cast<int>(CRC::Algorithm::CRC_16_XMODEM), true);
+    }
+
+    QByteArray subpacket = zdleEscape(data);
+    subpacket.append(ZDLE);
+    subpacket.append(frameEnd);
+    subpacket.append(zdleEscape(crc));
+    if (frameEnd == ZCRCW) {
+        subpacket.append(XON);
+    }
+
+    return subpacket;
+}
+
+QByteArray FileTransfer::zdleEscape(const QByteArray &bytes) const
+{
+    QByteArray escaped;
+    escaped.reserve(bytes.size() + bytes.size() / 16 + 8);
+    for (char c : bytes) {
+        const quint8 byte = static_cast<quint8>(c);
+        bool escape = false;
+        switch (byte & 0x7f) {
+        case 0x18: // ZDLE
+        case 0x10: // DLE
+        case 0x11: // XON
+        case 0x13: // XOFF
+            escape = true;
+            break;
+        default:
+            escape = m_zEscapeCtl && (byte & 0x60) == 0;
+            break;
+        }
+
+        if (escape) {
+            escaped.append(ZDLE);
+            escaped.append(static_cast<char>(byte ^ 0x40));
+        } else {
+            escaped.append(c);
+        }
+    }
+
+    return escaped;
+}
+
+QByteArray FileTransfer::fileInformation(bool zmodem) const
+{
+    // "name\0size mtime mode" for YMODEM, ZMODEM appends "serial filesLeft bytesLeft".
+    QFileInfo info(m_file.fileName());
+    QByteArray information = info.fileName().toUtf8();
+    information.append('\0');
+
+    qint64 const mtime = info.lastModified().toMSecsSinceEpoch() / 1000;
+    QString attributes = QString("%1 %2 %3").arg(info.size()).arg(mtime, 0, 8).arg(0100644, 0, 8);
+    if (zmodem) {
+        qint64 bytesLeft = info.size();
+        for (const QString &fileName : m_fileNames) {
+            bytesLeft += QFileInfo(fileName).size();
+        }
+        attributes += QString(" 0 %1 %2").arg(m_fileNames.size() + 1).arg(bytesLeft);
+    }
+
+    information.append(attributes.toLatin1());
+    information.append('\0');
+    return information;
+}
@@ -0,0 +1,120 @@
+﻿/***************************************************************************************************
+ * Copyright 2023-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+
+// Sends files with XMODEM-CRC, XMODEM-1K, YMODEM(batch) or ZMODEM(streaming). The object is moved to
+// the device thread, outputBytes() must be connected to Device::writeBytes() directly and
+// Device::bytesRead() must be connected to inputBytes(), so the protocol runs in the device thread
+// without a round trip through the ui thread.
+class FileTransfer : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Protocol { XModemCrc, XModem1K, YModem, ZModem };
+    Q_ENUM(Protocol);
+
+public:
+    explicit FileTransfer(QObject *parent = nullptr);
+    ~FileTransfer() override;
+
+    static QList<int> supportedProtocols();
+    static QString protocolName(int protocol);
+
+    Q_INVOKABLE void start(int protocol, const QStringList &fileNames, bool resume);
+    Q_INVOKABLE void cancel();
+    void inputBytes(const QByteArray &bytes);
+
+signals:
+    void outputBytes(const QByteArray &bytes);
+    // transferred: payload bytes of all files, elapsed: ms since the transfer was started
+    void progressChanged(const QString &fileName, qint64 position, qint64 size, qint64 transferred,
+                         qint64 elapsed);
+    void finished(bool succeeded, const QString &message, qint64 transferred, qint64 elapsed);
+
+private:
+    enum class State {
+        Idle,
+        WaitStart,
+        WaitHeaderAck,
+        WaitDataStart,
+        WaitBlockAck,
+        WaitEotAck,
+        WaitEndStart,
+        WaitEndAck,
+        ZWaitRInit,
+        ZWaitRPos,
+        ZSending,
+        ZWaitEofAck,
+        ZWaitFin
+    };
+
+private:
+    Protocol m_protocol{Protocol::XModemCrc};
+    State m_state{State::Idle};
+    QStringList m_fileNames;
+    QFile m_file;
+    bool m_resume{false};
+    QTimer *m_timer;
+    QElapsedTimer m_elapsedTimer;
+    QElapsedTimer m_progressTimer;
+    QByteArray m_rxBuffer;
+    QByteArray m_lastPacket;
+    int m_retries{0};
+    int m_cancels{0};
+    qint64 m_position{0};      // The position of the current file
+    qint64 m_startPosition{0}; // The position the current file was started(resumed) from
+    qint64 m_doneBytes{0};     // Bytes sent of the finished files
+
+    // XMODEM/YMODEM
+    bool m_useCrc{true};
+    quint8 m_blockNumber{1};
+    int m_blockSize{0};
+    bool m_endOfBatch{false};
+
+    // ZMODEM
+    bool m_zCrc32{false};
+    bool m_zEscapeCtl{false};
+    qint64 m_zRxBufferSize{0};
+    qint64 m_zAckedPosition{0};
+    qint64 m_zSinceQuery{0};
+    bool m_zWaitingAck{false};
+    int m_zErrors{0};
+
+private:
+    void finish(bool succeeded, const QString &message);
+    void output(const QByteArray &bytes);
+    void restartTimer(int msec);
+    void onTimeout();
+    bool openNextFile();
+    void updateProgress(bool force);
+    qint64 transferred() const;
+
+    void handleXyModem(char c);
+    void sendXyBlock();
+    void sendXyHeader(bool endOfBatch);
+    QByteArray makeXyBlock(quint8 number, const QByteArray &data, int size) const;
+
+    void handleZModem();
+    bool takeZHeader(int &type, quint32 &position);
+    void handleZHeader(int type, quint32 position);
+    void sendZFile();
+    void sendZData(qint64 position);
+    void streamZData();
+    void sendZHexHeader(int type, quint32 position);
+    QByteArray makeZBinaryHeader(int type, quint32 position) const;
+    QByteArray makeZSubpacket(const QByteArray &data, char frameEnd) const;
+    QByteArray zdleEscape(const QByteArray &bytes) const;
+    QByteArray fileInformation(bool zmodem) const;
+};
@@ -0,0 +1,163 @@
+﻿/***************************************************************************************************
+ * Copyright 2023-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "gapanalyser.h"
+
+#include <QtAlgorithms>
+#include <QtMath>
+
+static const int maxOctave = 24; // 2^24us, about 16s
+static const quint64 minSamples = 32;
+
+GapAnalyser::GapAnalyser()
+{
+    m_counts.fill(0, bucketCount());
+}
+
+void GapAnalyser::reset(qint32 baudRate)
+{
+    m_mutex.lock();
+    // 1 start bit, 8 data bits, 1 parity bit and 1 stop bit, the same as the 3.5 char rule.
+    m_charTime = baudRate > 0 ? qint64(11 * 1000000000.0 / baudRate) : 0;
+    m_lastChunk = -1;
+    m_counts.fill(0, bucketCount());
+    m_samples = 0;
+    m_elapsedTimer.start();
+    m_mutex.unlock();
+}
+
+void GapAnalyser::addChunk(int bytes)
+{
+    if (bytes <= 0) {
+        return;
+    }
+
+    m_mutex.lock();
+    qint64 const now = m_elapsedTimer.nsecsElapsed();
+    if (m_lastChunk >= 0) {
+        qint64 const idle = qMax<qint64>(0, now - m_lastChunk - bytes * m_charTime) / 1000;
+        m_counts[bucketIndex(idle)]++;
+        m_samples++;
+    }
+    m_lastChunk = now;
+    m_mutex.unlock();
+}
+
+void GapAnalyser::clear()
+{
+    m_mutex.lock();
+    m_lastChunk = -1;
+    m_counts.fill(0, bucketCount());
+    m_samples = 0;
+    m_mutex.unlock();
+}
+
+GapAnalyser::Histogram GapAnalyser::histogram() const
+{
+    Histogram histogram;
+    m_mutex.lock();
+    histogram.counts = m_counts;
+    histogram.samples = m_samples;
+    histogram.proposedGap = calculateProposedGap();
+    m_mutex.unlock();
+    return histogram;
+}
+
+qint64 GapAnalyser::proposedGap() const
+{
+    m_mutex.lock();
+    qint64 const gap = calculateProposedGap();
+    m_mutex.unlock();
+    return gap;
+}
+
+int GapAnalyser::bucketCount()
+{
+    return bucketIndex(qint64(1) << maxOctave) + 1;
+}
+
+int GapAnalyser::bucketIndex(qint64 gap)
+{
+    if (gap < 4) {
+        return gap < 0 ? 0 : int(gap);
+    }
+
+    quint64 const value = qMin<quint64>(quint64(gap), quint64(1) << maxOctave);
+    int const msb = 63 - qCountLeadingZeroBits(value);
+    return 4 * (msb - 2) + 4 + int((value >> (msb - 2)) & 3);
+}
+
+qint64 GapAnalyser::bucketLowerBound(int index)
+{
+    if (index < 4) {
+        return index;
+    }
+
+    int const msb = (index - 4) / 4 + 2;
+    int const sub = (index - 4) % 4;
+    return qint64(4 + sub) << (msb - 2);
+}
+
+qint64 GapAnalyser::calculateProposedGap() const
+{
+    if (m_samples < minSamples) {
+        return 0;
+    }
+
+    // Otsu's method on the bucket indexes, the buckets are logarithmic so the intra-frame gaps
+    // (a few us to a few ms of USB latency) and the inter-frame gaps form two separate modes.
+    double sumAll = 0;
+    for (int i = 0; i < m_counts.size(); ++i) {
+        sumAll += double(i) * m_counts.at(i);
+    }
+
+    double const total = double(m_samples);
+    double sumLow = 0;
+    double weightLow = 0;
+    double bestVariance = 0;
+    int threshold = -1;
+    for (int i = 0; i < m_counts.size() - 1; ++i) {
+        weightLow += m_counts.at(i);
+        sumLow += double(i) * m_counts.at(i);
+        double const weightHigh = total - weightLow;
+        if (weightLow == 0 || weightHigh == 0) {
+            continue;
+        }
+
+        double const meanLow = sumLow / weightLow;
+        double const meanHigh = (sumAll - sumLow) / weightHigh;
+        double const variance = weightLow * weightHigh * (meanLow - meanHigh) * (meanLow - meanHigh);
+        if (variance > bestVariance) {
+            bestVariance = variance;
+            threshold = i;
+        }
+    }
+
+    if (threshold < 0) {
+        return 0;
+    }
+
+    // The gap is put in the middle(geometric) of the empty range between the two modes.
+    int low = threshold;
+    while (low > 0 && m_counts.at(low) == 0) {
+        low--;
+    }
+    int high = threshold + 1;
+    while (high < m_counts.size() - 1 && m_counts.at(high) == 0) {
+        high++;
+    }
+
+    // A single mode(a continuous stream, or frames sent back to back) can not be separated.
+    if (high - low < 2) {
+        return 0;
+    }
+
+    qint64 const lowerGap = bucketLowerBound(low + 1);
+    qint64 const upperGap = bucketLowerBound(high);
+    return qMax<qint64>(lowerGap, qint64(qSqrt(double(lowerGap) * double(upperGap))));
+}
@@ -0,0 +1,52 @@
+﻿/***************************************************************************************************
+ * Copyright 2023-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QVector>
+
+// Records the idle gaps between consecutive reads as a histogram. A read delivers a chunk of bytes
+// that arrived back to back, so a gap is the time between two reads minus the time the bytes of
+// the later chunk took on the wire. The buckets are in microseconds, 1us wide below 4us and four
+// buckets per octave above, so the same histogram covers 1us to 16s.
+class GapAnalyser
+{
+public:
+    struct Histogram
+    {
+        QVector<quint64> counts;
+        quint64 samples{0};
+        qint64 proposedGap{0}; // us, 0 means that it can not be determined yet
+    };
+
+public:
+    GapAnalyser();
+
+    void reset(qint32 baudRate);
+    void addChunk(int bytes);
+    void clear();
+    Histogram histogram() const;
+    qint64 proposedGap() const;
+
+    static int bucketCount();
+    static int bucketIndex(qint64 gap);
+    static qint64 bucketLowerBound(int index);
+
+private:
+    QElapsedTimer m_elapsedTimer;
+    qint64 m_lastChunk{-1}; // ns
+    qint64 m_charTime{0};   // ns
+    QVector<quint64> m_counts;
+    quint64 m_samples{0};
+    mutable QMutex m_mutex;
+
+private:
+    qint64 calculateProposedGap() const;
+};
@@ -0,0 +1,133 @@
+﻿/***************************************************************************************************
+ * Copyright 2023-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "latencytest.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <QRandomGenerator>
+
+LatencyTest::LatencyTest(QObject *parent)
+    : QObject(parent)
+{
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &LatencyTest::onTimeout);
+}
+
+void LatencyTest::start(int count, int payloadSize, int timeout)
+{
+    // A new run id every time, a late echo of the previous run is never taken for a probe.
+    m_runId = static_cast<quint16>(QRandomGenerator::global()->generate());
+    m_count = qMax(1, count);
+    m_payloadSize = payloadSize;
+    m_timer->setInterval(qMax(1, timeout));
+    m_sequence = 0;
+    m_lost = 0;
+    m_samples.clear();
+    m_samples.reserve(m_count);
+    m_rxBuffer.clear();
+    m_running = true;
+    m_elapsedTimer.start();
+    sendProbe();
+}
+
+void LatencyTest::cancel()
+{
+    if (m_running) {
+        finish(false, tr("Cancelled."));
+    }
+}
+
+void LatencyTest::inputBytes(const QByteArray &bytes)
+{
+    if (!m_running) {
+        return;
+    }
+
+    // The echo may be split or merged with other bytes by a stream socket.
+    m_rxBuffer.append(bytes);
+    int index = m_rxBuffer.indexOf(m_probe);
+    if (index < 0) {
+        int keep = m_probe.size() - 1;
+        if (m_rxBuffer.size() > keep) {
+            m_rxBuffer.remove(0, m_rxBuffer.size() - keep);
+        }
+        return;
+    }
+
+    m_samples.append(m_elapsedTimer.nsecsElapsed() - m_sentAt);
+    m_rxBuffer.remove(0, index + m_probe.size());
+    next();
+}
+
+qint64 LatencyTest::percentile(const QList<qint64> &sorted, double p)
+{
+    if (sorted.isEmpty()) {
+        return 0;
+    }
+
+    int rank = static_cast<int>(std::ceil(p * sorted.size()));
+    return sorted.at(qBound(1, rank, sorted.size()) - 1);
+}
+
+void LatencyTest::sendProbe()
+{
+    // "#<run id>-<sequence>#" padded to the payload size, printable so that text channels work.
+    m_probe = QString("#%1-%2#")
+                  .arg(m_runId, 4, 16, QChar('0'))
+                  .arg(m_sequence, 8, 10, QChar('0'))
+                  .toLatin1();
+    if (m_probe.size() < m_payloadSize) {
+        m_probe.append(QByteArray(m_payloadSize - m_probe.size(), 'x'));
+    }
+
+    m_timer->start();
+    m_sentAt = m_elapsedTimer.nsecsElapsed();
+    emit outputBytes(m_probe);
+}
+
+void LatencyTest::next()
+{
+    m_sequence++;
+    emit progressChanged(m_sequence, m_count);
+    if (m_sequence >= m_count) {
+        finish(true, tr("Finished."));
+    } else {
+        sendProbe();
+    }
+}
+
+void LatencyTest::onTimeout()
+{
+    if (m_running) {
+        m_lost++;
+        m_rxBuffer.clear();
+        next();
+    }
+}
+
+void LatencyTest::finish(bool succeeded, const QString &message)
+{
+    m_timer->stop();
+    m_running = false;
+
+    QList<qint64> sorted = m_samples;
+    std::sort(sorted.begin(), sorted.end());
+    qint64 min = sorted.isEmpty() ? 0 : sorted.first();
+    qint64 max = sorted.isEmpty() ? 0 : sorted.last();
+    emit finished(succeeded,
+                  message,
+                  sorted.size(),
+                  m_lost,
+                  percentile(sorted, 0.5),
+                  percentile(sorted, 0.99),
+                  min,
+                  max);
+}
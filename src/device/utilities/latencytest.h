@@ -0,0 +1,60 @@
+﻿/***************************************************************************************************
+ * Copyright 2023-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+
+// Measures round trip times with ping-pong probes, the peer must echo the bytes back(e.g. the echo
+// option of the responder). A probe is written when the previous one has come back or has timed
+// out. The object is moved to the device thread, outputBytes() must be connected to
+// Device::writeBytes() directly and Device::bytesRead() must be connected to inputBytes(), so the
+// ui thread is not part of the measured path.
+class LatencyTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LatencyTest(QObject *parent = nullptr);
+
+    Q_INVOKABLE void start(int count, int payloadSize, int timeout);
+    Q_INVOKABLE void cancel();
+    void inputBytes(const QByteArray &bytes);
+
+    // Nearest-rank percentile of sorted samples, p is in (0, 1].
+    static qint64 percentile(const QList<qint64> &sorted, double p);
+
+signals:
+    void outputBytes(const QByteArray &bytes);
+    void progressChanged(int done, int total);
+    // Round trip times are in nanoseconds.
+    void finished(bool succeeded, const QString &message, int received, int lost, qint64 p50,
+                  qint64 p99, qint64 min, qint64 max);
+
+private:
+    QTimer *m_timer;
+    QElapsedTimer m_elapsedTimer;
+    QByteArray m_probe;
+    QByteArray m_rxBuffer;
+    QList<qint64> m_samples;
+    quint16 m_runId{0};
+    int m_count{0};
+    int m_payloadSize{0};
+    int m_sequence{0};
+    int m_lost{0};
+    qint64 m_sentAt{0};
+    bool m_running{false};
+
+private:
+    void sendProbe();
+    void next();
+    void onTimeout();
+    void finish(bool succeeded, const QString &message);
+};
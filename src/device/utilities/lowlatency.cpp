@@ -0,0 +1,82 @@
+﻿/***************************************************************************************************
+ * Copyright 2023-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "lowlatency.h"
+
+#include <QDebug>
+
+#if defined(Q_OS_LINUX)
+#include <atomic>
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/socket.h>
+#endif
+
+void LowLatency::setup(QAbstractSocket *socket)
+{
+    if (!socket) {
+        return;
+    }
+
+    // Everything the socket has received is handed over at once, it is not held back in chunks.
+    socket->setReadBufferSize(0);
+    bool tcp = socket->socketType() == QAbstractSocket::TcpSocket;
+#if defined(Q_OS_LINUX)
+    int fd = static_cast<int>(socket->socketDescriptor());
+    if (fd < 0) {
+        return;
+    }
+
+    setup(fd, tcp);
+    if (tcp) {
+        QObject::connect(socket, &QAbstractSocket::readyRead, socket, [fd]() {
+            rearmQuickAck(fd);
+        });
+    }
+#else
+    socket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, receiveBufferSize);
+    socket->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, sendBufferSize);
+    if (tcp) {
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    }
+#endif
+}
+
+#if defined(Q_OS_LINUX)
+void LowLatency::setup(int fd, bool tcp)
+{
+    int value = receiveBufferSize;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &value, sizeof(value));
+    value = sendBufferSize;
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &value, sizeof(value));
+
+    // Raising the value above net.core.busy_read needs CAP_NET_ADMIN, it is optional. It fails the
+    // same way for every socket, so it is reported once per process(sockets of worker threads too).
+    value = busyPollTime;
+    static std::atomic_bool busyPollReported{false};
+    if (::setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &value, sizeof(value)) < 0
+        && !busyPollReported.exchange(true)) {
+        qInfo() << "SO_BUSY_POLL is not available:" << strerror(errno);
+    }
+
+    if (tcp) {
+        value = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value));
+        rearmQuickAck(fd);
+    }
+}
+
+void LowLatency::rearmQuickAck(int fd)
+{
+    int value = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_QUICKACK, &value, sizeof(value));
+}
+#endif
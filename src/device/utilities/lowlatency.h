@@ -0,0 +1,31 @@
+﻿/***************************************************************************************************
+ * Copyright 2023-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QAbstractSocket>
+
+// The "low latency" profile of the socket devices: Nagle's algorithm and delayed ACKs are turned
+// off, a read busy-polls the device queue for a short time before it sleeps(SO_BUSY_POLL) and the
+// kernel buffers are sized so that a small message never waits behind a large backlog. The
+// options must be applied once the socket has a descriptor, i.e. after connecting or binding.
+class LowLatency
+{
+public:
+    static void setup(QAbstractSocket *socket);
+#if defined(Q_OS_LINUX)
+    static void setup(int fd, bool tcp);
+    // TCP_QUICKACK is not sticky, the kernel falls back to delayed ACKs, re-arm it after a read.
+    static void rearmQuickAck(int fd);
+#endif
+
+private:
+    static const int receiveBufferSize = 256 * 1024;
+    static const int sendBufferSize = 64 * 1024;
+    static const int busyPollTime = 50; // us
+};
@@ -0,0 +1,216 @@
+﻿/***************************************************************************************************
+ * Copyright 2023-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "outboundqueue.h"
+
+void OutboundQueue::setLimit(qint64 limit, OutboundQueuePolicy policy)
+{
+    m_limit = limit;
+    m_policy = policy;
+}
+
+bool OutboundQueue::enqueue(const QByteArray &bytes)
+{
+    if (m_limit > 0 && m_size + bytes.size() > m_limit) {
+        // A consumer is only slow if something is still pending, an oversize message is kept on
+        // its own like with the other policies.
+        if (m_policy == OutboundQueuePolicy::DisconnectSlowConsumer && m_size > 0) {
+            return false;
+        }
+
+        while (!m_messages.isEmpty() && m_size + bytes.size() > m_limit) {
+            m_size -= m_messages.dequeue().size();
+        }
+    }
+
+    m_messages.enqueue(bytes);
+    m_size += bytes.size();
+    return true;
+}
+
+QByteArray OutboundQueue::dequeue()
+{
+    if (m_messages.isEmpty()) {
+        return QByteArray();
+    }
+
+    QByteArray bytes = m_messages.dequeue();
+    m_size -= bytes.size();
+    return bytes;
+}
+
+QList<QByteArray> OutboundQueue::dequeue(int maxMessages)
+{
+    QList<QByteArray> messages;
+    while (!m_messages.isEmpty() && messages.size() < maxMessages) {
+        messages.append(m_messages.dequeue());
+        m_size -= messages.last().size();
+    }
+
+    return messages;
+}
+
+void OutboundQueue::clear()
+{
+    m_messages.clear();
+    m_size = 0;
+}
+
+bool OutboundQueue::isEmpty() const
+{
+    return m_messages.isEmpty();
+}
+
+qint64 OutboundQueue::size() const
+{
+    return m_size;
+}
+
+/**************************************************************************************************/
+void OutboundScheduler::setLimit(qint64 limit, OutboundQueuePolicy policy)
+{
+    m_limit = limit;
+    m_policy = policy;
+    for (auto it = m_queues.begin(); it != m_queues.end(); ++it) {
+        it->setLimit(limit, policy);
+    }
+}
+
+void OutboundScheduler::addClient(const QString &flag)
+{
+    OutboundQueue queue;
+    queue.setLimit(m_limit, m_policy);
+    m_queues.insert(flag, queue);
+}
+
+void OutboundScheduler::removeClient(const QString &flag)
+{
+    if (m_queues.remove(flag) > 0) {
+        m_ready.removeAll(flag);
+        m_scheduled.remove(flag);
+    }
+}
+
+void OutboundScheduler::clear()
+{
+    m_queues.clear();
+    m_ready.clear();
+    m_scheduled.clear();
+}
+
+bool OutboundScheduler::enqueue(const QString &flag, const QByteArray &bytes)
+{
+    auto it = m_queues.find(flag);
+    if (it == m_queues.end()) {
+        return false;
+    }
+
+    if (!it->enqueue(bytes)) {
+        return false;
+    }
+
+    if (!m_scheduled.contains(flag)) {
+        m_scheduled.insert(flag);
+        m_ready.append(flag);
+    }
+    return true;
+}
+
+void OutboundScheduler::drain(const std::function<bool(const QString &)> &isWritable,
+                              const std::function<void(const QString &, const QByteArray &)> &write)
+{
+    drain(1, isWritable, [&write](const QString &flag, const QList<QByteArray> &messages) {
+        write(flag, messages.first());
+    });
+}
+
+void OutboundScheduler::drain(
+    int maxMessages,
+    const std::function<bool(const QString &)> &isWritable,
+    const std::function<void(const QString &, const QList<QByteArray> &)> &write)
+{
+    // A round hands the messages of one batch to every writable client, it stops when a whole round
+    // made no progress: the remaining clients are drained again when their sockets have been
+    // flushed.
+    bool progress = true;
+    while (progress && !m_ready.isEmpty()) {
+        progress = false;
+        const int count = m_ready.size();
+        for (int i = 0; i < count && !m_ready.isEmpty(); ++i) {
+            const QString flag = m_ready.takeFirst();
+            auto it = m_queues.find(flag);
+            if (it == m_queues.end()) {
+                continue;
+            }
+
+            if (it->isEmpty()) {
+                m_scheduled.remove(flag);
+                continue;
+            }
+
+            if (!isWritable(flag)) {
+                m_ready.append(flag);
+                continue;
+            }
+
+            // write() may remove the client, the queue must not be touched after it.
+            const QList<QByteArray> messages = it->dequeue(maxMessages);
+            if (it->isEmpty()) {
+                m_scheduled.remove(flag);
+            } else {
+                m_ready.append(flag);
+            }
+
+            write(flag, messages);
+            progress = true;
+        }
+    }
+}
+
+void OutboundScheduler::drainClient(
+    const QString &flag,
+    const std::function<bool(const QString &)> &isWritable,
+    const std::function<void(const QString &, const QByteArray &)> &write)
+{
+    drainClient(flag,
+                1,
+                isWritable,
+                [&write](const QString &client, const QList<QByteArray> &messages) {
+                    write(client, messages.first());
+                });
+}
+
+void OutboundScheduler::drainClient(
+    const QString &flag,
+    int maxMessages,
+    const std::function<bool(const QString &)> &isWritable,
+    const std::function<void(const QString &, const QList<QByteArray> &)> &write)
+{
+    // write() may remove the client, the queue is looked up again for every batch.
+    while (isWritable(flag)) {
+        auto it = m_queues.find(flag);
+        if (it == m_queues.end() || it->isEmpty()) {
+            return;
+        }
+
+        write(flag, it->dequeue(maxMessages));
+    }
+}
+
+QHash<QString, qint64> OutboundScheduler::depths() const
+{
+    QHash<QString, qint64> depths;
+    for (const QString &flag : m_ready) {
+        const qint64 size = m_queues.value(flag).size();
+        if (size > 0) {
+            depths.insert(flag, size);
+        }
+    }
+
+    return depths;
+}
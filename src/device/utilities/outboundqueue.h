@@ -0,0 +1,87 @@
+﻿/***************************************************************************************************
+ * Copyright 2023-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <functional>
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QQueue>
+#include <QSet>
+#include <QString>
+
+#include "common/xtools.h"
+
+// The bounded outbound queue of one client. Messages are never split, a message larger than the
+// limit is kept on its own rather than being cut.
+class OutboundQueue
+{
+public:
+    void setLimit(qint64 limit, OutboundQueuePolicy policy);
+    // Returns false if the limit is exceeded while the queue is not empty, the slow consumer has to
+    // be disconnected.
+    bool enqueue(const QByteArray &bytes);
+    QByteArray dequeue();
+    QList<QByteArray> dequeue(int maxMessages);
+    void clear();
+
+    bool isEmpty() const;
+    qint64 size() const;
+
+private:
+    QQueue<QByteArray> m_messages;
+    qint64 m_size{0};
+    qint64 m_limit{0}; // 0 means unlimited
+    OutboundQueuePolicy m_policy{OutboundQueuePolicy::DropOldest};
+};
+
+// The outbound queues of all clients of a server. The queues are drained round-robin, one message
+// per client and round, so a client that can not keep up does not hold the others back. It is used
+// in the device thread only.
+class OutboundScheduler
+{
+public:
+    void setLimit(qint64 limit, OutboundQueuePolicy policy);
+    void addClient(const QString &flag);
+    void removeClient(const QString &flag);
+    void clear();
+
+    // Returns false if the client has to be disconnected, see OutboundQueue::enqueue().
+    bool enqueue(const QString &flag, const QByteArray &bytes);
+    // Hands messages to write() as long as isWritable() accepts more for the client.
+    void drain(const std::function<bool(const QString &)> &isWritable,
+               const std::function<void(const QString &, const QByteArray &)> &write);
+    // The same, but up to maxMessages queued messages of a client are handed over at once, so that
+    // they can be written with one system call.
+    void drain(int maxMessages,
+               const std::function<bool(const QString &)> &isWritable,
+               const std::function<void(const QString &, const QList<QByteArray> &)> &write);
+    // Drains the queue of one client only, for a socket that has just written bytes. The cost does
+    // not grow with the number of clients.
+    void drainClient(const QString &flag,
+                     const std::function<bool(const QString &)> &isWritable,
+                     const std::function<void(const QString &, const QByteArray &)> &write);
+    // The same, with up to maxMessages messages handed over at once.
+    void drainClient(const QString &flag,
+                     int maxMessages,
+                     const std::function<bool(const QString &)> &isWritable,
+                     const std::function<void(const QString &, const QList<QByteArray> &)> &write);
+    // Queued bytes of the clients which have queued messages.
+    QHash<QString, qint64> depths() const;
+
+private:
+    QHash<QString, OutboundQueue> m_queues; // flag -> queue
+    // The clients with queued messages, in turn. drainClient() leaves a client here when its queue
+    // becomes empty, it is dropped by the next round.
+    QList<QString> m_ready;
+    QSet<QString> m_scheduled; // The clients in m_ready
+    qint64 m_limit{0};
+    OutboundQueuePolicy m_policy{OutboundQueuePolicy::DropOldest};
+};
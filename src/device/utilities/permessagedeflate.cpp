@@ -0,0 +1,335 @@
+﻿/***************************************************************************************************
+ * Copyright 2023-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "permessagedeflate.h"
+
+#include <QElapsedTimer>
+#include <QLocale>
+#include <QObject>
+
+static const char syncTail[] = {'\x00', '\x00', '\xff', '\xff'};
+
+void DeflateStatistics::reset()
+{
+    rawSent = 0;
+    compressedSent = 0;
+    deflateTime = 0;
+    compressedReceived = 0;
+    rawReceived = 0;
+    inflateTime = 0;
+}
+
+QList<QPair<QString, QString>> DeflateStatistics::metrics() const
+{
+    // The ratio is compressed / raw, the time is spent in zlib by the device thread.
+    auto text = [](qint64 raw, qint64 compressed, qint64 time) {
+        qint64 const ratio = raw > 0 ? compressed * 100 / raw : 100;
+        qint64 const rate = time > 0 ? qint64(double(raw) * 1000000000.0 / time) : 0;
+        return QObject::tr("%1 to %2(%3%), %4 ms, %5/s")
+            .arg(QLocale().formattedDataSize(raw),
+                 QLocale().formattedDataSize(compressed),
+                 QString::number(ratio),
+                 QString::number(time / 1000000.0, 'f', 1),
+                 QLocale().formattedDataSize(rate));
+    };
+
+    QList<QPair<QString, QString>> list;
+    list.append(qMakePair(QObject::tr("Deflate"), text(rawSent, compressedSent, deflateTime)));
+    list.append(
+        qMakePair(QObject::tr("Inflate"), text(rawReceived, compressedReceived, inflateTime)));
+    return list;
+}
+
+PerMessageDeflate::PerMessageDeflate(bool server,
+                                     const Parameters &parameters,
+                                     DeflateStatistics *statistics)
+    : m_server(server)
+    , m_parameters(parameters)
+    , m_statistics(statistics)
+{
+    m_deflate = z_stream();
+    m_inflate = z_stream();
+    m_deflateValid = deflateInit2(&m_deflate,
+                                  Z_DEFAULT_COMPRESSION,
+                                  Z_DEFLATED,
+                                  -sendWindowBits(),
+                                  8,
+                                  Z_DEFAULT_STRATEGY)
+                     == Z_OK;
+    // The window of the receiver is always the largest one, whatever the peer uses fits into it.
+    m_inflateValid = inflateInit2(&m_inflate, -15) == Z_OK;
+}
+
+PerMessageDeflate::~PerMessageDeflate()
+{
+    if (m_deflateValid) {
+        deflateEnd(&m_deflate);
+    }
+    if (m_inflateValid) {
+        inflateEnd(&m_inflate);
+    }
+}
+
+QByteArray PerMessageDeflate::makeOffer(bool contextTakeover)
+{
+    QByteArray offer("permessage-deflate; client_max_window_bits");
+    if (!contextTakeover) {
+        offer += "; client_no_context_takeover; server_no_context_takeover";
+    }
+
+    return offer;
+}
+
+static bool parseWindowBits(const QByteArray &value, int &bits)
+{
+    bool ok = false;
+    bits = value.toInt(&ok);
+    return ok && bits >= 9 && bits <= 15 && value == QByteArray::number(bits);
+}
+
+// Splits "name; a; b=1" into the name and the parameters, false if a parameter is repeated.
+static bool parseExtension(const QByteArray &text,
+                           QByteArray &name,
+                           QList<QPair<QByteArray, QByteArray>> &parameters)
+{
+    const QList<QByteArray> parts = text.split(';');
+    name = parts.first().trimmed();
+    for (int i = 1; i < parts.size(); ++i) {
+        const QByteArray part = parts.at(i).trimmed();
+        const int equal = part.indexOf('=');
+        QByteArray key = (equal < 0 ? part : part.left(equal)).trimmed();
+        QByteArray value = equal < 0 ? QByteArray() : part.mid(equal + 1).trimmed();
+        if (value.startsWith('"') && value.endsWith('"') && value.size() >= 2) {
+            value = value.mid(1, value.size() - 2);
+        }
+
+        for (const auto &parameter : parameters) {
+            if (parameter.first == key) {
+                return false;
+            }
+        }
+        parameters.append(qMakePair(key, value));
+    }
+
+    return true;
+}
+
+bool PerMessageDeflate::negotiate(const QByteArray &offers,
+                                  bool contextTakeover,
+                                  Parameters &parameters,
+                                  QByteArray &response)
+{
+    // The offers are in the order of preference of the client, the first acceptable one wins.
+    const QList<QByteArray> extensions = offers.split(',');
+    for (const QByteArray &extension : extensions) {
+        QByteArray name;
+        QList<QPair<QByteArray, QByteArray>> offered;
+        if (!parseExtension(extension, name, offered) || name != "permessage-deflate") {
+            continue;
+        }
+
+        Parameters agreed;
+        agreed.serverNoContextTakeover = !contextTakeover;
+        agreed.clientNoContextTakeover = !contextTakeover;
+        bool clientWindowBits = false;
+        bool acceptable = true;
+        for (const auto &parameter : offered) {
+            if (parameter.first == "server_no_context_takeover" && parameter.second.isEmpty()) {
+                agreed.serverNoContextTakeover = true;
+            } else if (parameter.first == "client_no_context_takeover"
+                       && parameter.second.isEmpty()) {
+                agreed.clientNoContextTakeover = true;
+            } else if (parameter.first == "server_max_window_bits") {
+                acceptable = parseWindowBits(parameter.second, agreed.serverMaxWindowBits);
+            } else if (parameter.first == "client_max_window_bits") {
+                clientWindowBits = true;
+                if (!parameter.second.isEmpty()) {
+                    acceptable = parseWindowBits(parameter.second, agreed.clientMaxWindowBits);
+                }
+            } else {
+                acceptable = false;
+            }
+
+            if (!acceptable) {
+                break;
+            }
+        }
+
+        if (!acceptable) {
+            continue;
+        }
+
+        response = "permessage-deflate";
+        if (agreed.serverNoContextTakeover) {
+            response += "; server_no_context_takeover";
+        }
+        if (agreed.clientNoContextTakeover) {
+            response += "; client_no_context_takeover";
+        }
+        if (agreed.serverMaxWindowBits < 15) {
+            response += "; server_max_window_bits="
+                        + QByteArray::number(agreed.serverMaxWindowBits);
+        }
+        if (clientWindowBits && agreed.clientMaxWindowBits < 15) {
+            response += "; client_max_window_bits="
+                        + QByteArray::number(agreed.clientMaxWindowBits);
+        }
+
+        parameters = agreed;
+        return true;
+    }
+
+    return false;
+}
+
+bool PerMessageDeflate::parseResponse(const QByteArray &response, Parameters &parameters)
+{
+    QByteArray name;
+    QList<QPair<QByteArray, QByteArray>> answered;
+    if (response.contains(',') || !parseExtension(response, name, answered)
+        || name != "permessage-deflate") {
+        return false;
+    }
+
+    Parameters agreed;
+    for (const auto &parameter : answered) {
+        if (parameter.first == "server_no_context_takeover" && parameter.second.isEmpty()) {
+            agreed.serverNoContextTakeover = true;
+        } else if (parameter.first == "client_no_context_takeover" && parameter.second.isEmpty()) {
+            agreed.clientNoContextTakeover = true;
+        } else if (parameter.first == "server_max_window_bits") {
+            if (!parseWindowBits(parameter.second, agreed.serverMaxWindowBits)) {
+                return false;
+            }
+        } else if (parameter.first == "client_max_window_bits") {
+            if (!parseWindowBits(parameter.second, agreed.clientMaxWindowBits)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+
+    parameters = agreed;
+    return true;
+}
+
+bool PerMessageDeflate::compress(const QByteArray &data, bool last, QByteArray &payload)
+{
+    if (!m_deflateValid) {
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    if (!m_compressing && !sendsWithContextTakeover()) {
+        deflateReset(&m_deflate);
+    }
+    m_compressing = !last;
+
+    m_deflate.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.constData()));
+    m_deflate.avail_in = static_cast<uInt>(data.size());
+    const int chunk = qMax(256, data.size() / 2 + 64);
+    int size = 0;
+    do {
+        payload.resize(size + chunk);
+        m_deflate.next_out = reinterpret_cast<Bytef *>(payload.data() + size);
+        m_deflate.avail_out = static_cast<uInt>(chunk);
+        if (deflate(&m_deflate, Z_SYNC_FLUSH) == Z_STREAM_ERROR) {
+            m_compressing = false;
+            return false;
+        }
+        size = payload.size() - static_cast<int>(m_deflate.avail_out);
+    } while (m_deflate.avail_out == 0);
+
+    // The parts before the last one keep their empty stored block, it is valid deflate data.
+    payload.resize(size);
+    if (last && payload.endsWith(QByteArray::fromRawData(syncTail, 4))) {
+        payload.chop(4);
+    }
+
+    m_statistics->rawSent += data.size();
+    m_statistics->compressedSent += payload.size();
+    m_statistics->deflateTime += timer.nsecsElapsed();
+    return true;
+}
+
+bool PerMessageDeflate::decompress(const QByteArray &payload,
+                                   bool last,
+                                   const std::function<bool(const QByteArray &)> &output)
+{
+    if (!m_inflateValid) {
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QByteArray input = payload;
+    if (last) {
+        input.append(syncTail, 4);
+    }
+
+    // The output is handed over in chunks, a small payload may inflate to a huge message.
+    bool ok = true;
+    qint64 rawSize = 0;
+    if (!m_inflateEnded) {
+        m_inflate.next_in = reinterpret_cast<Bytef *>(input.data());
+        m_inflate.avail_in = static_cast<uInt>(input.size());
+        QByteArray chunk(64 * 1024, 0);
+        int ret = Z_OK;
+        do {
+            m_inflate.next_out = reinterpret_cast<Bytef *>(chunk.data());
+            m_inflate.avail_out = static_cast<uInt>(chunk.size());
+            ret = inflate(&m_inflate, Z_SYNC_FLUSH);
+            if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+                ok = false;
+                break;
+            }
+
+            const int size = chunk.size() - static_cast<int>(m_inflate.avail_out);
+            rawSize += size;
+            if (size > 0 && !output(QByteArray(chunk.constData(), size))) {
+                ok = false;
+                break;
+            }
+        } while (ret == Z_OK && (m_inflate.avail_out == 0 || m_inflate.avail_in > 0));
+
+        // A final block ends the stream, the rest of the message is ignored and the next message
+        // starts a new stream.
+        m_inflateEnded = ret == Z_STREAM_END;
+    }
+
+    if (last || !ok) {
+        if (m_inflateEnded || !receivesWithContextTakeover() || !ok) {
+            inflateReset(&m_inflate);
+        }
+        m_inflateEnded = false;
+    }
+
+    m_statistics->compressedReceived += payload.size();
+    m_statistics->rawReceived += rawSize;
+    m_statistics->inflateTime += timer.nsecsElapsed();
+    return ok;
+}
+
+bool PerMessageDeflate::sendsWithContextTakeover() const
+{
+    return m_server ? !m_parameters.serverNoContextTakeover
+                    : !m_parameters.clientNoContextTakeover;
+}
+
+int PerMessageDeflate::sendWindowBits() const
+{
+    return m_server ? m_parameters.serverMaxWindowBits : m_parameters.clientMaxWindowBits;
+}
+
+bool PerMessageDeflate::receivesWithContextTakeover() const
+{
+    return m_server ? !m_parameters.clientNoContextTakeover
+                    : !m_parameters.serverNoContextTakeover;
+}
@@ -0,0 +1,89 @@
+﻿/***************************************************************************************************
+ * Copyright 2023-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <functional>
+
+#include <QByteArray>
+#include <QList>
+#include <QPair>
+#include <QString>
+
+#include <zlib.h>
+
+// The compression counters of a device, shared by its connections and read by the ui thread.
+struct DeflateStatistics
+{
+    std::atomic<qint64> rawSent{0};
+    std::atomic<qint64> compressedSent{0};
+    std::atomic<qint64> deflateTime{0}; // ns
+    std::atomic<qint64> compressedReceived{0};
+    std::atomic<qint64> rawReceived{0};
+    std::atomic<qint64> inflateTime{0}; // ns
+
+    void reset();
+    QList<QPair<QString, QString>> metrics() const;
+};
+
+// The permessage-deflate extension(RFC 7692) of one web socket. A message is compressed with a
+// sync flush and the trailing 00 00 ff ff is removed, the receiver appends it again. With context
+// takeover the sliding window is kept from message to message, which is what makes small similar
+// messages(JSON telemetry) compress well, without it every message is compressed on its own.
+// Window sizes below 9 bits are declined, zlib can not produce raw deflate streams for them.
+class PerMessageDeflate
+{
+public:
+    struct Parameters
+    {
+        bool serverNoContextTakeover{false};
+        bool clientNoContextTakeover{false};
+        int serverMaxWindowBits{15};
+        int clientMaxWindowBits{15};
+    };
+
+public:
+    PerMessageDeflate(bool server, const Parameters &parameters, DeflateStatistics *statistics);
+    ~PerMessageDeflate();
+
+    // The value of the Sec-WebSocket-Extensions header of a client.
+    static QByteArray makeOffer(bool contextTakeover);
+    // Server: accepts the first acceptable offer, response is the value of the header to answer.
+    static bool negotiate(const QByteArray &offers,
+                          bool contextTakeover,
+                          Parameters &parameters,
+                          QByteArray &response);
+    // Client: false if the server answered with something that was not offered.
+    static bool parseResponse(const QByteArray &response, Parameters &parameters);
+
+    // A message may be compressed in parts, last marks its end. The payloads of the parts are
+    // sent in the frames of the message in the same order.
+    bool compress(const QByteArray &data, bool last, QByteArray &payload);
+    // The payloads of the frames of a message in order, the inflated bytes are handed to output in
+    // chunks of bounded size as they are produced. Fails if output returns false.
+    bool decompress(const QByteArray &payload,
+                    bool last,
+                    const std::function<bool(const QByteArray &)> &output);
+    bool sendsWithContextTakeover() const;
+    int sendWindowBits() const;
+
+private:
+    bool m_server;
+    Parameters m_parameters;
+    DeflateStatistics *m_statistics;
+    z_stream m_deflate;
+    z_stream m_inflate;
+    bool m_deflateValid{false};
+    bool m_inflateValid{false};
+    bool m_compressing{false};  // A message is being compressed
+    bool m_inflateEnded{false}; // The message being inflated had a final block
+
+private:
+    bool receivesWithContextTakeover() const;
+};
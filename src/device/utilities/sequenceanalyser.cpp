@@ -0,0 +1,217 @@
+﻿/***************************************************************************************************
+ * Copyright 2023-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "sequenceanalyser.h"
+
+#include <QtMath>
+
+static const int maxStreams = 1024;    // Senders beyond it are not followed
+static const quint64 maxWindow = 4096; // Sequence numbers, a power of two
+
+SequenceAnalyser::SequenceAnalyser() {}
+
+void SequenceAnalyser::reset(int sequenceOffset, int sequenceWidth, int timestampOffset)
+{
+    m_mutex.lock();
+    m_sequenceOffset = sequenceOffset;
+    m_sequenceWidth = qBound(1, sequenceWidth, 8);
+    m_timestampOffset = timestampOffset;
+    m_mask = m_sequenceWidth == 8 ? ~quint64(0) : (quint64(1) << (8 * m_sequenceWidth)) - 1;
+
+    // A datagram less than a window behind the highest one is late, a jump of up to half the
+    // sequence space(at most 64K) ahead is a loss. Anything else is a restart of the sender.
+    m_windowSize = qMin(maxWindow, (m_mask >> 1) + 1);
+    m_maxDropout = qMin<quint64>(65536, m_mask - m_windowSize);
+    m_streams.clear();
+    m_elapsedTimer.start();
+    m_mutex.unlock();
+}
+
+bool SequenceAnalyser::isEnabled() const
+{
+    m_mutex.lock();
+    bool const enabled = m_sequenceOffset >= 0;
+    m_mutex.unlock();
+    return enabled;
+}
+
+void SequenceAnalyser::addDatagram(const QString &flag, const QByteArray &datagram)
+{
+    m_mutex.lock();
+    if (m_sequenceOffset < 0 || datagram.size() < m_sequenceOffset + m_sequenceWidth) {
+        m_mutex.unlock();
+        return;
+    }
+
+    quint64 const sequence = readBigEndian(datagram, m_sequenceOffset, m_sequenceWidth);
+    auto it = m_streams.find(flag);
+    if (it == m_streams.end()) {
+        if (m_streams.size() < maxStreams) {
+            Stream &stream = m_streams[flag];
+            stream.statistics.flag = flag;
+            startStream(stream, sequence);
+            stream.statistics.received = 1;
+            updateJitter(stream, datagram);
+        }
+    } else {
+        updateStream(*it, sequence, datagram);
+    }
+    m_mutex.unlock();
+}
+
+void SequenceAnalyser::clear()
+{
+    m_mutex.lock();
+    m_streams.clear();
+    m_mutex.unlock();
+}
+
+QList<SequenceAnalyser::Statistics> SequenceAnalyser::statistics() const
+{
+    QList<Statistics> list;
+    m_mutex.lock();
+    for (auto it = m_streams.cbegin(); it != m_streams.cend(); ++it) {
+        list.append(it->statistics);
+    }
+    m_mutex.unlock();
+    return list;
+}
+
+SequenceAnalyser::Statistics SequenceAnalyser::total() const
+{
+    // The jitter of the total is the worst jitter of the streams.
+    Statistics total;
+    const QList<Statistics> list = statistics();
+    for (const Statistics &statistics : list) {
+        total.received += statistics.received;
+        total.expected += statistics.expected;
+        total.duplicates += statistics.duplicates;
+        total.reordered += statistics.reordered;
+        total.restarts += statistics.restarts;
+        total.jitter = qMax(total.jitter, statistics.jitter);
+    }
+
+    return total;
+}
+
+void SequenceAnalyser::startStream(Stream &stream, quint64 sequence)
+{
+    // Datagrams older than the first one are not counted, the stream is joined in the middle.
+    stream.base = sequence;
+    stream.highest = stream.base;
+    stream.badSequenceValid = false;
+    stream.window.fill(0, int(qMax<quint64>(1, m_windowSize / 64)));
+    testAndSet(stream, stream.highest);
+    stream.statistics.expected = stream.priorExpected + 1;
+}
+
+void SequenceAnalyser::updateStream(Stream &stream, quint64 sequence, const QByteArray &datagram)
+{
+    Statistics &statistics = stream.statistics;
+    quint64 const delta = (sequence - stream.highest) & m_mask;
+    if (delta == 0) {
+        statistics.duplicates++;
+        return;
+    }
+
+    if (delta <= m_maxDropout) {
+        advanceWindow(stream, stream.highest + delta);
+        stream.highest += delta;
+        stream.badSequenceValid = false;
+    } else if (m_mask - delta < m_windowSize - 1 && stream.highest - stream.base > m_mask - delta) {
+        // The datagram is m_mask - delta + 1 numbers behind. The window holds the highest number
+        // and the ones less than a window before it, a number a whole window behind shares its bit
+        // with the highest one.
+        quint64 const late = stream.highest - (m_mask - delta) - 1;
+        if (!testAndSet(stream, late)) {
+            statistics.duplicates++;
+            return;
+        }
+
+        statistics.reordered++;
+    } else if (stream.badSequenceValid && sequence == stream.badSequence) {
+        // Two datagrams in sequence after a jump, the sender restarted.
+        stream.priorExpected = statistics.expected;
+        stream.priorReceived = statistics.received;
+        statistics.restarts++;
+        startStream(stream, sequence);
+        statistics.received = stream.priorReceived + 1;
+        stream.lastTransitValid = false;
+        updateJitter(stream, datagram);
+        return;
+    } else {
+        stream.badSequence = (sequence + 1) & m_mask;
+        stream.badSequenceValid = true;
+        return;
+    }
+
+    statistics.received++;
+    statistics.expected = stream.priorExpected + stream.highest - stream.base + 1;
+    updateJitter(stream, datagram);
+}
+
+bool SequenceAnalyser::testAndSet(Stream &stream, quint64 sequence)
+{
+    quint64 const bit = sequence & (m_windowSize - 1);
+    quint64 &word = stream.window[int(bit / 64)];
+    quint64 const mask = quint64(1) << (bit % 64);
+    if (word & mask) {
+        return false;
+    }
+
+    word |= mask;
+    return true;
+}
+
+void SequenceAnalyser::advanceWindow(Stream &stream, quint64 highest)
+{
+    // The bits of the sequence numbers skipped over(still missing) are cleared, they are reused
+    // for the numbers a window earlier.
+    if (highest - stream.highest >= m_windowSize) {
+        stream.window.fill(0);
+    } else {
+        for (quint64 sequence = stream.highest + 1; sequence < highest; ++sequence) {
+            quint64 const bit = sequence & (m_windowSize - 1);
+            stream.window[int(bit / 64)] &= ~(quint64(1) << (bit % 64));
+        }
+    }
+
+    quint64 const bit = highest & (m_windowSize - 1);
+    stream.window[int(bit / 64)] |= quint64(1) << (bit % 64);
+}
+
+void SequenceAnalyser::updateJitter(Stream &stream, const QByteArray &datagram)
+{
+    if (m_timestampOffset < 0 || datagram.size() < m_timestampOffset + 8) {
+        return;
+    }
+
+    // Transit time = arrival - sender timestamp, the clocks do not need to be synchronised, only
+    // the difference of two transit times is used. J += (|D| - J) / 16.
+    qint64 const timestamp = qint64(readBigEndian(datagram, m_timestampOffset, 8));
+    qint64 const transit = m_elapsedTimer.nsecsElapsed() / 1000 - timestamp;
+    if (stream.lastTransitValid) {
+        double const d = qAbs(double(transit - stream.lastTransit));
+        double &jitter = stream.statistics.jitter;
+        jitter = jitter < 0 ? d / 16 : jitter + (d - jitter) / 16;
+    }
+
+    stream.lastTransit = transit;
+    stream.lastTransitValid = true;
+}
+
+quint64 SequenceAnalyser::readBigEndian(const QByteArray &datagram, int offset, int width)
+{
+    quint64 value = 0;
+    const uchar *data = reinterpret_cast<const uchar *>(datagram.constData()) + offset;
+    for (int i = 0; i < width; ++i) {
+        value = (value << 8) | data[i];
+    }
+
+    return value;
+}
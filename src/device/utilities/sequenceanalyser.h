@@ -0,0 +1,83 @@
+﻿/***************************************************************************************************
+ * Copyright 2023-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+
+// Follows the sequence numbers of datagram streams, one stream per sender, the way an RTP receiver
+// does(RFC 3550 A.1): the sequence number is extended with the count of wrap-arounds, a big jump
+// is accepted only when the next datagram continues it, and the last few thousand sequence numbers
+// are kept as a bitmap to tell duplicates from datagrams that arrive late. Lost is expected minus
+// received, so a late datagram reduces it again. With a sender timestamp the inter-arrival jitter
+// is estimated as in RFC 3550 A.8. Nothing is stored per datagram.
+class SequenceAnalyser
+{
+public:
+    struct Statistics
+    {
+        QString flag;
+        quint64 received{0}; // Unique datagrams
+        quint64 expected{0};
+        quint64 duplicates{0};
+        quint64 reordered{0}; // Datagrams older than the highest one received
+        quint64 restarts{0};  // Jumps the stream was resynchronised to
+        double jitter{-1};    // us, negative without timestamps
+
+        qint64 lost() const { return qint64(expected) - qint64(received); }
+    };
+
+public:
+    SequenceAnalyser();
+
+    // width and the timestamp are big endian, the timestamp is 8 bytes of microseconds. A negative
+    // offset disables the analyser or the jitter.
+    void reset(int sequenceOffset, int sequenceWidth, int timestampOffset);
+    bool isEnabled() const;
+    void addDatagram(const QString &flag, const QByteArray &datagram);
+    void clear();
+    QList<Statistics> statistics() const;
+    Statistics total() const;
+
+private:
+    struct Stream
+    {
+        quint64 base{0};    // The extended sequence number the counting started from
+        quint64 highest{0}; // Extended
+        quint64 badSequence{0};
+        bool badSequenceValid{false};
+        quint64 priorExpected{0}; // Of the stream before a restart
+        quint64 priorReceived{0};
+        QVector<quint64> window;
+        qint64 lastTransit{0};
+        bool lastTransitValid{false};
+        Statistics statistics;
+    };
+
+private:
+    int m_sequenceOffset{-1};
+    int m_sequenceWidth{4};
+    int m_timestampOffset{-1};
+    quint64 m_mask{0};
+    quint64 m_windowSize{0};
+    quint64 m_maxDropout{0};
+    QHash<QString, Stream> m_streams;
+    QElapsedTimer m_elapsedTimer;
+    mutable QMutex m_mutex;
+
+private:
+    void startStream(Stream &stream, quint64 sequence);
+    void updateStream(Stream &stream, quint64 sequence, const QByteArray &datagram);
+    bool testAndSet(Stream &stream, quint64 sequence);
+    void advanceWindow(Stream &stream, quint64 highest);
+    void updateJitter(Stream &stream, const QByteArray &datagram);
+    static quint64 readBigEndian(const QByteArray &datagram, int offset, int width);
+};
@@ -8,12 +8,17 @@
  **************************************************************************************************/
 #include "serialportscanner.h"
 
+#include <QCoreApplication>
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QSerialPort>
 #include <QSerialPortInfo>
 #include <QTimer>
 
+#if defined(X_ENABLE_LINUX_NATIVE)
+#include "device/linux/serialportmonitor.h"
+#endif
+
 SerialPortScanner::SerialPortScanner(QObject *parent)
     : QThread{parent}
 {}
@@ -24,9 +29,40 @@ SerialPortScanner::~SerialPortScanner()
     wait();
 }
 
-void SerialPortScanner::setIsBusyDevicesIgnored(bool ignored)
+SerialPortScanner *SerialPortScanner::instance()
 {
-    m_isBusyDevicesIgnored.store(ignored);
+    static SerialPortScanner *scanner = nullptr;
+    if (!scanner) {
+        scanner = new SerialPortScanner(qApp);
+        scanner->start();
+    }
+
+    return scanner;
+}
+
+void SerialPortScanner::requestBusyDevicesChecking(bool request)
+{
+    if (request) {
+        m_busyCheckingRequests.fetch_add(1);
+    } else {
+        m_busyCheckingRequests.fetch_sub(1);
+    }
+}
+
+QStringList SerialPortScanner::portNames() const
+{
+    m_portNamesMutex.lock();
+    QStringList portNames = m_portNames;
+    m_portNamesMutex.unlock();
+    return portNames;
+}
+
+QStringList SerialPortScanner::busyPortNames() const
+{
+    m_portNamesMutex.lock();
+    QStringList busyPortNames = m_busyPortNames;
+    m_portNamesMutex.unlock();
+    return busyPortNames;
 }
 
 QStringList SerialPortScanner::baudRates() const
@@ -42,37 +78,71 @@ QStringList SerialPortScanner::baudRates() const
 
 void SerialPortScanner::run()
 {
-    QTimer *timer = new QTimer();
-    timer->setInterval(1000);
-    timer->setSingleShot(true);
-    connect(timer, &QTimer::timeout, timer, [this, timer]() {
-        refresh();
-        timer->start();
+    // Plugging a hub or a multi-port adapter generates a burst of events, and the device node may
+    // not be ready when the kernel event arrives, so the refreshing is delayed a little.
+    QTimer *refreshTimer = new QTimer();
+    refreshTimer->setInterval(200);
+    refreshTimer->setSingleShot(true);
+    connect(refreshTimer, &QTimer::timeout, refreshTimer, [this]() { refresh(); });
+
+#if defined(X_ENABLE_LINUX_NATIVE)
+    SerialPortMonitor *monitor = new SerialPortMonitor();
+    m_isMonitoring.store(monitor->open());
+    connect(monitor, &SerialPortMonitor::portsChanged, refreshTimer, [refreshTimer]() {
+        refreshTimer->start();
+    });
+#endif
+
+    QTimer *pollTimer = new QTimer();
+    pollTimer->setInterval(1000);
+    connect(pollTimer, &QTimer::timeout, pollTimer, [this]() {
+        if (!m_isMonitoring.load() || m_busyCheckingRequests.load() > 0) {
+            refresh();
+        }
     });
 
     refresh();
-    timer->start();
+    pollTimer->start();
     exec();
-    timer->stop();
-    timer->deleteLater();
-    timer = nullptr;
+    pollTimer->stop();
+    pollTimer->deleteLater();
+    pollTimer = nullptr;
+    refreshTimer->stop();
+    refreshTimer->deleteLater();
+    refreshTimer = nullptr;
+#if defined(X_ENABLE_LINUX_NATIVE)
+    monitor->close();
+    monitor->deleteLater();
+    monitor = nullptr;
+#endif
 }
 
 void SerialPortScanner::refresh()
 {
     QStringList portNames;
+    QStringList busyPortNames;
     auto infos = QSerialPortInfo::availablePorts();
     for (auto &info : infos) {
-        if (m_isBusyDevicesIgnored.load()) {
-            if (!isBusyDevice(info.portName())) {
-                portNames.append(info.portName());
+        portNames.append(info.portName());
+    }
+
+    if (m_busyCheckingRequests.load() > 0) {
+        for (auto &portName : portNames) {
+            if (isBusyDevice(portName)) {
+                busyPortNames.append(portName);
             }
-        } else {
-            portNames.append(info.portName());
         }
     }
 
-    emit portNamesChanged(portNames);
+    m_portNamesMutex.lock();
+    bool changed = (portNames != m_portNames) || (busyPortNames != m_busyPortNames);
+    m_portNames = portNames;
+    m_busyPortNames = busyPortNames;
+    m_portNamesMutex.unlock();
+
+    if (changed) {
+        emit portNamesChanged(portNames);
+    }
 }
 
 bool SerialPortScanner::isBusyDevice(const QString &portName)
@@ -14,14 +14,22 @@
 #include <QThread>
 #include <QVariantList>
 
+// One scanner is shared by the whole process. On Linux the port list is refreshed when the kernel
+// reports a tty being added or removed, on other platforms it is polled every second.
 class SerialPortScanner : public QThread
 {
     Q_OBJECT
-public:
+private:
     explicit SerialPortScanner(QObject *parent = nullptr);
+
+public:
     ~SerialPortScanner() override;
+    static SerialPortScanner *instance();
 
-    Q_INVOKABLE void setIsBusyDevicesIgnored(bool ignored);
+    // Checking busy devices opens every port, it is done(polling) only while it is requested.
+    Q_INVOKABLE void requestBusyDevicesChecking(bool request);
+    Q_INVOKABLE QStringList portNames() const;
+    Q_INVOKABLE QStringList busyPortNames() const;
     Q_INVOKABLE QStringList baudRates() const;
 
 signals:
@@ -35,5 +43,9 @@ private:
     bool isBusyDevice(const QString &portName);
 
 private:
-    std::atomic_bool m_isBusyDevicesIgnored{false};
+    std::atomic_int m_busyCheckingRequests{0};
+    std::atomic_bool m_isMonitoring{false};
+    QStringList m_portNames;
+    QStringList m_busyPortNames;
+    mutable QMutex m_portNamesMutex;
 };
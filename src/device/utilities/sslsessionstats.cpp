@@ -0,0 +1,121 @@
+﻿/***************************************************************************************************
+ * Copyright 2023-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "sslsessionstats.h"
+
+#include <QLocale>
+#include <QSslCipher>
+
+SslSessionStats::SslSessionStats() {}
+
+void SslSessionStats::reset()
+{
+    m_mutex.lock();
+    m_handshakes = 0;
+    m_failedHandshakes = 0;
+    m_ticketOffers = 0;
+    m_lastHandshake = 0;
+    m_totalHandshake = 0;
+    m_fastestHandshake = 0;
+    m_lastTicketOffered = false;
+    m_protocol.clear();
+    m_cipher.clear();
+    m_mutex.unlock();
+
+    m_txMeter.reset();
+    m_rxMeter.reset();
+}
+
+void SslSessionStats::addHandshake(QSslSocket *socket, qint64 nsecs, bool ticketOffered)
+{
+    QString protocol = protocolName(socket->sessionProtocol());
+    QString cipher = socket->sessionCipher().name();
+
+    m_mutex.lock();
+    m_handshakes++;
+    m_ticketOffers += ticketOffered ? 1 : 0;
+    m_lastHandshake = nsecs;
+    m_totalHandshake += nsecs;
+    if (m_fastestHandshake == 0 || nsecs < m_fastestHandshake) {
+        m_fastestHandshake = nsecs;
+    }
+    m_lastTicketOffered = ticketOffered;
+    m_protocol = protocol;
+    m_cipher = cipher;
+    m_mutex.unlock();
+}
+
+void SslSessionStats::addFailedHandshake()
+{
+    m_mutex.lock();
+    m_failedHandshakes++;
+    m_mutex.unlock();
+}
+
+void SslSessionStats::addWrittenBytes(qint64 bytes)
+{
+    m_txMeter.addBytes(bytes);
+}
+
+void SslSessionStats::addReadBytes(qint64 bytes)
+{
+    m_rxMeter.addBytes(bytes);
+}
+
+QList<QPair<QString, QString>> SslSessionStats::metrics(bool showTicket) const
+{
+    auto ms = [](qint64 nsecs) { return QObject::tr("%1 ms").arg(nsecs / 1000000.0, 0, 'f', 2); };
+    auto bytes = [](qint64 bytes) { return QLocale().formattedDataSize(bytes); };
+
+    QList<QPair<QString, QString>> list;
+    m_mutex.lock();
+    list.append(qMakePair(QObject::tr("Handshakes"),
+                          QObject::tr("%1 (%2 failed)").arg(m_handshakes).arg(m_failedHandshakes)));
+    list.append(qMakePair(QObject::tr("Last handshake"), ms(m_lastHandshake)));
+    list.append(qMakePair(QObject::tr("Average handshake"),
+                          ms(m_handshakes > 0 ? m_totalHandshake / m_handshakes : 0)));
+    list.append(qMakePair(QObject::tr("Fastest handshake"), ms(m_fastestHandshake)));
+    if (showTicket) {
+        // Qt does not tell whether the session was resumed, a ticket offered by the client and a
+        // handshake much faster than the first one is the best hint.
+        list.append(qMakePair(QObject::tr("Session ticket"),
+                              QObject::tr("%1, offered %2 times")
+                                  .arg(m_lastTicketOffered ? QObject::tr("offered")
+                                                           : QObject::tr("not offered"))
+                                  .arg(m_ticketOffers)));
+    }
+    list.append(qMakePair(QObject::tr("Protocol"),
+                          m_protocol.isEmpty() ? QString("-") : m_protocol + " " + m_cipher));
+    m_mutex.unlock();
+
+    list.append(qMakePair(QObject::tr("Encrypted tx"),
+                          QString("%1, %2")
+                              .arg(bytes(m_txMeter.totalBytes()),
+                                   ThroughputMeter::formattedRate(m_txMeter.bytesPerSecond()))));
+    list.append(qMakePair(QObject::tr("Encrypted rx"),
+                          QString("%1, %2")
+                              .arg(bytes(m_rxMeter.totalBytes()),
+                                   ThroughputMeter::formattedRate(m_rxMeter.bytesPerSecond()))));
+    return list;
+}
+
+QString SslSessionStats::protocolName(QSsl::SslProtocol protocol)
+{
+    switch (protocol) {
+    case QSsl::TlsV1_0:
+        return QString("TLS 1.0");
+    case QSsl::TlsV1_1:
+        return QString("TLS 1.1");
+    case QSsl::TlsV1_2:
+        return QString("TLS 1.2");
+    case QSsl::TlsV1_3:
+        return QString("TLS 1.3");
+    default:
+        return QObject::tr("Unknown");
+    }
+}
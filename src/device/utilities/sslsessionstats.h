@@ -0,0 +1,47 @@
+﻿/***************************************************************************************************
+ * Copyright 2023-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QSslSocket>
+
+#include "throughputmeter.h"
+
+// Handshake times and application data throughput of the TLS devices. The device thread records,
+// the ui thread reads metrics().
+class SslSessionStats
+{
+public:
+    SslSessionStats();
+
+    void reset();
+    void addHandshake(QSslSocket *socket, qint64 nsecs, bool ticketOffered);
+    void addFailedHandshake();
+    void addWrittenBytes(qint64 bytes);
+    void addReadBytes(qint64 bytes);
+    QList<QPair<QString, QString>> metrics(bool showTicket) const;
+
+    static QString protocolName(QSsl::SslProtocol protocol);
+
+private:
+    mutable QMutex m_mutex;
+    int m_handshakes{0};
+    int m_failedHandshakes{0};
+    int m_ticketOffers{0};
+    qint64 m_lastHandshake{0};    // ns
+    qint64 m_totalHandshake{0};   // ns
+    qint64 m_fastestHandshake{0}; // ns
+    bool m_lastTicketOffered{false};
+    QString m_protocol;
+    QString m_cipher;
+    ThroughputMeter m_txMeter;
+    ThroughputMeter m_rxMeter;
+};
@@ -0,0 +1,76 @@
+﻿/***************************************************************************************************
+ * Copyright 2023-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "throughputmeter.h"
+
+#include <QLocale>
+
+ThroughputMeter::ThroughputMeter()
+{
+    reset();
+}
+
+void ThroughputMeter::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    for (int i = 0; i < bucketCount; ++i) {
+        m_buckets[i] = 0;
+    }
+    m_tick = 0;
+    m_totalBytes = 0;
+    m_elapsedTimer.start();
+}
+
+void ThroughputMeter::addBytes(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    advance();
+    m_buckets[m_tick % bucketCount] += bytes;
+    m_totalBytes += bytes;
+}
+
+qint64 ThroughputMeter::totalBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_totalBytes;
+}
+
+qint64 ThroughputMeter::bytesPerSecond() const
+{
+    QMutexLocker locker(&m_mutex);
+    advance();
+    qint64 bytes = 0;
+    for (int i = 0; i < bucketCount; ++i) {
+        bytes += m_buckets[i];
+    }
+
+    return bytes * 1000 / (bucketCount * bucketLength);
+}
+
+qint64 ThroughputMeter::averageBytesPerSecond() const
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 elapsed = m_elapsedTimer.elapsed();
+    return elapsed > 0 ? m_totalBytes * 1000 / elapsed : 0;
+}
+
+QString ThroughputMeter::formattedRate(qint64 bytesPerSecond)
+{
+    return QString("%1/s").arg(QLocale().formattedDataSize(bytesPerSecond));
+}
+
+void ThroughputMeter::advance() const
+{
+    // The buckets between the newest one and now are empty, at most all of them are cleared.
+    qint64 tick = m_elapsedTimer.elapsed() / bucketLength;
+    qint64 steps = qMin<qint64>(tick - m_tick, bucketCount);
+    for (qint64 i = 1; i <= steps; ++i) {
+        m_buckets[(m_tick + i) % bucketCount] = 0;
+    }
+    m_tick = tick;
+}
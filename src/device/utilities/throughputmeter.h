@@ -0,0 +1,41 @@
+﻿/***************************************************************************************************
+ * Copyright 2023-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QElapsedTimer>
+#include <QMutex>
+
+// Counts bytes and reports the rate of the last second, in ten buckets of 100ms. The device thread
+// adds bytes, the ui thread reads the rate.
+class ThroughputMeter
+{
+public:
+    ThroughputMeter();
+
+    void reset();
+    void addBytes(qint64 bytes);
+    qint64 totalBytes() const;
+    qint64 bytesPerSecond() const;
+    qint64 averageBytesPerSecond() const; // Since reset()
+
+    static QString formattedRate(qint64 bytesPerSecond);
+
+private:
+    static const int bucketCount = 10;
+    static const int bucketLength = 100; // ms
+
+    mutable QMutex m_mutex;
+    QElapsedTimer m_elapsedTimer;
+    mutable qint64 m_buckets[bucketCount];
+    mutable qint64 m_tick{0}; // The 100ms tick the newest bucket belongs to
+    qint64 m_totalBytes{0};
+
+private:
+    void advance() const;
+};
@@ -0,0 +1,852 @@
+﻿/***************************************************************************************************
+ * Copyright 2023-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "websocketconnection.h"
+
+#include <QCryptographicHash>
+#include <QIODevice>
+#include <QRandomGenerator>
+#include <QSharedPointer>
+#include <QTimer>
+#include <QtEndian>
+
+#if defined(X_ENABLE_ZLIB)
+#include "permessagedeflate.h"
+#endif
+
+static const int maxHeaderSize = 16 * 1024;
+static const int handshakeTimeout = 10 * 1000; // ms
+
+WebSocketConnection::WebSocketConnection(QTcpSocket *socket, Role role, QObject *parent)
+    : QObject(parent)
+    , m_socket(socket)
+    , m_role(role)
+{
+    m_socket->setParent(this);
+    m_handshakeTimer = new QTimer(this);
+    m_handshakeTimer->setSingleShot(true);
+    m_handshakeTimer->setInterval(handshakeTimeout);
+    connect(m_handshakeTimer, &QTimer::timeout, this, [this]() {
+        fail(1002, tr("The opening handshake timed out."));
+    });
+
+    connect(m_socket, &QTcpSocket::readyRead, this, &WebSocketConnection::onReadyRead);
+    connect(m_socket, &QTcpSocket::connected, this, [this]() { sendRequest(); });
+    connect(m_socket, &QTcpSocket::bytesWritten, this, [this]() { writeStreamParts(); });
+    connect(m_socket, &QTcpSocket::disconnected, this, [this]() {
+        // Nothing is reported after fail() or abort(), they have set the state already.
+        const State state = m_state;
+        m_state = State::Closed;
+        m_handshakeTimer->stop();
+        m_streamNext = nullptr;
+        if (state == State::Open || state == State::Closing) {
+            emit disconnected();
+        } else if (state != State::Closed) {
+            emit errorOccurred(tr("The connection was closed during the opening handshake."));
+        }
+    });
+    connect(m_socket, &QTcpSocket::errorOccurred, this, [this]() {
+        // A regular close of the peer is reported by disconnected().
+        if (m_state != State::Closed
+            && m_socket->error() != QAbstractSocket::RemoteHostClosedError) {
+            emit errorOccurred(m_socket->errorString());
+        }
+    });
+
+    if (m_role == Role::Server) {
+        m_state = State::Handshaking;
+        m_handshakeTimer->start();
+        if (m_socket->bytesAvailable() > 0) {
+            QTimer::singleShot(0, this, [this]() { onReadyRead(); });
+        }
+    }
+}
+
+WebSocketConnection::~WebSocketConnection()
+{
+#if defined(X_ENABLE_ZLIB)
+    delete m_deflate;
+#endif
+}
+
+void WebSocketConnection::setCompression(bool enabled,
+                                         bool contextTakeover,
+                                         int threshold,
+                                         DeflateStatistics *statistics)
+{
+#if defined(X_ENABLE_ZLIB)
+    m_compression = enabled && statistics;
+#else
+    m_compression = false;
+#endif
+    m_contextTakeover = contextTakeover;
+    m_compressionThreshold = threshold;
+    m_statistics = statistics;
+}
+
+void WebSocketConnection::setRequestHeader(const QByteArray &name, const QByteArray &value)
+{
+    m_requestHeaders.append(qMakePair(name, value));
+}
+
+void WebSocketConnection::open(const QString &host, quint16 port)
+{
+    m_host = host;
+    m_port = port;
+    m_state = State::Connecting;
+    m_handshakeTimer->start();
+    m_socket->connectToHost(host, port);
+}
+
+void WebSocketConnection::close(quint16 code)
+{
+    if (m_state == State::Open) {
+        QByteArray payload(2, 0);
+        qToBigEndian<quint16>(code, reinterpret_cast<uchar *>(payload.data()));
+        writeFrame(encodeFrame(Close, payload, false));
+        m_state = State::Closing;
+    }
+
+    m_socket->disconnectFromHost();
+}
+
+void WebSocketConnection::abort()
+{
+    m_state = State::Closed;
+    m_streamNext = nullptr;
+    m_socket->abort();
+}
+
+QTcpSocket *WebSocketConnection::socket() const
+{
+    return m_socket;
+}
+
+bool WebSocketConnection::isOpen() const
+{
+    return m_state == State::Open;
+}
+
+bool WebSocketConnection::isCompressed() const
+{
+    return m_deflate != nullptr;
+}
+
+bool WebSocketConnection::buildsFramesInOrder() const
+{
+    if (m_role == Role::Client) {
+        return true;
+    }
+
+#if defined(X_ENABLE_ZLIB)
+    return m_deflate && m_deflate->sendsWithContextTakeover();
+#else
+    return false;
+#endif
+}
+
+int WebSocketConnection::frameKey(int messageSize) const
+{
+    if (buildsFramesInOrder()) {
+        return -1;
+    }
+
+#if defined(X_ENABLE_ZLIB)
+    // Compressed frames depend on the window size only, the compression level is the same.
+    if (m_deflate && messageSize >= m_compressionThreshold) {
+        return m_deflate->sendWindowBits();
+    }
+#else
+    Q_UNUSED(messageSize);
+#endif
+
+    return 0;
+}
+
+QByteArray WebSocketConnection::makeFrame(const QByteArray &message, bool binary)
+{
+    // Text must be valid UTF-8, invalid sequences are replaced the way sendTextMessage() of
+    // QWebSocket does it.
+    const QByteArray payload = binary ? message : QString::fromUtf8(message).toUtf8();
+    const int opcode = binary ? Binary : Text;
+#if defined(X_ENABLE_ZLIB)
+    if (m_deflate && payload.size() >= m_compressionThreshold) {
+        QByteArray compressed;
+        if (m_deflate->compress(payload, true, compressed)) {
+            // Without context takeover a message that does not shrink is sent as it is, with it
+            // the peer has to see every message the compressor has seen.
+            if (m_deflate->sendsWithContextTakeover() || compressed.size() < payload.size()) {
+                return encodeFrame(opcode, compressed, true);
+            }
+        }
+    }
+#endif
+
+    return encodeFrame(opcode, payload, false);
+}
+
+qint64 WebSocketConnection::writeMessage(const QByteArray &message, bool binary)
+{
+    if (m_state != State::Open) {
+        return -1;
+    }
+
+    // The frames of a stream must not be interleaved with other messages.
+    if (m_streamNext) {
+        m_pendingMessages.append(qMakePair(message, binary));
+        return message.size();
+    }
+
+    return writeFrame(makeFrame(message, binary));
+}
+
+qint64 WebSocketConnection::writeFrame(const QByteArray &frame)
+{
+    return m_socket->write(frame);
+}
+
+bool WebSocketConnection::writeStream(const std::function<QByteArray()> &next, bool binary)
+{
+    if (m_state != State::Open || m_streamNext) {
+        return false;
+    }
+
+    m_streamNext = next;
+    m_streamPart = next();
+    m_streamCarry.clear();
+    m_streamBinary = binary;
+    m_streamStarted = false;
+    m_streamBytes = 0;
+    // The size is not known in advance, a stream is compressed whenever compression is agreed.
+    // Only the connections that build their frames in order, the shared frames of the others are
+    // built meanwhile and must not touch the compressor in the middle of a message.
+    m_streamCompressed = m_deflate && buildsFramesInOrder();
+    writeStreamParts();
+    return true;
+}
+
+bool WebSocketConnection::writeStream(QIODevice *device, bool binary)
+{
+    // The device is deleted with the generator, at the end of the stream or when the connection
+    // is closed.
+    QSharedPointer<QIODevice> source(device);
+    return writeStream([source]() { return source->read(partSize); }, binary);
+}
+
+bool WebSocketConnection::isStreaming() const
+{
+    return static_cast<bool>(m_streamNext);
+}
+
+void WebSocketConnection::onReadyRead()
+{
+    m_buffer.append(m_socket->readAll());
+    if (m_state == State::Handshaking) {
+        bool const done = m_role == Role::Server ? readRequest() : readResponse();
+        if (!done) {
+            return;
+        }
+    }
+
+    if (m_state == State::Open || m_state == State::Closing) {
+        readFrames();
+    }
+}
+
+void WebSocketConnection::sendRequest()
+{
+    QByteArray nonce(16, 0);
+    for (int i = 0; i < nonce.size(); ++i) {
+        nonce[i] = static_cast<char>(QRandomGenerator::global()->bounded(256));
+    }
+    m_key = nonce.toBase64();
+
+    QByteArray request = "GET / HTTP/1.1\r\n";
+    request += "Host: " + m_host.toUtf8() + ":" + QByteArray::number(m_port) + "\r\n";
+    request += "Upgrade: websocket\r\n";
+    request += "Connection: Upgrade\r\n";
+    request += "Sec-WebSocket-Key: " + m_key + "\r\n";
+    request += "Sec-WebSocket-Version: 13\r\n";
+#if defined(X_ENABLE_ZLIB)
+    if (m_compression) {
+        request += "Sec-WebSocket-Extensions: " + PerMessageDeflate::makeOffer(m_contextTakeover)
+                   + "\r\n";
+    }
+#endif
+    for (const auto &header : m_requestHeaders) {
+        request += header.first + ": " + header.second + "\r\n";
+    }
+    request += "\r\n";
+
+    m_state = State::Handshaking;
+    m_socket->write(request);
+}
+
+// Splits the head of a request or response into the first line and the headers(lower case names).
+static bool parseHead(QByteArray &buffer,
+                      QByteArray &firstLine,
+                      QList<QPair<QByteArray, QByteArray>> &headers,
+                      bool &complete)
+{
+    const int end = buffer.indexOf("\r\n\r\n");
+    complete = end >= 0;
+    if (!complete) {
+        return buffer.size() <= maxHeaderSize;
+    }
+
+    const QList<QByteArray> lines = buffer.left(end).split('\n');
+    buffer.remove(0, end + 4);
+    firstLine = lines.first().trimmed();
+    for (int i = 1; i < lines.size(); ++i) {
+        const int colon = lines.at(i).indexOf(':');
+        if (colon <= 0) {
+            return false;
+        }
+        headers.append(qMakePair(lines.at(i).left(colon).trimmed().toLower(),
+                                 lines.at(i).mid(colon + 1).trimmed()));
+    }
+
+    return true;
+}
+
+static QByteArray headerValue(const QList<QPair<QByteArray, QByteArray>> &headers,
+                              const QByteArray &name)
+{
+    // Repeated headers are combined the way HTTP does it.
+    QByteArray value;
+    for (const auto &header : headers) {
+        if (header.first == name) {
+            value += (value.isEmpty() ? QByteArray() : QByteArray(", ")) + header.second;
+        }
+    }
+
+    return value;
+}
+
+bool WebSocketConnection::readRequest()
+{
+    QByteArray requestLine;
+    QList<QPair<QByteArray, QByteArray>> headers;
+    bool complete = false;
+    if (!parseHead(m_buffer, requestLine, headers, complete)) {
+        m_socket->write("HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n");
+        fail(1002, tr("Invalid opening handshake."));
+        return false;
+    }
+    if (!complete) {
+        return false;
+    }
+
+    const QByteArray key = headerValue(headers, "sec-websocket-key");
+    if (!requestLine.startsWith("GET ") || key.isEmpty()
+        || headerValue(headers, "upgrade").toLower() != "websocket"
+        || !headerValue(headers, "connection").toLower().contains("upgrade")) {
+        m_socket->write("HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n");
+        fail(1002, tr("Invalid opening handshake."));
+        return false;
+    }
+    if (headerValue(headers, "sec-websocket-version") != "13") {
+        m_socket->write("HTTP/1.1 426 Upgrade Required\r\nSec-WebSocket-Version: 13\r\n"
+                        "Connection: close\r\n\r\n");
+        fail(1002, tr("Unsupported web socket version."));
+        return false;
+    }
+
+    QByteArray response = "HTTP/1.1 101 Switching Protocols\r\n";
+    response += "Upgrade: websocket\r\n";
+    response += "Connection: Upgrade\r\n";
+    response += "Sec-WebSocket-Accept: " + acceptKey(key) + "\r\n";
+#if defined(X_ENABLE_ZLIB)
+    const QByteArray offers = headerValue(headers, "sec-websocket-extensions");
+    PerMessageDeflate::Parameters parameters;
+    QByteArray extension;
+    if (m_compression
+        && PerMessageDeflate::negotiate(offers, m_contextTakeover, parameters, extension)) {
+        m_deflate = new PerMessageDeflate(true, parameters, m_statistics);
+        response += "Sec-WebSocket-Extensions: " + extension + "\r\n";
+    }
+#endif
+    response += "\r\n";
+    m_socket->write(response);
+
+    m_state = State::Open;
+    m_handshakeTimer->stop();
+    emit connected();
+    return true;
+}
+
+bool WebSocketConnection::readResponse()
+{
+    QByteArray statusLine;
+    QList<QPair<QByteArray, QByteArray>> headers;
+    bool complete = false;
+    if (!parseHead(m_buffer, statusLine, headers, complete)) {
+        fail(1002, tr("Invalid opening handshake response."));
+        return false;
+    }
+    if (!complete) {
+        return false;
+    }
+
+    const QList<QByteArray> status = statusLine.split(' ');
+    if (status.size() < 2 || status.at(1) != "101") {
+        fail(1002, tr("The server refused the web socket: %1").arg(QString::fromUtf8(statusLine)));
+        return false;
+    }
+    if (headerValue(headers, "sec-websocket-accept") != acceptKey(m_key)) {
+        fail(1002, tr("Invalid Sec-WebSocket-Accept."));
+        return false;
+    }
+
+    const QByteArray extensions = headerValue(headers, "sec-websocket-extensions");
+    if (!extensions.isEmpty()) {
+#if defined(X_ENABLE_ZLIB)
+        PerMessageDeflate::Parameters parameters;
+        if (!m_compression || !PerMessageDeflate::parseResponse(extensions, parameters)) {
+            fail(1010, tr("The server answered with an extension that was not offered."));
+            return false;
+        }
+        m_deflate = new PerMessageDeflate(false, parameters, m_statistics);
+#else
+        fail(1010, tr("The server answered with an extension that was not offered."));
+        return false;
+#endif
+    }
+
+    m_state = State::Open;
+    m_handshakeTimer->stop();
+    emit connected();
+    return true;
+}
+
+bool WebSocketConnection::readFrames()
+{
+    // The payload of a data frame is handled as it arrives, a frame of any size needs bounded
+    // memory. Control frames are small, they are handled whole. The consumed bytes are removed
+    // once.
+    const uchar *data = reinterpret_cast<const uchar *>(m_buffer.constData());
+    const qint64 size = m_buffer.size();
+    qint64 offset = 0;
+    bool ok = true;
+    while (ok && offset < size) {
+        if (m_frameRemaining >= 0) {
+            const qint64 count = qMin(m_frameRemaining, size - offset);
+            QByteArray payload(reinterpret_cast<const char *>(data + offset), int(count));
+            if (m_frameMasked) {
+                char *bytes = payload.data();
+                for (int i = 0; i < payload.size(); ++i) {
+                    bytes[i] ^= m_frameMask[(m_frameOffset + i) & 3];
+                }
+            }
+
+            offset += count;
+            m_frameOffset += count;
+            m_frameRemaining -= count;
+            ok = (payload.isEmpty() || handleData(payload))
+                 && (m_frameRemaining > 0 || endDataFrame());
+            continue;
+        }
+
+        if (size - offset < 2) {
+            break;
+        }
+
+        const bool fin = data[offset] & 0x80;
+        const bool rsv1 = data[offset] & 0x40;
+        const int opcode = data[offset] & 0x0f;
+        const bool masked = data[offset + 1] & 0x80;
+        quint64 length = data[offset + 1] & 0x7f;
+        qint64 headerSize = 2;
+        if (length == 126) {
+            if (size - offset < 4) {
+                break;
+            }
+            length = qFromBigEndian<quint16>(data + offset + 2);
+            headerSize = 4;
+        } else if (length == 127) {
+            if (size - offset < 10) {
+                break;
+            }
+            length = qFromBigEndian<quint64>(data + offset + 2);
+            headerSize = 10;
+        }
+
+        if (data[offset] & 0x30) {
+            fail(1002, tr("Reserved bits are set."));
+            return false;
+        }
+        // Clients must mask their frames, servers must not.
+        if (masked != (m_role == Role::Server)) {
+            fail(1002, tr("Invalid masking of a frame."));
+            return false;
+        }
+        // The most significant bit of a 64 bit length must be 0.
+        if (length >> 63) {
+            fail(1002, tr("Invalid frame length."));
+            return false;
+        }
+
+        const qint64 maskSize = masked ? 4 : 0;
+        if (size - offset < headerSize + maskSize) {
+            break;
+        }
+
+        if (opcode >= Close) {
+            if (length > 125) {
+                fail(1002, tr("Invalid control frame."));
+                return false;
+            }
+            if (size - offset < headerSize + maskSize + qint64(length)) {
+                break;
+            }
+
+            const uchar *mask = data + offset + headerSize;
+            QByteArray payload(reinterpret_cast<const char *>(mask + maskSize), int(length));
+            if (masked) {
+                char *bytes = payload.data();
+                for (int i = 0; i < payload.size(); ++i) {
+                    bytes[i] ^= mask[i & 3];
+                }
+            }
+
+            offset += headerSize + maskSize + qint64(length);
+            ok = handleControlFrame(opcode, fin, rsv1, payload);
+            continue;
+        }
+
+        m_frameFin = fin;
+        m_frameMasked = masked;
+        for (int i = 0; i < maskSize; ++i) {
+            m_frameMask[i] = data[offset + headerSize + i];
+        }
+        m_frameRemaining = qint64(length);
+        m_frameOffset = 0;
+        offset += headerSize + maskSize;
+        ok = startDataFrame(opcode, rsv1) && (m_frameRemaining > 0 || endDataFrame());
+    }
+
+    if (ok) {
+        m_buffer.remove(0, int(offset));
+    }
+
+    return ok;
+}
+
+bool WebSocketConnection::handleControlFrame(int opcode,
+                                             bool fin,
+                                             bool rsv1,
+                                             const QByteArray &payload)
+{
+    if (!fin || rsv1) {
+        fail(1002, tr("Invalid control frame."));
+        return false;
+    }
+
+    if (opcode == Ping) {
+        writeFrame(encodeFrame(Pong, payload, false));
+    } else if (opcode == Close) {
+        // The close frame is echoed with the same status code, then the tcp connection is closed.
+        if (m_state == State::Open) {
+            writeFrame(encodeFrame(Close, payload.left(2), false));
+        }
+        m_state = State::Closing;
+        m_socket->disconnectFromHost();
+        return false;
+    } else if (opcode != Pong) {
+        fail(1002, tr("Unknown opcode."));
+        return false;
+    }
+
+    return true;
+}
+
+bool WebSocketConnection::startDataFrame(int opcode, bool rsv1)
+{
+    if (opcode == Continuation) {
+        if (!m_messageStarted || rsv1) {
+            fail(1002, tr("Unexpected continuation frame."));
+            return false;
+        }
+    } else if (opcode == Text || opcode == Binary) {
+        // RSV1 marks a compressed message, it is only set on the first frame.
+        if (m_messageStarted || (rsv1 && !m_deflate)) {
+            fail(1002, tr("Unexpected data frame."));
+            return false;
+        }
+        m_messageStarted = true;
+        m_messageBinary = opcode == Binary;
+        m_messageCompressed = rsv1;
+        m_messageInParts = false;
+        m_message.clear();
+    } else {
+        fail(1002, tr("Unknown opcode."));
+        return false;
+    }
+
+    return true;
+}
+
+bool WebSocketConnection::handleData(const QByteArray &data)
+{
+#if defined(X_ENABLE_ZLIB)
+    if (m_messageCompressed) {
+        const bool ok = m_deflate->decompress(data, false, [this](const QByteArray &bytes) {
+            m_message.append(bytes);
+            return deliverMessage(false);
+        });
+        if (!ok && m_state != State::Closed) {
+            fail(1007, tr("Invalid compressed message."));
+        }
+        return ok;
+    }
+#endif
+
+    m_message.append(data);
+    return deliverMessage(false);
+}
+
+bool WebSocketConnection::endDataFrame()
+{
+    m_frameRemaining = -1;
+    if (!m_frameFin) {
+        return true;
+    }
+
+    m_messageStarted = false;
+#if defined(X_ENABLE_ZLIB)
+    if (m_messageCompressed) {
+        const bool ok = m_deflate->decompress(QByteArray(), true, [this](const QByteArray &bytes) {
+            m_message.append(bytes);
+            return deliverMessage(false);
+        });
+        if (!ok) {
+            if (m_state != State::Closed) {
+                fail(1007, tr("Invalid compressed message."));
+            }
+            return false;
+        }
+    }
+#endif
+
+    return deliverMessage(true);
+}
+
+bool WebSocketConnection::deliverMessage(bool last)
+{
+    // A message up to partSize is delivered whole, a larger one in parts of about that size.
+    if (!last && m_message.size() < partSize) {
+        return true;
+    }
+
+    QByteArray part;
+    if (m_messageBinary) {
+        part.swap(m_message);
+    } else {
+        // A part of a text ends on a character boundary, a split character starts the next part.
+        const int size = last ? m_message.size() : completeUtf8Size(m_message);
+        part = m_message.left(size);
+        m_message.remove(0, size);
+        if (!isValidUtf8(part)) {
+            fail(1007, tr("Invalid UTF-8 text message."));
+            return false;
+        }
+    }
+
+    if (last && !m_messageInParts) {
+        emit messageReceived(part, m_messageBinary);
+    } else {
+        m_messageInParts = !last;
+        emit partReceived(part, m_messageBinary, last);
+    }
+
+    return true;
+}
+
+void WebSocketConnection::writeStreamParts()
+{
+    // At most partSize bytes wait in the socket, the next part is requested when they are written.
+    while (m_streamNext && m_state == State::Open && m_socket->bytesToWrite() < partSize) {
+        QByteArray part = m_streamPart;
+        m_streamPart = m_streamNext();
+        const bool last = m_streamPart.isEmpty();
+        m_streamBytes += part.size();
+        if (!m_streamBinary) {
+            // Text must be valid UTF-8 as a whole, a character may be split by the parts.
+            part.prepend(m_streamCarry);
+            const int size = last ? part.size() : completeUtf8Size(part);
+            m_streamCarry = part.mid(size);
+            part = QString::fromUtf8(part.left(size)).toUtf8();
+        }
+
+        const int opcode = m_streamStarted ? Continuation : (m_streamBinary ? Binary : Text);
+        bool rsv1 = false;
+#if defined(X_ENABLE_ZLIB)
+        if (m_streamCompressed) {
+            QByteArray compressed;
+            if (!m_deflate->compress(part, last, compressed)) {
+                fail(1011, tr("Failed to compress the message."));
+                return;
+            }
+            part = compressed;
+            rsv1 = !m_streamStarted;
+        }
+#endif
+        writeFrame(encodeFrame(opcode, part, rsv1, last));
+        m_streamStarted = true;
+        emit streamPartWritten(m_streamBytes);
+        if (last) {
+            m_streamNext = nullptr;
+            m_streamCarry.clear();
+            emit streamFinished(m_streamBytes);
+
+            const QList<QPair<QByteArray, bool>> messages = m_pendingMessages;
+            m_pendingMessages.clear();
+            for (const auto &message : messages) {
+                writeMessage(message.first, message.second);
+            }
+        }
+    }
+}
+
+void WebSocketConnection::fail(quint16 code, const QString &errorString)
+{
+    if (m_state == State::Open) {
+        QByteArray payload(2, 0);
+        qToBigEndian<quint16>(code, reinterpret_cast<uchar *>(payload.data()));
+        writeFrame(encodeFrame(Close, payload, false));
+        m_socket->flush();
+    }
+
+    m_state = State::Closed;
+    m_handshakeTimer->stop();
+    m_streamNext = nullptr;
+    emit errorOccurred(errorString);
+    m_socket->abort();
+}
+
+QByteArray WebSocketConnection::encodeFrame(int opcode,
+                                            const QByteArray &payload,
+                                            bool rsv1,
+                                            bool fin) const
+{
+    const bool masked = m_role == Role::Client;
+    const quint64 size = static_cast<quint64>(payload.size());
+    QByteArray frame;
+    frame.reserve(payload.size() + 14);
+    frame.append(static_cast<char>((fin ? 0x80 : 0) | (rsv1 ? 0x40 : 0) | opcode));
+    const char maskBit = masked ? char(0x80) : char(0);
+    if (size < 126) {
+        frame.append(static_cast<char>(maskBit | char(size)));
+    } else if (size <= 0xffff) {
+        frame.append(static_cast<char>(maskBit | 126));
+        frame.append(static_cast<char>(size >> 8));
+        frame.append(static_cast<char>(size));
+    } else {
+        frame.append(static_cast<char>(maskBit | 127));
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            frame.append(static_cast<char>(size >> shift));
+        }
+    }
+
+    if (!masked) {
+        frame.append(payload);
+        return frame;
+    }
+
+    uchar mask[4];
+    qToBigEndian<quint32>(QRandomGenerator::global()->generate(), mask);
+    frame.append(reinterpret_cast<const char *>(mask), 4);
+    const int start = frame.size();
+    frame.append(payload);
+    char *bytes = frame.data() + start;
+    for (int i = 0; i < payload.size(); ++i) {
+        bytes[i] ^= mask[i & 3];
+    }
+
+    return frame;
+}
+
+QByteArray WebSocketConnection::acceptKey(const QByteArray &key)
+{
+    const QByteArray guid("258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
+    return QCryptographicHash::hash(key + guid, QCryptographicHash::Sha1).toBase64();
+}
+
+bool WebSocketConnection::isValidUtf8(const QByteArray &bytes)
+{
+    // RFC 3629: no overlong forms, no surrogates, nothing above U+10FFFF.
+    const uchar *data = reinterpret_cast<const uchar *>(bytes.constData());
+    const int size = bytes.size();
+    int i = 0;
+    while (i < size) {
+        const uchar c = data[i];
+        int extra = 0;
+        uint min = 0;
+        uint code = 0;
+        if (c < 0x80) {
+            i++;
+            continue;
+        } else if ((c & 0xe0) == 0xc0) {
+            extra = 1;
+            min = 0x80;
+            code = c & 0x1f;
+        } else if ((c & 0xf0) == 0xe0) {
+            extra = 2;
+            min = 0x800;
+            code = c & 0x0f;
+        } else if ((c & 0xf8) == 0xf0) {
+            extra = 3;
+            min = 0x10000;
+            code = c & 0x07;
+        } else {
+            return false;
+        }
+
+        if (i + extra >= size) {
+            return false;
+        }
+        for (int j = 1; j <= extra; ++j) {
+            if ((data[i + j] & 0xc0) != 0x80) {
+                return false;
+            }
+            code = (code << 6) | (data[i + j] & 0x3f);
+        }
+        if (code < min || code > 0x10ffff || (code >= 0xd800 && code <= 0xdfff)) {
+            return false;
+        }
+        i += extra + 1;
+    }
+
+    return true;
+}
+
+int WebSocketConnection::completeUtf8Size(const QByteArray &bytes)
+{
+    // The size without an incomplete sequence at the end, the lead byte is at most 3 bytes back.
+    const uchar *data = reinterpret_cast<const uchar *>(bytes.constData());
+    const int size = bytes.size();
+    for (int i = size - 1; i >= 0 && i >= size - 3; --i) {
+        const uchar c = data[i];
+        if ((c & 0xc0) == 0x80) {
+            continue;
+        }
+
+        int length = 1;
+        if ((c & 0xe0) == 0xc0) {
+            length = 2;
+        } else if ((c & 0xf0) == 0xe0) {
+            length = 3;
+        } else if ((c & 0xf8) == 0xf0) {
+            length = 4;
+        }
+
+        return size - i < length ? i : size;
+    }
+
+    return size;
+}
@@ -0,0 +1,155 @@
+﻿/***************************************************************************************************
+ * Copyright 2023-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <functional>
+
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QTcpSocket>
+
+class QIODevice;
+class QTimer;
+class PerMessageDeflate;
+struct DeflateStatistics;
+
+// One end of a web socket(RFC 6455) over a tcp socket. QWebSocket can neither negotiate extensions
+// nor read frames with RSV1 set, so the web socket devices speak the protocol themselves: the
+// opening handshake, masking, fragmentation, ping/pong and the closing handshake, and the
+// permessage-deflate extension(RFC 7692) if it is built with zlib. The frames of the server are not
+// masked and can be built once and written to many connections, see frameKey(). Messages of any
+// size are sent and received in parts, see writeStream() and partReceived().
+class WebSocketConnection : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Role { Client, Server };
+    // Received messages larger than this are delivered in parts, streamed messages are sent in
+    // frames of about this size.
+    static const int partSize = 1024 * 1024;
+
+public:
+    // The connection takes the ownership of the socket. A server connection starts waiting for the
+    // opening handshake at once.
+    WebSocketConnection(QTcpSocket *socket, Role role, QObject *parent = nullptr);
+    ~WebSocketConnection() override;
+
+    // Before the opening handshake. Messages smaller than threshold are sent uncompressed.
+    void setCompression(bool enabled,
+                        bool contextTakeover,
+                        int threshold,
+                        DeflateStatistics *statistics);
+    void setRequestHeader(const QByteArray &name, const QByteArray &value);
+    void open(const QString &host, quint16 port);
+    void close(quint16 code = 1000);
+    void abort();
+
+    QTcpSocket *socket() const;
+    bool isOpen() const;
+    bool isCompressed() const;
+
+    // The frames of a client are masked with a new key each, with context takeover they depend on
+    // the messages sent before. Such frames are built by writeMessage() when they are written.
+    bool buildsFramesInOrder() const;
+    // Connections with the same key get the same frame for a message of that size, the frame can
+    // be built by one of them and shared. -1 if the connection builds its frames in order.
+    int frameKey(int messageSize) const;
+    QByteArray makeFrame(const QByteArray &message, bool binary);
+    qint64 writeMessage(const QByteArray &message, bool binary);
+    qint64 writeFrame(const QByteArray &frame);
+    // Sends a message whose parts are returned by next() one by one, an empty part ends it. A part
+    // is requested only when the socket has written most of the previous ones, so the memory
+    // needed does not depend on the size of the message. The messages written meanwhile follow the
+    // stream. False if another stream is being sent.
+    bool writeStream(const std::function<QByteArray()> &next, bool binary);
+    // Streams the bytes of an opened device, the connection takes the ownership of it.
+    bool writeStream(QIODevice *device, bool binary);
+    bool isStreaming() const;
+
+signals:
+    void connected();
+    void disconnected();
+    void errorOccurred(const QString &errorString);
+    void messageReceived(const QByteArray &message, bool binary);
+    // A message larger than partSize, its parts in order, last is set for the final one.
+    void partReceived(const QByteArray &part, bool binary, bool last);
+    void streamPartWritten(qint64 bytes); // Bytes of the stream written so far
+    void streamFinished(qint64 bytes);
+
+private:
+    enum class State { Connecting, Handshaking, Open, Closing, Closed };
+    enum Opcode {
+        Continuation = 0x0,
+        Text = 0x1,
+        Binary = 0x2,
+        Close = 0x8,
+        Ping = 0x9,
+        Pong = 0xa
+    };
+
+private:
+    QTcpSocket *m_socket;
+    Role m_role;
+    State m_state{State::Connecting};
+    QTimer *m_handshakeTimer;
+    QByteArray m_buffer; // Received bytes not parsed yet, a frame is parsed as it arrives
+    QByteArray m_key;    // Client, Sec-WebSocket-Key
+    QList<QPair<QByteArray, QByteArray>> m_requestHeaders;
+    QString m_host;
+    quint16 m_port{0};
+
+    // The data frame being received
+    bool m_frameFin{false};
+    bool m_frameMasked{false};
+    uchar m_frameMask[4];
+    qint64 m_frameRemaining{-1}; // Payload bytes still to come, -1 if no frame is being received
+    qint64 m_frameOffset{0};
+
+    // The message being received
+    QByteArray m_message; // Not delivered yet
+    bool m_messageStarted{false};
+    bool m_messageBinary{false};
+    bool m_messageCompressed{false};
+    bool m_messageInParts{false}; // A part of it has been delivered
+
+    // The message being sent by writeStream()
+    std::function<QByteArray()> m_streamNext;
+    QByteArray m_streamPart;  // The next part, read ahead to know which part is the last one
+    QByteArray m_streamCarry; // Text, the incomplete UTF-8 sequence at the end of the last part
+    bool m_streamBinary{false};
+    bool m_streamStarted{false};
+    bool m_streamCompressed{false};
+    qint64 m_streamBytes{0};
+    QList<QPair<QByteArray, bool>> m_pendingMessages; // Written while streaming
+
+    bool m_compression{false};
+    bool m_contextTakeover{true};
+    int m_compressionThreshold{0};
+    DeflateStatistics *m_statistics{nullptr};
+    PerMessageDeflate *m_deflate{nullptr};
+
+private:
+    void onReadyRead();
+    void sendRequest();
+    bool readRequest();
+    bool readResponse();
+    bool readFrames();
+    bool handleControlFrame(int opcode, bool fin, bool rsv1, const QByteArray &payload);
+    bool startDataFrame(int opcode, bool rsv1);
+    bool handleData(const QByteArray &data);
+    bool endDataFrame();
+    bool deliverMessage(bool last);
+    void writeStreamParts();
+    void fail(quint16 code, const QString &errorString);
+    QByteArray encodeFrame(int opcode, const QByteArray &payload, bool rsv1, bool fin = true) const;
+    static QByteArray acceptKey(const QByteArray &key);
+    static bool isValidUtf8(const QByteArray &bytes);
+    static int completeUtf8Size(const QByteArray &bytes);
+};
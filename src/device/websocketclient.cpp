@@ -8,7 +8,11 @@
  **************************************************************************************************/
 #include "websocketclient.h"
 
+#include <QFile>
+
 #include "common/xtools.h"
+#include "utilities/lowlatency.h"
+#include "utilities/websocketconnection.h"
 
 WebSocketClient::WebSocketClient(QObject *parent)
     : SocketClient(parent)
@@ -18,72 +22,115 @@ WebSocketClient::~WebSocketClient() {}
 
 QObject *WebSocketClient::initDevice()
 {
-    m_webSocket = new QWebSocket();
-    connect(m_webSocket,
-            &QWebSocket::textMessageReceived,
-            m_webSocket,
-            [this](const QString &message) { onTextMessageReceived(message); });
-    connect(m_webSocket,
-            &QWebSocket::binaryMessageReceived,
-            m_webSocket,
-            [this](const QByteArray &message) { onBinaryMessageReceived(message); });
-    connect(m_webSocket, &QWebSocket::disconnected, m_webSocket, [this]() {
-        emit errorOccurred("");
+    m_connection = new WebSocketConnection(new QTcpSocket(), WebSocketConnection::Role::Client);
+#if defined(X_ENABLE_ZLIB)
+    m_deflateStatistics.reset();
+    m_connection->setCompression(m_compression,
+                                 m_contextTakeover,
+                                 m_compressionThreshold,
+                                 &m_deflateStatistics);
+#endif
+    connect(m_connection,
+            &WebSocketConnection::messageReceived,
+            m_connection,
+            [this](const QByteArray &message, bool binary) { onMessageReceived(message, binary); });
+    // The parts of a large message are shown as they arrive.
+    connect(m_connection,
+            &WebSocketConnection::partReceived,
+            m_connection,
+            [this](const QByteArray &part, bool binary) { onMessageReceived(part, binary); });
+    const QString flag = makeFlag(m_serverAddress, m_serverPort);
+    connect(m_connection,
+            &WebSocketConnection::streamPartWritten,
+            m_connection,
+            [this, flag](qint64 bytes) { emit streamProgressChanged(flag, bytes, false); });
+    connect(m_connection,
+            &WebSocketConnection::streamFinished,
+            m_connection,
+            [this, flag](qint64 bytes) { emit streamProgressChanged(flag, bytes, true); });
+    connect(this, &Socket::invokeWriteFile, m_connection, [this](const QString &fileName) {
+        writeFileActually(fileName);
     });
-    connect(m_webSocket, xWebSocketErrorOccurred, m_webSocket, [this]() {
-        emit errorOccurred(m_webSocket->errorString());
+    connect(m_connection, &WebSocketConnection::connected, m_connection, [this]() {
+        if (m_lowLatency) {
+            LowLatency::setup(m_connection->socket());
+        }
+    });
+    connect(m_connection, &WebSocketConnection::disconnected, m_connection, [this]() {
+        emit errorOccurred("");
     });
+    connect(m_connection,
+            &WebSocketConnection::errorOccurred,
+            m_connection,
+            [this](const QString &errorString) { emit errorOccurred(errorString); });
 
-    QString url = QString("ws://%1:%2").arg(m_serverAddress).arg(m_serverPort);
     if (m_authentication) {
-        QNetworkRequest request(url);
         QString username = m_username;
         QString password = m_password;
         QString concatenated = username + ":" + password;
         QByteArray data = concatenated.toLocal8Bit().toBase64();
         QString headerData = "Basic " + data;
-        request.setRawHeader("Authorization", headerData.toLocal8Bit());
+        m_connection->setRequestHeader("Authorization", headerData.toLocal8Bit());
 
-        qInfo() << "Request: " << request.url();
         qInfo() << "User: " << username << " Password: " << password;
-
-        m_webSocket->open(request);
-    } else {
-        m_webSocket->open(url);
     }
-    return m_webSocket;
+
+    m_connection->open(m_serverAddress, m_serverPort);
+    return m_connection;
 }
 
 void WebSocketClient::deinitDevice()
 {
-    m_webSocket->close();
-    m_webSocket->deleteLater();
-    m_webSocket = nullptr;
+    m_connection->close();
+    m_connection->deleteLater();
+    m_connection = nullptr;
 }
 
 void WebSocketClient::writeActually(const QByteArray &bytes)
 {
-    if (m_channel == static_cast<int>(WebSocketDataChannel::Text)) {
-        if (m_webSocket->sendTextMessage(QString::fromUtf8(bytes)) > 0) {
-            emit bytesWritten(bytes, makeFlag(m_serverAddress, m_serverPort) + "[T]");
-        }
-    } else if (m_channel == static_cast<int>(WebSocketDataChannel::Binary)) {
-        if (m_webSocket->sendBinaryMessage(bytes) > 0) {
-            emit bytesWritten(bytes, makeFlag(m_serverAddress, m_serverPort) + "[B]");
-        }
-    } else {
+    if (m_channel != static_cast<int>(WebSocketDataChannel::Text)
+        && m_channel != static_cast<int>(WebSocketDataChannel::Binary)) {
         qWarning() << "Invalid data channel: " << m_channel;
+        return;
+    }
+
+    bool binary = m_channel == static_cast<int>(WebSocketDataChannel::Binary);
+    if (m_connection->writeMessage(bytes, binary) > 0) {
+        QString flag = makeFlag(m_serverAddress, m_serverPort);
+        emit bytesWritten(bytes, flag + (binary ? "[B]" : "[T]"));
+    }
+
+    if (m_lowLatency) {
+        m_connection->socket()->flush();
     }
 }
 
-void WebSocketClient::onTextMessageReceived(const QString &message)
+QList<QPair<QString, QString>> WebSocketClient::metrics() const
 {
-    QString flag = makeFlag(m_serverAddress, m_serverPort);
-    emit bytesRead(message.toUtf8(), flag + "[T]");
+#if defined(X_ENABLE_ZLIB)
+    return m_deflateStatistics.metrics();
+#else
+    return QList<QPair<QString, QString>>();
+#endif
+}
+
+void WebSocketClient::writeFileActually(const QString &fileName)
+{
+    QFile *file = new QFile(fileName);
+    if (!file->open(QFile::ReadOnly)) {
+        emit warningOccurred(tr("Failed to open %1: %2").arg(fileName, file->errorString()));
+        delete file;
+        return;
+    }
+
+    bool binary = m_channel == static_cast<int>(WebSocketDataChannel::Binary);
+    if (!m_connection->writeStream(file, binary)) {
+        emit warningOccurred(tr("The connection is not open or a file is being sent."));
+    }
 }
 
-void WebSocketClient::onBinaryMessageReceived(const QByteArray &message)
+void WebSocketClient::onMessageReceived(const QByteArray &message, bool binary)
 {
     QString flag = makeFlag(m_serverAddress, m_serverPort);
-    emit bytesRead(message, flag + "[B]");
+    emit bytesRead(message, flag + (binary ? "[B]" : "[T]"));
 }
@@ -8,10 +8,9 @@
  **************************************************************************************************/
 #pragma once
 
-#include <QWebSocket>
-
 #include "socketclient.h"
 
+class WebSocketConnection;
 class WebSocketClient : public SocketClient
 {
     Q_OBJECT
@@ -22,11 +21,12 @@ public:
     QObject *initDevice() override;
     void deinitDevice() override;
     void writeActually(const QByteArray &bytes) override;
+    QList<QPair<QString, QString>> metrics() const override;
 
 private:
-    QWebSocket *m_webSocket{nullptr};
+    WebSocketConnection *m_connection{nullptr};
 
 private:
-    void onTextMessageReceived(const QString &message);
-    void onBinaryMessageReceived(const QByteArray &message);
+    void writeFileActually(const QString &fileName);
+    void onMessageReceived(const QByteArray &message, bool binary);
 };
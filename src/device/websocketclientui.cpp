@@ -8,16 +8,23 @@
  **************************************************************************************************/
 #include "websocketclientui.h"
 
+#include "devicemetricsview.h"
 #include "websocketclient.h"
+#include "websocketstreamview.h"
 
 WebSocketClientUi::WebSocketClientUi(QWidget *parent)
     : SocketClientUi(parent)
 {
     setWriteToWidgetsVisible(false);
     setMulticastWidgetsVisible(false);
+    setCompressionWidgetsVisible(true);
 }
 
-WebSocketClientUi::~WebSocketClientUi() {}
+WebSocketClientUi::~WebSocketClientUi()
+{
+    delete m_metricsView;
+    delete m_streamView;
+}
 
 Device *WebSocketClientUi::newDevice()
 {
@@ -28,4 +35,24 @@ void WebSocketClientUi::setUiEnabled(bool enabled)
 {
     setServerWidgetsEnabled(enabled);
     setAuthenticationWidgetsEnabled(enabled);
+    setCompressionWidgetsEnabled(enabled);
+    setLowLatencyWidgetsEnabled(enabled);
+}
+
+QList<QWidget *> WebSocketClientUi::deviceControllers()
+{
+    if (!m_streamView) {
+        m_streamView = new WebSocketStreamView(qobject_cast<Socket *>(device()));
+    }
+
+    // Only the compression reports metrics.
+#if defined(X_ENABLE_ZLIB)
+    if (!m_metricsView) {
+        m_metricsView = new DeviceMetricsView(device());
+    }
+
+    return QList<QWidget *>{m_streamView, m_metricsView};
+#else
+    return QList<QWidget *>{m_streamView};
+#endif
 }
@@ -8,9 +8,12 @@
  **************************************************************************************************/
 #include "websocketserver.h"
 
-#include <QWebSocket>
+#include <QFile>
+#include <QTimer>
 
 #include "common/xtools.h"
+#include "utilities/lowlatency.h"
+#include "utilities/websocketconnection.h"
 
 WebSocketServer::WebSocketServer(QObject *parent)
     : SocketServer(parent)
@@ -20,22 +23,49 @@ WebSocketServer::~WebSocketServer() {}
 
 QObject *WebSocketServer::initDevice()
 {
-    m_webSocketServer = new QWebSocketServer(QStringLiteral("WebSocket Server"),
-                                             QWebSocketServer::NonSecureMode);
-    connect(m_webSocketServer, &QWebSocketServer::acceptError, m_webSocketServer, [this]() {
-        emit errorOccurred(m_webSocketServer->errorString());
+    m_scheduler.setLimit(m_queueLimit, static_cast<OutboundQueuePolicy>(m_queuePolicy));
+#if defined(X_ENABLE_ZLIB)
+    m_deflateStatistics.reset();
+#endif
+    m_tcpServer = new QTcpServer();
+    connect(m_tcpServer, &QTcpServer::acceptError, m_tcpServer, [this]() {
+        emit errorOccurred(m_tcpServer->errorString());
     });
-    connect(m_webSocketServer, &QWebSocketServer::newConnection, m_webSocketServer, [this]() {
-        QWebSocket *socket = this->m_webSocketServer->nextPendingConnection();
-        qInfo() << "New connection:" << socket->peerAddress().toString() << socket->peerPort();
+    connect(m_tcpServer, &QTcpServer::newConnection, m_tcpServer, [this]() {
+        while (m_tcpServer->hasPendingConnections()) {
+            QTcpSocket *socket = m_tcpServer->nextPendingConnection();
+            qInfo() << "New connection:" << socket->peerAddress().toString() << socket->peerPort();
 
-        m_sockets.append(socket);
-        this->setupSocket(socket);
+            // The client is added once the opening handshake is done.
+            const QString flag = makeFlag(socket->peerAddress().toString(), socket->peerPort());
+            auto connection = new WebSocketConnection(socket,
+                                                      WebSocketConnection::Role::Server,
+                                                      m_tcpServer);
+#if defined(X_ENABLE_ZLIB)
+            connection->setCompression(m_compression,
+                                       m_contextTakeover,
+                                       m_compressionThreshold,
+                                       &m_deflateStatistics);
+#endif
+            connect(connection, &WebSocketConnection::connected, connection, [=]() {
+                setupConnection(connection, flag);
+            });
+            connect(connection, &WebSocketConnection::disconnected, connection, [=]() {
+                removeConnection(connection, flag);
+            });
+            connect(connection,
+                    &WebSocketConnection::errorOccurred,
+                    connection,
+                    [=](const QString &errorString) {
+                        qInfo() << "WebSocketServer:" << flag << errorString;
+                        removeConnection(connection, flag);
+                    });
+        }
     });
 
-    if (!m_webSocketServer->listen(QHostAddress(m_serverAddress), m_serverPort)) {
-        m_webSocketServer->deleteLater();
-        m_webSocketServer = nullptr;
+    if (!m_tcpServer->listen(QHostAddress(m_serverAddress), m_serverPort)) {
+        m_tcpServer->deleteLater();
+        m_tcpServer = nullptr;
 
         qWarning() << "WebSocketServer: listen failed";
 
@@ -44,96 +74,203 @@ QObject *WebSocketServer::initDevice()
 
     qInfo("Web socket server info:%s:%d", m_serverAddress.toLatin1().data(), m_serverPort);
 
-    return m_webSocketServer;
+    QTimer *queueDepthTimer = new QTimer(m_tcpServer);
+    connect(queueDepthTimer, &QTimer::timeout, queueDepthTimer, [this]() {
+        setClientQueueDepths(m_scheduler.depths());
+    });
+    queueDepthTimer->start(500);
+
+    connect(this, &Socket::invokeWriteFile, m_tcpServer, [this](const QString &fileName) {
+        writeFileActually(fileName);
+    });
+
+    return m_tcpServer;
 }
 
 void WebSocketServer::deinitDevice()
 {
-    if (m_webSocketServer) {
-        m_webSocketServer->close();
-        m_webSocketServer->deleteLater();
-        m_webSocketServer = nullptr;
+    // The connections are children of the server.
+    if (m_tcpServer) {
+        m_tcpServer->close();
+        m_tcpServer->deleteLater();
+        m_tcpServer = nullptr;
     }
+
+    m_connections.clear();
+    m_scheduler.clear();
+    clearClients();
 }
 
 void WebSocketServer::writeActually(const QByteArray &bytes)
 {
+    // A frame is built once for all clients that get the same frame(the same negotiated
+    // compression), the queues of the clients share it. A broadcast costs one encoding however many
+    // clients there are. Only the connections that compress with context takeover build their own
+    // frames, in order, when the message is handed to them. The queues are drained round-robin, a
+    // stalled client only fills its own queue.
     QString currentFlag = currentClientFlag();
-    if (currentFlag.isEmpty()) {
-        for (auto &socket : m_sockets) {
-            writeActually(socket, bytes);
+    QStringList flags = currentFlag.isEmpty() ? m_connections.keys() : QStringList(currentFlag);
+    bool binary = m_channel == static_cast<int>(WebSocketDataChannel::Binary);
+    QHash<int, QByteArray> frames; // frame key -> frame
+    int count = 0;
+    QString lastFlag;
+    for (const QString &flag : flags) {
+        WebSocketConnection *connection = m_connections.value(flag, nullptr);
+        if (!connection) {
+            continue;
         }
-    } else {
-        for (auto &socket : m_sockets) {
-            if (currentFlag == makeFlag(socket->peerAddress().toString(), socket->peerPort())) {
-                writeActually(socket, bytes);
-                break;
+
+        QByteArray item = bytes;
+        const int key = connection->frameKey(bytes.size());
+        if (key >= 0) {
+            auto frame = frames.constFind(key);
+            if (frame == frames.constEnd()) {
+                frame = frames.insert(key, connection->makeFrame(bytes, binary));
             }
+            item = *frame;
+        }
+
+        if (m_scheduler.enqueue(flag, item)) {
+            lastFlag = flag;
+            count++;
+        } else {
+            emit warningOccurred(
+                tr("The outbound queue of %1 is full, the client is disconnected.").arg(flag));
+            connection->abort();
+            removeConnection(connection, flag);
         }
     }
+
+    // A broadcast is reported once, not once per client.
+    if (count == 1) {
+        emit bytesWritten(bytes, lastFlag + (binary ? "[B]" : "[T]"));
+    } else if (count > 1) {
+        emit bytesWritten(bytes, tr("%1 clients").arg(count) + (binary ? "[B]" : "[T]"));
+    }
+
+    drainQueues();
 }
 
-void WebSocketServer::setupSocket(QWebSocket *socket)
+QList<QPair<QString, QString>> WebSocketServer::metrics() const
 {
-    QString flag = makeFlag(socket->peerAddress().toString(), socket->peerPort());
-    addClient(flag);
+#if defined(X_ENABLE_ZLIB)
+    return m_deflateStatistics.metrics();
+#else
+    return QList<QPair<QString, QString>>();
+#endif
+}
 
-    connect(socket, &QWebSocket::disconnected, socket, [=]() { removeClient(flag); });
-    connect(socket, &QWebSocket::disconnected, socket, [=]() { this->m_sockets.removeAll(socket); });
+void WebSocketServer::setupConnection(WebSocketConnection *connection, const QString &flag)
+{
+    m_connections.insert(flag, connection);
+    m_scheduler.addClient(flag);
+    addClient(flag);
+    if (m_lowLatency) {
+        LowLatency::setup(connection->socket());
+    }
 
-    connect(socket, &QWebSocket::textMessageReceived, socket, [=](const QString &message) {
-        onTextMessageReceived(socket, message);
+    connect(connection->socket(), &QTcpSocket::bytesWritten, connection, [=]() {
+        drainQueues(flag);
     });
-    connect(socket, &QWebSocket::binaryMessageReceived, socket, [=](const QByteArray &message) {
-        onBinaryMessageReceived(socket, message);
+    connect(connection,
+            &WebSocketConnection::messageReceived,
+            connection,
+            [=](const QByteArray &message, bool binary) {
+                onMessageReceived(flag, message, binary);
+            });
+    // The parts of a large message are shown as they arrive.
+    connect(connection,
+            &WebSocketConnection::partReceived,
+            connection,
+            [=](const QByteArray &part, bool binary) { onMessageReceived(flag, part, binary); });
+    connect(connection, &WebSocketConnection::streamPartWritten, connection, [=](qint64 bytes) {
+        emit streamProgressChanged(flag, bytes, false);
     });
-
-    connect(socket, xWebSocketErrorOccurred, socket, [=]() {
-        this->m_sockets.removeAll(socket);
-        this->removeClient(flag);
+    // The queued messages wait for the end of a stream.
+    connect(connection, &WebSocketConnection::streamFinished, connection, [=](qint64 bytes) {
+        emit streamProgressChanged(flag, bytes, true);
+        drainQueues(flag);
     });
 }
 
-void WebSocketServer::writeActually(QWebSocket *socket, const QByteArray &bytes)
+void WebSocketServer::removeConnection(WebSocketConnection *connection, const QString &flag)
 {
-    const QString flag = makeFlag(socket->peerAddress().toString(), socket->peerPort());
-    if (m_channel == static_cast<int>(WebSocketDataChannel::Binary)) {
-        if (socket->sendBinaryMessage(bytes) == bytes.size()) {
-            emit bytesWritten(bytes, flag + "[B]");
-        } else {
-            qInfo() << "WebSocketServer: sendBinaryMessage failed:" << socket->errorString();
-        }
-    } else if (m_channel == static_cast<int>(WebSocketDataChannel::Text)) {
-        if (socket->sendTextMessage(QString::fromUtf8(bytes)) == bytes.size()) {
-            emit bytesWritten(bytes, flag + "[T]");
-        } else {
-            qInfo() << "WebSocketServer: sendTextMessage failed:" << socket->errorString();
-        }
+    // Both errorOccurred and disconnected may be emitted for the same connection, a connection may
+    // fail before its handshake is done.
+    connection->deleteLater();
+    if (m_connections.value(flag, nullptr) != connection) {
+        return;
     }
+
+    m_connections.remove(flag);
+    m_scheduler.removeClient(flag);
+    removeClient(flag);
 }
 
-void WebSocketServer::onTextMessageReceived(QWebSocket *socket, const QString &message)
+void WebSocketServer::drainQueues(const QString &flag)
 {
-    const QString socketFlag = makeFlag(socket->peerAddress().toString(), socket->peerPort());
-    const QString currentFlag = currentClientFlag();
-    if (currentFlag.isEmpty()) {
-        emit bytesRead(message.toUtf8(), socketFlag + "[T]");
-    } else {
-        if (currentFlag == socketFlag) {
-            emit bytesRead(message.toUtf8(), socketFlag + "[T]");
+    // A socket takes the next frame only when most of the previous ones have been written to the
+    // network, otherwise the socket would buffer without limit again.
+    const qint64 highWaterMark = 64 * 1024;
+    const bool binary = m_channel == static_cast<int>(WebSocketDataChannel::Binary);
+    auto isWritable = [this, highWaterMark](const QString &client) {
+        WebSocketConnection *connection = m_connections.value(client, nullptr);
+        return connection && !connection->isStreaming()
+               && connection->socket()->bytesToWrite() < highWaterMark;
+    };
+    auto write = [this, binary](const QString &client, const QByteArray &item) {
+        WebSocketConnection *connection = m_connections.value(client, nullptr);
+        if (!connection) {
+            return;
+        }
+
+        qint64 ret = connection->buildsFramesInOrder() ? connection->writeMessage(item, binary)
+                                                       : connection->writeFrame(item);
+        if (ret < 0) {
+            qInfo() << "WebSocketServer: write failed:" << connection->socket()->errorString();
         }
+        if (m_lowLatency) {
+            connection->socket()->flush();
+        }
+    };
+
+    // A socket that has written bytes only needs its own queue to be drained, a broadcast needs a
+    // full round-robin pass.
+    if (flag.isEmpty()) {
+        m_scheduler.drain(isWritable, write);
+    } else {
+        m_scheduler.drainClient(flag, isWritable, write);
     }
 }
 
-void WebSocketServer::onBinaryMessageReceived(QWebSocket *socket, const QByteArray &message)
+void WebSocketServer::writeFileActually(const QString &fileName)
 {
+    // Every client reads the file on its own, the clients stream at their own pace.
     QString currentFlag = currentClientFlag();
-    if (currentFlag.isEmpty()) {
-        QString flag = makeFlag(m_serverAddress, m_serverPort);
-        emit bytesRead(message, flag + "[B]");
-    } else {
-        if (currentFlag == makeFlag(socket->peerAddress().toString(), socket->peerPort())) {
-            emit bytesRead(message, currentFlag + "[B]");
+    QStringList flags = currentFlag.isEmpty() ? m_connections.keys() : QStringList(currentFlag);
+    bool binary = m_channel == static_cast<int>(WebSocketDataChannel::Binary);
+    for (const QString &flag : flags) {
+        WebSocketConnection *connection = m_connections.value(flag, nullptr);
+        if (!connection) {
+            continue;
+        }
+
+        QFile *file = new QFile(fileName);
+        if (!file->open(QFile::ReadOnly)) {
+            emit warningOccurred(tr("Failed to open %1: %2").arg(fileName, file->errorString()));
+            delete file;
+            return;
+        }
+        if (!connection->writeStream(file, binary)) {
+            emit warningOccurred(tr("A file is being sent to %1.").arg(flag));
         }
     }
 }
+
+void WebSocketServer::onMessageReceived(const QString &flag, const QByteArray &message, bool binary)
+{
+    const QString currentFlag = currentClientFlag();
+    if (currentFlag.isEmpty() || currentFlag == flag) {
+        emit bytesRead(message, flag + (binary ? "[B]" : "[T]"));
+    }
+}
@@ -8,10 +8,13 @@
  **************************************************************************************************/
 #pragma once
 
-#include <QWebSocketServer>
+#include <QHash>
+#include <QTcpServer>
 
 #include "socketserver.h"
+#include "utilities/outboundqueue.h"
 
+class WebSocketConnection;
 class WebSocketServer : public SocketServer
 {
     Q_OBJECT
@@ -22,15 +25,19 @@ public:
     QObject *initDevice() override;
     void deinitDevice() override;
     void writeActually(const QByteArray &bytes) override;
+    QList<QPair<QString, QString>> metrics() const override;
 
 private:
-    QWebSocketServer *m_webSocketServer{nullptr};
-    QList<QWebSocket *> m_sockets;
+    QTcpServer *m_tcpServer{nullptr};
+    QHash<QString, WebSocketConnection *> m_connections; // flag -> connection
+    // The encoded frames, or the messages of the connections that build their frames in order.
+    OutboundScheduler m_scheduler;
 
 private:
-    void setupSocket(QWebSocket *socket);
-    void writeActually(QWebSocket *socket, const QByteArray &bytes);
-
-    void onTextMessageReceived(QWebSocket *socket, const QString &message);
-    void onBinaryMessageReceived(QWebSocket *socket, const QByteArray &message);
+    void setupConnection(WebSocketConnection *connection, const QString &flag);
+    void removeConnection(WebSocketConnection *connection, const QString &flag);
+    // All queues, or the queue of the client with the given flag only.
+    void drainQueues(const QString &flag = QString());
+    void writeFileActually(const QString &fileName);
+    void onMessageReceived(const QString &flag, const QByteArray &message, bool binary);
 };
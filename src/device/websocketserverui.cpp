@@ -8,16 +8,24 @@
  **************************************************************************************************/
 #include "websocketserverui.h"
 
+#include "devicemetricsview.h"
 #include "websocketserver.h"
+#include "websocketstreamview.h"
 
 WebSocketServerUi::WebSocketServerUi(QWidget *parent)
     : SocketServerUi(parent)
 {
     setAuthenticationWidgetsVisible(false);
     setMulticastWidgetsVisible(false);
+    setCompressionWidgetsVisible(true);
+    setQueueWidgetsVisible(true);
 }
 
-WebSocketServerUi::~WebSocketServerUi() {}
+WebSocketServerUi::~WebSocketServerUi()
+{
+    delete m_metricsView;
+    delete m_streamView;
+}
 
 Device *WebSocketServerUi::newDevice()
 {
@@ -29,4 +37,25 @@ Device *WebSocketServerUi::newDevice()
 void WebSocketServerUi::setUiEnabled(bool enabled)
 {
     setServerWidgetsEnabled(enabled);
+    setQueueWidgetsEnabled(enabled);
+    setCompressionWidgetsEnabled(enabled);
+    setLowLatencyWidgetsEnabled(enabled);
+}
+
+QList<QWidget *> WebSocketServerUi::deviceControllers()
+{
+    if (!m_streamView) {
+        m_streamView = new WebSocketStreamView(qobject_cast<Socket *>(device()));
+    }
+
+    // Only the compression reports metrics.
+#if defined(X_ENABLE_ZLIB)
+    if (!m_metricsView) {
+        m_metricsView = new DeviceMetricsView(device());
+    }
+
+    return QList<QWidget *>{m_streamView, m_metricsView};
+#else
+    return QList<QWidget *>{m_streamView};
+#endif
 }
@@ -10,6 +10,8 @@
 
 #include "socketserverui.h"
 
+class DeviceMetricsView;
+class WebSocketStreamView;
 class WebSocketServerUi : public SocketServerUi
 {
     Q_OBJECT
@@ -19,4 +21,9 @@ public:
 
     Device *newDevice() override;
     void setUiEnabled(bool enabled) override;
+    QList<QWidget *> deviceControllers() override;
+
+private:
+    DeviceMetricsView *m_metricsView{nullptr};
+    WebSocketStreamView *m_streamView{nullptr};
 };
@@ -0,0 +1,75 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "websocketstreamview.h"
+
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLocale>
+#include <QProgressBar>
+#include <QPushButton>
+
+#include "socket.h"
+
+WebSocketStreamView::WebSocketStreamView(Socket *socket, QWidget *parent)
+    : QWidget(parent)
+    , m_socket(socket)
+{
+    QPushButton *sendButton = new QPushButton(tr("Send File"), this);
+    sendButton->setToolTip(tr("The file is sent as one message of any size, in frames of 1 MiB."));
+    m_progressBar = new QProgressBar(this);
+    m_progressBar->setValue(0);
+    m_label = new QLabel(QString("-"), this);
+
+    QHBoxLayout *layout = new QHBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(sendButton);
+    layout->addWidget(m_progressBar, 1);
+    layout->addWidget(m_label);
+
+    connect(sendButton, &QPushButton::clicked, this, &WebSocketStreamView::onSendButtonClicked);
+    connect(m_socket,
+            &Socket::streamProgressChanged,
+            this,
+            &WebSocketStreamView::onStreamProgressChanged);
+}
+
+WebSocketStreamView::~WebSocketStreamView() {}
+
+void WebSocketStreamView::onSendButtonClicked()
+{
+    if (!m_socket->isRunning()) {
+        m_label->setText(tr("The device is not opened."));
+        return;
+    }
+
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Select File"));
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    m_fileSize = QFileInfo(fileName).size();
+    m_progressBar->setValue(0);
+    m_label->setText(QFileInfo(fileName).fileName());
+    m_socket->writeFile(fileName);
+}
+
+void WebSocketStreamView::onStreamProgressChanged(const QString &to, qint64 bytes, bool finished)
+{
+    // The server reports every client, the progress bar follows the one reported last.
+    int const percent = m_fileSize > 0 ? static_cast<int>(bytes * 100 / m_fileSize) : 100;
+    m_progressBar->setValue(finished ? 100 : qMin(percent, 100));
+    QString size = QLocale().formattedDataSize(bytes);
+    if (finished) {
+        m_label->setText(tr("%1 sent to %2").arg(size, to));
+    } else {
+        m_label->setText(QString("%1, %2").arg(to, size));
+    }
+}
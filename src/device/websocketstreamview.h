@@ -0,0 +1,32 @@
+﻿/***************************************************************************************************
+ * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QWidget>
+
+class QLabel;
+class QProgressBar;
+class Socket;
+class WebSocketStreamView : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit WebSocketStreamView(Socket *socket, QWidget *parent = nullptr);
+    ~WebSocketStreamView() override;
+
+private:
+    Socket *m_socket;
+    QProgressBar *m_progressBar;
+    QLabel *m_label;
+    qint64 m_fileSize{0};
+
+private:
+    void onSendButtonClicked();
+    void onStreamProgressChanged(const QString &to, qint64 bytes, bool finished);
+};
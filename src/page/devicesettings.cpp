@@ -34,6 +34,7 @@ DeviceSettings::DeviceSettings(QWidget *parent)
 {
     ui->setupUi(this);
     setupTextFormat(ui->comboBoxSaveTextFormat);
+    ui->comboBoxSaveTextFormat->addItem(tr("Capture"), SaveThread::captureFormat);
     ui->comboBoxMaxBytes->addItem("16K", 16);
     ui->comboBoxMaxBytes->addItem("32K", 32);
     ui->comboBoxMaxBytes->addItem("64K", 64);
@@ -0,0 +1,213 @@
+﻿/***************************************************************************************************
+ * Copyright 2025-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "filetransferview.h"
+#include "ui_filetransferview.h"
+
+#include <QFileDialog>
+#include <QFileInfo>
+
+#include "common/xtools.h"
+#include "device/device.h"
+#include "device/utilities/filetransfer.h"
+
+struct FileTransferViewKeys
+{
+    const QString protocol{"protocol"};
+    const QString fileNames{"fileNames"};
+    const QString resume{"resume"};
+};
+
+FileTransferView::FileTransferView(QWidget *parent)
+    : QWidget(parent)
+    , ui(new Ui::FileTransferView)
+{
+    ui->setupUi(this);
+    for (int protocol : FileTransfer::supportedProtocols()) {
+        ui->comboBoxProtocol->addItem(FileTransfer::protocolName(protocol), protocol);
+    }
+
+    connect(ui->pushButtonAdd, &QPushButton::clicked, this, &FileTransferView::onAddButtonClicked);
+    connect(ui->pushButtonRemove, &QPushButton::clicked, this, [=]() {
+        delete ui->listWidgetFiles->currentItem();
+    });
+    connect(ui->pushButtonClear, &QPushButton::clicked, ui->listWidgetFiles, &QListWidget::clear);
+    connect(ui->pushButtonSend, &QPushButton::clicked, this, &FileTransferView::onSendButtonClicked);
+    connect(ui->pushButtonCancel,
+            &QPushButton::clicked,
+            this,
+            &FileTransferView::onCancelButtonClicked);
+
+    setRunning(false);
+}
+
+FileTransferView::~FileTransferView()
+{
+    delete ui;
+}
+
+void FileTransferView::setDevice(Device *device)
+{
+    m_device = device;
+    connect(device, &Device::closed, this, [=]() {
+        if (m_running) {
+            onFinished(false, tr("The device is closed."), 0, 0);
+        }
+    });
+}
+
+QVariantMap FileTransferView::save() const
+{
+    QStringList fileNames;
+    for (int i = 0; i < ui->listWidgetFiles->count(); ++i) {
+        fileNames.append(ui->listWidgetFiles->item(i)->text());
+    }
+
+    FileTransferViewKeys keys;
+    QVariantMap map;
+    map[keys.protocol] = ui->comboBoxProtocol->currentData().toInt();
+    map[keys.fileNames] = fileNames;
+    map[keys.resume] = ui->checkBoxResume->isChecked();
+    return map;
+}
+
+void FileTransferView::load(const QVariantMap &data)
+{
+    if (data.isEmpty()) {
+        return;
+    }
+
+    FileTransferViewKeys keys;
+    int protocol = data.value(keys.protocol).toInt();
+    QStringList fileNames = data.value(keys.fileNames).toStringList();
+    bool resume = data.value(keys.resume).toBool();
+
+    int index = ui->comboBoxProtocol->findData(protocol);
+    ui->comboBoxProtocol->setCurrentIndex(index < 0 ? 0 : index);
+    ui->listWidgetFiles->clear();
+    ui->listWidgetFiles->addItems(fileNames);
+    ui->checkBoxResume->setChecked(resume);
+}
+
+void FileTransferView::onAddButtonClicked()
+{
+    QStringList fileNames = QFileDialog::getOpenFileNames(this, tr("Select Files"));
+    ui->listWidgetFiles->addItems(fileNames);
+}
+
+void FileTransferView::onSendButtonClicked()
+{
+    if (!m_device || !m_device->isRunning()) {
+        ui->labelInfo->setText(tr("The device is not opened."));
+        return;
+    }
+
+    QStringList fileNames;
+    for (int i = 0; i < ui->listWidgetFiles->count(); ++i) {
+        fileNames.append(ui->listWidgetFiles->item(i)->text());
+    }
+    if (fileNames.isEmpty()) {
+        ui->labelInfo->setText(tr("No file to send."));
+        return;
+    }
+
+    // The transfer runs in the device thread, the bytes are written and read without a round trip
+    // through the ui thread. It is deleted when it is finished or when the device is closed.
+    FileTransfer *transfer = new FileTransfer();
+    transfer->moveToThread(m_device);
+    connect(transfer, &FileTransfer::outputBytes, m_device, &Device::writeBytes, Qt::DirectConnection);
+    connect(m_device, &Device::bytesRead, transfer, &FileTransfer::inputBytes);
+    connect(m_device, &QThread::finished, transfer, &QObject::deleteLater);
+    connect(this, &FileTransferView::invokeStart, transfer, &FileTransfer::start);
+    connect(this, &FileTransferView::invokeCancel, transfer, &FileTransfer::cancel);
+    connect(transfer, &FileTransfer::progressChanged, this, &FileTransferView::onProgressChanged);
+    connect(transfer, &FileTransfer::finished, this, &FileTransferView::onFinished);
+    connect(transfer, &FileTransfer::finished, transfer, &QObject::deleteLater);
+    m_transfer = transfer;
+    m_linkRate = linkRate();
+
+    int protocol = ui->comboBoxProtocol->currentData().toInt();
+    bool resume = ui->checkBoxResume->isChecked();
+    emit invokeStart(protocol, fileNames, resume);
+
+    ui->progressBar->setValue(0);
+    ui->labelInfo->setText(tr("Waiting for the receiver..."));
+    setRunning(true);
+}
+
+void FileTransferView::onCancelButtonClicked()
+{
+    emit invokeCancel();
+}
+
+void FileTransferView::onProgressChanged(
+    const QString &fileName, qint64 position, qint64 size, qint64 transferred, qint64 elapsed)
+{
+    ui->progressBar->setValue(size > 0 ? static_cast<int>(position * 100 / size) : 100);
+    ui->labelInfo->setText(QString("%1, %2")
+                               .arg(QFileInfo(fileName).fileName(), throughput(transferred, elapsed)));
+}
+
+void FileTransferView::onFinished(bool succeeded,
+                                  const QString &message,
+                                  qint64 transferred,
+                                  qint64 elapsed)
+{
+    m_transfer = nullptr;
+    if (succeeded) {
+        ui->progressBar->setValue(100);
+    }
+
+    QString info = message;
+    if (transferred > 0) {
+        info += QString(" ") + throughput(transferred, elapsed);
+    }
+    ui->labelInfo->setText(info);
+    setRunning(false);
+}
+
+void FileTransferView::setRunning(bool running)
+{
+    m_running = running;
+    ui->pushButtonSend->setEnabled(!running);
+    ui->pushButtonCancel->setEnabled(running);
+    ui->comboBoxProtocol->setEnabled(!running);
+    ui->checkBoxResume->setEnabled(!running);
+    ui->listWidgetFiles->setEnabled(!running);
+    ui->pushButtonAdd->setEnabled(!running);
+    ui->pushButtonRemove->setEnabled(!running);
+    ui->pushButtonClear->setEnabled(!running);
+}
+
+QString FileTransferView::throughput(qint64 transferred, qint64 elapsed) const
+{
+    qint64 const rate = elapsed > 0 ? transferred * 1000 / elapsed : 0;
+    QString text = tr("%1 bytes, %2B/s").arg(transferred).arg(rate);
+    if (m_linkRate > 0) {
+        text += QString(" ") + tr("(%1% of the link rate)").arg(rate * 100 / m_linkRate);
+    }
+
+    return text;
+}
+
+qint64 FileTransferView::linkRate() const
+{
+    // Only a serial port has a known link rate, the bytes per second of its baud rate.
+    QVariantMap parameters = m_device->save();
+    SerialPortItemKeys keys;
+    if (!parameters.contains(keys.baudRate)) {
+        return 0;
+    }
+
+    int baudRate = parameters.value(keys.baudRate).toInt();
+    int dataBits = parameters.value(keys.dataBits, 8).toInt();
+    int parity = parameters.value(keys.parity, 0).toInt();
+    int stopBits = parameters.value(keys.stopBits, 1).toInt();
+    int bits = 1 + dataBits + (parity != 0 ? 1 : 0) + (stopBits == 2 ? 2 : 1);
+    return baudRate / bits;
+}
@@ -0,0 +1,53 @@
+﻿/***************************************************************************************************
+ * Copyright 2025-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QPointer>
+#include <QVariantMap>
+#include <QWidget>
+
+namespace Ui {
+class FileTransferView;
+}
+
+class Device;
+class FileTransfer;
+class FileTransferView : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit FileTransferView(QWidget *parent = nullptr);
+    ~FileTransferView() override;
+
+    void setDevice(Device *device);
+    QVariantMap save() const;
+    void load(const QVariantMap &data);
+
+signals:
+    void invokeStart(int protocol, const QStringList &fileNames, bool resume);
+    void invokeCancel();
+
+private:
+    Ui::FileTransferView *ui;
+    QPointer<Device> m_device;
+    QPointer<FileTransfer> m_transfer;
+    qint64 m_linkRate{0}; // bytes per second, 0 means unknown
+    bool m_running{false};
+
+private:
+    void onAddButtonClicked();
+    void onSendButtonClicked();
+    void onCancelButtonClicked();
+    void onProgressChanged(const QString &fileName, qint64 position, qint64 size,
+                           qint64 transferred, qint64 elapsed);
+    void onFinished(bool succeeded, const QString &message, qint64 transferred, qint64 elapsed);
+    void setRunning(bool running);
+    QString throughput(qint64 transferred, qint64 elapsed) const;
+    qint64 linkRate() const;
+};
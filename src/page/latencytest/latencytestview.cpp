@@ -0,0 +1,167 @@
+﻿/***************************************************************************************************
+ * Copyright 2025-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "latencytestview.h"
+#include "ui_latencytestview.h"
+
+#include "common/xtools.h"
+#include "device/device.h"
+#include "device/utilities/latencytest.h"
+
+struct LatencyTestViewKeys
+{
+    const QString count{"count"};
+    const QString payloadSize{"payloadSize"};
+    const QString timeout{"timeout"};
+};
+
+LatencyTestView::LatencyTestView(QWidget *parent)
+    : QWidget(parent)
+    , ui(new Ui::LatencyTestView)
+{
+    ui->setupUi(this);
+    ui->tableWidget->setColumnCount(7);
+    ui->tableWidget->setHorizontalHeaderLabels(QStringList() << tr("Profile") << tr("Received")
+                                                             << tr("Lost") << tr("p50(us)")
+                                                             << tr("p99(us)") << tr("Min(us)")
+                                                             << tr("Max(us)"));
+
+    connect(ui->pushButtonStart, &QPushButton::clicked, this, &LatencyTestView::onStartButtonClicked);
+    connect(ui->pushButtonCancel, &QPushButton::clicked, this, &LatencyTestView::invokeCancel);
+    connect(ui->pushButtonClear, &QPushButton::clicked, this, [=]() {
+        ui->tableWidget->setRowCount(0);
+    });
+
+    setRunning(false);
+}
+
+LatencyTestView::~LatencyTestView()
+{
+    delete ui;
+}
+
+void LatencyTestView::setDevice(Device *device)
+{
+    m_device = device;
+    connect(device, &Device::closed, this, [=]() {
+        if (m_running) {
+            ui->labelInfo->setText(tr("The device is closed."));
+            m_test = nullptr;
+            setRunning(false);
+        }
+    });
+}
+
+QVariantMap LatencyTestView::save() const
+{
+    LatencyTestViewKeys keys;
+    QVariantMap map;
+    map[keys.count] = ui->spinBoxCount->value();
+    map[keys.payloadSize] = ui->spinBoxPayloadSize->value();
+    map[keys.timeout] = ui->spinBoxTimeout->value();
+    return map;
+}
+
+void LatencyTestView::load(const QVariantMap &data)
+{
+    if (data.isEmpty()) {
+        return;
+    }
+
+    LatencyTestViewKeys keys;
+    ui->spinBoxCount->setValue(data.value(keys.count).toInt());
+    ui->spinBoxPayloadSize->setValue(data.value(keys.payloadSize).toInt());
+    ui->spinBoxTimeout->setValue(data.value(keys.timeout).toInt());
+}
+
+void LatencyTestView::onStartButtonClicked()
+{
+    if (!m_device || !m_device->isRunning()) {
+        ui->labelInfo->setText(tr("The device is not opened."));
+        return;
+    }
+
+    // The probes are written and matched in the device thread, the ui thread is not part of the
+    // round trip. The test is deleted when it is finished or when the device is closed.
+    LatencyTest *test = new LatencyTest();
+    test->moveToThread(m_device);
+    connect(test, &LatencyTest::outputBytes, m_device, &Device::writeBytes, Qt::DirectConnection);
+    connect(m_device, &Device::bytesRead, test, &LatencyTest::inputBytes);
+    connect(m_device, &QThread::finished, test, &QObject::deleteLater);
+    connect(this, &LatencyTestView::invokeStart, test, &LatencyTest::start);
+    connect(this, &LatencyTestView::invokeCancel, test, &LatencyTest::cancel);
+    connect(test, &LatencyTest::progressChanged, this, &LatencyTestView::onProgressChanged);
+    connect(test, &LatencyTest::finished, this, &LatencyTestView::onFinished);
+    connect(test, &LatencyTest::finished, test, &QObject::deleteLater);
+    m_test = test;
+    m_profile = profile();
+
+    emit invokeStart(ui->spinBoxCount->value(),
+                     ui->spinBoxPayloadSize->value(),
+                     ui->spinBoxTimeout->value());
+
+    ui->progressBar->setValue(0);
+    ui->labelInfo->setText(tr("Waiting for the echoes..."));
+    setRunning(true);
+}
+
+void LatencyTestView::onProgressChanged(int done, int total)
+{
+    ui->progressBar->setValue(total > 0 ? done * 100 / total : 100);
+}
+
+void LatencyTestView::onFinished(bool succeeded,
+                                 const QString &message,
+                                 int received,
+                                 int lost,
+                                 qint64 p50,
+                                 qint64 p99,
+                                 qint64 min,
+                                 qint64 max)
+{
+    m_test = nullptr;
+    ui->labelInfo->setText(message);
+    setRunning(false);
+    if (!succeeded || received == 0) {
+        return;
+    }
+
+    // Every run is kept as a row, so runs with and without the low latency profile can be
+    // compared side by side.
+    auto us = [](qint64 ns) { return QString::number(ns / 1000.0, 'f', 1); };
+    QStringList cells;
+    cells << m_profile << QString::number(received) << QString::number(lost) << us(p50) << us(p99)
+          << us(min) << us(max);
+    int row = ui->tableWidget->rowCount();
+    ui->tableWidget->insertRow(row);
+    for (int column = 0; column < cells.size(); ++column) {
+        ui->tableWidget->setItem(row, column, new QTableWidgetItem(cells.at(column)));
+    }
+    ui->tableWidget->scrollToBottom();
+}
+
+void LatencyTestView::setRunning(bool running)
+{
+    m_running = running;
+    ui->pushButtonStart->setEnabled(!running);
+    ui->pushButtonCancel->setEnabled(running);
+    ui->spinBoxCount->setEnabled(!running);
+    ui->spinBoxPayloadSize->setEnabled(!running);
+    ui->spinBoxTimeout->setEnabled(!running);
+}
+
+QString LatencyTestView::profile() const
+{
+    QVariantMap parameters = m_device->save();
+    SocketItemKeys keys;
+    if (!parameters.contains(keys.lowLatency)) {
+        return tr("Default");
+    }
+
+    return parameters.value(keys.lowLatency).toBool() ? tr("Low latency") : tr("Default");
+}
@@ -0,0 +1,50 @@
+﻿/***************************************************************************************************
+ * Copyright 2025-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of eTools project.
+ *
+ * eTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QPointer>
+#include <QVariantMap>
+#include <QWidget>
+
+namespace Ui {
+class LatencyTestView;
+}
+
+class Device;
+class LatencyTest;
+class LatencyTestView : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit LatencyTestView(QWidget *parent = nullptr);
+    ~LatencyTestView() override;
+
+    void setDevice(Device *device);
+    QVariantMap save() const;
+    void load(const QVariantMap &data);
+
+signals:
+    void invokeStart(int count, int payloadSize, int timeout);
+    void invokeCancel();
+
+private:
+    Ui::LatencyTestView *ui;
+    QPointer<Device> m_device;
+    QPointer<LatencyTest> m_test;
+    QString m_profile;
+    bool m_running{false};
+
+private:
+    void onStartButtonClicked();
+    void onProgressChanged(int done, int total);
+    void onFinished(bool succeeded, const QString &message, int received, int lost, qint64 p50,
+                    qint64 p99, qint64 min, qint64 max);
+    void setRunning(bool running);
+    QString profile() const;
+};
@@ -1,4 +1,4 @@
-/***************************************************************************************************
+﻿/***************************************************************************************************
  * Copyright 2024-2025 x-tools-author(x-tools@outlook.com). All rights reserved.
  *
  * The file is encoded using "utf8 with bom", it is a part of eTools project.
@@ -17,24 +17,38 @@
 #include "device/chartstestui.h"
 #include "device/device.h"
 #include "device/deviceui.h"
+#include "device/generatorui.h"
 #include "device/localserverui.h"
 #include "device/localsocketui.h"
+#include "device/replayui.h"
 #include "device/tcpclientui.h"
 #include "device/tcpserverui.h"
 #include "device/udpclientui.h"
 #include "device/udpserverui.h"
 #include "devicesettings.h"
 #include "emitter/emitterview.h"
+#include "page/filetransfer/filetransferview.h"
+#include "page/latencytest/latencytestview.h"
 #include "page/preset/presetview.h"
 #include "page/responder/responderview.h"
 
 #ifdef X_ENABLE_SERIAL_PORT
+#include "device/serialportsnifferui.h"
 #include "device/serialportui.h"
 #endif
 #ifdef X_ENABLE_WEB_SOCKET
 #include "device/websocketclientui.h"
 #include "device/websocketserverui.h"
 #endif
+#ifdef X_ENABLE_LINUX_NATIVE
+#include "device/multicastreceiverui.h"
+#include "device/sharedmemoryui.h"
+#include "device/tcpproxyui.h"
+#endif
+#ifdef X_ENABLE_SSL
+#include "device/ssltcpclientui.h"
+#include "device/ssltcpserverui.h"
+#endif
 
 #ifdef X_ENABLE_BLUETOOTH
 #include "device/blecentralui.h"
@@ -77,6 +91,8 @@ struct ParameterKeys
     const QString emitterItems{"emitterItems"};
     const QString responserItems{"responserItems"};
     const QString transfers{"transfers"};
+    const QString fileTransfer{"fileTransfer"};
+    const QString latencyTest{"latencyTest"};
 
     const QString chartsItems{"chartsItems"};
 } g_keys;
@@ -183,6 +199,8 @@ QVariantMap Page::save()
     if (ui->tabTransfers->isEnabled()) {
         map.insert(g_keys.transfers, ui->tabTransfers->save());
     }
+    map.insert(g_keys.fileTransfer, ui->tabFileTransfer->save());
+    map.insert(g_keys.latencyTest, ui->tabLatencyTest->save());
 
 #ifdef X_ENABLE_CHARTS
     map.insert(g_keys.chartsItems, m_chartsView->save());
@@ -249,6 +267,8 @@ void Page::load(const QVariantMap &parameters)
     ui->tabEmitter->load(parameters.value(g_keys.emitterItems).toMap());
     ui->tabResponder->load(parameters.value(g_keys.responserItems).toMap());
     ui->tabTransfers->load(parameters.value(g_keys.transfers).toMap());
+    ui->tabFileTransfer->load(parameters.value(g_keys.fileTransfer).toMap());
+    ui->tabLatencyTest->load(parameters.value(g_keys.latencyTest).toMap());
 
     onDeviceTypeChanged();
     onInputFormatChanged();
@@ -588,6 +608,8 @@ void Page::setupDevice(Device *device)
     connect(ui->tabPreset, &PresetView::outputBytes, device, &Device::writeBytes);
     connect(ui->tabEmitter, &EmitterView::outputBytes, device, &Device::writeBytes);
     connect(ui->tabResponder, &ResponderView::outputBytes, device, &Device::writeBytes);
+    ui->tabFileTransfer->setDevice(device);
+    ui->tabLatencyTest->setDevice(device);
 }
 
 void Page::writeBytes()
@@ -817,6 +839,8 @@ DeviceUi *Page::newDeviceUi(int type)
 #ifdef X_ENABLE_SERIAL_PORT
     case static_cast<int>(DeviceType::SerialPort):
         return new SerialPortUi();
+    case static_cast<int>(DeviceType::SerialPortSniffer):
+        return new SerialPortSnifferUi();
 #endif
 #ifdef X_ENABLE_BLUETOOTH
     case static_cast<int>(DeviceType::BleCentral):
@@ -830,6 +854,20 @@ DeviceUi *Page::newDeviceUi(int type)
         return new TcpClientUi();
     case static_cast<int>(DeviceType::TcpServer):
         return new TcpServerUi();
+#ifdef X_ENABLE_SSL
+    case static_cast<int>(DeviceType::SslTcpClient):
+        return new SslTcpClientUi();
+    case static_cast<int>(DeviceType::SslTcpServer):
+        return new SslTcpServerUi();
+#endif
+#ifdef X_ENABLE_LINUX_NATIVE
+    case static_cast<int>(DeviceType::TcpProxy):
+        return new TcpProxyUi();
+    case static_cast<int>(DeviceType::MulticastReceiver):
+        return new MulticastReceiverUi();
+    case static_cast<int>(DeviceType::SharedMemory):
+        return new SharedMemoryUi();
+#endif
 #ifdef X_ENABLE_WEB_SOCKET
     case static_cast<int>(DeviceType::WebSocketClient):
         return new WebSocketClientUi();
@@ -840,6 +878,10 @@ DeviceUi *Page::newDeviceUi(int type)
         return new LocalSocketUi();
     case static_cast<int>(DeviceType::LocalServer):
         return new LocalServerUi();
+    case static_cast<int>(DeviceType::Replay):
+        return new ReplayUi();
+    case static_cast<int>(DeviceType::Generator):
+        return new GeneratorUi();
 #ifdef X_ENABLE_CHARTS
     case static_cast<int>(DeviceType::ChartsTest):
         return new ChartsTestUi();
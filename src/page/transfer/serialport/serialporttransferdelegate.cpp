@@ -13,6 +13,7 @@
 #include <QLineEdit>
 
 #include "common/xtools.h"
+#include "device/utilities/serialportscanner.h"
 
 SerialPortTransferDelegate::SerialPortTransferDelegate(QObject *parent)
     : QStyledItemDelegate(parent)
@@ -51,7 +52,7 @@ void SerialPortTransferDelegate::setEditorData(QWidget *editor, const QModelInde
             setupTransferType(cb);
         } else if (column == 1) {
             cb = qobject_cast<QComboBox *>(editor);
-            setupPortName(cb);
+            cb->addItems(SerialPortScanner::instance()->portNames());
         } else if (column == 2) {
             cb = qobject_cast<QComboBox *>(editor);
             setupBaudRate(cb);
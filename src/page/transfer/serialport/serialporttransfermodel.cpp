@@ -23,7 +23,7 @@ QVariantMap SerialPortTransferModel::saveRow(const int row)
         return {};
     }
 
-    SerialPortItem item;
+    SerialPortItem item = defaultSerialPortItem();
     item.portName = data(index(row, 1), Qt::EditRole).toString();
     item.baudRate = data(index(row, 2), Qt::EditRole).toInt();
     item.dataBits = data(index(row, 3), Qt::EditRole).toInt();
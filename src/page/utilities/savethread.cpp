@@ -16,10 +16,14 @@
 #include <QTimer>
 
 #include "common/xtools.h"
+#include "device/utilities/capturefile.h"
 
 SaveThread::SaveThread(QObject *parent)
     : QThread(parent)
-{}
+    , m_startTime(QDateTime::currentMSecsSinceEpoch())
+{
+    m_elapsedTimer.start();
+}
 
 SaveThread::~SaveThread()
 {
@@ -34,13 +38,15 @@ void SaveThread::saveData(const SaveParameters &parameters, const QByteArray &da
     ctx.parameters = parameters;
     ctx.data = data;
     ctx.isRx = isRx;
+    ctx.timestamp = m_startTime * 1000 + m_elapsedTimer.nsecsElapsed() / 1000;
     m_ctxList.append(ctx);
     m_ctxListMutex.unlock();
 }
 
 void saveDataToFile(const SaveThread::SaveContext &ctx, QFile *file)
 {
-    QDateTime now = QDateTime::currentDateTime();
+    // The data is written up to a second after it has been handed over.
+    QDateTime now = QDateTime::fromMSecsSinceEpoch(ctx.timestamp / 1000);
     QString dateFmt = QLocale().dateFormat();
     QString timeFmt = QLocale().timeFormat(QLocale::ShortFormat);
 
@@ -68,6 +74,19 @@ void saveDataToFile(const SaveThread::SaveContext &ctx, QFile *file)
     stream << line << "\n";
 }
 
+void saveCaptureToFile(const SaveThread::SaveContext &ctx, QFile *file)
+{
+    if (file->size() == 0) {
+        file->write(CaptureFile::magic());
+    }
+
+    CaptureFile::Record record;
+    record.timestamp = ctx.timestamp;
+    record.isRx = ctx.isRx;
+    record.bytes = ctx.data;
+    file->write(CaptureFile::encodeRecord(record));
+}
+
 void renameFile(const QString &oldName)
 {
     QFileInfo info(oldName);
@@ -92,7 +111,7 @@ void saveDataToFile(const QList<SaveThread::SaveContext> &ctxList)
             continue;
         }
 
-        if (!ctx.parameters.saveDate) {
+        if (!ctx.parameters.saveToFile) {
             continue;
         }
 
@@ -118,7 +137,11 @@ void saveDataToFile(const QList<SaveThread::SaveContext> &ctxList)
             }
         }
 
-        saveDataToFile(ctx, file);
+        if (ctx.parameters.format == SaveThread::captureFormat) {
+            saveCaptureToFile(ctx, file);
+        } else {
+            saveDataToFile(ctx, file);
+        }
     }
 
     if (file) {
@@ -8,6 +8,7 @@
  **************************************************************************************************/
 #pragma once
 
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QPair>
 #include <QThread>
@@ -16,6 +17,9 @@ class SaveThread : public QThread
 {
     Q_OBJECT
 public:
+    // The save format of a binary capture(CaptureFile), the other save formats are TextFormat.
+    static const int captureFormat = 0x100;
+
     struct SaveParameters
     {
         bool saveToFile;
@@ -34,6 +38,7 @@ public:
         SaveParameters parameters;
         QByteArray data;
         bool isRx;
+        qint64 timestamp; // us since epoch, when the data was handed over
     };
 
 public:
@@ -46,6 +51,8 @@ private:
     QList<SaveContext> m_ctxList;
     QMutex m_ctxListMutex;
     SaveParameters m_parameters;
+    QElapsedTimer m_elapsedTimer;
+    qint64 m_startTime; // ms since epoch
 
 protected:
     void run() override;